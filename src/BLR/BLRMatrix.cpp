@@ -1793,6 +1793,68 @@ namespace strumpack {
       }
     }
 
+    template<typename scalar_t> void BLRMatrix<scalar_t>::trsmUN_gemm
+    (Trans op, const BLRMatrix<scalar_t>& F1, const BLRMatrix<scalar_t>& F2,
+     DenseMatrix<scalar_t>& B1, DenseMatrix<scalar_t>& B2, int task_depth) {
+      using DMW_t = DenseMatrixWrapper<scalar_t>;
+      assert(op != Trans::N);
+      auto rb = F1.rowblocks();
+      // op(U) is block lower triangular, with op(U)_ij = op(U_ji)
+      for (std::size_t i=0; i<rb; i++) {
+        DMW_t Bi(F1.tilecols(i), B1.cols(), B1, F1.tilecoff(i), 0);
+        for (std::size_t j=0; j<i; j++)
+          F1.tile(j, i).gemm_a
+            (op, Trans::N, scalar_t(-1.),
+             DMW_t(F1.tilerows(j), B1.cols(), B1, F1.tileroff(j), 0),
+             scalar_t(1.), Bi, task_depth);
+        trsm(Side::L, UpLo::U, op, Diag::N, scalar_t(1.),
+             F1.tile(i, i).D(), Bi, task_depth);
+      }
+      if (!B2.rows()) return;
+#if defined(STRUMPACK_USE_OPENMP_TASKLOOP)
+#pragma omp taskloop default(shared)
+#endif
+      for (std::size_t j=0; j<F2.colblocks(); j++) {
+        DMW_t B2j(F2.tilecols(j), B2.cols(), B2, F2.tilecoff(j), 0);
+        for (std::size_t i=0; i<F2.rowblocks(); i++)
+          F2.tile(i, j).gemm_a
+            (op, Trans::N, scalar_t(-1.),
+             DMW_t(F2.tilerows(i), B1.cols(), B1, F2.tileroff(i), 0),
+             scalar_t(1.), B2j, task_depth);
+      }
+    }
+
+    template<typename scalar_t> void BLRMatrix<scalar_t>::gemm_trsmLU
+    (Trans op, const BLRMatrix<scalar_t>& F1, const BLRMatrix<scalar_t>& F2,
+     DenseMatrix<scalar_t>& B1, DenseMatrix<scalar_t>& B2, int task_depth) {
+      using DMW_t = DenseMatrixWrapper<scalar_t>;
+      assert(op != Trans::N);
+      if (B2.rows()) {
+#if defined(STRUMPACK_USE_OPENMP_TASKLOOP)
+#pragma omp taskloop default(shared)
+#endif
+        for (std::size_t i=0; i<F2.colblocks(); i++) {
+          DMW_t B1i(F2.tilecols(i), B1.cols(), B1, F2.tilecoff(i), 0);
+          for (std::size_t j=0; j<F2.rowblocks(); j++)
+            F2.tile(j, i).gemm_a
+              (op, Trans::N, scalar_t(-1.),
+               DMW_t(F2.tilerows(j), B2.cols(), B2, F2.tileroff(j), 0),
+               scalar_t(1.), B1i, task_depth);
+        }
+      }
+      // op(L) is block upper triangular, with op(L)_ij = op(L_ji)
+      for (std::size_t i=F1.colblocks(); i --> 0; ) {
+        DMW_t Bi(F1.tilecols(i), B1.cols(), B1, F1.tilecoff(i), 0);
+        for (std::size_t j=i+1; j<F1.rowblocks(); j++)
+          F1.tile(j, i).gemm_a
+            (op, Trans::N, scalar_t(-1.),
+             DMW_t(F1.tilerows(j), B1.cols(), B1, F1.tileroff(j), 0),
+             scalar_t(1.), Bi, task_depth);
+        trsm(Side::L, UpLo::L, op, Diag::U, scalar_t(1.),
+             F1.tile(i, i).D(), Bi, task_depth);
+      }
+    }
+
     template<typename scalar_t> void
     trsm(Side s, UpLo ul, Trans ta, Diag d,
          scalar_t alpha, const BLRMatrix<scalar_t>& a,
@@ -122,6 +122,7 @@ namespace strumpack {
       }
 
       const std::vector<int>& piv() const { return piv_; }
+      std::vector<int>& piv() { return piv_; }
 
       /**
        * Multiply this BLR matrix with a dense matrix (vector), ie,
@@ -226,6 +227,26 @@ namespace strumpack {
       gemm_trsmUNN(const BLRM_t& F1, const BLRM_t& F2,
                    DenseM_t& B1, DenseM_t& B2, int task_depth);
 
+      /**
+       * Forward solve with the (conjugate) transposed factors:
+       * B1 = op(U(F1))^{-1} B1, B2 = B2 - op(F2) B1, where U(F1) is
+       * the upper triangular (non-unit) part of F1 and op is
+       * Trans::T or Trans::C.
+       */
+      static void
+      trsmUN_gemm(Trans op, const BLRM_t& F1, const BLRM_t& F2,
+                  DenseM_t& B1, DenseM_t& B2, int task_depth);
+
+      /**
+       * Backward solve with the (conjugate) transposed factors:
+       * B1 = op(L(F1))^{-1} (B1 - op(F2) B2), where L(F1) is the
+       * unit lower triangular part of F1 and op is Trans::T or
+       * Trans::C. Row pivoting is not applied.
+       */
+      static void
+      gemm_trsmLU(Trans op, const BLRM_t& F1, const BLRM_t& F2,
+                  DenseM_t& B1, DenseM_t& B2, int task_depth);
+
     private:
       std::size_t m_ = 0, n_ = 0, nbrows_ = 0, nbcols_ = 0;
       std::vector<std::size_t> roff_, coff_, cl2l_, rl2l_;
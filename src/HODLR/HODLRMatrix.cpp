@@ -70,6 +70,7 @@ namespace strumpack {
       const auto& K = *(temp->K);
       const auto& comm = *(temp->c);
       auto data = alldat_loc;
+      std::vector<std::size_t> I, J;
       for (int isec=0, r0=0, c0=0; isec<*Ninter; isec++) {
         auto m = rowids[isec];
         auto n = colids[isec];
@@ -77,11 +78,13 @@ namespace strumpack {
         assert(pmaps[pgids[isec]] == 1);          // prows == 1
         assert(pmaps[(*Npmap)+pgids[isec]] == 1); // pcols == 1
         if (comm.rank() == p0) {
-          for (int c=0; c<n; c++) {
-            auto col = std::abs(allcols[c0+c])-1;
-            for (int r=0; r<m; r++)
-              data[r+c*m] = K.eval(allrows[r0+r]-1, col);
-          }
+          // evaluate the whole block, see Kernel::eval_block
+          I.resize(m);
+          J.resize(n);
+          for (int r=0; r<m; r++) I[r] = allrows[r0+r]-1;
+          for (int c=0; c<n; c++) J[c] = std::abs(allcols[c0+c])-1;
+          DenseMatrixWrapper<scalar_t> B(m, n, data, m);
+          K(I, J, B);
           data += m*n;
         }
         r0 += m;
@@ -170,6 +173,7 @@ namespace strumpack {
           (opts.clustering_algorithm(), K.data(),
            K.permutation(), opts.leaf_size());
       else tree.refine(opts.leaf_size());
+      K.set_cluster_tree(tree);
       int min_lvl = 2 + std::ceil(std::log2(c.size()));
       lvls_ = std::max(min_lvl, tree.levels());
       tree.expand_complete_levels(lvls_);
@@ -62,7 +62,8 @@ namespace strumpack {
         TaskTimer timer("approximate_neighbors");
         timer.start();
         find_approximate_neighbors
-          (coords, opts.ann_iterations(), ann_number, ann, scores);
+          (coords, opts.ann_iterations(), ann_number, ann, scores,
+           opts.ann_single_precision());
         if (opts.verbose())
           std::cout << "# k-ANN=" << ann_number
                     << ", approximate neighbor search time = "
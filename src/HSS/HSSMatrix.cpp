@@ -26,7 +26,7 @@
  *             Division).
  *
  */
-
+#include <cstdint>
 
 #include "HSSMatrix.hpp"
 
@@ -93,6 +93,7 @@ namespace strumpack {
       auto t = binary_tree_clustering
         (opts.clustering_algorithm(), K.data(), K.permutation(), opts.leaf_size());
       K.permute();
+      K.set_cluster_tree(t);
       if (opts.verbose())
         std::cout << "# clustering (" << get_name(opts.clustering_algorithm())
                   << ") time = " << timer.elapsed() << std::endl;
@@ -425,8 +426,17 @@ namespace strumpack {
     }
 
 
+    /**
+     * Written at the start of every node, followed by the size of the
+     * scalar type. This changed when the ULV factors were added to
+     * the stream, older streams are rejected by read.
+     */
+    static const std::uint32_t hss_stream_tag = 0x32535348; // "HSS2"
+
     template<typename scalar_t> void
     HSSMatrix<scalar_t>::write(std::ofstream& os) const {
+      std::uint32_t tag[2] = {hss_stream_tag, sizeof(scalar_t)};
+      os.write((const char*)tag, sizeof(tag));
       os.write((const char*)&this->rows_, sizeof(this->rows_));
       os.write((const char*)&this->cols_, sizeof(this->cols_));
       os.write((const char*)&this->U_state_, sizeof(this->U_state_));
@@ -439,6 +449,12 @@ namespace strumpack {
       os.write((const char*)&this->V_rows_, sizeof(this->V_rows_));
       os << this->Asub_;
       os << U_ << V_ << D_ << B01_ << B10_;
+      // the ULV factors, if this was factored
+      auto& F = this->ULV_;
+      os << F.L_ << F.Vt0_ << F.W1_ << F.Q_ << F.D_;
+      std::size_t np = F.piv_.size();
+      os.write((const char*)&np, sizeof(np));
+      os.write((const char*)F.piv_.data(), sizeof(int)*np);
       int nc = this->ch_.size();
       os.write((const char*)&nc, sizeof(nc));
       for (auto& c : this->ch_)
@@ -447,6 +463,16 @@ namespace strumpack {
 
     template<typename scalar_t> void
     HSSMatrix<scalar_t>::read(std::ifstream& is) {
+      std::uint32_t tag[2] = {0, 0};
+      is.read((char*)tag, sizeof(tag));
+      if (!is.good() || tag[0] != hss_stream_tag ||
+          tag[1] != sizeof(scalar_t)) {
+        std::cerr << "ERROR: cannot read HSSMatrix, not an HSSMatrix"
+                  << " stream, from an older version, or with a different"
+                  << " scalar type" << std::endl;
+        is.setstate(std::ios::failbit);
+        return;
+      }
       is.read((char*)&this->rows_, sizeof(this->rows_));
       is.read((char*)&this->cols_, sizeof(this->cols_));
       is.read((char*)&this->U_state_, sizeof(this->U_state_));
@@ -459,11 +485,27 @@ namespace strumpack {
       is.read((char*)&this->V_rows_, sizeof(this->V_rows_));
       is >> this->Asub_;
       is >> U_ >> V_ >> D_ >> B01_ >> B10_;
+      auto& F = this->ULV_;
+      is >> F.L_ >> F.Vt0_ >> F.W1_ >> F.Q_ >> F.D_;
+      std::size_t np = 0;
+      is.read((char*)&np, sizeof(np));
+      if (!is.good() || np > this->rows_) {
+        is.setstate(std::ios::failbit);
+        return;
+      }
+      F.piv_.resize(np);
+      is.read((char*)F.piv_.data(), sizeof(int)*np);
       int nc = 0;
       is.read((char*)&nc, sizeof(nc));
+      if (!is.good() || nc < 0 || nc > 2) {
+        is.setstate(std::ios::failbit);
+        return;
+      }
       this->ch_.resize(nc);
-      for (auto& c : this->ch_)
+      for (auto& c : this->ch_) {
         c.reset(new HSSMatrix<scalar_t>(is));
+        if (!is.good()) return;
+      }
     }
 
     template<typename scalar_t> void
@@ -496,6 +538,11 @@ namespace strumpack {
       }
       HSSMatrix<scalar_t> H;
       H.read(f);
+      if (!f.good()) {
+        std::cerr << "ERROR: could not read HSSMatrix from "
+                  << fname << std::endl;
+        return HSSMatrix<scalar_t>();
+      }
       return H;
     }
 
@@ -506,12 +506,29 @@ namespace strumpack {
 
       /**
        * Read an HSSMatrix<scalar_t> from a binary file, called
-       * fname.
+       * fname. If the file was not written by write (for instance by
+       * an older version of STRUMPACK), with the same scalar type, an
+       * error is printed and an empty matrix is returned.
        *
        * \see write
        */
       static HSSMatrix<scalar_t> read(const std::string& fname);
 
+      /**
+       * Write this HSS matrix, including the ULV factorization (if
+       * computed), to an open binary stream, without a header. This
+       * can be embedded in a larger file.
+       *
+       * \see read(std::ifstream&), write(const std::string&)
+       */
+      void write(std::ofstream& os) const override;
+
+      /**
+       * Read an HSS matrix written with write(std::ofstream&). On a
+       * stream in another format, the failbit of the stream is set.
+       */
+      void read(std::ifstream& is) override;
+
       const HSSFactors<scalar_t>& ULV() { return this->ULV_; }
 
     protected:
@@ -668,9 +685,6 @@ namespace strumpack {
       template<typename T> friend
       void draw(const HSSMatrix<T>& H, const std::string& name);
 
-      void read(std::ifstream& is) override;
-      void write(std::ofstream& os) const override;
-
       friend class HSSMatrixMPI<scalar_t>;
 
       using HSSMatrixBase<scalar_t>::child;
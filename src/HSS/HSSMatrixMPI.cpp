@@ -106,6 +106,7 @@ namespace strumpack {
       timer.start();
       auto t = binary_tree_clustering
         (opts.clustering_algorithm(), K.data(), K.permutation(), opts.leaf_size());
+      K.set_cluster_tree(t);
       if (opts.verbose() && Comm().is_root())
         std::cout << "# clustering (" << get_name(opts.clustering_algorithm())
                   << ") time = " << timer.elapsed() << std::endl;
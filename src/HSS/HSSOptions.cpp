@@ -97,6 +97,7 @@ namespace strumpack {
          {"hss_enable_sync",           no_argument, 0, 19},
          {"hss_disable_sync",          no_argument, 0, 20},
          {"hss_log_ranks",             no_argument, 0, 21},
+         {"hss_ann_single_precision",  no_argument, 0, 22},
          {"hss_verbose",               no_argument, 0, 'v'},
          {"hss_quiet",                 no_argument, 0, 'q'},
          {"help",                      no_argument, 0, 'h'},
@@ -228,6 +229,7 @@ namespace strumpack {
         case 19: { set_synchronized_compression(true); } break;
         case 20: { set_synchronized_compression(false); } break;
         case 21: { set_log_ranks(true); } break;
+        case 22: { set_ann_single_precision(true); } break;
         case 'v': this->set_verbose(true); break;
         case 'q': this->set_verbose(false); break;
         case 'h': describe_options(); break;
@@ -275,6 +277,8 @@ namespace strumpack {
                 << approximate_neighbors() << ")" << std::endl
                 << "#   --hss_ann_iterations int (default "
                 << ann_iterations() << ")" << std::endl
+                << "#   --hss_ann_single_precision (default "
+                << ann_single_precision() << ")" << std::endl
                 << "#   --hss_enable_sync (default "
                 << synchronized_compression() << ")" << std::endl
                 << "#   --hss_disable_sync (default "
@@ -282,6 +282,18 @@ namespace strumpack {
         ann_iterations_ = iters;
       }
 
+      /**
+       * Do the approximate nearest neighbors search, used in the HSS
+       * compression algorithm for kernel matrices, on a single
+       * precision copy of the data points. This is faster and
+       * requires less memory bandwidth for double precision data.
+       *
+       * \param single Use single precision for the neighbor search
+       */
+      void set_ann_single_precision(bool single) {
+        ann_single_ = single;
+      }
+
       /**
        * Set this to true if you want to manually fill the random
        * sample vectors with random values.
@@ -416,6 +428,13 @@ namespace strumpack {
        */
       int ann_iterations() const { return ann_iterations_; }
 
+      /**
+       * Is the approximate nearest neighbors search done in single
+       * precision?
+       * \see set_ann_single_precision
+       */
+      bool ann_single_precision() const { return ann_single_; }
+
       /**
        * Will the user define its own random matrices?
        *
@@ -480,6 +499,7 @@ namespace strumpack {
       ClusteringAlgorithm clustering_algo_ = ClusteringAlgorithm::TWO_MEANS;
       int approximate_neighbors_ = 64;
       int ann_iterations_ = 5;
+      bool ann_single_ = false;
 
       void set_defaults() {
         this->type_ = structured::Type::HSS;
@@ -37,6 +37,9 @@
 #include "StrumpackOptions.hpp"
 #include "sparse/ordering/MatrixReordering.hpp"
 #include "sparse/EliminationTree.hpp"
+#include "sparse/FactorFile.hpp"
+#include "sparse/OutOfCoreStorage.hpp"
+#include "sparse/fronts/FrontalMatrix.hpp"
 #include "iterative/IterativeSolvers.hpp"
 
 namespace strumpack {
@@ -53,7 +56,10 @@ namespace strumpack {
     (argc, argv, verbose, root) { }
 
   template<typename scalar_t,typename integer_t>
-  SparseSolver<scalar_t,integer_t>::~SparseSolver() = default;
+  SparseSolver<scalar_t,integer_t>::~SparseSolver() {
+    if (!opts_.trace_file().empty())
+      trace_.write(opts_.trace_file());
+  }
 
 
   template<typename scalar_t,typename integer_t> void
@@ -70,8 +76,10 @@ namespace strumpack {
   template<typename scalar_t,typename integer_t> int
   SparseSolver<scalar_t,integer_t>::compute_reordering
   (const int* p, int base, int nx, int ny, int nz,
-   int components, int width) {
+   int components, int width, const RealDenseM_t* coords) {
     if (p) return nd_->set_permutation(opts_, *mat_, p, base);
+    if (coords)
+      return nd_->coordinate_nested_dissection(opts_, *mat_, *coords);
     return nd_->nested_dissection
       (opts_, *mat_, nx, ny, nz, components, width);
   }
@@ -147,15 +155,28 @@ namespace strumpack {
 
   template<typename scalar_t,typename integer_t> void
   SparseSolver<scalar_t,integer_t>::transform_x0
-  (DenseM_t& x, DenseM_t& xtmp) {
+  (DenseM_t& x, DenseM_t& xtmp, Trans op) {
     integer_t N = matrix()->size(), d = x.cols();
     auto& P = reordering()->iperm();
-    if (opts_.matching() == MatchingJob::MAX_DIAGONAL_PRODUCT_SCALING)
+    if (op != Trans::N) {
+      // inverse of transform_x for op(A)
+      auto R = row_scaling();
+      for (integer_t j=0; j<d; j++)
+#pragma omp parallel for
+        for (integer_t i=0; i<N; i++)
+          xtmp(i, j) = x(i, j) / R[i];
+      for (integer_t j=0; j<d; j++)
+#pragma omp parallel for
+        for (integer_t i=0; i<N; i++)
+          x(i, j) = xtmp(P[i], j);
+      return;
+    }
+    if (matching_.job == MatchingJob::MAX_DIAGONAL_PRODUCT_SCALING)
       for (integer_t j=0; j<d; j++)
 #pragma omp parallel for
         for (integer_t i=0; i<N; i++)
           x(i, j) = x(i, j) / matching_.C[i];
-    if (opts_.matching() == MatchingJob::NONE)
+    if (matching_.job == MatchingJob::NONE)
       xtmp.copy(x);
     else
       for (integer_t j=0; j<d; j++)
@@ -176,27 +197,36 @@ namespace strumpack {
 
   template<typename scalar_t,typename integer_t> void
   SparseSolver<scalar_t,integer_t>::transform_x
-  (DenseM_t& x, DenseM_t& xtmp) {
+  (DenseM_t& x, DenseM_t& xtmp, Trans op) {
     integer_t N = matrix()->size(), d = x.cols();
     auto& Pi = reordering()->perm();
     for (integer_t j=0; j<d; j++)
 #pragma omp parallel for
       for (integer_t i=0; i<N; i++)
         xtmp(i, j) = x(Pi[i], j);
+    if (op != Trans::N) {
+      // for op(A), the row scaling of A becomes a column scaling
+      auto R = row_scaling();
+      for (integer_t j=0; j<d; j++)
+#pragma omp parallel for
+        for (integer_t i=0; i<N; i++)
+          x(i, j) = R[i] * xtmp(i, j);
+      return;
+    }
     if (this->equil_.type == EquilibrationType::COLUMN ||
         this->equil_.type == EquilibrationType::BOTH)
       for (integer_t j=0; j<d; j++)
 #pragma omp parallel for
         for (integer_t i=0; i<N; i++)
           xtmp(i, j) = equil_.C[i] * xtmp(i, j);
-    if (opts_.matching() == MatchingJob::NONE)
+    if (matching_.job == MatchingJob::NONE)
       x.copy(xtmp);
     else {
       for (integer_t j=0; j<d; j++)
 #pragma omp parallel for
         for (integer_t i=0; i<N; i++)
           x(matching_.Q[i], j) = xtmp(i, j);
-      if (opts_.matching() == MatchingJob::MAX_DIAGONAL_PRODUCT_SCALING)
+      if (matching_.job == MatchingJob::MAX_DIAGONAL_PRODUCT_SCALING)
         for (integer_t j=0; j<d; j++)
 #pragma omp parallel for
           for (integer_t i=0; i<N; i++)
@@ -204,21 +234,63 @@ namespace strumpack {
     }
   }
 
-  template<typename scalar_t,typename integer_t> void
-  SparseSolver<scalar_t,integer_t>::transform_b
-  (const DenseM_t& b, DenseM_t& bloc) {
+  template<typename scalar_t,typename integer_t>
+  std::vector<typename RealType<scalar_t>::value_type>
+  SparseSolver<scalar_t,integer_t>::row_scaling() const {
     using real_t = typename RealType<scalar_t>::value_type;
-    integer_t N = matrix()->size(), d = b.cols();
-    auto& P = reordering()->iperm();
+    integer_t N = matrix()->size();
     std::vector<real_t> R(N, 1.);
     if (equil_.type == EquilibrationType::ROW ||
         equil_.type == EquilibrationType::BOTH)
       for (integer_t i=0; i<N; i++)
         R[i] *= equil_.R[i];
     if (this->reordered_ &&
-        opts_.matching() == MatchingJob::MAX_DIAGONAL_PRODUCT_SCALING)
+        matching_.job == MatchingJob::MAX_DIAGONAL_PRODUCT_SCALING)
       for (integer_t i=0; i<N; i++)
         R[i] *= matching_.R[i];
+    return R;
+  }
+
+  /**
+   * The factored matrix is P Dr A Dc Q P^T, with Dr, Dc the (row,
+   * column) scaling from equilibration and matching, Q the matching
+   * column permutation and P the fill reducing permutation. For
+   * op(A) = A^T or A^H, the right-hand side is transformed with P
+   * Q^T Dc instead of P Dr.
+   */
+  template<typename scalar_t,typename integer_t> void
+  SparseSolver<scalar_t,integer_t>::transform_b
+  (const DenseM_t& b, DenseM_t& bloc, Trans op) {
+    integer_t N = matrix()->size(), d = b.cols();
+    auto& P = reordering()->iperm();
+    if (op != Trans::N) {
+      DenseM_t btmp(b);
+      if (matching_.job == MatchingJob::MAX_DIAGONAL_PRODUCT_SCALING)
+        for (integer_t j=0; j<d; j++)
+#pragma omp parallel for
+          for (integer_t i=0; i<N; i++)
+            btmp(i, j) = matching_.C[i] * btmp(i, j);
+      if (matching_.job == MatchingJob::NONE)
+        bloc.copy(btmp);
+      else
+        for (integer_t j=0; j<d; j++)
+#pragma omp parallel for
+          for (integer_t i=0; i<N; i++)
+            bloc(i, j) = btmp(matching_.Q[i], j);
+      if (this->equil_.type == EquilibrationType::COLUMN ||
+          this->equil_.type == EquilibrationType::BOTH)
+        for (integer_t j=0; j<d; j++)
+#pragma omp parallel for
+          for (integer_t i=0; i<N; i++)
+            bloc(i, j) = equil_.C[i] * bloc(i, j);
+      btmp.copy(bloc);
+      for (integer_t j=0; j<d; j++)
+#pragma omp parallel for
+        for (integer_t i=0; i<N; i++)
+          bloc(i, j) = btmp(P[i], j);
+      return;
+    }
+    auto R = row_scaling();
     for (integer_t j=0; j<d; j++)
 #pragma omp parallel for
       for (integer_t i=0; i<N; i++) {
@@ -230,77 +302,160 @@ namespace strumpack {
   template<typename scalar_t,typename integer_t> ReturnCode
   SparseSolver<scalar_t,integer_t>::solve_internal
   (const DenseM_t& b, DenseM_t& x, bool use_initial_guess) {
+    return solve_internal(Trans::N, b, x, use_initial_guess);
+  }
+
+  template<typename scalar_t,typename integer_t> ReturnCode
+  SparseSolver<scalar_t,integer_t>::solve_internal
+  (Trans op, const DenseM_t& b, DenseM_t& x, bool use_initial_guess) {
+    if (op != Trans::N) {
+      if (!is_complex<scalar_t>()) op = Trans::T;
+      if (opts_.symmetric()) {
+        // complex symmetric: A^T = A, Hermitian: A^H = A, otherwise
+        // op(A) = conj(A) and conj(x) = A^{-1} conj(b)
+        if (!is_complex<scalar_t>() ||
+            ((op == Trans::T) ==
+             (opts_.matrix_symmetry() == MatrixSymmetry::SYMMETRIC)))
+          return solve_internal(Trans::N, b, x, use_initial_guess);
+        DenseM_t bc(b);
+        for (std::size_t j=0; j<bc.cols(); j++)
+          for (std::size_t i=0; i<bc.rows(); i++)
+            bc(i, j) = blas::my_conj(bc(i, j));
+        if (use_initial_guess)
+          for (std::size_t j=0; j<x.cols(); j++)
+            for (std::size_t i=0; i<x.rows(); i++)
+              x(i, j) = blas::my_conj(x(i, j));
+        auto ierr = solve_internal(Trans::N, bc, x, use_initial_guess);
+        for (std::size_t j=0; j<x.cols(); j++)
+          for (std::size_t i=0; i<x.rows(); i++)
+            x(i, j) = blas::my_conj(x(i, j));
+        return ierr;
+      }
+      if ((opts_.compression() != CompressionType::NONE &&
+           opts_.compression() != CompressionType::BLR) ||
+          opts_.use_gpu()) {
+        if (is_root_)
+          std::cerr << "# ERROR: solve with op(A) = A^T or A^H is only"
+                    << " supported without compression or with BLR"
+                    << " compression, on the CPU." << std::endl;
+        return ReturnCode::NOT_SUPPORTED;
+      }
+    }
     TaskTimer t("solve");
-    this->perf_counters_start();
     t.start();
     assert(b.cols() == x.cols());
 
-    // reordering has to be called, even for the iterative solvers
-    if (!this->reordered_) {
-      ReturnCode ierr = this->reorder();
-      if (ierr != ReturnCode::SUCCESS) return ierr;
-    }
-    // factor needs to be called, except for the non-preconditioned
-    // solvers
-    if (!this->factored_ &&
-        (opts_.Krylov_solver() != KrylovSolver::GMRES) &&
-        (opts_.Krylov_solver() != KrylovSolver::BICGSTAB)) {
-      ReturnCode ierr = this->factor();
-      // TODO there could be zero pivots, but replaced, and this
-      // should still continue!!
-      if (ierr != ReturnCode::SUCCESS) return ierr;
+    {
+      // concurrent solves wait for the first one to reorder/factor
+      std::lock_guard<std::mutex> lock(this->solve_mtx_);
+      // reordering has to be called, even for the iterative solvers
+      if (!this->reordered_) {
+        ReturnCode ierr = this->reorder();
+        if (ierr != ReturnCode::SUCCESS) return ierr;
+      }
+      // factor needs to be called, except for the non-preconditioned
+      // solvers
+      if (!this->factored_ &&
+          (opts_.Krylov_solver() != KrylovSolver::GMRES) &&
+          (opts_.Krylov_solver() != KrylovSolver::BICGSTAB)) {
+        ReturnCode ierr = this->factor();
+        // TODO there could be zero pivots, but replaced, and this
+        // should still continue!!
+        if (ierr != ReturnCode::SUCCESS) return ierr;
+      }
     }
+    std::unique_lock<std::mutex> serial(this->solve_mtx_, std::defer_lock);
+    if (!tree_->reentrant_solve() || opts_.use_gpu()) serial.lock();
+    // count in a separate set, added to the solver counters at the
+    // end, so that concurrent solves do not mix up their counts
+    auto counters = std::make_shared<PerfCounterSet>();
+    typename SPBase_t::CallScope scope(*this, counters);
+    auto mark = this->perf_counters_start(SolverPhase::SOLVE);
 
     integer_t d = b.cols();
     assert(matrix()->size() < std::numeric_limits<int>::max());
     DenseM_t bloc(b.rows(), d);
 
-    auto spmv = [&](const scalar_t* x, scalar_t* y)
-                { matrix()->spmv(x, y); };
-    Krylov_its_ = 0;
+    auto spmv = [&](const scalar_t* x, scalar_t* y) {
+      if (op == Trans::N) matrix()->spmv(x, y);
+      else {
+        auto X = ConstDenseMatrixWrapperPtr(b.rows(), 1, x, b.rows());
+        DenseMW_t Y(b.rows(), 1, y, b.rows());
+        mat_->spmv(op, *X, Y);
+      }
+    };
+    int its = 0;
+    // the out-of-core solves are serialized, see above
+    auto ooc = tree()->out_of_core();
+    const auto ooc_errors = ooc ? ooc->read_errors() : 0;
 
     if (use_initial_guess &&
         opts_.Krylov_solver() != KrylovSolver::DIRECT)
-      transform_x0(x, bloc);
-    transform_b(b, bloc);
+      transform_x0(x, bloc, op);
+    transform_b(b, bloc, op);
 
     auto MFsolve =
       [&](scalar_t* w) {
         DenseMW_t X(x.rows(), 1, w, x.ld());
-        tree()->multifrontal_solve(X);
+        tree()->multifrontal_solve(op, X);
+      };
+    // block versions, for all columns at once
+    using real_t = typename RealType<scalar_t>::value_type;
+    iterative::BSPMV<scalar_t> bspmv =
+      [&](const DenseM_t& v, DenseM_t& w) {
+        if (op == Trans::N) matrix()->spmv(v, w);
+        else mat_->spmv(op, v, w);
       };
+    std::function<real_t(const DenseM_t&, const DenseM_t&)> bw_error =
+      [&](const DenseM_t& v, const DenseM_t& w) {
+        return mat_->max_scaled_residual(op, v, w); };
+    iterative::BPREC<scalar_t> bMFsolve =
+      [&](DenseM_t& w) { tree()->multifrontal_solve(op, w); };
+    auto refine = [&]() {
+      if (op == Trans::N)
+        iterative::IterativeRefinement<scalar_t,integer_t>
+          (*matrix(), [&](DenseM_t& w) { tree()->multifrontal_solve(w); },
+           x, bloc, opts_.rel_tol(), opts_.abs_tol(),
+           its, opts_.maxit(), use_initial_guess,
+           opts_.verbose() && is_root_);
+      else
+        iterative::IterativeRefinement<scalar_t>
+          (bspmv, bw_error, bMFsolve, x, bloc, opts_.rel_tol(),
+           opts_.abs_tol(), its, opts_.maxit(), use_initial_guess,
+           opts_.verbose() && is_root_);
+    };
+    auto block_gmres = [&]() {
+      iterative::BlockGMRes<scalar_t>
+        (bspmv, bMFsolve, x, bloc, opts_.rel_tol(), opts_.abs_tol(),
+         its, opts_.maxit(), opts_.gmres_restart(),
+         opts_.GramSchmidt_type(), use_initial_guess,
+         opts_.verbose() && is_root_);
+    };
 
     switch (opts_.Krylov_solver()) {
     case KrylovSolver::AUTO: {
       if (opts_.compression() != CompressionType::NONE && x.cols() == 1)
         iterative::GMRes<scalar_t>
           (spmv, MFsolve, x.rows(), x.data(), bloc.data(),
-           opts_.rel_tol(), opts_.abs_tol(), Krylov_its_, opts_.maxit(),
+           opts_.rel_tol(), opts_.abs_tol(), its, opts_.maxit(),
            opts_.gmres_restart(), opts_.GramSchmidt_type(),
            use_initial_guess, opts_.verbose() && is_root_);
-      else
-        iterative::IterativeRefinement<scalar_t,integer_t>
-          (*matrix(), [&](DenseM_t& w) { tree()->multifrontal_solve(w); },
-           x, bloc, opts_.rel_tol(), opts_.abs_tol(),
-           Krylov_its_, opts_.maxit(), use_initial_guess,
-           opts_.verbose() && is_root_);
+      else if (opts_.compression() != CompressionType::NONE)
+        block_gmres();
+      else refine();
     }; break;
     case KrylovSolver::DIRECT: {
       x = bloc;
-      tree()->multifrontal_solve(x);
+      tree()->multifrontal_solve(op, x);
     }; break;
     case KrylovSolver::REFINE: {
-      iterative::IterativeRefinement<scalar_t,integer_t>
-        (*matrix(), [&](DenseM_t& w) { tree()->multifrontal_solve(w); },
-         x, bloc, opts_.rel_tol(), opts_.abs_tol(),
-         Krylov_its_, opts_.maxit(), use_initial_guess,
-         opts_.verbose() && is_root_);
+      refine();
     }; break;
     case KrylovSolver::PREC_GMRES: {
       assert(x.cols() == 1);
       iterative::GMRes<scalar_t>
         (spmv, MFsolve, x.rows(), x.data(), bloc.data(),
-         opts_.rel_tol(), opts_.abs_tol(), Krylov_its_, opts_.maxit(),
+         opts_.rel_tol(), opts_.abs_tol(), its, opts_.maxit(),
          opts_.gmres_restart(), opts_.GramSchmidt_type(),
          use_initial_guess, opts_.verbose() && is_root_);
     }; break;
@@ -308,14 +463,14 @@ namespace strumpack {
       assert(x.cols() == 1);
       iterative::BiCGStab<scalar_t>
         (spmv, MFsolve, x.rows(), x.data(), bloc.data(),
-         opts_.rel_tol(), opts_.abs_tol(), Krylov_its_, opts_.maxit(),
+         opts_.rel_tol(), opts_.abs_tol(), its, opts_.maxit(),
          use_initial_guess, opts_.verbose() && is_root_);
     }; break;
     case KrylovSolver::GMRES: { // see above
       assert(x.cols() == 1);
       iterative::GMRes<scalar_t>
         (spmv, [](scalar_t* x) {}, x.rows(), x.data(), bloc.data(),
-         opts_.rel_tol(), opts_.abs_tol(), Krylov_its_, opts_.maxit(),
+         opts_.rel_tol(), opts_.abs_tol(), its, opts_.maxit(),
          opts_.gmres_restart(), opts_.GramSchmidt_type(),
          use_initial_guess, opts_.verbose() && is_root_);
     }; break;
@@ -323,15 +478,31 @@ namespace strumpack {
       assert(x.cols() == 1);
       iterative::BiCGStab<scalar_t>
         (spmv, [](scalar_t* x) {}, x.rows(), x.data(), bloc.data(),
-         opts_.rel_tol(), opts_.abs_tol(), Krylov_its_, opts_.maxit(),
+         opts_.rel_tol(), opts_.abs_tol(), its, opts_.maxit(),
          use_initial_guess, opts_.verbose() && is_root_);
+    }; break;
+    case KrylovSolver::PREC_BLOCK_GMRES: {
+      block_gmres();
+    }; break;
+    case KrylovSolver::BLOCK_REFINE: {
+      iterative::BlockIterativeRefinement<scalar_t>
+        (bspmv, bw_error, bMFsolve, x, bloc, opts_.rel_tol(),
+         opts_.abs_tol(), its, opts_.maxit(), use_initial_guess,
+         opts_.verbose() && is_root_);
     }
     }
-    transform_x(x, bloc);
+    transform_x(x, bloc, op);
+    Krylov_its_ = its;
 
     t.stop();
-    this->perf_counters_stop("DIRECT/GMRES solve");
-    this->print_solve_stats(t);
+    {
+      std::lock_guard<std::mutex> lock(this->stats_mtx_);
+      this->perf_counters_stop(mark, "DIRECT/GMRES solve");
+      this->print_solve_stats(t);
+    }
+    this->counters_->add(counters->counts());
+    if (ooc && ooc->read_errors() != ooc_errors)
+      return ReturnCode::FILE_ERROR;
     return ReturnCode::SUCCESS;
   }
 
@@ -340,6 +511,29 @@ namespace strumpack {
     tree_.reset(nullptr);
   }
 
+  template<typename scalar_t,typename integer_t> bool
+  SparseSolver<scalar_t,integer_t>::save_factors_internal
+  (FactorFileWriter& f) const {
+    if (!nd_ || !tree_) return false;
+    nd_->save(f);
+    return tree_->save(f);
+  }
+
+  template<typename scalar_t,typename integer_t> bool
+  SparseSolver<scalar_t,integer_t>::load_factors_internal
+  (const std::shared_ptr<FactorFileReader>& f) {
+    setup_reordering();
+    if (!nd_->load(*f) ||
+        nd_->perm().size() != std::size_t(matrix()->size()))
+      return false;
+    tree_.reset(new EliminationTree<scalar_t,integer_t>());
+    if (!tree_->load(f)) {
+      tree_.reset(nullptr);
+      return false;
+    }
+    return true;
+  }
+
   // explicit template instantiations
   template class SparseSolver<float,int>;
   template class SparseSolver<double,int>;
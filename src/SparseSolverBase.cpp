@@ -36,6 +36,8 @@
 #include "StrumpackOptions.hpp"
 #include "sparse/ordering/MatrixReordering.hpp"
 #include "sparse/EliminationTree.hpp"
+#include "sparse/OutOfCoreStorage.hpp"
+#include "sparse/FactorFile.hpp"
 #include "iterative/IterativeSolvers.hpp"
 #include "dense/GPUWrapper.hpp"
 
@@ -117,6 +119,11 @@ namespace strumpack {
     return tree()->factor_nonzeros();
   }
 
+  template<typename scalar_t,typename integer_t> FrontCounter
+  SparseSolverBase<scalar_t,integer_t>::front_counter() const {
+    return tree()->front_counter();
+  }
+
   template<typename scalar_t,typename integer_t> std::size_t
   SparseSolverBase<scalar_t,integer_t>::factor_memory() const {
     return tree()->factor_nonzeros() * sizeof(scalar_t);
@@ -204,8 +211,36 @@ namespace strumpack {
 #endif
   }
 
-  template<typename scalar_t,typename integer_t> void
-  SparseSolverBase<scalar_t,integer_t>::perf_counters_start() {
+  template<typename scalar_t,typename integer_t>
+  SparseSolverBase<scalar_t,integer_t>::CallScope::CallScope
+  (const SparseSolverBase<scalar_t,integer_t>& s,
+   const std::shared_ptr<PerfCounterSet>& c) {
+#if defined(_OPENMP)
+    if (s.opts_.num_threads() > 0) {
+      threads_ = omp_get_max_threads();
+      omp_set_num_threads(s.opts_.num_threads());
+    }
+#endif
+    // after setting the number of threads, so the counters and the
+    // trace session are activated on the threads that will be used
+    counters_.reset(new PerfCounterScope(c ? c : s.counters_));
+    if (!s.opts_.trace_file().empty())
+      trace_.reset(new TraceSessionScope(s.trace_));
+  }
+
+  template<typename scalar_t,typename integer_t>
+  SparseSolverBase<scalar_t,integer_t>::CallScope::~CallScope() {
+    trace_.reset();
+    counters_.reset();
+#if defined(_OPENMP)
+    if (threads_) omp_set_num_threads(threads_);
+#endif
+  }
+
+  template<typename scalar_t,typename integer_t> PerfReport::Mark
+  SparseSolverBase<scalar_t,integer_t>::perf_counters_start
+  (SolverPhase p) {
+    auto m = perf_report_.start(p, PerfCounterSet::active());
 #if defined(STRUMPACK_USE_PAPI)
     float mflops = 0., rtime = 0., ptime = 0.;
     long_long flpops = 0; // cannot use class variables in openmp clause
@@ -214,15 +249,13 @@ namespace strumpack {
     PAPI_flops(&rtime, &ptime, &flpops, &mflops);
     _flpops = flpops; rtime_ = rtime; ptime_ = ptime;
 #endif
-#if defined(STRUMPACK_COUNT_FLOPS)
-    f0_ = params::flops;
-    b0_ = params::bytes_moved;
-#endif
+    return m;
   }
 
   template<typename scalar_t,typename integer_t> void
   SparseSolverBase<scalar_t,integer_t>::perf_counters_stop
-  (const std::string& s) {
+  (const PerfReport::Mark& m, const std::string& s) {
+    perf_report_.stop(m, PerfCounterSet::active());
 #if defined(STRUMPACK_USE_PAPI)
     float mflops = 0., rtime = 0., ptime = 0.;
     long_long flpops = 0;
@@ -256,8 +289,10 @@ namespace strumpack {
     }
 #endif
 #if defined(STRUMPACK_COUNT_FLOPS)
-    fmin_ = fmax_ = ftot_ = params::flops - f0_;
-    bmin_ = bmax_ = btot_ = params::bytes_moved - b0_;
+    fmin_ = fmax_ = ftot_ =
+      params::flops - m.counts[int(PerfCounterType::FLOPS)];
+    bmin_ = bmax_ = btot_ =
+      params::bytes_moved - m.counts[int(PerfCounterType::BYTES_MOVED)];
 #endif
   }
 
@@ -274,6 +309,11 @@ namespace strumpack {
       std::cout << "#   - number of Krylov iterations = "
                 << Krylov_its_ << std::endl;
       std::cout << "#   - solve time = " << tel << std::endl;
+      if (auto ooc = tree()->out_of_core())
+        std::cout << "#   - out-of-core factors read = "
+                  << ooc->bytes_read() / 1.e6 << " MB"
+                  << ", overlapped with solve = "
+                  << ooc->read_overlap() * 100. << " %" << std::endl;
 #if defined(STRUMPACK_COUNT_FLOPS)
       std::cout << "#   - solve flops = " << double(ftot_) << " min = "
                 << double(fmin_) << " max = " << double(fmax_) << std::endl;
@@ -313,14 +353,33 @@ namespace strumpack {
     return reorder_internal(p, base, 1, 1, 1, 1, 1);
   }
 
+  template<typename scalar_t,typename integer_t> ReturnCode
+  SparseSolverBase<scalar_t,integer_t>::reorder
+  (const RealDenseM_t& coords) {
+    return reorder_internal(nullptr, 0, 1, 1, 1, 1, 1, &coords);
+  }
+
   template<typename scalar_t,typename integer_t> ReturnCode
   SparseSolverBase<scalar_t,integer_t>::reorder_internal
   (const int* p, int base, int nx, int ny, int nz,
-   int components, int width) {
+   int components, int width, const RealDenseM_t* coords) {
     if (!matrix()) return ReturnCode::MATRIX_NOT_SET;
     if (reordered_) return ReturnCode::SUCCESS;
+    CallScope scope(*this);
+    auto mark = perf_counters_start(SolverPhase::REORDERING);
     TaskTimer t1("permute-scale");
     int ierr;
+    if (opts_.symmetric()) {
+      // matching and (unsymmetric) equilibration destroy the symmetry
+      if (opts_.matching() != MatchingJob::NONE) {
+        if (opts_.verbose() && is_root_)
+          std::cout << "# WARNING: matching is not supported with "
+                    << get_name(opts_.matrix_symmetry())
+                    << " matrix, disabling matching" << std::endl;
+        opts_.set_matching(MatchingJob::NONE);
+      }
+      matrix()->set_symm_sparse();
+    }
     if (opts_.verbose() && is_root_)
       std::cout << "# matching job: " << get_description(opts_.matching())
                 << std::endl;
@@ -333,8 +392,10 @@ namespace strumpack {
       }
     }
 
-    equil_ = matrix()->equilibration();
-    matrix()->equilibrate(equil_);
+    if (!opts_.symmetric()) {
+      equil_ = matrix()->equilibration();
+      matrix()->equilibrate(equil_);
+    }
     if (opts_.verbose() && is_root_)
       std::cout << "# matrix equilibration, r_cond = "
                 << equil_.rcond << " , c_cond = " << equil_.ccond
@@ -359,10 +420,10 @@ namespace strumpack {
     }
 
     TaskTimer t3("nested-dissection");
-    perf_counters_start();
     t3.start();
     setup_reordering();
-    ierr = compute_reordering(p, base, nx, ny, nz, components, width);
+    ierr = compute_reordering
+      (p, base, nx, ny, nz, components, width, coords);
     if (ierr) {
       std::cerr << "ERROR: nested dissection went wrong, ierr="
                 << ierr << std::endl;
@@ -377,9 +438,9 @@ namespace strumpack {
       std::cout << "#   - symmetrization time = " << t2.elapsed()
                 << std::endl;
     }
-    perf_counters_stop("nested dissection");
+    perf_counters_stop(mark, "nested dissection");
 
-    perf_counters_start();
+    mark = perf_counters_start(SolverPhase::SYMBOLIC_FACTORIZATION);
     TaskTimer t0("symbolic-factorization", [&](){ setup_tree(); });
     /* do not clear the tree data, because if we update the matrix
      * values, we want to reuse this information */
@@ -390,6 +451,13 @@ namespace strumpack {
         std::cout << "# symbolic factorization:" << std::endl;
         std::cout << "#   - nr of dense Frontal matrices = "
                   << number_format_with_commas(fc.dense) << std::endl;
+        if (opts_.amalgamation())
+          std::cout << "#   - nr of fronts removed by amalgamation = "
+                    << number_format_with_commas(fc.amalgamated)
+                    << std::endl
+                    << "#   - explicit zeros added by amalgamation = "
+                    << number_format_with_commas(fc.amalgamation_zeros)
+                    << std::endl;
         switch (opts_.compression()) {
         case CompressionType::HSS:
           std::cout << "#   - nr of HSS Frontal matrices = "
@@ -428,7 +496,7 @@ namespace strumpack {
         std::cout << "#   - symb-factor time = " << t0.elapsed() << std::endl;
       }
     }
-    perf_counters_stop("symbolic factorization");
+    perf_counters_stop(mark, "symbolic factorization");
 
     if (opts_.compression() != CompressionType::NONE) {
       if (is_root_) {
@@ -451,13 +519,13 @@ namespace strumpack {
         }
 #endif
       }
-      perf_counters_start();
+      mark = perf_counters_start(SolverPhase::SYMBOLIC_FACTORIZATION);
       // TODO also broadcast this?? is computed with metis
       TaskTimer t4("separator-reordering", [&](){ separator_reordering(); });
       if (opts_.verbose() && is_root_)
         std::cout << "#   - sep-reorder time = "
                   << t4.elapsed() << std::endl;
-      perf_counters_stop("separator reordering");
+      perf_counters_stop(mark, "separator reordering");
     }
 
     reordered_ = true;
@@ -556,6 +624,7 @@ namespace strumpack {
   SparseSolverBase<scalar_t,integer_t>::factor() {
     if (!matrix()) return ReturnCode::MATRIX_NOT_SET;
     if (factored_) return ReturnCode::SUCCESS;
+    CallScope scope(*this);
     if (!reordered_) {
       ReturnCode ierr = reorder();
       if (ierr != ReturnCode::SUCCESS) return ierr;
@@ -574,13 +643,13 @@ namespace strumpack {
                   << "enabled" << std::endl;
       }
     }
-    perf_counters_start();
+    auto mark = perf_counters_start(SolverPhase::NUMERICAL_FACTORIZATION);
     flop_breakdown_reset();
     ReturnCode err_code;
     TaskTimer t1("Sparse-factorization", [&]() {
       err_code = tree()->multifrontal_factorization(*matrix(), opts_);
     });
-    perf_counters_stop("numerical factorization");
+    perf_counters_stop(mark, "numerical factorization");
     if (opts_.verbose()) {
       auto fnnz = factor_nonzeros();
       auto max_rank = maximum_rank();
@@ -609,6 +678,12 @@ namespace strumpack {
                   << double(params::peak_device_memory)/1.e6
                   << " MB" << std::endl;
 #endif
+        if (auto ooc = tree()->out_of_core())
+          std::cout << "#   - out-of-core factors written = "
+                    << ooc->bytes_written() / 1.e6 << " MB"
+                    << (ooc->on_disk() ? "" : " (kept in memory)")
+                    << ", overlapped with factorization = "
+                    << ooc->write_overlap() * 100. << " %" << std::endl;
         if (opts_.compression() != CompressionType::NONE) {
           std::cout << "#   - compression = " << std::boolalpha
                     << get_name(opts_.compression()) << std::endl;
@@ -687,12 +762,14 @@ namespace strumpack {
   template<typename scalar_t,typename integer_t> ReturnCode
   SparseSolverBase<scalar_t,integer_t>::solve
   (const scalar_t* b, scalar_t* x, bool use_initial_guess) {
+    CallScope scope(*this);
     return solve_internal(b, x, use_initial_guess);
   }
 
   template<typename scalar_t,typename integer_t> ReturnCode
   SparseSolverBase<scalar_t,integer_t>::solve
   (const DenseM_t& b, DenseM_t& x, bool use_initial_guess) {
+    CallScope scope(*this);
     return solve_internal(b, x, use_initial_guess);
   }
 
@@ -700,6 +777,7 @@ namespace strumpack {
   SparseSolverBase<scalar_t,integer_t>::solve
   (int nrhs, const scalar_t* b, int ldb, scalar_t* x, int ldx,
    bool use_initial_guess) {
+    CallScope scope(*this);
     return solve_internal(nrhs, b, ldb, x, ldx, use_initial_guess);
   }
 
@@ -717,12 +795,188 @@ namespace strumpack {
     return this->solve(*B, X, use_initial_guess);
   }
 
+  template<typename scalar_t,typename integer_t> ReturnCode
+  SparseSolverBase<scalar_t,integer_t>::solve
+  (Trans op, const scalar_t* b, scalar_t* x, bool use_initial_guess) {
+    CallScope scope(*this);
+    if (op == Trans::N)
+      return solve_internal(b, x, use_initial_guess);
+    auto N = matrix()->size();
+    auto B = ConstDenseMatrixWrapperPtr(N, 1, b, N);
+    DenseMW_t X(N, 1, x, N);
+    return solve_internal(op, *B, X, use_initial_guess);
+  }
+
+  template<typename scalar_t,typename integer_t> ReturnCode
+  SparseSolverBase<scalar_t,integer_t>::solve
+  (Trans op, const DenseM_t& b, DenseM_t& x, bool use_initial_guess) {
+    CallScope scope(*this);
+    return solve_internal(op, b, x, use_initial_guess);
+  }
+
+  template<typename scalar_t,typename integer_t> ReturnCode
+  SparseSolverBase<scalar_t,integer_t>::solve
+  (Trans op, int nrhs, const scalar_t* b, int ldb, scalar_t* x, int ldx,
+   bool use_initial_guess) {
+    CallScope scope(*this);
+    if (op == Trans::N)
+      return solve_internal(nrhs, b, ldb, x, ldx, use_initial_guess);
+    if (!nrhs) return ReturnCode::SUCCESS;
+    auto N = matrix()->size();
+    assert(ldb >= N);
+    assert(ldx >= N);
+    assert(nrhs >= 1);
+    auto B = ConstDenseMatrixWrapperPtr(N, nrhs, b, ldb);
+    DenseMW_t X(N, nrhs, x, ldx);
+    return solve_internal(op, *B, X, use_initial_guess);
+  }
+
+  template<typename scalar_t,typename integer_t> ReturnCode
+  SparseSolverBase<scalar_t,integer_t>::solve_internal
+  (Trans op, const DenseM_t& b, DenseM_t& x, bool use_initial_guess) {
+    if (op == Trans::N)
+      return solve_internal(b, x, use_initial_guess);
+    if (is_root_)
+      std::cerr << "# ERROR: solve with op(A) = A^T or A^H"
+                << " is not supported by this solver." << std::endl;
+    return ReturnCode::NOT_SUPPORTED;
+  }
+
   template<typename scalar_t,typename integer_t> void
   SparseSolverBase<scalar_t,integer_t>::delete_factors() {
+    CallScope scope(*this);
     delete_factors_internal();
     factored_ = false;
   }
 
+  template<typename scalar_t,typename integer_t> ReturnCode
+  SparseSolverBase<scalar_t,integer_t>::save_factors
+  (const std::string& fname) {
+    CallScope scope(*this);
+    if (!matrix()) return ReturnCode::MATRIX_NOT_SET;
+    if (!factored_) {
+      ReturnCode ierr = factor();
+      if (ierr != ReturnCode::SUCCESS) return ierr;
+    }
+    TaskTimer t("save-factors");
+    t.start();
+    FactorFileWriter f(fname);
+    if (!f.good()) {
+      std::cerr << "# ERROR: could not open " << fname
+                << " for writing" << std::endl;
+      return ReturnCode::FILE_ERROR;
+    }
+    f.write_header<scalar_t,integer_t>();
+    f.write(opts_.matrix_symmetry());
+    f.write(opts_.compression());
+    f.write(matrix()->size());
+    f.write(matrix()->nnz());
+    f.write(matching_.job);
+    f.write(matching_.Q);
+    f.write(matching_.R);
+    f.write(matching_.C);
+    f.write(equil_.info);
+    f.write(equil_.type);
+    f.write(equil_.rcond);
+    f.write(equil_.ccond);
+    f.write(equil_.Amax);
+    f.write(equil_.R);
+    f.write(equil_.C);
+    if (!save_factors_internal(f)) {
+      if (is_root_)
+        std::cerr << "# ERROR: saving the factors is not supported"
+                  << " by this solver, or for these fronts" << std::endl;
+      return ReturnCode::NOT_SUPPORTED;
+    }
+    f.write_footer();
+    if (!f.good()) {
+      std::cerr << "# ERROR: failed to write " << fname << std::endl;
+      return ReturnCode::FILE_ERROR;
+    }
+    t.stop();
+    if (opts_.verbose() && is_root_)
+      std::cout << "# factors saved to " << fname << " in "
+                << t.elapsed() << " sec" << std::endl;
+    return ReturnCode::SUCCESS;
+  }
+
+  template<typename scalar_t,typename integer_t> ReturnCode
+  SparseSolverBase<scalar_t,integer_t>::load_factors
+  (const std::string& fname) {
+    CallScope scope(*this);
+    if (!matrix()) return ReturnCode::MATRIX_NOT_SET;
+    if (reordered_) {
+      // the matrix was already permuted and scaled
+      if (is_root_)
+        std::cerr << "# ERROR: load_factors requires a new matrix,"
+                  << " set with set_matrix or set_csr_matrix" << std::endl;
+      return ReturnCode::NOT_SUPPORTED;
+    }
+    TaskTimer t("load-factors");
+    t.start();
+    auto f = std::make_shared<FactorFileReader>(fname);
+    if (!f->good() || !f->read_header<scalar_t,integer_t>())
+      return ReturnCode::FILE_ERROR;
+    auto symm = f->read<MatrixSymmetry>();
+    auto comp = f->read<CompressionType>();
+    auto n = f->read<integer_t>();
+    auto nnz = f->read<integer_t>();
+    if (n != matrix()->size()) {
+      std::cerr << "# ERROR: " << fname << " holds the factors of a matrix"
+                << " of size " << n << ", not " << matrix()->size()
+                << std::endl;
+      return ReturnCode::FILE_ERROR;
+    }
+    MatchingData<scalar_t,integer_t> matching;
+    Equilibration<scalar_t> equil;
+    f->read(matching.job);
+    f->read(matching.Q);
+    f->read(matching.R);
+    f->read(matching.C);
+    f->read(equil.info);
+    f->read(equil.type);
+    f->read(equil.rcond);
+    f->read(equil.ccond);
+    f->read(equil.Amax);
+    f->read(equil.R);
+    f->read(equil.C);
+    if (!f->good() || !load_factors_internal(f) || !f->read_footer()) {
+      std::cerr << "# ERROR: failed to read the factors from "
+                << fname << std::endl;
+      delete_factors_internal();
+      return ReturnCode::FILE_ERROR;
+    }
+    // apply the same transformations to the matrix as in reorder
+    if (symm != MatrixSymmetry::UNSYMMETRIC)
+      matrix()->set_symm_sparse();
+    matrix()->apply_matching(matching);
+    matrix()->equilibrate(equil);
+    opts_.set_matrix_symmetry(symm);
+    opts_.set_compression(comp);
+    opts_.set_matching(matching.job);
+    if (opts_.replace_tiny_pivots()) {
+      using real_t = typename RealType<scalar_t>::value_type;
+      opts_.set_pivot_threshold
+        (std::sqrt(blas::lamch<real_t>('E')) * matrix()->norm1());
+    }
+    matrix()->symmetrize_sparsity();
+    if (matrix()->nnz() != nnz) {
+      std::cerr << "# ERROR: the sparsity pattern of the matrix does"
+                << " not match the factors in " << fname << std::endl;
+      delete_factors_internal();
+      return ReturnCode::FILE_ERROR;
+    }
+    matrix()->permute(reordering()->iperm(), reordering()->perm());
+    matching_ = std::move(matching);
+    equil_ = std::move(equil);
+    reordered_ = factored_ = true;
+    t.stop();
+    if (opts_.verbose() && is_root_)
+      std::cout << "# factors loaded from " << fname << " in "
+                << t.elapsed() << " sec" << std::endl;
+    return ReturnCode::SUCCESS;
+  }
+
   // explicit template instantiations
   template class SparseSolverBase<float,int>;
   template class SparseSolverBase<double,int>;
@@ -34,12 +34,16 @@
 #define STRUMPACK_SPARSE_SOLVER_BASE_HPP
 
 #include <new>
+#include <mutex>
+#include <atomic>
 #include <memory>
 #include <vector>
 #include <string>
 
 #include "StrumpackConfig.hpp"
 #include "StrumpackOptions.hpp"
+#include "misc/PerfCounters.hpp"
+#include "misc/TaskTimer.hpp"
 #include "sparse/CSRMatrix.hpp"
 #include "dense/DenseMatrix.hpp"
 
@@ -52,6 +56,9 @@ namespace strumpack {
   template<typename scalar_t,typename integer_t> class MatrixReordering;
   template<typename scalar_t,typename integer_t> class EliminationTree;
   class TaskTimer;
+  class FactorFileWriter;
+  class FactorFileReader;
+  struct FrontCounter;
 
   /**
    * \class SparseSolverBase
@@ -71,6 +78,17 @@ namespace strumpack {
    * integer_t=int64_t instead. This should be a __signed__ integer
    * type.
    *
+   * Different solver objects can be used concurrently, from
+   * different threads, each with its own OpenMP thread budget, see
+   * SPOptions::set_num_threads. Once the matrix is factored, solve
+   * can be called concurrently on the same SparseSolver object, each
+   * call uses its own workspace. The solves are serialized internally
+   * for HSS or HODLR compression, out-of-core factors and GPU
+   * off-loading. SparseSolverMPIDist always serializes concurrent
+   * solves on the same object. Other member functions (factor, update of the
+   * matrix values, ..) should not be called concurrently with any
+   * other call on the same object.
+   *
    * \see SparseSolverMPIDist,
    * SparseSolverMixedPrecision
    */
@@ -82,6 +100,8 @@ namespace strumpack {
     using Reord_t = MatrixReordering<scalar_t,integer_t>;
     using DenseM_t = DenseMatrix<scalar_t>;
     using DenseMW_t = DenseMatrixWrapper<scalar_t>;
+    using real_t = typename RealType<scalar_t>::value_type;
+    using RealDenseM_t = DenseMatrix<real_t>;
 
   public:
 
@@ -167,6 +187,26 @@ namespace strumpack {
      */
     ReturnCode reorder(const int* p, int base=0);
 
+    /**
+     * Perform sparse matrix reordering, using geometric nested
+     * dissection based on the coordinates of the unknowns, for
+     * instance the nodes of an unstructured finite element
+     * mesh. Each subdomain is split along its principal (inertial)
+     * axis, and the separator is then refined using the sparsity
+     * graph. This is typically much faster than Metis or Scotch,
+     * with comparable fill. Using this will ignore the reordering
+     * method selected in the options struct. The nd_param option is
+     * used as the minimum size of a subdomain.
+     *
+     * \param coords d x N matrix, where d is the number of spatial
+     * dimensions, column i contains the coordinates of unknown i.
+     * For the distributed solver (SparseSolverMPIDist), this should
+     * only hold the coordinates of the locally owned rows, so it
+     * should be d x N_local.
+     * \return error code
+     */
+    ReturnCode reorder(const RealDenseM_t& coords);
+
     /**
      * Perform numerical factorization of the sparse input matrix.
      *
@@ -278,6 +318,64 @@ namespace strumpack {
                      scalar_t* x, int ldx,
                      bool use_initial_guess=false);
 
+    /**
+     * Solve a linear system with the transpose, op(A) = A^T, or the
+     * conjugate transpose, op(A) = A^H, of the input matrix, with a
+     * single right-hand side. This reuses the factorization of A, no
+     * additional factorization is performed. If op is Trans::N, this
+     * is the same as solve(b, x, use_initial_guess).
+     *
+     * This is currently supported for the sequential/multithreaded
+     * solver, without compression or with BLR compression. In other
+     * cases, ReturnCode::NOT_SUPPORTED is returned.
+     *
+     * \param op Trans::N, Trans::T or Trans::C
+     * \param b input, will not be modified. Pointer to the right-hand
+     * side, see solve(const scalar_t*, scalar_t*, bool).
+     * \param x Output, pointer to the solution vector.
+     * \param use_initial_guess set to true if x contains an intial
+     * guess to the solution.
+     * \return error code
+     * \see solve(const scalar_t*, scalar_t*, bool)
+     */
+    ReturnCode solve(Trans op, const scalar_t* b, scalar_t* x,
+                     bool use_initial_guess=false);
+
+    /**
+     * Solve a linear system op(A) X = B, with op(A) = A, A^T or A^H,
+     * with a single or multiple right-hand sides.
+     *
+     * \param op Trans::N, Trans::T or Trans::C
+     * \param b input, will not be modified, see
+     * solve(const DenseM_t&, DenseM_t&, bool)
+     * \param x Output, solution
+     * \param use_initial_guess set to true if x contains an intial
+     * guess to the solution.
+     * \return error code
+     * \see solve(Trans, const scalar_t*, scalar_t*, bool)
+     */
+    ReturnCode solve(Trans op, const DenseM_t& b, DenseM_t& x,
+                     bool use_initial_guess=false);
+
+    /**
+     * Solve a linear system op(A) X = B, with op(A) = A, A^T or A^H,
+     * with a single or multiple right-hand sides.
+     *
+     * \param op Trans::N, Trans::T or Trans::C
+     * \param nrhs Number of right hand sides.
+     * \param b input, will not be modified
+     * \param ldb leading dimension of b
+     * \param x Output, pointer to the solution vector.
+     * \param ldx leading dimension of x
+     * \param use_initial_guess set to true if x contains an intial
+     * guess to the solution.
+     * \return error code
+     * \see solve(Trans, const scalar_t*, scalar_t*, bool)
+     */
+    ReturnCode solve(Trans op, int nrhs, const scalar_t* b, int ldb,
+                     scalar_t* x, int ldx,
+                     bool use_initial_guess=false);
+
     /**
      * Return the object holding the options for this sparse solver.
      */
@@ -324,6 +422,16 @@ namespace strumpack {
      */
     std::size_t factor_nonzeros() const;
 
+    /**
+     * Return the number of fronts of each type, and the number of
+     * fronts removed by amalgamation, see
+     * SPOptions::set_amalgamation_ratio. This should be called after
+     * the reordering phase. For the SparseSolverMPIDist distributed
+     * memory solver, this routine is collective on the MPI
+     * communicator.
+     */
+    FrontCounter front_counter() const;
+
     /**
      * Return the amount of memory taken by the sparse factorization
      * factors. This is the fill-in. It is simply computed as
@@ -389,13 +497,72 @@ namespace strumpack {
      */
     void delete_factors();
 
+    /**
+     * Return the performance report of this solver object, with the
+     * time spent in each phase of the solver (reordering, symbolic
+     * factorization, numerical factorization and solve) and the
+     * increase of the performance counters (flops, bytes moved,
+     * memory, ..) during that phase, accumulated over all calls.
+     * The counters only include the work done by this solver object,
+     * also when other solver objects are used concurrently in the
+     * same process. The counters are only updated when STRUMPACK is
+     * configured with STRUMPACK_COUNT_FLOPS.
+     *
+     * \see PerfReport, reset_performance_report
+     */
+    const PerfReport& performance_report() const { return perf_report_; }
+
+    /**
+     * Reset all timings and counters in the performance report.
+     */
+    void reset_performance_report() { perf_report_.clear(); }
+
+    /**
+     * Write the complete factorization (permutations, scaling,
+     * separator tree and the factors of all fronts) to a binary
+     * file. If the matrix was not factored yet, this will call
+     * factor(). The file can later be loaded with load_factors, to
+     * solve without refactoring. The file format is only portable
+     * between builds with the same scalar and integer types and the
+     * same byte order.
+     *
+     * This is currently supported for the sequential/multithreaded
+     * solver, with dense, BLR, HSS or lossy compressed fronts.
+     *
+     * \param fname name of the file to write
+     * \return error code, FILE_ERROR if the file could not be
+     * written, NOT_SUPPORTED for solvers or fronts that cannot be
+     * saved
+     * \see load_factors
+     */
+    ReturnCode save_factors(const std::string& fname);
+
+    /**
+     * Load a factorization written by save_factors. The same matrix
+     * (or a matrix with the same sparsity pattern and values) must
+     * already be set, with set_matrix or set_csr_matrix, since it is
+     * still used in the solve phase, for instance for iterative
+     * refinement. The reordering, scaling and factorization phases
+     * are skipped. The file is memory mapped and dense and BLR
+     * factors are used directly from the mapping, so the file should
+     * not be modified while it is in use, i.e., until the factors are
+     * deleted or recomputed.
+     *
+     * \param fname name of a file written by save_factors
+     * \return error code, FILE_ERROR if the file could not be read
+     * or does not match the matrix
+     * \see save_factors
+     */
+    ReturnCode load_factors(const std::string& fname);
+
   protected:
     virtual void setup_tree() = 0;
     virtual void setup_reordering() = 0;
     virtual
     int compute_reordering(const int* p, int base,
                            int nx, int ny, int nz,
-                           int components, int width) = 0;
+                           int components, int width,
+                           const RealDenseM_t* coords) = 0;
     virtual void separator_reordering() = 0;
 
     virtual SpMat_t* matrix() = 0;
@@ -406,8 +573,27 @@ namespace strumpack {
     virtual const Reord_t* reordering() const = 0;
     virtual const Tree_t* tree() const = 0;
 
-    virtual void perf_counters_start();
-    virtual void perf_counters_stop(const std::string& s);
+    virtual PerfReport::Mark perf_counters_start(SolverPhase p);
+    virtual void perf_counters_stop(const PerfReport::Mark& m,
+                                    const std::string& s);
+
+    /**
+     * For the duration of a call: sets the number of OpenMP threads
+     * for the calling thread, see SPOptions::set_num_threads, and
+     * activates the performance counters of this solver, or the
+     * counters c if given, and the trace session of this solver if
+     * a trace file was set.
+     */
+    class CallScope {
+    public:
+      CallScope(const SparseSolverBase<scalar_t,integer_t>& s,
+                const std::shared_ptr<PerfCounterSet>& c=nullptr);
+      ~CallScope();
+    private:
+      int threads_ = 0;
+      std::unique_ptr<TraceSessionScope> trace_;
+      std::unique_ptr<PerfCounterScope> counters_;
+    };
 
     virtual void synchronize() {}
     virtual void communicate_ordering() {}
@@ -438,6 +624,9 @@ namespace strumpack {
     ReturnCode solve_internal(int nrhs, const scalar_t* b, int ldb,
                               scalar_t* x, int ldx,
                               bool use_initial_guess=false);
+    virtual
+    ReturnCode solve_internal(Trans op, const DenseM_t& b, DenseM_t& x,
+                              bool use_initial_guess=false);
 
     SPOptions<scalar_t> opts_;
     bool is_root_;
@@ -447,17 +636,32 @@ namespace strumpack {
 
     std::new_handler old_handler_;
     std::ostream* rank_out_ = nullptr;
-    bool factored_ = false;
-    bool reordered_ = false;
-    int Krylov_its_ = 0;
+    std::atomic<bool> factored_{false}, reordered_{false};
+    std::atomic<int> Krylov_its_{0};
+
+    // serializes the lazy reorder/factor in solve, and the solves
+    // which cannot run concurrently
+    std::mutex solve_mtx_;
+    // serializes the statistics (ftot_, ..) and their output, for
+    // concurrent solves
+    std::mutex stats_mtx_;
+
+    // counters updated by all threads working for this solver, see
+    // PerfCounterScope
+    std::shared_ptr<PerfCounterSet> counters_ =
+      std::make_shared<PerfCounterSet>();
+    PerfReport perf_report_;
+
+    // the events traced for this solver, see SPOptions::set_trace_file
+    TraceSession trace_;
 
 #if defined(STRUMPACK_USE_PAPI)
     float rtime_ = 0., ptime_ = 0.;
     long_long _flpops = 0;
 #endif
 #if defined(STRUMPACK_COUNT_FLOPS)
-    long long int f0_ = 0, ftot_ = 0, fmin_ = 0, fmax_ = 0;
-    long long int b0_ = 0, btot_ = 0, bmin_ = 0, bmax_ = 0;
+    long long int ftot_ = 0, fmin_ = 0, fmax_ = 0;
+    long long int btot_ = 0, bmin_ = 0, bmax_ = 0;
     long long int m0_ = 0, mtot_ = 0, mmin_ = 0, mmax_ = 0;
     long long int ptot_ = 0, pmin_ = 0, pmax_ = 0;
     long long int dm0_ = 0, dmtot_ = 0, dmmin_ = 0, dmmax_ = 0;
@@ -467,9 +671,14 @@ namespace strumpack {
   private:
     ReturnCode reorder_internal(const int* p, int base,
                                 int nx, int ny, int nz,
-                                int components, int width);
+                                int components, int width,
+                                const RealDenseM_t* coords=nullptr);
 
     virtual void delete_factors_internal() = 0;
+    virtual bool save_factors_internal(FactorFileWriter& f) const
+    { return false; }
+    virtual bool load_factors_internal
+    (const std::shared_ptr<FactorFileReader>& f) { return false; }
   };
 
   template<typename scalar_t,typename integer_t>
@@ -43,7 +43,14 @@ namespace strumpack {
 
   template<typename scalar_t,typename integer_t>
   SparseSolverMPIDist<scalar_t,integer_t>::
-  ~SparseSolverMPIDist() = default;
+  ~SparseSolverMPIDist() {
+    if (!opts_.trace_file().empty()) {
+      int finalized;
+      MPI_Finalized(&finalized);
+      if (!finalized)
+        trace_.write(opts_.trace_file(), comm_);
+    }
+  }
 
   template<typename scalar_t,typename integer_t>
   SparseSolverMPIDist<scalar_t,integer_t>::
@@ -201,8 +208,11 @@ namespace strumpack {
   template<typename scalar_t,typename integer_t> int
   SparseSolverMPIDist<scalar_t,integer_t>::compute_reordering
   (const int* p, int base, int nx, int ny, int nz,
-   int components, int width) {
+   int components, int width, const RealDenseM_t* coords) {
     if (p) return nd_mpi_->set_permutation(opts_, *mat_mpi_, p, base);
+    if (coords)
+      return nd_mpi_->coordinate_nested_dissection
+        (opts_, *mat_mpi_, *coords);
     return nd_mpi_->nested_dissection
       (opts_, *mat_mpi_, nx, ny, nz, components, width);
   }
@@ -248,6 +258,11 @@ namespace strumpack {
   (const DenseM_t& b, DenseM_t& x, bool use_initial_guess) {
     using real_t = typename RealType<scalar_t>::value_type;
 
+    // the MPI collectives and the exchange patterns of the
+    // distributed fronts are not thread safe, so concurrent solves on
+    // the same object are serialized
+    std::lock_guard<std::mutex> lock(this->solve_mtx_);
+
     // reordering has to be called, even for the iterative solvers
     if (!this->reordered_) {
       ReturnCode ierr = this->reorder();
@@ -267,13 +282,13 @@ namespace strumpack {
     assert(b.rows() == x.rows());
     assert(b.cols() == x.cols());
     TaskTimer t("solve");
-    this->perf_counters_start();
+    auto mark = this->perf_counters_start(SolverPhase::SOLVE);
     t.start();
     auto nloc = x.rows();
-    this->Krylov_its_ = 0;
+    int its = 0;
 
     auto bloc = b;
-    if (opts_.matching() == MatchingJob::MAX_DIAGONAL_PRODUCT_SCALING)
+    if (this->matching_.job == MatchingJob::MAX_DIAGONAL_PRODUCT_SCALING)
       bloc.scale_rows_real(this->matching_.R);
     if (this->equil_.type == EquilibrationType::ROW ||
         this->equil_.type == EquilibrationType::BOTH)
@@ -281,7 +296,7 @@ namespace strumpack {
 
     if (use_initial_guess &&
         opts_.Krylov_solver() != KrylovSolver::DIRECT) {
-      if (opts_.matching() == MatchingJob::MAX_DIAGONAL_PRODUCT_SCALING ||
+      if (this->matching_.job == MatchingJob::MAX_DIAGONAL_PRODUCT_SCALING ||
           this->equil_.type == EquilibrationType::COLUMN ||
           this->equil_.type == EquilibrationType::BOTH) {
         std::vector<real_t> C(nloc, 1.);
@@ -289,7 +304,7 @@ namespace strumpack {
             this->equil_.type == EquilibrationType::BOTH)
           for (std::size_t i=0; i<nloc; i++)
             C[i] /= this->equil_.C[i + mat_mpi_->begin_row()];
-        if (opts_.matching() == MatchingJob::MAX_DIAGONAL_PRODUCT_SCALING)
+        if (this->matching_.job == MatchingJob::MAX_DIAGONAL_PRODUCT_SCALING)
           for (std::size_t i=0; i<nloc; i++)
             C[i] /= this->matching_.C[i + mat_mpi_->begin_row()];
         x.scale_rows_real(C);
@@ -308,7 +323,7 @@ namespace strumpack {
         iterative::GMResMPI<scalar_t>
           (comm_, spmv, prec, nloc, x.data(), bloc.data(),
            opts_.rel_tol(), opts_.abs_tol(),
-           this->Krylov_its_, opts_.maxit(),
+           its, opts_.maxit(),
            opts_.gmres_restart(), opts_.GramSchmidt_type(),
            use_initial_guess, opts_.verbose() && is_root_);
       };
@@ -318,7 +333,7 @@ namespace strumpack {
         iterative::BiCGStabMPI<scalar_t>
           (comm_, spmv, prec, nloc, x.data(), bloc.data(),
            opts_.rel_tol(), opts_.abs_tol(),
-           this->Krylov_its_, opts_.maxit(),
+           its, opts_.maxit(),
            use_initial_guess, opts_.verbose() && is_root_);
       };
     auto MFsolve =
@@ -333,7 +348,7 @@ namespace strumpack {
            [&](DenseM_t& w) {
              tree()->multifrontal_solve_dist(w, mat_mpi_->dist()); },
            x, bloc, opts_.rel_tol(), opts_.abs_tol(),
-           this->Krylov_its_, opts_.maxit(),
+           its, opts_.maxit(),
            use_initial_guess, opts_.verbose() && is_root_);
       };
 
@@ -358,6 +373,15 @@ namespace strumpack {
     case KrylovSolver::PREC_BICGSTAB: {
       bicgstab(MFsolve);
     }; break;
+    case KrylovSolver::PREC_BLOCK_GMRES: {
+      // the block solvers are not distributed, use the column-wise
+      // distributed solvers instead
+      if (x.cols() == 1) gmres(MFsolve);
+      else refine();
+    }; break;
+    case KrylovSolver::BLOCK_REFINE: {
+      refine();
+    }; break;
     case KrylovSolver::DIRECT: {
       // TODO bloc is already a copy, avoid extra copy?
       x = bloc;
@@ -368,14 +392,16 @@ namespace strumpack {
     if (this->equil_.type == EquilibrationType::COLUMN ||
         this->equil_.type == EquilibrationType::BOTH)
       x.scale_rows_real(this->equil_.C.data() + mat_mpi_->begin_row());
-    if (opts_.matching() != MatchingJob::NONE) {
+    if (this->matching_.job != MatchingJob::NONE) {
       permute_vector(x, this->matching_.Q, mat_mpi_->dist(), comm_);
-      if (opts_.matching() == MatchingJob::MAX_DIAGONAL_PRODUCT_SCALING)
+      if (this->matching_.job == MatchingJob::MAX_DIAGONAL_PRODUCT_SCALING)
         x.scale_rows_real(this->matching_.C.data() + mat_mpi_->begin_row());
     }
 
+    this->Krylov_its_ = its;
+
     t.stop();
-    this->perf_counters_stop("DIRECT/GMRES solve");
+    this->perf_counters_stop(mark, "DIRECT/GMRES solve");
     this->print_solve_stats(t);
     return ReturnCode::SUCCESS;
   }
@@ -391,7 +417,8 @@ namespace strumpack {
 
   template<typename scalar_t,typename integer_t> void
   SparseSolverMPIDist<scalar_t,integer_t>::perf_counters_stop
-  (const std::string& s) {
+  (const PerfReport::Mark& m, const std::string& s) {
+    this->perf_report_.stop(m, PerfCounterSet::active());
     if (opts_.verbose()) {
 #if defined(STRUMPACK_USE_PAPI)
       float rtime1=0., ptime1=0., mflops=0.;
@@ -417,8 +444,9 @@ namespace strumpack {
       }
 #endif
 #if defined(STRUMPACK_COUNT_FLOPS)
-      auto df = params::flops - this->f0_;
-      long long int flopsbytes[2] = {df, params::bytes_moved - this->b0_};
+      auto df = params::flops - m.counts[int(PerfCounterType::FLOPS)];
+      long long int flopsbytes[2] =
+        {df, params::bytes_moved - m.counts[int(PerfCounterType::BYTES_MOVED)]};
       comm_.all_reduce(flopsbytes, 2, MPI_SUM);
       this->ftot_ = flopsbytes[0];
       this->btot_ = flopsbytes[1];
@@ -77,6 +77,10 @@ namespace strumpack {
         solve_func(wx);
       };
     auto spmv = [&](const refine_t* x, refine_t* y) { mat_.spmv(x, y); };
+    using real_t = typename RealType<refine_t>::value_type;
+    iterative::BSPMV<refine_t> bspmv =
+      [&](const DenseMatrix<refine_t>& v, DenseMatrix<refine_t>& w) {
+        mat_.spmv(v, w); };
 
     auto old_verbose = solver_.options().verbose();
     solver_.options().set_verbose(false);
@@ -118,6 +122,22 @@ namespace strumpack {
          opts_.rel_tol(), opts_.abs_tol(), Krylov_its_, opts_.maxit(),
          use_initial_guess, opts_.verbose());
     }; break;
+    case KrylovSolver::PREC_BLOCK_GMRES: {
+      iterative::BlockGMRes<refine_t>
+        (bspmv, solve_func, x, b, opts_.rel_tol(), opts_.abs_tol(),
+         Krylov_its_, opts_.maxit(), opts_.gmres_restart(),
+         opts_.GramSchmidt_type(), use_initial_guess, opts_.verbose());
+    }; break;
+    case KrylovSolver::BLOCK_REFINE: {
+      std::function<real_t(const DenseMatrix<refine_t>&,
+                           const DenseMatrix<refine_t>&)> bw_error =
+        [&](const DenseMatrix<refine_t>& v, const DenseMatrix<refine_t>& w) {
+          return mat_.max_scaled_residual(v, w); };
+      iterative::BlockIterativeRefinement<refine_t>
+        (bspmv, bw_error, solve_func, x, b, opts_.rel_tol(),
+         opts_.abs_tol(), Krylov_its_, opts_.maxit(), use_initial_guess,
+         opts_.verbose());
+    }; break;
     case KrylovSolver::GMRES:
     case KrylovSolver::BICGSTAB: {
       std::cerr << "ERROR: non-preconditioned solvers not supported "
@@ -100,6 +100,9 @@ namespace strumpack {
       copy(b, x, 0, 0);
       solve_func(x);
     }; break;
+    case KrylovSolver::PREC_BLOCK_GMRES:
+    case KrylovSolver::BLOCK_REFINE:
+      // block solvers are not distributed, fall back to refinement
     case KrylovSolver::REFINE: {
       iterative::IterativeRefinementMPI<refine_t,integer_t>
         (solver_.Comm(), mat_, solve_func, x, b,
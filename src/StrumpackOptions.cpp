@@ -52,6 +52,7 @@ namespace strumpack {
     case ReorderingStrategy::AND: return "AND";
     case ReorderingStrategy::MLF: return "MLF";
     case ReorderingStrategy::SPECTRAL: return "Spectral";
+    case ReorderingStrategy::ND: return "ND";
     }
     return "UNKNOWN";
   }
@@ -70,6 +71,7 @@ namespace strumpack {
     case ReorderingStrategy::AND: return false;
     case ReorderingStrategy::MLF: return false;
     case ReorderingStrategy::SPECTRAL: return false;
+    case ReorderingStrategy::ND: return false;
     }
     return false;
   }
@@ -88,8 +90,17 @@ namespace strumpack {
     return "UNKNOWN";
   }
 
+  std::string get_name(MatrixSymmetry sym) {
+    switch (sym) {
+    case MatrixSymmetry::UNSYMMETRIC: return "unsymmetric";
+    case MatrixSymmetry::SYMMETRIC: return "symmetric";
+    case MatrixSymmetry::POSITIVE_DEFINITE: return "positive_definite";
+    }
+    return "UNKNOWN";
+  }
+
   MatchingJob get_matching(int job) {
-    if (job < 0 || job > 6)
+    if (job < 0 || job > 7)
       std::cerr << "ERROR: Matching job not recognized!!" << std::endl;
     return static_cast<MatchingJob>(job);
   }
@@ -109,6 +120,8 @@ namespace strumpack {
       return "maximum matching with row and column scaling";
     case MatchingJob::COMBBLAS:
       return "approximate weighted perfect matching, from CombBLAS";
+    case MatchingJob::APPROX_DIAGONAL_PRODUCT_SCALING:
+      return "approximate maximum matching with row and column scaling";
     }
     return "UNKNOWN";
   }
@@ -185,6 +198,18 @@ namespace strumpack {
        {"sp_proportional_mapping",      required_argument, 0, 50},
        {"sp_enable_openmp_tree",        no_argument, 0, 51},
        {"sp_disable_openmp_tree",       no_argument, 0, 52},
+       {"sp_matrix_symmetry",           required_argument, 0, 53},
+       {"sp_amalgamation_ratio",        required_argument, 0, 54},
+       {"sp_amalgamation_size",         required_argument, 0, 55},
+       {"sp_enable_numeric_refactorization", no_argument, 0, 56},
+       {"sp_disable_numeric_refactorization", no_argument, 0, 57},
+       {"sp_out_of_core_path",          required_argument, 0, 58},
+       {"sp_num_threads",               required_argument, 0, 59},
+       {"sp_trace_file",                required_argument, 0, 60},
+       {"sp_enable_static_tree_mapping", no_argument, 0, 61},
+       {"sp_disable_static_tree_mapping", no_argument, 0, 62},
+       {"sp_enable_small_front_batching", no_argument, 0, 63},
+       {"sp_disable_small_front_batching", no_argument, 0, 64},
        {"sp_verbose",                   no_argument, 0, 'v'},
        {"sp_quiet",                     no_argument, 0, 'q'},
        {"help",                         no_argument, 0, 'h'},
@@ -221,6 +246,8 @@ namespace strumpack {
         else if (s == "gmres") set_Krylov_solver(KrylovSolver::GMRES);
         else if (s == "pbicgstab") set_Krylov_solver(KrylovSolver::PREC_BICGSTAB);
         else if (s == "bicgstab") set_Krylov_solver(KrylovSolver::BICGSTAB);
+        else if (s == "pbgmres") set_Krylov_solver(KrylovSolver::PREC_BLOCK_GMRES);
+        else if (s == "brefinement") set_Krylov_solver(KrylovSolver::BLOCK_REFINE);
         else std::cerr << "# WARNING: Krylov solver not recognized,"
                " using default" << std::endl;
       } break;
@@ -252,9 +279,11 @@ namespace strumpack {
         else if (s == "mlf") set_reordering_method(ReorderingStrategy::MLF);
         else if (s == "and") set_reordering_method(ReorderingStrategy::AND);
         else if (s == "spectral") set_reordering_method(ReorderingStrategy::SPECTRAL);
+        else if (s == "nd") set_reordering_method(ReorderingStrategy::ND);
         else std::cerr << "# WARNING: matrix reordering strategy not"
                " recognized, use 'metis', 'parmetis', 'scotch', 'ptscotch',"
-               " 'rcm', 'geometric', 'amd', 'mmd', 'mlf', 'and' or 'spectral'"
+               " 'rcm', 'geometric', 'amd', 'mmd', 'mlf', 'and', 'spectral'"
+               " or 'nd'"
                        << std::endl;
       } break;
       case 8: {
@@ -428,6 +457,41 @@ namespace strumpack {
       } break;
       case 51: enable_openmp_tree(); break;
       case 52: disable_openmp_tree(); break;
+      case 53: {
+        std::string s; std::istringstream iss(optarg); iss >> s;
+        if (s == "unsymmetric")
+          set_matrix_symmetry(MatrixSymmetry::UNSYMMETRIC);
+        else if (s == "symmetric")
+          set_matrix_symmetry(MatrixSymmetry::SYMMETRIC);
+        else if (s == "positive_definite" || s == "spd")
+          set_matrix_symmetry(MatrixSymmetry::POSITIVE_DEFINITE);
+        else std::cerr << "# WARNING: matrix symmetry not recognized,"
+               " use 'unsymmetric', 'symmetric' or 'positive_definite'"
+                       << std::endl;
+      } break;
+      case 54: {
+        std::istringstream iss(optarg);
+        iss >> amalg_ratio_;
+        set_amalgamation_ratio(amalg_ratio_);
+      } break;
+      case 55: {
+        std::istringstream iss(optarg);
+        iss >> amalg_size_;
+        set_amalgamation_size(amalg_size_);
+      } break;
+      case 56: { enable_numeric_refactorization(); } break;
+      case 57: { disable_numeric_refactorization(); } break;
+      case 58: { set_out_of_core_path(optarg); } break;
+      case 59: {
+        std::istringstream iss(optarg);
+        iss >> num_threads_;
+        set_num_threads(num_threads_);
+      } break;
+      case 60: { set_trace_file(optarg); } break;
+      case 61: enable_static_tree_mapping(); break;
+      case 62: disable_static_tree_mapping(); break;
+      case 63: enable_small_front_batching(); break;
+      case 64: disable_small_front_batching(); break;
       case 'h': { describe_options(); } break;
       case 'v': set_verbose(true); break;
       case 'q': set_verbose(false); break;
@@ -468,9 +532,13 @@ namespace strumpack {
     std::cout << "#          Krylov absolute (preconditioned) residual"
               << " stopping tolerance" << std::endl;
     std::cout << "#   --sp_Krylov_solver [auto|direct|refinement|pgmres|"
-              << "gmres|pbicgstab|bicgstab]" << std::endl;
+              << "gmres|pbicgstab|bicgstab|pbgmres|brefinement]" << std::endl;
     std::cout << "#          default: auto (refinement when using compression, pgmres"
               << " (preconditioned) with compression)" << std::endl;
+    std::cout << "#          pbgmres: preconditioned block GMRes, for"
+              << " multiple right-hand sides" << std::endl;
+    std::cout << "#          brefinement: refinement with per column"
+              << " convergence" << std::endl;
     std::cout << "#   --sp_gmres_restart int (default " << gmres_restart()
               << ")" << std::endl;
     std::cout << "#          gmres restart length" << std::endl;
@@ -478,7 +546,7 @@ namespace strumpack {
               << std::endl;
     std::cout << "#          Gram-Schmidt type for GMRES" << std::endl;
     std::cout << "#   --sp_reordering_method [natural|metis|scotch|parmetis|"
-              << "ptscotch|rcm|geometric|amd|mmd|mlf|and|spectral]" << std::endl;
+              << "ptscotch|rcm|geometric|amd|mmd|mlf|and|spectral|nd]" << std::endl;
     std::cout << "#          Select a fill-reducing ordering algorithm." << std::endl;
     std::cout << "#          Geometric only works on regular meshes and you"
               << " need to provide the sizes." << std::endl;
@@ -521,9 +589,9 @@ namespace strumpack {
               << std::boolalpha << use_agg_amalg() << ")" << std::endl;
     std::cout << "#   --sp_disable_agg_amalg (default "
               << std::boolalpha << !use_agg_amalg() << ")" << std::endl;
-    std::cout << "#   --sp_matching int [0-6] (default "
+    std::cout << "#   --sp_matching int [0-7] (default "
               << static_cast<int>(matching()) << ")" << std::endl;
-    for (int i=0; i<7; i++)
+    for (int i=0; i<8; i++)
       std::cout << "#      " << i << " " <<
         get_description(get_matching(i)) << std::endl;
     std::cout << "#   --sp_compression (default "
@@ -569,6 +637,48 @@ namespace strumpack {
               << std::boolalpha << !use_openmp_tree_ << ")" << std::endl
               << "#          uses less more memory, but scales worse with OpenMP threads"
               << std::endl;
+    std::cout << "#   --sp_enable_static_tree_mapping (default "
+              << std::boolalpha << use_static_tree_map_ << ")" << std::endl
+              << "#          map subtrees to threads, using --sp_proportional_mapping"
+              << std::endl;
+    std::cout << "#   --sp_disable_static_tree_mapping (default "
+              << std::boolalpha << !use_static_tree_map_ << ")" << std::endl
+              << "#          schedule subtrees dynamically as OpenMP tasks"
+              << std::endl;
+    std::cout << "#   --sp_enable_small_front_batching (default "
+              << std::boolalpha << batch_small_fronts_ << ")" << std::endl
+              << "#          factor small dense subtrees with batched kernels"
+              << std::endl;
+    std::cout << "#   --sp_disable_small_front_batching (default "
+              << std::boolalpha << !batch_small_fronts_ << ")" << std::endl
+              << "#          factor every dense front with LAPACK/BLAS"
+              << std::endl;
+    std::cout << "#   --sp_matrix_symmetry [unsymmetric|symmetric|positive_definite]"
+              << " (default " << get_name(sym_) << ")" << std::endl
+              << "#          use LU, LDL^T or Cholesky for the dense fronts"
+              << std::endl;
+    std::cout << "#   --sp_amalgamation_ratio (default "
+              << amalgamation_ratio() << ")" << std::endl
+              << "#          max ratio of explicit zeros for merging fronts"
+              << std::endl;
+    std::cout << "#   --sp_amalgamation_size (default "
+              << amalgamation_size() << ")" << std::endl
+              << "#          always merge fronts up to this separator size"
+              << std::endl;
+    std::cout << "#   --sp_enable_numeric_refactorization" << std::endl
+              << "#          keep index maps and front storage for"
+              << " refactorization" << std::endl;
+    std::cout << "#   --sp_disable_numeric_refactorization" << std::endl;
+    std::cout << "#   --sp_out_of_core_path [dir] (default none)" << std::endl
+              << "#          store the dense factors in a file in dir"
+              << std::endl;
+    std::cout << "#   --sp_num_threads (default "
+              << num_threads() << ")" << std::endl
+              << "#          OpenMP threads for this solver, 0 for all"
+              << std::endl;
+    std::cout << "#   --sp_trace_file [file] (default none)" << std::endl
+              << "#          write a Chrome/Perfetto JSON trace to file"
+              << std::endl;
     std::cout << "#   --sp_lossy_precision [1-64] (default "
               << lossy_precision() << ")" << std::endl
               << "#          lossy compression precision" << std::endl
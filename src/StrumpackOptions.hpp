@@ -34,6 +34,7 @@
 
 #include <limits>
 #include <cstdlib>
+#include <string>
 
 #include "dense/BLASLAPACKWrapper.hpp"
 #include "HSS/HSSOptions.hpp"
@@ -71,7 +72,9 @@ namespace strumpack {
     MMD,        /*!< Multiple minimum degree                        */
     AND,        /*!< Nested dissection                              */
     MLF,        /*!< Minimum local fill                             */
-    SPECTRAL    /*!< Spectral nested dissection                     */
+    SPECTRAL,   /*!< Spectral nested dissection                     */
+    ND          /*!< Built-in multilevel, multithreaded nested
+                  dissection, does not require Metis                */
   };
 
   /**
@@ -112,6 +115,28 @@ namespace strumpack {
   std::string get_name(CompressionType comp);
 
 
+  /**
+   * Enumeration of the symmetry properties of the sparse matrix that
+   * can be exploited by the (dense) frontal matrix factorization.
+   * \ingroup Enumerations
+   */
+  enum class MatrixSymmetry {
+    UNSYMMETRIC,        /*!< General matrix, LU factorization with
+                          partial pivoting in the fronts          */
+    SYMMETRIC,          /*!< Symmetric (A = A^T) possibly indefinite,
+                          Bunch-Kaufman LDL^T in the fronts, only
+                          the lower triangle is stored            */
+    POSITIVE_DEFINITE   /*!< Symmetric/Hermitian positive definite,
+                          Cholesky LL^H in the fronts, only the
+                          lower triangle is stored                */
+  };
+
+  /**
+   * Return a name/string for the MatrixSymmetry.
+   */
+  std::string get_name(MatrixSymmetry sym);
+
+
   /**
    * Enumeration of possible matching algorithms, used for permutation
    * of the sparse matrix to improve stability.
@@ -126,7 +151,11 @@ namespace strumpack {
     MAX_DIAGONAL_SUM,             /*!< Maximum sum of diagonal values      */
     MAX_DIAGONAL_PRODUCT_SCALING, /*!< Maximum product of diagonal values
                                     and row and column scaling             */
-    COMBBLAS                      /*!< Use AWPM from CombBLAS              */
+    COMBBLAS,                     /*!< Use AWPM from CombBLAS              */
+    APPROX_DIAGONAL_PRODUCT_SCALING /*!< Approximate maximum product of
+                                      diagonal values and row and column
+                                      scaling, distributed auction
+                                      algorithm (MC64 when sequential) */
   };
 
   enum class EquilibrationType : char
@@ -174,7 +203,13 @@ namespace strumpack {
     GMRES,          /*!< UN-preconditioned GMRes. (for testing mainly)      */
     PREC_BICGSTAB,  /*!< Preconditioned BiCGStab. The preconditioner is the
                       (approx) multifrontal solver.                         */
-    BICGSTAB        /*!< UN-preconditioned BiCGStab. (for testing mainly)   */
+    BICGSTAB,       /*!< UN-preconditioned BiCGStab. (for testing mainly)   */
+    PREC_BLOCK_GMRES, /*!< Preconditioned block GMRes, for all right-hand
+                        sides at once, with deflation of converged
+                        columns. The preconditioner is the (approx)
+                        multifrontal solver.                                 */
+    BLOCK_REFINE    /*!< Iterative refinement, with per column
+                      convergence and deflation of converged columns.     */
   };
 
   /**
@@ -322,7 +357,9 @@ namespace strumpack {
      * STRUMPACK needs to be configured with support for those
      * libraries. Some reorderings only work when using the
      * distributed memory solvers (StrumpackSparseSolverMPI or
-     * StrumpackSparseSolverMPIDist).
+     * StrumpackSparseSolverMPIDist). The default is Metis, or the
+     * built-in nested dissection (ReorderingStrategy::ND) when
+     * STRUMPACK is configured without Metis.
      *
      * \param m fill reducing reordering
      */
@@ -768,6 +805,155 @@ namespace strumpack {
      */
     void disable_openmp_tree() { use_openmp_tree_ = false; }
 
+    /**
+     * Map the subtrees of the supernodal tree statically to the
+     * OpenMP threads, using proportional mapping with the cost model
+     * set with set_proportional_mapping(), instead of the dynamic
+     * scheduling of the subtrees as OpenMP tasks. This gives a more
+     * predictable peak memory usage.
+     * \see set_proportional_mapping(), enable_openmp_tree()
+     */
+    void enable_static_tree_mapping() { use_static_tree_map_ = true; }
+
+    /**
+     * Use dynamic scheduling of the subtrees of the supernodal tree
+     * over the OpenMP threads.
+     * \see enable_static_tree_mapping()
+     */
+    void disable_static_tree_mapping() { use_static_tree_map_ = false; }
+
+    /**
+     * Factor subtrees of small dense fronts level by level, with
+     * batched kernels for fronts with a small separator and update
+     * set, instead of calling LAPACK/BLAS per front. This is the
+     * default. Only used for LU.
+     * \see disable_small_front_batching()
+     */
+    void enable_small_front_batching() { batch_small_fronts_ = true; }
+
+    /**
+     * Factor all dense fronts with LAPACK/BLAS, one front at a time.
+     * \see enable_small_front_batching()
+     */
+    void disable_small_front_batching() { batch_small_fronts_ = false; }
+
+    /**
+     * Specify the symmetry of the matrix. For SYMMETRIC or
+     * POSITIVE_DEFINITE matrices, the dense frontal matrices are
+     * factored with LDL^T (Bunch-Kaufman) or Cholesky respectively,
+     * and only the lower triangular parts of the fronts are stored
+     * and updated. This halves the factor memory and flops. Fronts
+     * using compression (HSS, BLR, HODLR, ..) are not affected and
+     * still use LU. When the symmetry is set, the sparsity pattern
+     * of the input matrix is also assumed to be symmetric, see
+     * CompressedSparseMatrix::symm_sparse. Matching should be
+     * disabled, since it destroys the symmetry.
+     *
+     * \see set_matching
+     */
+    void set_matrix_symmetry(MatrixSymmetry sym) { sym_ = sym; }
+
+    /**
+     * Set the maximum ratio of explicit zeros for relaxed supernode
+     * amalgamation. After the symbolic factorization, the fronts of
+     * two leaf children are merged with their parent into a single
+     * front, when the number of explicitly stored zeros, added by
+     * this merging (accumulated over the merged subtree), is at most
+     * this ratio times the size of the merged front. This is applied
+     * bottom-up, so that small subtrees collapse into a single
+     * front. A value of 0 (the default) disables this criterion.
+     *
+     * \param r ratio of explicit zeros, >= 0
+     * \see set_amalgamation_size
+     */
+    void set_amalgamation_ratio(double r)
+    { assert(r >= 0.); amalg_ratio_ = r; }
+
+    /**
+     * Set the separator size below which fronts are always merged,
+     * see set_amalgamation_ratio. Children are merged with their
+     * parent if the separator of the merged front is at most this
+     * size, regardless of the added explicit zeros. A value of 0
+     * (the default) disables this criterion.
+     *
+     * \param s maximum separator size of an amalgamated front, >= 0
+     * \see set_amalgamation_ratio
+     */
+    void set_amalgamation_size(int s)
+    { assert(s >= 0); amalg_size_ = s; }
+
+    /**
+     * Enable numeric refactorization. This is useful when the
+     * solver is used for a sequence of matrices with the same
+     * sparsity pattern, see SparseSolver::update_matrix_values. On
+     * the first numerical factorization, the index maps used in the
+     * extend-add operations, and a plan to scatter the sparse matrix
+     * elements to the fronts, are computed and stored in the fronts,
+     * and the dense front storage (factors and the workspace for the
+     * contribution blocks) is kept allocated after the
+     * factorization. Subsequent factorizations then only redo the
+     * arithmetic. This requires some extra memory.
+     *
+     * \see disable_numeric_refactorization()
+     */
+    void enable_numeric_refactorization() { refactor_ = true; }
+
+    /**
+     * Disable numeric refactorization, this is the default.
+     *
+     * \see enable_numeric_refactorization()
+     */
+    void disable_numeric_refactorization() { refactor_ = false; }
+
+    /**
+     * Store the factors of the (dense) fronts out-of-core, in a
+     * temporary file in the directory path, for instance on a local
+     * disk or NVMe drive. During the factorization, the factors of a
+     * front are written by a background thread as soon as that front
+     * is factored, so that only the active fronts and contribution
+     * blocks stay in memory. The solve reads the factors back, with
+     * read-ahead in the order of the forward/backward solve. An
+     * empty path (the default) disables out-of-core storage. The
+     * factors of compressed (BLR, HSS, HODLR, lossy) fronts are kept
+     * in memory.
+     *
+     * \param path existing directory for the temporary file
+     * \see out_of_core(), out_of_core_path()
+     */
+    void set_out_of_core_path(const std::string& path) { ooc_path_ = path; }
+
+    /**
+     * Set the number of OpenMP threads used by this solver object,
+     * for the reordering, factorization and solve. By default (0),
+     * all threads of the calling thread's OpenMP thread pool are
+     * used, see omp_get_max_threads(). When multiple solver objects
+     * are used concurrently, from different (non OpenMP) threads,
+     * each calling thread gets its own OpenMP thread pool, and this
+     * can be used to divide the cores over the solvers.
+     *
+     * \param t number of threads, 0 for the default
+     * \see num_threads()
+     */
+    void set_num_threads(int t) { assert(t >= 0); num_threads_ = t; }
+
+    /**
+     * Record a trace of the reordering, factorization and solve, and
+     * write it to a file when the solver object is destroyed. For
+     * every front, the trace shows the factorization, extend-add,
+     * compression and solve, with the front dimensions, rank and
+     * level in the elimination tree, on a separate track for every
+     * thread and (with MPI) every rank. The file is in Chrome
+     * trace-event JSON format, to be opened in Perfetto
+     * (ui.perfetto.dev) or chrome://tracing. An empty name (the
+     * default) disables tracing.
+     *
+     * \param filename name of the JSON trace file
+     * \see trace_file(), Tracer
+     */
+    void set_trace_file(const std::string& filename) {
+      trace_file_ = filename;
+    }
+
     /**
      * Set the precision for lossy compression. Preferred mode is
      * accuracy. To use precision mode, set the accuracy to a negative
@@ -794,7 +980,9 @@ namespace strumpack {
     void set_print_compressed_front_stats(bool b) { print_comp_front_stats_ = b; }
 
     /**
-     * Set the type of proportional mapping.
+     * Set the type of proportional mapping, used for the mapping of
+     * the supernodal tree to the MPI processes, and to the threads
+     * if enable_static_tree_mapping() is set.
      */
     void set_proportional_mapping(ProportionalMapping pmap) { prop_map_ = pmap; }
 
@@ -1155,6 +1343,87 @@ namespace strumpack {
      */
     bool use_openmp_tree() const { return use_openmp_tree_; }
 
+    /**
+     * Check wheter the subtrees of the supernodal tree are mapped
+     * statically to the threads.
+     * \see enable_static_tree_mapping()
+     */
+    bool use_static_tree_mapping() const { return use_static_tree_map_; }
+
+    /**
+     * Check whether subtrees of small dense fronts are factored with
+     * the batched kernels.
+     * \see enable_small_front_batching()
+     */
+    bool small_front_batching() const { return batch_small_fronts_; }
+
+    /**
+     * Get the symmetry of the matrix, as specified by the user.
+     * \see set_matrix_symmetry()
+     */
+    MatrixSymmetry matrix_symmetry() const { return sym_; }
+
+    /**
+     * Get the maximum ratio of explicit zeros for relaxed supernode
+     * amalgamation.
+     * \see set_amalgamation_ratio()
+     */
+    double amalgamation_ratio() const { return amalg_ratio_; }
+
+    /**
+     * Get the separator size below which fronts are always
+     * amalgamated.
+     * \see set_amalgamation_size()
+     */
+    int amalgamation_size() const { return amalg_size_; }
+
+    /**
+     * Check whether relaxed supernode amalgamation is enabled.
+     * \see set_amalgamation_ratio(), set_amalgamation_size()
+     */
+    bool amalgamation() const
+    { return amalg_ratio_ > 0. || amalg_size_ > 0; }
+
+    /**
+     * Check whether numeric refactorization is enabled.
+     * \see enable_numeric_refactorization()
+     */
+    bool numeric_refactorization() const { return refactor_; }
+
+    /**
+     * Check whether the factors are stored out-of-core.
+     * \see set_out_of_core_path()
+     */
+    bool out_of_core() const { return !ooc_path_.empty(); }
+
+    /**
+     * Get the directory for the out-of-core factor storage, empty if
+     * the factors are stored in memory.
+     * \see set_out_of_core_path()
+     */
+    const std::string& out_of_core_path() const { return ooc_path_; }
+
+    /**
+     * Get the number of OpenMP threads to be used by this solver
+     * object, 0 means all threads in the OpenMP thread pool of the
+     * calling thread.
+     * \see set_num_threads()
+     */
+    int num_threads() const { return num_threads_; }
+
+    /**
+     * Get the name of the trace file, empty if tracing is disabled.
+     * \see set_trace_file()
+     */
+    const std::string& trace_file() const { return trace_file_; }
+
+    /**
+     * Check whether a symmetric factorization (LDL^T or Cholesky)
+     * should be used for the dense fronts.
+     * \see set_matrix_symmetry()
+     */
+    bool symmetric() const { return sym_ != MatrixSymmetry::UNSYMMETRIC; }
+
     /**
      * Returns the number of GPU streams to use.
      */
@@ -1277,7 +1546,11 @@ namespace strumpack {
     int gmres_restart_ = 30;
     GramSchmidtType Gram_Schmidt_type_ = GramSchmidtType::MODIFIED;
     /** Reordering options */
+#if defined(STRUMPACK_USE_METIS)
     ReorderingStrategy reordering_method_ = ReorderingStrategy::METIS;
+#else
+    ReorderingStrategy reordering_method_ = ReorderingStrategy::ND;
+#endif
     int nd_planar_levels_ = 0;
     int nd_param_ = 8;
     int nx_ = 1;
@@ -1296,6 +1569,13 @@ namespace strumpack {
     bool print_comp_front_stats_ = false;
     ProportionalMapping prop_map_ = ProportionalMapping::FLOPS;
     bool use_openmp_tree_ = true;
+    bool use_static_tree_map_ = false;
+    bool batch_small_fronts_ = true;
+    MatrixSymmetry sym_ = MatrixSymmetry::UNSYMMETRIC;
+    double amalg_ratio_ = 0.;
+    int amalg_size_ = 0;
+    bool refactor_ = false;
+    std::string ooc_path_;
 
     /** GPU options */
 #if defined(STRUMPACK_USE_GPU)
@@ -1306,6 +1586,12 @@ namespace strumpack {
     bool use_gpu_aware_mpi_ = std::getenv("STRUMPACK_GPU_AWARE_MPI");
     int gpu_streams_ = default_gpu_streams();
 
+    /** OpenMP threads, 0 for omp_get_max_threads() */
+    int num_threads_ = 0;
+
+    /** Chrome trace-event file, empty for no tracing */
+    std::string trace_file_;
+
     /** compression options */
     CompressionType comp_ = CompressionType::NONE;
 
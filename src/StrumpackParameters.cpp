@@ -43,35 +43,35 @@ namespace strumpack {
     int task_recursion_cutoff_level = 0;
 #endif
 
-    std::atomic<long long int> flops(0);
-    std::atomic<long long int> bytes_moved(0);
-    std::atomic<long long int> memory(0);
-    std::atomic<long long int> peak_memory(0);
-    std::atomic<long long int> device_memory(0);
-    std::atomic<long long int> peak_device_memory(0);
+    PerfCounter flops(PerfCounterType::FLOPS);
+    PerfCounter bytes_moved(PerfCounterType::BYTES_MOVED);
+    PerfCounter memory(PerfCounterType::MEMORY);
+    PerfCounter peak_memory(PerfCounterType::PEAK_MEMORY);
+    PerfCounter device_memory(PerfCounterType::DEVICE_MEMORY);
+    PerfCounter peak_device_memory(PerfCounterType::PEAK_DEVICE_MEMORY);
 
-    std::atomic<long long int> CB_sample_flops(0);
-    std::atomic<long long int> sparse_sample_flops(0);
-    std::atomic<long long int> extraction_flops(0);
-    std::atomic<long long int> ULV_factor_flops(0);
-    std::atomic<long long int> schur_flops(0);
-    std::atomic<long long int> full_rank_flops(0);
-    std::atomic<long long int> random_flops(0);
-    std::atomic<long long int> ID_flops(0);
-    std::atomic<long long int> QR_flops(0);
-    std::atomic<long long int> ortho_flops(0);
-    std::atomic<long long int> reduce_sample_flops(0);
-    std::atomic<long long int> update_sample_flops(0);
-    std::atomic<long long int> hss_solve_flops(0);
+    PerfCounter CB_sample_flops(PerfCounterType::CB_SAMPLE_FLOPS);
+    PerfCounter sparse_sample_flops(PerfCounterType::SPARSE_SAMPLE_FLOPS);
+    PerfCounter extraction_flops(PerfCounterType::EXTRACTION_FLOPS);
+    PerfCounter ULV_factor_flops(PerfCounterType::ULV_FACTOR_FLOPS);
+    PerfCounter schur_flops(PerfCounterType::SCHUR_FLOPS);
+    PerfCounter full_rank_flops(PerfCounterType::FULL_RANK_FLOPS);
+    PerfCounter random_flops(PerfCounterType::RANDOM_FLOPS);
+    PerfCounter ID_flops(PerfCounterType::ID_FLOPS);
+    PerfCounter QR_flops(PerfCounterType::QR_FLOPS);
+    PerfCounter ortho_flops(PerfCounterType::ORTHO_FLOPS);
+    PerfCounter reduce_sample_flops(PerfCounterType::REDUCE_SAMPLE_FLOPS);
+    PerfCounter update_sample_flops(PerfCounterType::UPDATE_SAMPLE_FLOPS);
+    PerfCounter hss_solve_flops(PerfCounterType::HSS_SOLVE_FLOPS);
 
-    std::atomic<long long int> f11_fill_flops(0);
-    std::atomic<long long int> f12_fill_flops(0);
-    std::atomic<long long int> f21_fill_flops(0);
-    std::atomic<long long int> f22_fill_flops(0);
+    PerfCounter f11_fill_flops(PerfCounterType::F11_FILL_FLOPS);
+    PerfCounter f12_fill_flops(PerfCounterType::F12_FILL_FLOPS);
+    PerfCounter f21_fill_flops(PerfCounterType::F21_FILL_FLOPS);
+    PerfCounter f22_fill_flops(PerfCounterType::F22_FILL_FLOPS);
 
-    std::atomic<long long int> f21_mult_flops(0);
-    std::atomic<long long int> invf11_mult_flops(0);
-    std::atomic<long long int> f12_mult_flops(0);
+    PerfCounter f21_mult_flops(PerfCounterType::F21_MULT_FLOPS);
+    PerfCounter invf11_mult_flops(PerfCounterType::INVF11_MULT_FLOPS);
+    PerfCounter f12_mult_flops(PerfCounterType::F12_MULT_FLOPS);
 
   } // end namespace params
 } // end namespace strumpack
@@ -40,6 +40,7 @@
 #include <omp.h>
 #endif
 #include "StrumpackConfig.hpp"
+#include "misc/PerfCounters.hpp"
 
 namespace strumpack { // these are all global variables
 
@@ -53,7 +54,11 @@ namespace strumpack { // these are all global variables
     REORDERING_ERROR,   /*!< The matrix reordering failed.          */
     ZERO_PIVOT,         /*!< A zero pivot was encountered.          */
     NO_CONVERGENCE,     /*!< The iterative solver did not converge. */
-    INACCURATE_INERTIA  /*!< Inertia could not be computed.         */
+    INACCURATE_INERTIA, /*!< Inertia could not be computed.         */
+    NOT_SUPPORTED,      /*!< Operation not supported for the current
+                             solver configuration.                  */
+    FILE_ERROR          /*!< A file could not be written or read,
+                             or its contents are invalid.           */
   };
 
   inline std::ostream& operator<<(std::ostream& os, ReturnCode& e) {
@@ -64,6 +69,8 @@ namespace strumpack { // these are all global variables
     case ReturnCode::ZERO_PIVOT:         os << "ZERO_PIVOT"; break;
     case ReturnCode::NO_CONVERGENCE:     os << "NO_CONVERGENCE"; break;
     case ReturnCode::INACCURATE_INERTIA: os << "INACCURATE_INERTIA"; break;
+    case ReturnCode::NOT_SUPPORTED:      os << "NOT_SUPPORTED"; break;
+    case ReturnCode::FILE_ERROR:         os << "FILE_ERROR"; break;
     }
     return os;
   }
@@ -75,35 +82,35 @@ namespace strumpack { // these are all global variables
     extern int num_threads;
     extern int task_recursion_cutoff_level;
 
-    extern std::atomic<long long int> flops;
-    extern std::atomic<long long int> bytes_moved;
-    extern std::atomic<long long int> memory;
-    extern std::atomic<long long int> peak_memory;
-    extern std::atomic<long long int> device_memory;
-    extern std::atomic<long long int> peak_device_memory;
-
-    extern std::atomic<long long int> CB_sample_flops;
-    extern std::atomic<long long int> sparse_sample_flops;
-    extern std::atomic<long long int> extraction_flops;
-    extern std::atomic<long long int> ULV_factor_flops;
-    extern std::atomic<long long int> schur_flops;
-    extern std::atomic<long long int> full_rank_flops;
-    extern std::atomic<long long int> random_flops;
-    extern std::atomic<long long int> ID_flops;
-    extern std::atomic<long long int> ortho_flops;
-    extern std::atomic<long long int> QR_flops;
-    extern std::atomic<long long int> reduce_sample_flops;
-    extern std::atomic<long long int> update_sample_flops;
-    extern std::atomic<long long int> hss_solve_flops;
-
-    extern std::atomic<long long int> f11_fill_flops;
-    extern std::atomic<long long int> f12_fill_flops;
-    extern std::atomic<long long int> f21_fill_flops;
-    extern std::atomic<long long int> f22_fill_flops;
-
-    extern std::atomic<long long int> f21_mult_flops;
-    extern std::atomic<long long int> invf11_mult_flops;
-    extern std::atomic<long long int> f12_mult_flops;
+    extern PerfCounter flops;
+    extern PerfCounter bytes_moved;
+    extern PerfCounter memory;
+    extern PerfCounter peak_memory;
+    extern PerfCounter device_memory;
+    extern PerfCounter peak_device_memory;
+
+    extern PerfCounter CB_sample_flops;
+    extern PerfCounter sparse_sample_flops;
+    extern PerfCounter extraction_flops;
+    extern PerfCounter ULV_factor_flops;
+    extern PerfCounter schur_flops;
+    extern PerfCounter full_rank_flops;
+    extern PerfCounter random_flops;
+    extern PerfCounter ID_flops;
+    extern PerfCounter ortho_flops;
+    extern PerfCounter QR_flops;
+    extern PerfCounter reduce_sample_flops;
+    extern PerfCounter update_sample_flops;
+    extern PerfCounter hss_solve_flops;
+
+    extern PerfCounter f11_fill_flops;
+    extern PerfCounter f12_fill_flops;
+    extern PerfCounter f21_fill_flops;
+    extern PerfCounter f22_fill_flops;
+
+    extern PerfCounter f21_mult_flops;
+    extern PerfCounter invf11_mult_flops;
+    extern PerfCounter f12_mult_flops;
 
 #endif //DOXYGEN_SHOULD_SKIP_THIS
 
@@ -158,24 +165,10 @@ namespace strumpack { // these are all global variables
 #define STRUMPACK_HODLR_F12_MULT_FLOPS(n)       \
   strumpack::params::f12_mult_flops += n
 
-#define STRUMPACK_ADD_MEMORY(n) {                                       \
-    strumpack::params::memory += n;                                     \
-    auto new_peak_ = std::max(strumpack::params::memory.load(),         \
-                              strumpack::params::peak_memory.load());   \
-    auto old_peak_ = strumpack::params::peak_memory.load();             \
-    while (new_peak_ > old_peak_ &&                                     \
-           !strumpack::params::peak_memory.compare_exchange_weak        \
-           (old_peak_, new_peak_)) { }                                  \
-  }
-#define STRUMPACK_ADD_DEVICE_MEMORY(n) {                                \
-    strumpack::params::device_memory += n;                              \
-    auto new_peak_ = std::max(strumpack::params::device_memory.load(),  \
-                              strumpack::params::peak_device_memory.load()); \
-    auto old_peak_ = strumpack::params::peak_device_memory.load();      \
-    while (new_peak_ > old_peak_ &&                                     \
-           !strumpack::params::peak_device_memory.compare_exchange_weak \
-           (old_peak_, new_peak_)) { }                                  \
-  }
+#define STRUMPACK_ADD_MEMORY(n)                 \
+  strumpack::params::memory += n;
+#define STRUMPACK_ADD_DEVICE_MEMORY(n)          \
+  strumpack::params::device_memory += n;
 
 #define STRUMPACK_SUB_MEMORY(n)                 \
   strumpack::params::memory -= n;
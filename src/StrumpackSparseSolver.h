@@ -90,7 +90,8 @@ typedef enum
    STRUMPACK_MATCHING_MAX_SMALLEST_DIAGONAL_2=3,
    STRUMPACK_MATCHING_MAX_DIAGONAL_SUM=4,
    STRUMPACK_MATCHING_MAX_DIAGONAL_PRODUCT_SCALING=5,
-   STRUMPACK_MATCHING_COMBBLAS=6
+   STRUMPACK_MATCHING_COMBBLAS=6,
+   STRUMPACK_MATCHING_APPROX_DIAGONAL_PRODUCT_SCALING=7
   } STRUMPACK_MATCHING_JOB;
 
 typedef enum
@@ -107,6 +108,7 @@ typedef enum
    STRUMPACK_AND=9,
    STRUMPACK_MLF=10,
    STRUMPACK_SPECTRAL=11,
+   STRUMPACK_ND=12,
   } STRUMPACK_REORDERING_STRATEGY;
 
 typedef enum
@@ -135,7 +137,9 @@ typedef enum
    STRUMPACK_PREC_GMRES=3,
    STRUMPACK_GMRES=4,
    STRUMPACK_PREC_BICGSTAB=5,
-   STRUMPACK_BICGSTAB=6
+   STRUMPACK_BICGSTAB=6,
+   STRUMPACK_PREC_BLOCK_GMRES=7,
+   STRUMPACK_BLOCK_REFINE=8
   } STRUMPACK_KRYLOV_SOLVER;
 
 typedef enum
@@ -145,7 +149,9 @@ typedef enum
    STRUMPACK_REORDERING_ERROR=2,
    STRUMPACK_ZERO_PIVOT=3,
    STRUMPACK_NO_CONVERGENCE=4,
-   STRUMPACK_INACCURATE_INERTIA=5
+   STRUMPACK_INACCURATE_INERTIA=5,
+   STRUMPACK_NOT_SUPPORTED=6,
+   STRUMPACK_FILE_ERROR=7
   } STRUMPACK_RETURN_CODE;
 
 
@@ -79,6 +79,8 @@ namespace strumpack {
     using Reord_t = MatrixReordering<scalar_t,integer_t>;
     using DenseM_t = DenseMatrix<scalar_t>;
     using DenseMW_t = DenseMatrixWrapper<scalar_t>;
+    using real_t = typename RealType<scalar_t>::value_type;
+    using RealDenseM_t = DenseMatrix<real_t>;
 
   public:
 
@@ -208,7 +210,8 @@ namespace strumpack {
     void setup_reordering() override;
     int compute_reordering(const int* p, int base,
                            int nx, int ny, int nz,
-                           int components, int width) override;
+                           int components, int width,
+                           const RealDenseM_t* coords) override;
     void separator_reordering() override;
 
     SpMat_t* matrix() override { return mat_.get(); }
@@ -227,12 +230,18 @@ namespace strumpack {
                               bool use_initial_guess=false) override;
     ReturnCode solve_internal(const DenseM_t& b, DenseM_t& x,
                               bool use_initial_guess=false) override;
+    ReturnCode solve_internal(Trans op, const DenseM_t& b, DenseM_t& x,
+                              bool use_initial_guess=false) override;
 
     void delete_factors_internal() override;
+    bool save_factors_internal(FactorFileWriter& f) const override;
+    bool load_factors_internal
+    (const std::shared_ptr<FactorFileReader>& f) override;
 
-    void transform_x0(DenseM_t& x, DenseM_t& xtmp);
-    void transform_b(const DenseM_t& b, DenseM_t& bloc);
-    void transform_x(DenseM_t& x, DenseM_t& xtmp);
+    void transform_x0(DenseM_t& x, DenseM_t& xtmp, Trans op=Trans::N);
+    void transform_b(const DenseM_t& b, DenseM_t& bloc, Trans op=Trans::N);
+    void transform_x(DenseM_t& x, DenseM_t& xtmp, Trans op=Trans::N);
+    std::vector<typename RealType<scalar_t>::value_type> row_scaling() const;
 
     std::unique_ptr<CSRMatrix<scalar_t,integer_t>> mat_;
     std::unique_ptr<MatrixReordering<scalar_t,integer_t>> nd_;
@@ -246,6 +255,7 @@ namespace strumpack {
     using SPBase_t::factored_;
     using SPBase_t::reordered_;
     using SPBase_t::Krylov_its_;
+    using SPBase_t::trace_;
     using SPBase_t::solve_internal;
   };
 
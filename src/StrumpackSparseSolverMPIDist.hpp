@@ -76,6 +76,8 @@ namespace strumpack {
     using Reord_t = MatrixReordering<scalar_t,integer_t>;
     using DenseM_t = DenseMatrix<scalar_t>;
     using DenseMW_t = DenseMatrixWrapper<scalar_t>;
+    using real_t = typename RealType<scalar_t>::value_type;
+    using RealDenseM_t = DenseMatrix<real_t>;
 
   public:
     /**
@@ -294,6 +296,7 @@ namespace strumpack {
   private:
     using SparseSolverBase<scalar_t,integer_t>::is_root_;
     using SparseSolverBase<scalar_t,integer_t>::opts_;
+    using SparseSolverBase<scalar_t,integer_t>::trace_;
     MPIComm comm_;
 
     SpMat_t* matrix() override { return mat_mpi_.get(); }
@@ -309,10 +312,12 @@ namespace strumpack {
     void setup_tree() override;
     void setup_reordering() override;
     int compute_reordering(const int* p, int base, int nx, int ny, int nz,
-                           int components, int width) override;
+                           int components, int width,
+                           const RealDenseM_t* coords) override;
     void separator_reordering() override;
 
-    void perf_counters_stop(const std::string& s) override;
+    void perf_counters_stop(const PerfReport::Mark& m,
+                            const std::string& s) override;
     void synchronize() override { comm_.barrier(); }
     void reduce_flop_counters() const override;
 
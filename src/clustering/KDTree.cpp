@@ -27,8 +27,10 @@
  *
  */
 #include <algorithm>
+#include <numeric>
 
 #include "Clustering.hpp"
+#include "StrumpackParameters.hpp"
 
 namespace strumpack {
 
@@ -37,14 +39,27 @@ namespace strumpack {
    std::size_t cluster_size, int* perm) {
     auto n = p.cols();
     auto d = p.rows();
-    // find coordinate of the most spread
-    std::vector<scalar_t> maxs(d), mins(d);
-    for (std::size_t j=0; j<d; ++j)
-      maxs[j] = mins[j] = p(j, 0);
-    for (std::size_t i=1; i<n; ++i)
+    // find coordinate of the most spread, in chunks of points, which
+    // are handled by different tasks for large clusters
+    const std::size_t B = 32768, nb = (n + B - 1) / B;
+    DenseMatrix<scalar_t> cmaxs(d, nb), cmins(d, nb);
+#pragma omp taskloop default(shared) if(nb > 1)
+    for (std::size_t b=0; b<nb; b++) {
+      auto mx = cmaxs.ptr(0, b), mn = cmins.ptr(0, b);
+      for (std::size_t j=0; j<d; ++j)
+        mx[j] = mn[j] = p(j, b*B);
+      for (std::size_t i=b*B+1; i<std::min(n, (b+1)*B); ++i)
+        for (std::size_t j=0; j<d; ++j) {
+          mx[j] = std::max(p(j, i), mx[j]);
+          mn[j] = std::min(p(j, i), mn[j]);
+        }
+    }
+    std::vector<scalar_t> maxs(cmaxs.ptr(0, 0), cmaxs.ptr(0, 0)+d),
+      mins(cmins.ptr(0, 0), cmins.ptr(0, 0)+d);
+    for (std::size_t b=1; b<nb; b++)
       for (std::size_t j=0; j<d; ++j) {
-        maxs[j] = std::max(p(j, i), maxs[j]);
-        mins[j] = std::min(p(j, i), mins[j]);
+        maxs[j] = std::max(cmaxs(j, b), maxs[j]);
+        mins[j] = std::min(cmins(j, b), mins[j]);
       }
     scalar_t max_var = maxs[0] - mins[0];
     std::size_t dim = 0;
@@ -104,6 +119,38 @@ namespace strumpack {
       cluster[idx[i]] = 1;
 #endif
 
+    if (nb > 1) {
+      // permute the data out of place, in parallel: count the points
+      // in the first cluster per chunk, a prefix sum gives the
+      // destination of each chunk, then scatter and copy back
+      std::vector<std::size_t> off(nb+1, 0);
+#pragma omp taskloop default(shared)
+      for (std::size_t b=0; b<nb; b++) {
+        std::size_t c = 0;
+        for (std::size_t i=b*B; i<std::min(n, (b+1)*B); i++)
+          if (!cluster[i]) c++;
+        off[b+1] = c;
+      }
+      std::partial_sum(off.begin(), off.end(), off.begin());
+      DenseMatrix<scalar_t> pc(d, n);
+      std::vector<int> pperm(n);
+#pragma omp taskloop default(shared)
+      for (std::size_t b=0; b<nb; b++) {
+        std::size_t t0 = off[b], t1 = nc[0] + b*B - off[b];
+        for (std::size_t i=b*B; i<std::min(n, (b+1)*B); i++) {
+          auto t = cluster[i] ? t1++ : t0++;
+          std::copy(p.ptr(0, i), p.ptr(0, i)+d, pc.ptr(0, t));
+          pperm[t] = perm[i];
+        }
+      }
+#pragma omp taskloop default(shared)
+      for (std::size_t b=0; b<nb; b++)
+        for (std::size_t i=b*B; i<std::min(n, (b+1)*B); i++) {
+          std::copy(pc.ptr(0, i), pc.ptr(0, i)+d, p.ptr(0, i));
+          perm[i] = pperm[i];
+        }
+      return;
+    }
     // permute the data
     std::size_t ct = 0;
     for (std::size_t j=0, cj=ct; j<nc[0]; j++) {
@@ -121,7 +168,8 @@ namespace strumpack {
 
 
   template<typename scalar_t> structured::ClusterTree recursive_kd
-  (DenseMatrix<scalar_t>& p, std::size_t cluster_size, int* perm) {
+  (DenseMatrix<scalar_t>& p, std::size_t cluster_size, int* perm,
+   int depth) {
     auto n = p.cols();
     structured::ClusterTree tree(n);
     if (n < cluster_size) return tree;
@@ -131,10 +179,27 @@ namespace strumpack {
     tree.c.resize(2);
     tree.c[0].size = nc[0];
     tree.c[1].size = nc[1];
+    // the two halves are disjoint, in p and in perm
     DenseMatrixWrapper<scalar_t> p0(p.rows(), nc[0], p, 0, 0);
-    tree.c[0] = recursive_kd(p0, cluster_size, perm);
+#pragma omp task default(shared)                                        \
+  if(depth < params::task_recursion_cutoff_level)                       \
+  final(depth >= params::task_recursion_cutoff_level-1) mergeable
+    tree.c[0] = recursive_kd(p0, cluster_size, perm, depth+1);
     DenseMatrixWrapper<scalar_t> p1(p.rows(), nc[1], p, 0, nc[0]);
-    tree.c[1] = recursive_kd(p1, cluster_size, perm+nc[0]);
+#pragma omp task default(shared)                                        \
+  if(depth < params::task_recursion_cutoff_level)                       \
+  final(depth >= params::task_recursion_cutoff_level-1) mergeable
+    tree.c[1] = recursive_kd(p1, cluster_size, perm+nc[0], depth+1);
+#pragma omp taskwait
+    return tree;
+  }
+
+  template<typename scalar_t> structured::ClusterTree recursive_kd
+  (DenseMatrix<scalar_t>& p, std::size_t cluster_size, int* perm) {
+    structured::ClusterTree tree;
+#pragma omp parallel if(!omp_in_parallel())
+#pragma omp single nowait
+    tree = recursive_kd(p, cluster_size, perm, 0);
     return tree;
   }
 
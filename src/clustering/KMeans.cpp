@@ -28,6 +28,7 @@
  */
 #include "Clustering.hpp"
 #include "kernel/Metrics.hpp"
+#include "StrumpackParameters.hpp"
 
 namespace strumpack {
 
@@ -137,29 +138,47 @@ namespace strumpack {
     int iter = 0;
     bool changes = true;
     std::vector<int> cluster(n);
+    // the points are processed in chunks, by different tasks for
+    // large clusters, with per chunk partial sums for the centers
+    const std::size_t B = 32768, nb = (n + B - 1) / B;
+    std::vector<DenseMatrix<scalar_t>> csum(nb);
+    std::vector<std::vector<std::size_t>> ccount(nb);
+    std::vector<char> cchanges(nb);
     while ((changes == true) && (iter < kmeans_max_it)) {
       // for each point, find the closest cluster center
-      changes = false;
-      for (std::size_t i=0; i<n; i++) {
-        auto min_dist = Euclidean_distance(d, &p(0, i), &center(0, 0));
-        int ci = 0;
-        for (int c=1; c<k; c++) {
-          auto dd = Euclidean_distance(d, &p(0, i), &center(0, c));
-          if (dd < min_dist) {
-            min_dist = dd;
-            ci = c;
+#pragma omp taskloop default(shared) if(nb > 1)
+      for (std::size_t b=0; b<nb; b++) {
+        csum[b] = DenseMatrix<scalar_t>(d, k);
+        csum[b].zero();
+        ccount[b].assign(k, 0);
+        cchanges[b] = false;
+        for (std::size_t i=b*B; i<std::min(n, (b+1)*B); i++) {
+          auto min_dist = Euclidean_distance(d, &p(0, i), &center(0, 0));
+          int ci = 0;
+          for (int c=1; c<k; c++) {
+            auto dd = Euclidean_distance(d, &p(0, i), &center(0, c));
+            if (dd < min_dist) {
+              min_dist = dd;
+              ci = c;
+            }
           }
+          if (ci != cluster[i]) cchanges[b] = true;
+          cluster[i] = ci;
+          ccount[b][ci]++;
+          for (std::size_t j=0; j<d; j++)
+            csum[b](j, ci) += p(j, i);
         }
-        if (ci != cluster[i]) changes = true;
-        cluster[i] = ci;
       }
+      changes = false;
       std::fill(nc.begin(), nc.end(), 0);
       center.zero();
-      for (std::size_t i=0; i<n; i++) {
-        auto c = cluster[i];
-        nc[c]++;
-        for (std::size_t j=0; j<d; j++)
-          center(j, c) += p(j, i);
+      for (std::size_t b=0; b<nb; b++) {
+        if (cchanges[b]) changes = true;
+        for (int c=0; c<k; c++) {
+          nc[c] += ccount[b][c];
+          for (std::size_t j=0; j<d; j++)
+            center(j, c) += csum[b](j, c);
+        }
       }
       for (int c=0; c<k; c++)
         for (std::size_t j=0; j<d; j++)
@@ -186,7 +205,7 @@ namespace strumpack {
   template<typename scalar_t>
   structured::ClusterTree recursive_2_means
   (DenseMatrix<scalar_t>& p, std::size_t cluster_size,
-   int* perm, std::mt19937& generator) {
+   int* perm, std::mt19937& generator, int depth) {
     const auto n = p.cols();
     structured::ClusterTree tree(n);
     if (n < cluster_size) return tree;
@@ -196,11 +215,32 @@ namespace strumpack {
     tree.c.resize(2);
     tree.c[0].size = nc[0];
     tree.c[1].size = nc[1];
-    // TODO threading
+    // each child gets its own generator, so the result does not
+    // depend on the order in which the tasks are executed
+    std::mt19937 g0(generator()), g1(generator());
     DenseMatrixWrapper<scalar_t> p0(p.rows(), nc[0], p, 0, 0);
-    tree.c[0] = recursive_2_means(p0, cluster_size, perm, generator);
+#pragma omp task default(shared)                                        \
+  if(depth < params::task_recursion_cutoff_level)                       \
+  final(depth >= params::task_recursion_cutoff_level-1) mergeable
+    tree.c[0] = recursive_2_means(p0, cluster_size, perm, g0, depth+1);
     DenseMatrixWrapper<scalar_t> p1(p.rows(), nc[1], p, 0, nc[0]);
-    tree.c[1] = recursive_2_means(p1, cluster_size, perm+nc[0], generator);
+#pragma omp task default(shared)                                        \
+  if(depth < params::task_recursion_cutoff_level)                       \
+  final(depth >= params::task_recursion_cutoff_level-1) mergeable
+    tree.c[1] = recursive_2_means
+      (p1, cluster_size, perm+nc[0], g1, depth+1);
+#pragma omp taskwait
+    return tree;
+  }
+
+  template<typename scalar_t>
+  structured::ClusterTree recursive_2_means
+  (DenseMatrix<scalar_t>& p, std::size_t cluster_size,
+   int* perm, std::mt19937& generator) {
+    structured::ClusterTree tree;
+#pragma omp parallel if(!omp_in_parallel())
+#pragma omp single nowait
+    tree = recursive_2_means(p, cluster_size, perm, generator, 0);
     return tree;
   }
 
@@ -33,9 +33,12 @@
 #include <numeric>
 #include <random>
 #include <chrono>
+#include <cstdint>
+#include <type_traits>
 
 #include "NeighborSearch.hpp"
 #include "kernel/Metrics.hpp"
+#include "StrumpackParameters.hpp"
 
 namespace strumpack {
 
@@ -70,6 +73,7 @@ namespace strumpack {
     auto d = data.rows();
     auto subset_size = index_subset.size();
     DenseMatrix<real_t> distances(subset_size, n);
+#pragma omp parallel for
     for (std::size_t j=0; j<n; j++)
       for (std::size_t i=0; i<subset_size; i++)
         distances(i, j) = Euclidean_distance_squared
@@ -80,26 +84,28 @@ namespace strumpack {
   //-------FIND APPROXIMATE NEAREST NEIGHBORS FROM PROJECTION TREE---
 
   // 1. CONSTRUCT THE TREE
-  // leaves - list of all indices such that
-  // leaves[leaf_sizes[i]]...leaves[leaf_sizes[i+1]]
-  // belong to i-th leaf of the projection tree
-  // gauss_id and gaussian samples - for the fixed samples option
+  // cur_indices[start]...cur_indices[start+cur_node_size-1] are
+  // split recursively, the two halves are handled by different
+  // tasks. The leaves are contiguous in cur_indices, leaf_start is
+  // set to 1 for the first position of every leaf. Every node draws
+  // its direction from its own generator, seeded from seed, start and
+  // cur_node_size, so the result does not depend on the scheduling.
   template<typename real_t, typename int_t>
   void construct_projection_tree
   (const DenseMatrix<real_t>& data, std::size_t min_leaf_size,
    std::vector<int_t>& cur_indices, std::size_t start,
-   std::size_t cur_node_size, std::vector<std::size_t>& leaves,
-   std::vector<std::size_t>& leaf_sizes, std::mt19937& generator) {
+   std::size_t cur_node_size, std::vector<char>& leaf_start,
+   std::uint32_t seed, int depth) {
     auto d = data.rows();
     if (cur_node_size < min_leaf_size) {
-      auto prev_size = leaf_sizes.back();
-      leaf_sizes.push_back(cur_node_size + prev_size);
-      for (std::size_t i=0; i<cur_node_size; i++)
-        leaves.push_back(cur_indices[start+i]);
+      leaf_start[start] = 1;
       return;
     }
 
     // choose random direction
+    std::seed_seq seq{seed, std::uint32_t(start),
+        std::uint32_t(cur_node_size)};
+    std::mt19937 generator(seq);
     std::vector<real_t> direction_vector(d);
     std::normal_distribution<real_t> normal_distr(0.0, 1.0);
     for (std::size_t i=0; i<d; i++)
@@ -110,42 +116,42 @@ namespace strumpack {
 
     // find relative coordinates
     std::vector<real_t> relative_coordinates(cur_node_size, 0.0);
-    //#pragma omp parallel for if(cur_node_size > 1000)
+#pragma omp taskloop default(shared) grainsize(16384)   \
+  if(cur_node_size > 32768)
     for (std::size_t i=0; i<cur_node_size; i++)
       relative_coordinates[i] = blas::dotc
         (d, &data(0, cur_indices[start+i]), 1, &direction_vector[0], 1);
 
-    // median split
+    // median split, only the median needs to be in place, not a full
+    // sort
     std::vector<int_t> idx(cur_node_size);
     std::iota(idx.begin(), idx.end(), 0);
     int_t half_size = (int_t)cur_node_size / 2;
-    // std::nth_element
-    //   (idx.begin(), idx.begin()+half_size, idx.end(),
-    //    [&](const int_t& a, const int_t& b) {
-    //      return (relative_coordinates[a] < relative_coordinates[b]) ||
-    //        ((relative_coordinates[a] == relative_coordinates[b])
-    //         && (a < b)); });
-    std::sort
-      (idx.begin(), idx.end(),
+    std::nth_element
+      (idx.begin(), idx.begin()+half_size, idx.end(),
        [&](const int_t& a, const int_t& b) {
          return (relative_coordinates[a] < relative_coordinates[b]) ||
-           ((relative_coordinates[a] == relative_coordinates[b]) && (a < b)); });
-    // std::stable_sort
-    //   (idx.begin(), idx.end(),
-    //    [&](const int_t& a, const int_t& b) {
-    //      return relative_coordinates[a] < relative_coordinates[b]; });
+           ((relative_coordinates[a] == relative_coordinates[b])
+            && (a < b)); });
     std::vector<int_t> cur_indices_sorted(cur_node_size, 0);
     for (std::size_t i=0; i<cur_node_size; i++)
       cur_indices_sorted[i] = cur_indices[start+idx[i]];
-    for (std::size_t i=start; i<start+cur_node_size; i++)
-      cur_indices[i] = cur_indices_sorted[i-start];
+    std::copy(cur_indices_sorted.begin(), cur_indices_sorted.end(),
+              cur_indices.begin()+start);
 
+#pragma omp task default(shared)                                        \
+  if(depth < params::task_recursion_cutoff_level)                       \
+  final(depth >= params::task_recursion_cutoff_level-1) mergeable
     construct_projection_tree
       (data, min_leaf_size, cur_indices, start,
-       half_size, leaves, leaf_sizes, generator);
+       half_size, leaf_start, seed, depth+1);
+#pragma omp task default(shared)                                        \
+  if(depth < params::task_recursion_cutoff_level)                       \
+  final(depth >= params::task_recursion_cutoff_level-1) mergeable
     construct_projection_tree
       (data, min_leaf_size, cur_indices, start + half_size,
-       cur_node_size - half_size, leaves, leaf_sizes, generator);
+       cur_node_size - half_size, leaf_start, seed, depth+1);
+#pragma omp taskwait
   }
 
   // 2. FIND CLOSEST POINTS INSIDE LEAVES
@@ -196,17 +202,20 @@ namespace strumpack {
     auto n = data.cols();
     auto ann_number = neighbors.rows();
     std::size_t min_leaf_size = 6 * ann_number;
-    std::vector<std::size_t> leaves, leaf_sizes;
-    leaves.reserve(n);
-    leaf_sizes.reserve(2*n / min_leaf_size);
-    leaf_sizes.push_back(0);
-    std::size_t cur_node_size = n;
-    std::size_t start = 0;
-    std::vector<int_t> cur_indices(cur_node_size);
+    std::vector<int_t> cur_indices(n);
     std::iota(cur_indices.begin(), cur_indices.end(), 0);
+    std::vector<char> leaf_start(n+1, 0);
+    auto seed = generator();
+#pragma omp parallel if(!omp_in_parallel())
+#pragma omp single nowait
     construct_projection_tree
-      (data, min_leaf_size, cur_indices, start,
-       cur_node_size, leaves, leaf_sizes, generator);
+      (data, min_leaf_size, cur_indices, 0, n, leaf_start, seed, 0);
+    std::vector<std::size_t> leaves(cur_indices.begin(), cur_indices.end()),
+      leaf_sizes;
+    leaf_sizes.reserve(2*n / min_leaf_size + 1);
+    for (std::size_t i=0; i<n; i++)
+      if (leaf_start[i]) leaf_sizes.push_back(i);
+    leaf_sizes.push_back(n);
     find_neighbors_in_tree(data, leaves, leaf_sizes, neighbors, scores);
   }
 
@@ -219,39 +228,43 @@ namespace strumpack {
   (DenseMatrix<int_t>& neighbors, DenseMatrix<real_t>& scores,
    DenseMatrix<int_t>& new_neighbors, DenseMatrix<real_t>& new_scores) {
     auto ann_number = neighbors.rows();
-    std::vector<int_t> cur_neighbors(ann_number);
-    std::vector<real_t> cur_scores(ann_number);
-    for (std::size_t c=0; c<neighbors.cols(); c++) {
-      std::size_t r1 = 0, r2 = 0, cur = 0;
-      while ((r1 < ann_number) && (r2 < ann_number) &&
-             (cur < ann_number)) {
-        if (scores(r1, c) > new_scores(r2, c)) {
-          cur_neighbors[cur] = new_neighbors(r2, c);
-          cur_scores[cur] = new_scores(r2, c);
-          r2++;
-        } else {
-          cur_neighbors[cur] = neighbors(r1, c);
-          cur_scores[cur] = scores(r1, c);
-          if (neighbors(r1, c) == new_neighbors(r2, c)) r2++;
-          r1++;
+#pragma omp parallel if(!omp_in_parallel())
+    {
+      std::vector<int_t> cur_neighbors(ann_number);
+      std::vector<real_t> cur_scores(ann_number);
+#pragma omp for
+      for (std::size_t c=0; c<neighbors.cols(); c++) {
+        std::size_t r1 = 0, r2 = 0, cur = 0;
+        while ((r1 < ann_number) && (r2 < ann_number) &&
+               (cur < ann_number)) {
+          if (scores(r1, c) > new_scores(r2, c)) {
+            cur_neighbors[cur] = new_neighbors(r2, c);
+            cur_scores[cur] = new_scores(r2, c);
+            r2++;
+          } else {
+            cur_neighbors[cur] = neighbors(r1, c);
+            cur_scores[cur] = scores(r1, c);
+            if (neighbors(r1, c) == new_neighbors(r2, c)) r2++;
+            r1++;
+          }
+          cur++;
         }
-        cur++;
-      }
-      while (cur < ann_number) {
-        if (r1 == ann_number) {
-          cur_neighbors[cur] = new_neighbors(r2, c);
-          cur_scores[cur] = new_scores(r2, c);
-          r2++;
-        } else {
-          cur_neighbors[cur] = neighbors(r1, c);
-          cur_scores[cur] = scores(r1, c);
-          r1++;
+        while (cur < ann_number) {
+          if (r1 == ann_number) {
+            cur_neighbors[cur] = new_neighbors(r2, c);
+            cur_scores[cur] = new_scores(r2, c);
+            r2++;
+          } else {
+            cur_neighbors[cur] = neighbors(r1, c);
+            cur_scores[cur] = scores(r1, c);
+            r1++;
+          }
+          cur++;
+        }
+        for (std::size_t i=0; i<ann_number; i++) {
+          neighbors(i, c) = cur_neighbors[i];
+          scores(i, c) = cur_scores[i];
         }
-        cur++;
-      }
-      for (std::size_t i=0; i<ann_number; i++) {
-        neighbors(i, c) = cur_neighbors[i];
-        scores(i, c) = cur_scores[i];
       }
     }
   }
@@ -264,8 +277,9 @@ namespace strumpack {
     auto ann_number = neighbors.rows();
     auto sample_dists = find_distance_matrix_from_subset(data, samples);
     // record ann_number closest points in each leaf to neighbors
-    std::vector<int_t> idx(n);
-    for (int_t i=0; i<samples.size(); i++) {
+#pragma omp parallel for
+    for (std::size_t i=0; i<samples.size(); i++) {
+      std::vector<int_t> idx(n);
       std::iota(idx.begin(), idx.end(), 0);
       std::partial_sort
         (idx.begin(), idx.begin()+ann_number, idx.end(),
@@ -324,8 +338,27 @@ namespace strumpack {
   template<typename real_t, typename int_t> void find_approximate_neighbors
   (const DenseMatrix<real_t>& data, std::size_t num_iters,
    std::size_t ann_number, DenseMatrix<int_t>& neighbors,
-   DenseMatrix<real_t>& scores) {
+   DenseMatrix<real_t>& scores, bool single_precision) {
     auto n = data.cols();
+    if (single_precision && !std::is_same<real_t,float>::value) {
+      // search in single precision, then compute the scores for the
+      // neighbors that were found in the original precision
+      auto d = data.rows();
+      DenseMatrix<float> fdata(d, n), fscores;
+#pragma omp parallel for
+      for (std::size_t j=0; j<n; j++)
+        for (std::size_t i=0; i<d; i++)
+          fdata(i, j) = data(i, j);
+      find_approximate_neighbors
+        (fdata, num_iters, ann_number, neighbors, fscores, false);
+      scores.resize(ann_number, n);
+#pragma omp parallel for
+      for (std::size_t j=0; j<n; j++)
+        for (std::size_t i=0; i<ann_number; i++)
+          scores(i, j) = Euclidean_distance_squared
+            (d, &data(0, j), &data(0, neighbors(i, j)));
+      return;
+    }
     neighbors.resize(ann_number, n);
     scores.resize(ann_number, n);
     neighbors.zero();
@@ -351,10 +384,10 @@ namespace strumpack {
   template void find_approximate_neighbors
   (const DenseMatrix<float>& data, std::size_t num_iters,
    std::size_t ann_number, DenseMatrix<unsigned int>& neighbors,
-   DenseMatrix<float>& scores);
+   DenseMatrix<float>& scores, bool single_precision);
   template void find_approximate_neighbors
   (const DenseMatrix<double>& data, std::size_t num_iters,
    std::size_t ann_number, DenseMatrix<unsigned int>& neighbors,
-   DenseMatrix<double>& scores);
+   DenseMatrix<double>& scores, bool single_precision);
 
 } // end namespace strumpack
@@ -34,11 +34,19 @@
 
 namespace strumpack {
 
+  /**
+   * Find ann_number approximate nearest neighbors for all points
+   * (columns) in data, using up to num_iters random projection
+   * trees. With single_precision, the search is done on a single
+   * precision copy of (double precision) data, the scores, squared
+   * distances to the neighbors, are still computed in the precision
+   * of data.
+   */
   template<typename real_t, typename int_t>
   void find_approximate_neighbors
   (const DenseMatrix<real_t>& data, std::size_t num_iters,
    std::size_t ann_number, DenseMatrix<int_t>& neighbors,
-   DenseMatrix<real_t>& scores);
+   DenseMatrix<real_t>& scores, bool single_precision=false);
 
 } // end namespace strumpack
 
@@ -210,6 +210,23 @@ namespace strumpack {
          const std::complex<double>* b, strumpack_blas_int* ldb, std::complex<double>* beta,
          std::complex<double>* c, strumpack_blas_int* ldc);
 
+      void STRUMPACK_FC_GLOBAL(ssyrk,SSYRK)
+        (char* ul, char* t, strumpack_blas_int* n, strumpack_blas_int* k,
+         float* alpha, const float* a, strumpack_blas_int* lda,
+         float* beta, float* c, strumpack_blas_int* ldc);
+      void STRUMPACK_FC_GLOBAL(dsyrk,DSYRK)
+        (char* ul, char* t, strumpack_blas_int* n, strumpack_blas_int* k,
+         double* alpha, const double* a, strumpack_blas_int* lda,
+         double* beta, double* c, strumpack_blas_int* ldc);
+      void STRUMPACK_FC_GLOBAL(cherk,CHERK)
+        (char* ul, char* t, strumpack_blas_int* n, strumpack_blas_int* k,
+         float* alpha, const std::complex<float>* a, strumpack_blas_int* lda,
+         float* beta, std::complex<float>* c, strumpack_blas_int* ldc);
+      void STRUMPACK_FC_GLOBAL(zherk,ZHERK)
+        (char* ul, char* t, strumpack_blas_int* n, strumpack_blas_int* k,
+         double* alpha, const std::complex<double>* a, strumpack_blas_int* lda,
+         double* beta, std::complex<double>* c, strumpack_blas_int* ldc);
+
       void STRUMPACK_FC_GLOBAL(strsm,STRSM)
         (char* s, char* ul, char* t, char* d, strumpack_blas_int* m, strumpack_blas_int* n,
          float* alpha, const float* a, strumpack_blas_int* lda, float* b, strumpack_blas_int* ldb);
@@ -622,6 +639,41 @@ namespace strumpack {
       STRUMPACK_BYTES(2*8*gemm_moves(m,n,k));
     }
 
+    void herk(char ul, char t, int n, int k, float alpha,
+              const float* a, int lda, float beta, float* c, int ldc) {
+      strumpack_blas_int n_ = n, k_ = k, lda_ = lda, ldc_ = ldc;
+      STRUMPACK_FC_GLOBAL(ssyrk,SSYRK)
+        (&ul, &t, &n_, &k_, &alpha, a, &lda_, &beta, c, &ldc_);
+      STRUMPACK_FLOPS(herk_flops(n,k));
+      STRUMPACK_BYTES(4*herk_moves(n,k));
+    }
+    void herk(char ul, char t, int n, int k, double alpha,
+              const double* a, int lda, double beta, double* c, int ldc) {
+      strumpack_blas_int n_ = n, k_ = k, lda_ = lda, ldc_ = ldc;
+      STRUMPACK_FC_GLOBAL(dsyrk,DSYRK)
+        (&ul, &t, &n_, &k_, &alpha, a, &lda_, &beta, c, &ldc_);
+      STRUMPACK_FLOPS(herk_flops(n,k));
+      STRUMPACK_BYTES(8*herk_moves(n,k));
+    }
+    void herk(char ul, char t, int n, int k, float alpha,
+              const std::complex<float>* a, int lda, float beta,
+              std::complex<float>* c, int ldc) {
+      strumpack_blas_int n_ = n, k_ = k, lda_ = lda, ldc_ = ldc;
+      STRUMPACK_FC_GLOBAL(cherk,CHERK)
+        (&ul, &t, &n_, &k_, &alpha, a, &lda_, &beta, c, &ldc_);
+      STRUMPACK_FLOPS(4*herk_flops(n,k));
+      STRUMPACK_BYTES(2*4*herk_moves(n,k));
+    }
+    void herk(char ul, char t, int n, int k, double alpha,
+              const std::complex<double>* a, int lda, double beta,
+              std::complex<double>* c, int ldc) {
+      strumpack_blas_int n_ = n, k_ = k, lda_ = lda, ldc_ = ldc;
+      STRUMPACK_FC_GLOBAL(zherk,ZHERK)
+        (&ul, &t, &n_, &k_, &alpha, a, &lda_, &beta, c, &ldc_);
+      STRUMPACK_FLOPS(4*herk_flops(n,k));
+      STRUMPACK_BYTES(2*8*herk_moves(n,k));
+    }
+
     void gemv(char t, int m, int n, float alpha, const float *a, int lda,
               const float *x, int incx, float beta, float *y, int incy) {
       strumpack_blas_int m_ = m, n_ = n, lda_ = lda, incx_ = incx, incy_ = incy;
@@ -241,6 +241,28 @@ namespace strumpack {
               std::complex<double> beta,
               std::complex<double>* c, int ldc);
 
+    inline long long herk_flops(long long n, long long k) {
+      return n * (n + 1) * k;
+    }
+    inline long long herk_moves(long long n, long long k) {
+      return n * (n + 1) + n * k;
+    }
+    /**
+     * Hermitian rank-k update, C = alpha A A^H + beta C, only the
+     * part of C indicated by ul is referenced/updated. For real
+     * types this is xSYRK, for complex types xHERK.
+     */
+    void herk(char ul, char t, int n, int k, float alpha,
+              const float* a, int lda, float beta, float* c, int ldc);
+    void herk(char ul, char t, int n, int k, double alpha,
+              const double* a, int lda, double beta, double* c, int ldc);
+    void herk(char ul, char t, int n, int k, float alpha,
+              const std::complex<float>* a, int lda, float beta,
+              std::complex<float>* c, int ldc);
+    void herk(char ul, char t, int n, int k, double alpha,
+              const std::complex<double>* a, int lda, double beta,
+              std::complex<double>* c, int ldc);
+
     template<typename scalar> inline
     long long gemv_flops(long long m, long long n, scalar alpha, scalar beta) {
       return (alpha != scalar(0.)) * m * (n * 2 - 1) +
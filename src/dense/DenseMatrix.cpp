@@ -28,6 +28,7 @@
  */
 
 #include <string>
+#include <cstdint>
 #include <iomanip>
 #include <cassert>
 #include <algorithm>
@@ -878,13 +879,28 @@ namespace strumpack {
     return D;
   }
 
+  /**
+   * Written after the version, followed by the size of the scalar
+   * type. Streams without this tag, such as those from older versions
+   * which stored the raw object, are rejected by operator>>.
+   */
+  static const std::uint32_t dense_stream_tag = 0x32534d44; // "DMS2"
+
   template<typename scalar_t> std::ofstream&
   operator<<(std::ofstream& os, const DenseMatrix<scalar_t>& D) {
     int v[3];
     get_version(v, v+1, v+2);
     os.write((const char*)v, sizeof(v));
-    os.write((const char*)(&D), sizeof(DenseMatrix<scalar_t>));
-    os.write((const char*)(D.data()), sizeof(scalar_t)*D.rows()*D.cols());
+    std::uint32_t tag[2] = {dense_stream_tag, sizeof(scalar_t)};
+    os.write((const char*)tag, sizeof(tag));
+    // only the dimensions and the data, column by column, not the
+    // object itself, which holds pointers
+    std::size_t m = D.rows(), n = D.cols();
+    os.write((const char*)&m, sizeof(m));
+    os.write((const char*)&n, sizeof(n));
+    if (m)
+      for (std::size_t j=0; j<n; j++)
+        os.write((const char*)(D.ptr(0, j)), sizeof(scalar_t)*m);
     return os;
   }
   template std::ofstream& operator<<(std::ofstream& os, const DenseMatrix<float>& D);
@@ -905,9 +921,31 @@ namespace strumpack {
                 << v[0] << "." << v[1] << "." << v[2]
                 << ")" << std::endl;
     }
-    is.read((char*)&D, sizeof(DenseMatrix<scalar_t>));
-    D.data_ = new scalar_t[D.rows()*D.cols()];
-    is.read((char*)D.data(), sizeof(scalar_t)*D.rows()*D.cols());
+    std::uint32_t tag[2] = {0, 0};
+    is.read((char*)tag, sizeof(tag));
+    std::size_t m = 0, n = 0;
+    is.read((char*)&m, sizeof(m));
+    is.read((char*)&n, sizeof(n));
+    auto fail = [&](const char* msg) -> std::ifstream& {
+      std::cerr << "ERROR: cannot read DenseMatrix, " << msg << std::endl;
+      is.setstate(std::ios::failbit);
+      D = DenseMatrix<scalar_t>();
+      return is;
+    };
+    if (!is.good() || tag[0] != dense_stream_tag)
+      return fail("not a DenseMatrix stream, or from an older version");
+    if (tag[1] != sizeof(scalar_t))
+      return fail("written with a different scalar type");
+    // the remaining size of the stream bounds m*n
+    auto pos = is.tellg();
+    is.seekg(0, std::ios::end);
+    std::size_t rem = is.tellg() - pos;
+    is.seekg(pos);
+    if (n && m > rem / sizeof(scalar_t) / n)
+      return fail("the dimensions do not match the size of the file");
+    D = DenseMatrix<scalar_t>(m, n);
+    is.read((char*)D.data(), sizeof(scalar_t)*m*n);
+    if (!is.good()) return fail("unexpected end of file");
     return is;
   }
   template std::ifstream& operator>>(std::ifstream& os, DenseMatrix<float>& D);
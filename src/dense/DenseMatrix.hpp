@@ -966,7 +966,9 @@ namespace strumpack {
 
     /**
      * Read a DenseMatrix<scalar_t> from a binary file, called
-     * fname.
+     * fname. If the file was not written by write (for instance by
+     * an older version of STRUMPACK), with the same scalar type, an
+     * error is printed and an empty matrix is returned.
      *
      * \see write
      */
@@ -87,11 +87,13 @@ module strumpack
   enumerator :: STRUMPACK_MATCHING_MAX_DIAGONAL_SUM = 4
   enumerator :: STRUMPACK_MATCHING_MAX_DIAGONAL_PRODUCT_SCALING = 5
   enumerator :: STRUMPACK_MATCHING_COMBBLAS = 6
+  enumerator :: STRUMPACK_MATCHING_APPROX_DIAGONAL_PRODUCT_SCALING = 7
  end enum
  integer, parameter, public :: STRUMPACK_MATCHING_JOB = kind(STRUMPACK_MATCHING_NONE)
  public :: STRUMPACK_MATCHING_NONE, STRUMPACK_MATCHING_MAX_CARDINALITY, STRUMPACK_MATCHING_MAX_SMALLEST_DIAGONAL, &
     STRUMPACK_MATCHING_MAX_SMALLEST_DIAGONAL_2, STRUMPACK_MATCHING_MAX_DIAGONAL_SUM, &
-    STRUMPACK_MATCHING_MAX_DIAGONAL_PRODUCT_SCALING, STRUMPACK_MATCHING_COMBBLAS
+    STRUMPACK_MATCHING_MAX_DIAGONAL_PRODUCT_SCALING, STRUMPACK_MATCHING_COMBBLAS, &
+    STRUMPACK_MATCHING_APPROX_DIAGONAL_PRODUCT_SCALING
  ! typedef enum STRUMPACK_REORDERING_STRATEGY
  enum, bind(c)
   enumerator :: STRUMPACK_NATURAL = 0
@@ -106,10 +108,12 @@ module strumpack
   enumerator :: STRUMPACK_AND = 9
   enumerator :: STRUMPACK_MLF = 10
   enumerator :: STRUMPACK_SPECTRAL = 11
+  enumerator :: STRUMPACK_ND = 12
  end enum
  integer, parameter, public :: STRUMPACK_REORDERING_STRATEGY = kind(STRUMPACK_NATURAL)
  public :: STRUMPACK_NATURAL, STRUMPACK_METIS, STRUMPACK_PARMETIS, STRUMPACK_SCOTCH, STRUMPACK_PTSCOTCH, STRUMPACK_RCM, &
-    STRUMPACK_GEOMETRIC, STRUMPACK_AMD, STRUMPACK_MMD, STRUMPACK_AND, STRUMPACK_MLF, STRUMPACK_SPECTRAL
+    STRUMPACK_GEOMETRIC, STRUMPACK_AMD, STRUMPACK_MMD, STRUMPACK_AND, STRUMPACK_MLF, STRUMPACK_SPECTRAL, &
+    STRUMPACK_ND
  ! typedef enum STRUMPACK_GRAM_SCHMIDT_TYPE
  enum, bind(c)
   enumerator :: STRUMPACK_CLASSICAL = 0
@@ -140,10 +144,12 @@ module strumpack
   enumerator :: STRUMPACK_GMRES = 4
   enumerator :: STRUMPACK_PREC_BICGSTAB = 5
   enumerator :: STRUMPACK_BICGSTAB = 6
+  enumerator :: STRUMPACK_PREC_BLOCK_GMRES = 7
+  enumerator :: STRUMPACK_BLOCK_REFINE = 8
  end enum
  integer, parameter, public :: STRUMPACK_KRYLOV_SOLVER = kind(STRUMPACK_AUTO)
  public :: STRUMPACK_AUTO, STRUMPACK_DIRECT, STRUMPACK_REFINE, STRUMPACK_PREC_GMRES, STRUMPACK_GMRES, STRUMPACK_PREC_BICGSTAB, &
-    STRUMPACK_BICGSTAB
+    STRUMPACK_BICGSTAB, STRUMPACK_PREC_BLOCK_GMRES, STRUMPACK_BLOCK_REFINE
  ! typedef enum STRUMPACK_RETURN_CODE
  enum, bind(c)
   enumerator :: STRUMPACK_SUCCESS = 0
@@ -152,10 +158,13 @@ module strumpack
   enumerator :: STRUMPACK_ZERO_PIVOT = 3
   enumerator :: STRUMPACK_NO_CONVERGENCE = 4
   enumerator :: STRUMPACK_INACCURATE_INERTIA = 5
+  enumerator :: STRUMPACK_NOT_SUPPORTED = 6
+  enumerator :: STRUMPACK_FILE_ERROR = 7
  end enum
  integer, parameter, public :: STRUMPACK_RETURN_CODE = kind(STRUMPACK_SUCCESS)
  public :: STRUMPACK_SUCCESS, STRUMPACK_MATRIX_NOT_SET, STRUMPACK_REORDERING_ERROR, STRUMPACK_ZERO_PIVOT, &
-    STRUMPACK_NO_CONVERGENCE, STRUMPACK_INACCURATE_INERTIA
+    STRUMPACK_NO_CONVERGENCE, STRUMPACK_INACCURATE_INERTIA, STRUMPACK_NOT_SUPPORTED, &
+    STRUMPACK_FILE_ERROR
  public :: STRUMPACK_init_mt
  public :: STRUMPACK_set_distributed_csr_matrix
  public :: STRUMPACK_update_distributed_csr_matrix_values
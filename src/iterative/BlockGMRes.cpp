@@ -0,0 +1,274 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#include <iostream>
+#include <iomanip>
+#include <numeric>
+#include <algorithm>
+
+#include "IterativeSolvers.hpp"
+
+namespace strumpack {
+
+  namespace iterative {
+
+    /*
+     * Apply the Givens rotation [conj(c) conj(s); -s c] to rows i and
+     * i+1 of columns [c0, c1) of A.
+     */
+    template<typename scalar_t> void
+    apply_givens(DenseMatrix<scalar_t>& A, std::size_t i,
+                 std::size_t c0, std::size_t c1, scalar_t c, scalar_t s) {
+      for (std::size_t j=c0; j<c1; j++) {
+        auto a = A(i, j), b = A(i+1, j);
+        A(i, j) = blas::my_conj(c)*a + blas::my_conj(s)*b;
+        A(i+1, j) = -s*a + c*b;
+      }
+    }
+
+    /*
+     * This is left preconditioned restarted block GMRes, for all
+     * columns of b at once. The Krylov space is built from the block
+     * of (preconditioned) residuals. At each restart, columns that
+     * have converged are removed from the block, and the residual
+     * block is reduced to its numerical rank.
+     */
+    template<typename scalar_t, typename real_t> real_t BlockGMRes
+    (const BSPMV<scalar_t>& A, const BPREC<scalar_t>& M,
+     DenseMatrix<scalar_t>& x, const DenseMatrix<scalar_t>& b,
+     real_t rtol, real_t atol, int& totit, int maxit, int restart,
+     GramSchmidtType GStype, bool non_zero_guess, bool verbose) {
+      using DenseM_t = DenseMatrix<scalar_t>;
+      using DenseMW_t = DenseMatrixWrapper<scalar_t>;
+      const std::size_t n = b.rows(), nrhs = b.cols();
+      const auto eps = blas::lamch<real_t>('E');
+      if (restart > maxit) restart = maxit;
+      totit = 0;
+      if (!nrhs) return real_t(0.);
+      if (!non_zero_guess) x.zero();
+      DenseM_t b_prec(b);
+      M(b_prec);
+
+      std::vector<real_t> rho(nrhs), rho0(nrhs);
+      auto converged = [&](std::size_t j) {
+        return rho[j] < atol || rho[j] <= rtol * rho0[j];
+      };
+      auto print = [&](const std::vector<std::size_t>& J,
+                       std::size_t nact, bool rs) {
+        if (!verbose) return;
+        real_t mres(0.), mrel(0.);
+        for (auto j : J) {
+          mres = std::max(mres, rho[j]);
+          mrel = std::max(mrel, rho0[j] > real_t(0.) ? rho[j]/rho0[j] : real_t(0.));
+        }
+        std::cout << "BLOCK GMRES it. " << totit << "\tmax res = "
+                  << std::setw(12) << mres
+                  << "\tmax rel.res = " << std::setw(12) << mrel
+                  << "\tactive = " << nact
+                  << (rs ? "\t restart!" : "") << std::endl;
+      };
+
+      // active, not converged columns
+      std::vector<std::size_t> J(nrhs);
+      std::iota(J.begin(), J.end(), 0);
+      real_t rho_prev(0.);
+      for (int cycle=0; ; cycle++) {
+        std::size_t p = J.size();
+        DenseM_t R(n, p);
+        if (non_zero_guess || cycle > 0) {
+          auto xJ = x.extract_cols(J);
+          A(xJ, R);
+          M(R);
+          for (std::size_t j=0; j<p; j++)
+            for (std::size_t i=0; i<n; i++)
+              R(i, j) = b_prec(i, J[j]) - R(i, j);
+        } else R = b_prec.extract_cols(J);
+        for (std::size_t j=0; j<p; j++) {
+          rho[J[j]] = blas::nrm2(n, R.ptr(0, j), 1);
+          if (cycle == 0) rho0[J[j]] = rho[J[j]];
+        }
+        // deflation, remove converged columns from the block
+        std::vector<std::size_t> Jn, keep;
+        for (std::size_t j=0; j<p; j++)
+          if (!converged(J[j])) {
+            Jn.push_back(J[j]);
+            keep.push_back(j);
+          }
+        print(J, Jn.size(), true);
+        if (Jn.empty() || totit >= maxit) break;
+        // stop when the last cycle did not reduce the residual, for
+        // instance when the tolerance is below the working precision
+        real_t rmax(0.);
+        for (auto j : Jn) rmax = std::max(rmax, rho[j]);
+        if (cycle > 0 && rmax >= rho_prev) break;
+        rho_prev = rmax;
+        if (Jn.size() < p) {
+          R = R.extract_cols(keep);
+          J = Jn;
+          p = J.size();
+        }
+
+        // R = V0 S, with V0 n x r orthonormal, r <= p the numerical
+        // rank of R, using modified Gram-Schmidt
+        std::size_t r = 0;
+        DenseM_t S(p, p);
+        S.zero();
+        DenseM_t V(n, (restart+1)*p);
+        for (std::size_t j=0; j<p; j++) {
+          auto v = V.ptr(0, r);
+          std::copy(R.ptr(0, j), R.ptr(0, j)+n, v);
+          for (std::size_t i=0; i<r; i++) {
+            S(i, j) = blas::dotc(n, V.ptr(0, i), 1, v, 1);
+            blas::axpy(n, -S(i, j), V.ptr(0, i), 1, v, 1);
+          }
+          auto nrm = blas::nrm2(n, v, 1);
+          if (nrm > 10 * eps * rho[J[j]]) {
+            S(r, j) = nrm;
+            blas::scal(n, scalar_t(1.)/nrm, v, 1);
+            r++;
+          }
+        }
+        if (!r) break;
+
+        // block Arnoldi, with block size r, and QR factorization of
+        // the block Hessenberg matrix H using Givens rotations, which
+        // are also applied to G = [S; 0]
+        const std::size_t ldh = (restart+1)*r;
+        DenseM_t H(ldh, restart*r), G(ldh, p);
+        H.zero();
+        G.zero();
+        copy(r, p, S, 0, 0, G, 0, 0);
+        std::vector<std::size_t> rot_i;
+        std::vector<scalar_t> rot_c, rot_s;
+        std::size_t k = 0;
+        // after a breakdown, the next basis block has a zero column,
+        // so Arnoldi stops after that step, and the columns that did
+        // not converge yet continue in the next restart cycle
+        bool breakdown = false;
+        for (bool done=false; !done && k<std::size_t(restart); k++) {
+          totit++;
+          const std::size_t k0 = k*r, k1 = k0+r;
+          DenseMW_t Vk(n, r, V, 0, k0), W(n, r, V, 0, k1);
+          A(Vk, W);
+          M(W);
+          std::vector<real_t> wnrm(r);
+          for (std::size_t j=0; j<r; j++)
+            wnrm[j] = blas::nrm2(n, W.ptr(0, j), 1);
+          if (GStype == GramSchmidtType::CLASSICAL) {
+            DenseMW_t Vp(n, k1, V, 0, 0), Hk(k1, r, H, 0, k0);
+            gemm(Trans::C, Trans::N, scalar_t(1.), Vp, W,
+                 scalar_t(0.), Hk);
+            gemm(Trans::N, Trans::N, scalar_t(-1.), Vp, Hk,
+                 scalar_t(1.), W);
+          } else {
+            for (std::size_t i=0; i<=k; i++) {
+              DenseMW_t Vi(n, r, V, 0, i*r), Hik(r, r, H, i*r, k0);
+              gemm(Trans::C, Trans::N, scalar_t(1.), Vi, W,
+                   scalar_t(0.), Hik);
+              gemm(Trans::N, Trans::N, scalar_t(-1.), Vi, Hik,
+                   scalar_t(1.), W);
+            }
+          }
+          // W = V_{k+1} H_{k+1,k}
+          for (std::size_t j=0; j<r; j++) {
+            auto w = W.ptr(0, j);
+            for (std::size_t i=0; i<j; i++) {
+              auto h = blas::dotc(n, W.ptr(0, i), 1, w, 1);
+              blas::axpy(n, -h, W.ptr(0, i), 1, w, 1);
+              H(k1+i, k0+j) = h;
+            }
+            auto nrm = blas::nrm2(n, w, 1);
+            H(k1+j, k0+j) = nrm;
+            if (nrm <= 10 * eps * wnrm[j]) {
+              // (lucky) breakdown, stop after this step
+              std::fill(w, w+n, scalar_t(0.));
+              breakdown = true;
+            } else blas::scal(n, scalar_t(1.)/nrm, w, 1);
+          }
+          for (std::size_t t=0; t<rot_i.size(); t++)
+            apply_givens(H, rot_i[t], k0, k1, rot_c[t], rot_s[t]);
+          for (std::size_t c=k0; c<k1; c++)
+            for (std::size_t i=c+r; i>c; i--) {
+              auto a = H(i-1, c), h = H(i, c);
+              auto delta = std::sqrt(std::norm(a) + std::norm(h));
+              scalar_t gc(1.), gs(0.);
+              if (delta != real_t(0.)) { gc = a / delta; gs = h / delta; }
+              apply_givens(H, i-1, c, k1, gc, gs);
+              apply_givens(G, i-1, 0, p, gc, gs);
+              rot_i.push_back(i-1);
+              rot_c.push_back(gc);
+              rot_s.push_back(gs);
+            }
+          bool all_converged = true;
+          for (std::size_t j=0; j<p; j++) {
+            rho[J[j]] = blas::nrm2(r, G.ptr(k1, j), 1);
+            if (!converged(J[j])) all_converged = false;
+          }
+          done = breakdown || all_converged || totit >= maxit;
+          print(J, p, false);
+        }
+        // x(:,J) += V Y, with H Y = G
+        const std::size_t K = k*r;
+        DenseMW_t Hk(K, K, H, 0, 0), Y(K, p, G, 0, 0), Vk(n, K, V, 0, 0);
+        trsm(Side::L, UpLo::U, Trans::N, Diag::N, scalar_t(1.), Hk, Y);
+        DenseM_t dx(n, p);
+        gemm(Trans::N, Trans::N, scalar_t(1.), Vk, Y, scalar_t(0.), dx);
+        for (std::size_t j=0; j<p; j++)
+          blas::axpy(n, scalar_t(1.), dx.ptr(0, j), 1, x.ptr(0, J[j]), 1);
+      }
+      return *std::max_element(rho.begin(), rho.end());
+    }
+
+    // explicit template instantiations
+    template float BlockGMRes
+    (const BSPMV<float>& A, const BPREC<float>& M,
+     DenseMatrix<float>& x, const DenseMatrix<float>& b,
+     float rtol, float atol, int& totit, int maxit, int restart,
+     GramSchmidtType GStype, bool non_zero_guess, bool verbose);
+    template double BlockGMRes
+    (const BSPMV<double>& A, const BPREC<double>& M,
+     DenseMatrix<double>& x, const DenseMatrix<double>& b,
+     double rtol, double atol, int& totit, int maxit, int restart,
+     GramSchmidtType GStype, bool non_zero_guess, bool verbose);
+    template float BlockGMRes
+    (const BSPMV<std::complex<float>>& A,
+     const BPREC<std::complex<float>>& M,
+     DenseMatrix<std::complex<float>>& x,
+     const DenseMatrix<std::complex<float>>& b,
+     float rtol, float atol, int& totit, int maxit, int restart,
+     GramSchmidtType GStype, bool non_zero_guess, bool verbose);
+    template double BlockGMRes
+    (const BSPMV<std::complex<double>>& A,
+     const BPREC<std::complex<double>>& M,
+     DenseMatrix<std::complex<double>>& x,
+     const DenseMatrix<std::complex<double>>& b,
+     double rtol, double atol, int& totit, int maxit, int restart,
+     GramSchmidtType GStype, bool non_zero_guess, bool verbose);
+
+  } // end namespace iterative
+} // end namespace strumpack
@@ -44,15 +44,19 @@ namespace strumpack {
     using Prec = std::function<void(DMat<scalar_t>&)>;
 
 
-    template<typename scalar_t,typename integer_t,typename real_t> void
-    IterativeRefinement(const SpMat<scalar_t,integer_t>& A,
+    template<typename scalar_t,typename real_t> void
+    IterativeRefinement(const std::function
+                        <void(const DMat<scalar_t>&, DMat<scalar_t>&)>& A,
+                        const std::function
+                        <real_t(const DMat<scalar_t>&,
+                                const DMat<scalar_t>&)>& bw,
                         const Prec<scalar_t>& M,
                         DMat<scalar_t>& x, const DMat<scalar_t>& b,
                         real_t rtol, real_t atol, int& totit, int maxit,
                         bool non_zero_guess, bool verbose) {
       DMat<scalar_t> r(x.rows(), x.cols());
       if (non_zero_guess) {
-        A.spmv(x, r);
+        A(x, r);
         r.scale_and_add(scalar_t(-1.), b);
       } else {
         r = b;
@@ -73,8 +77,8 @@ namespace strumpack {
              totit++ < maxit && bw_error > atol) {
         M(r);
         x.add(r);
-        bw_error = A.max_scaled_residual(x, b);
-        A.spmv(x, r);
+        bw_error = bw(x, b);
+        A(x, r);
         r.scale_and_add(scalar_t(-1.), b);
         res_norm = r.norm();
         rel_res_norm = res_norm / res0;
@@ -88,6 +92,88 @@ namespace strumpack {
     }
 
 
+    template<typename scalar_t,typename integer_t,typename real_t> void
+    IterativeRefinement(const SpMat<scalar_t,integer_t>& A,
+                        const Prec<scalar_t>& M,
+                        DMat<scalar_t>& x, const DMat<scalar_t>& b,
+                        real_t rtol, real_t atol, int& totit, int maxit,
+                        bool non_zero_guess, bool verbose) {
+      std::function<void(const DMat<scalar_t>&, DMat<scalar_t>&)> Aop =
+        [&A](const DMat<scalar_t>& v, DMat<scalar_t>& w) { A.spmv(v, w); };
+      std::function<real_t(const DMat<scalar_t>&, const DMat<scalar_t>&)> bw =
+        [&A](const DMat<scalar_t>& v, const DMat<scalar_t>& w) {
+          return A.max_scaled_residual(v, w); };
+      IterativeRefinement<scalar_t>
+        (Aop, bw, M, x, b, rtol, atol, totit, maxit, non_zero_guess, verbose);
+    }
+
+    template<typename scalar_t,typename real_t> void
+    BlockIterativeRefinement(const BSPMV<scalar_t>& A,
+                             const std::function
+                             <real_t(const DMat<scalar_t>&,
+                                     const DMat<scalar_t>&)>& bw,
+                             const BPREC<scalar_t>& M,
+                             DMat<scalar_t>& x, const DMat<scalar_t>& b,
+                             real_t rtol, real_t atol, int& totit, int maxit,
+                             bool non_zero_guess, bool verbose) {
+      const std::size_t n = x.rows(), nrhs = x.cols();
+      DMat<scalar_t> r(n, nrhs);
+      if (non_zero_guess) {
+        A(x, r);
+        r.scale_and_add(scalar_t(-1.), b);
+      } else {
+        r = b;
+        x.zero();
+      }
+      std::vector<real_t> res(nrhs), res0(nrhs), bw_error(nrhs, real_t(1.));
+      for (std::size_t j=0; j<nrhs; j++)
+        res[j] = res0[j] = blas::nrm2(n, r.ptr(0, j), 1);
+      // active, not converged columns
+      std::vector<std::size_t> J;
+      auto deflate = [&]() {
+        J.clear();
+        for (std::size_t j=0; j<nrhs; j++)
+          if (res[j] > atol && res[j] > rtol * res0[j] && bw_error[j] > atol)
+            J.push_back(j);
+      };
+      auto print = [&]() {
+        if (!verbose) return;
+        real_t mres(0.), mrel(0.), mbw(0.);
+        for (std::size_t j=0; j<nrhs; j++) {
+          mres = std::max(mres, res[j]);
+          mrel = std::max(mrel, res0[j] > real_t(0.) ? res[j]/res0[j] : real_t(0.));
+          mbw = std::max(mbw, bw_error[j]);
+        }
+        std::cout << "BLOCK REFINEMENT it. " << totit
+                  << "\tmax res = " << std::setw(12) << mres
+                  << "\tmax rel.res = " << std::setw(12) << mrel
+                  << "\tmax bw.error = " << std::setw(12) << mbw
+                  << "\tactive = " << J.size() << std::endl;
+      };
+      totit = 0;
+      deflate();
+      print();
+      while (!J.empty() && totit++ < maxit) {
+        auto rJ = r.extract_cols(J);
+        M(rJ);
+        for (std::size_t j=0; j<J.size(); j++)
+          blas::axpy(n, scalar_t(1.), rJ.ptr(0, j), 1, x.ptr(0, J[j]), 1);
+        auto xJ = x.extract_cols(J);
+        A(xJ, rJ);
+        for (std::size_t j=0; j<J.size(); j++) {
+          auto c = J[j];
+          for (std::size_t i=0; i<n; i++)
+            r(i, c) = b(i, c) - rJ(i, j);
+          res[c] = blas::nrm2(n, r.ptr(0, c), 1);
+          bw_error[c] = bw
+            (*ConstDenseMatrixWrapperPtr(n, 1, x.ptr(0, c), x.ld()),
+             *ConstDenseMatrixWrapperPtr(n, 1, b.ptr(0, c), b.ld()));
+        }
+        deflate();
+        print();
+      }
+    }
+
     // TODO avoid this duplication
     template<typename scalar_t,typename real_t> void
     IterativeRefinement(const DMat<scalar_t>& A, const Prec<scalar_t>& M,
@@ -125,6 +211,76 @@ namespace strumpack {
     }
 
     // explicit template instantiations
+    template void
+    BlockIterativeRefinement(const BSPMV<float>& A,
+                             const std::function
+                             <float(const DMat<float>&, const DMat<float>&)>& bw,
+                             const BPREC<float>& M,
+                             DMat<float>& x, const DMat<float>& b,
+                             float rtol, float atol, int& totit, int maxit,
+                             bool non_zero_guess, bool verbose);
+    template void
+    BlockIterativeRefinement(const BSPMV<double>& A,
+                             const std::function
+                             <double(const DMat<double>&, const DMat<double>&)>& bw,
+                             const BPREC<double>& M,
+                             DMat<double>& x, const DMat<double>& b,
+                             double rtol, double atol, int& totit, int maxit,
+                             bool non_zero_guess, bool verbose);
+    template void
+    BlockIterativeRefinement(const BSPMV<std::complex<float>>& A,
+                             const std::function
+                             <float(const DMat<std::complex<float>>&, const DMat<std::complex<float>>&)>& bw,
+                             const BPREC<std::complex<float>>& M,
+                             DMat<std::complex<float>>& x, const DMat<std::complex<float>>& b,
+                             float rtol, float atol, int& totit, int maxit,
+                             bool non_zero_guess, bool verbose);
+    template void
+    BlockIterativeRefinement(const BSPMV<std::complex<double>>& A,
+                             const std::function
+                             <double(const DMat<std::complex<double>>&, const DMat<std::complex<double>>&)>& bw,
+                             const BPREC<std::complex<double>>& M,
+                             DMat<std::complex<double>>& x, const DMat<std::complex<double>>& b,
+                             double rtol, double atol, int& totit, int maxit,
+                             bool non_zero_guess, bool verbose);
+
+    template void
+    IterativeRefinement(const std::function
+                        <void(const DMat<float>&, DMat<float>&)>& A,
+                        const std::function
+                        <float(const DMat<float>&, const DMat<float>&)>& bw,
+                        const Prec<float>& M,
+                        DMat<float>& x, const DMat<float>& b,
+                        float rtol, float atol, int& totit, int maxit,
+                        bool non_zero_guess, bool verbose);
+    template void
+    IterativeRefinement(const std::function
+                        <void(const DMat<double>&, DMat<double>&)>& A,
+                        const std::function
+                        <double(const DMat<double>&, const DMat<double>&)>& bw,
+                        const Prec<double>& M,
+                        DMat<double>& x, const DMat<double>& b,
+                        double rtol, double atol, int& totit, int maxit,
+                        bool non_zero_guess, bool verbose);
+    template void
+    IterativeRefinement(const std::function
+                        <void(const DMat<std::complex<float>>&, DMat<std::complex<float>>&)>& A,
+                        const std::function
+                        <float(const DMat<std::complex<float>>&, const DMat<std::complex<float>>&)>& bw,
+                        const Prec<std::complex<float>>& M,
+                        DMat<std::complex<float>>& x, const DMat<std::complex<float>>& b,
+                        float rtol, float atol, int& totit, int maxit,
+                        bool non_zero_guess, bool verbose);
+    template void
+    IterativeRefinement(const std::function
+                        <void(const DMat<std::complex<double>>&, DMat<std::complex<double>>&)>& A,
+                        const std::function
+                        <double(const DMat<std::complex<double>>&, const DMat<std::complex<double>>&)>& bw,
+                        const Prec<std::complex<double>>& M,
+                        DMat<std::complex<double>>& x, const DMat<std::complex<double>>& b,
+                        double rtol, double atol, int& totit, int maxit,
+                        bool non_zero_guess, bool verbose);
+
     template void
     IterativeRefinement(const SpMat<float,int>& A, const Prec<float>& M,
                         DMat<float>& x, const DMat<float>& b,
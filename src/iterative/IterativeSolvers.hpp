@@ -48,6 +48,13 @@ namespace strumpack {
     template<typename T>
     using PREC = std::function<void(T*)>;
 
+    template<typename T>
+    using BSPMV = std::function<void(const DenseMatrix<T>&,
+                                     DenseMatrix<T>&)>;
+
+    template<typename T>
+    using BPREC = std::function<void(DenseMatrix<T>&)>;
+
     /*
      * This is left preconditioned restarted GMRes.
      *
@@ -63,6 +70,35 @@ namespace strumpack {
                  bool non_zero_guess, bool verbose);
 
 
+    /**
+     * Left preconditioned restarted block GMRes, for all columns of
+     * x and b at once. The matrix and the preconditioner are always
+     * applied to a block of vectors. Columns that have converged are
+     * removed from the block (deflated) at restart.
+     *
+     * \param A routine to compute y = A x, for a block of vectors
+     * \param M routine to apply the preconditioner to a block of
+     * vectors, in place
+     * \param x on output this contains the solution, on input this can
+     * be the initial guess. Should be allocated to the size of b.
+     * \param b the right hand sides
+     * \param rtol relative stopping tolerance, per column
+     * \param atol absolute stopping tolerance, per column
+     * \param totit on output the number of block iterations
+     * \param maxit maximum number of block iterations
+     * \param restart restart length, in number of blocks
+     * \return maximum (preconditioned) residual norm over all columns
+     */
+    template<typename scalar_t,
+             typename real_t = typename RealType<scalar_t>::value_type>
+    real_t BlockGMRes(const BSPMV<scalar_t>& A,
+                      const BPREC<scalar_t>& M,
+                      DenseMatrix<scalar_t>& x,
+                      const DenseMatrix<scalar_t>& b,
+                      real_t rtol, real_t atol, int& totit, int maxit,
+                      int restart, GramSchmidtType GStype,
+                      bool non_zero_guess, bool verbose);
+
     /**
      * http://www.netlib.org/templates/matlab/bicgstab.m
      */
@@ -105,6 +141,76 @@ namespace strumpack {
                              bool non_zero_guess, bool verbose);
 
 
+    /**
+     * Iterative refinement, with the matrix given as a routine, to
+     * solve a linear system M^{-1}op(A)x=M^{-1}b.
+     *
+     * \tparam scalar_t scalar type
+     * \tparam real_t real type, can be derived from the scalar_t type
+     *
+     * \param A routine to compute y = op(A) x
+     * \param bw_error routine to compute the componentwise backward
+     * error of x, for right hand side b
+     * \param M routine to apply M^{-1} to a matrix
+     * \param x on output this contains the solution, on input this can
+     * be the initial guess.
+     * \param b the right hand side
+     * \param rtol relative stopping tolerance
+     * \param atol absolute stopping tolerance
+     * \param totit on output this will contain the number of iterations
+     * that were performed
+     * \param maxit maximum number of iterations
+     * \param non_zero_guess x use x as an initial guess
+     */
+    template<typename scalar_t,
+             typename real_t = typename RealType<scalar_t>::value_type>
+    void IterativeRefinement(const std::function
+                             <void(const DenseMatrix<scalar_t>&,
+                                   DenseMatrix<scalar_t>&)>& A,
+                             const std::function
+                             <real_t(const DenseMatrix<scalar_t>&,
+                                     const DenseMatrix<scalar_t>&)>& bw_error,
+                             const std::function
+                             <void(DenseMatrix<scalar_t>&)>& M,
+                             DenseMatrix<scalar_t>& x,
+                             const DenseMatrix<scalar_t>& b,
+                             real_t rtol, real_t atol, int& totit, int maxit,
+                             bool non_zero_guess, bool verbose);
+
+
+    /**
+     * Iterative refinement for multiple right hand sides, with per
+     * column convergence checks. Only the columns that have not yet
+     * converged are refined, the matrix and the preconditioner are
+     * applied to that block of columns at once.
+     *
+     * \param A routine to compute y = A x, for a block of vectors
+     * \param bw_error routine to compute the componentwise backward
+     * error of a single column x, for right hand side b
+     * \param M routine to apply M^{-1} to a block of vectors
+     * \param x on output this contains the solution, on input this can
+     * be the initial guess.
+     * \param b the right hand sides
+     * \param rtol relative stopping tolerance, per column
+     * \param atol absolute stopping tolerance, per column
+     * \param totit on output this will contain the number of iterations
+     * that were performed
+     * \param maxit maximum number of iterations
+     * \param non_zero_guess x use x as an initial guess
+     */
+    template<typename scalar_t,
+             typename real_t = typename RealType<scalar_t>::value_type>
+    void BlockIterativeRefinement(const BSPMV<scalar_t>& A,
+                                  const std::function
+                                  <real_t(const DenseMatrix<scalar_t>&,
+                                          const DenseMatrix<scalar_t>&)>& bw_error,
+                                  const BPREC<scalar_t>& M,
+                                  DenseMatrix<scalar_t>& x,
+                                  const DenseMatrix<scalar_t>& b,
+                                  real_t rtol, real_t atol, int& totit,
+                                  int maxit, bool non_zero_guess,
+                                  bool verbose);
+
     /**
      * Iterative refinement, with a dense matrix, to solve a linear
      * system M^{-1}Ax=M^{-1}b.
@@ -121,7 +121,8 @@ template<typename scalar_t> void STRUMPACK_kernel_fit_HODLR_MPI
 #endif
 
 template<typename scalar_t> void STRUMPACK_kernel_predict
-(STRUMPACKKernel kernel, int m, scalar_t* test, scalar_t* prediction) {
+(STRUMPACKKernel kernel, int m, scalar_t* test, scalar_t* prediction,
+ scalar_t tol=scalar_t(0.)) {
   auto KR = static_cast<STRUMPACKKernelRegression<scalar_t>*>(kernel);
   DenseMatrixWrapper<scalar_t> test_(KR->K_->d(), m, test, KR->K_->d());
   if (KR->dist_) {
@@ -130,7 +131,7 @@ template<typename scalar_t> void STRUMPACK_kernel_predict
     std::copy(pred.begin(), pred.end(), prediction);
 #endif
   } else {
-    auto pred = KR->K_->predict(test_, KR->weights_);
+    auto pred = KR->K_->predict(test_, KR->weights_, tol);
     std::copy(pred.begin(), pred.end(), prediction);
   }
 }
@@ -194,6 +195,17 @@ extern "C" {
     STRUMPACK_kernel_predict<float>(kernel, m, test, prediction);
   }
 
+  void STRUMPACK_kernel_predict_tol_double
+  (STRUMPACKKernel kernel, int m, double* test, double* prediction,
+   double tol) {
+    STRUMPACK_kernel_predict<double>(kernel, m, test, prediction, tol);
+  }
+  void STRUMPACK_kernel_predict_tol_float
+  (STRUMPACKKernel kernel, int m, float* test, float* prediction,
+   float tol) {
+    STRUMPACK_kernel_predict<float>(kernel, m, test, prediction, tol);
+  }
+
 #ifdef __cplusplus
 }
 #endif
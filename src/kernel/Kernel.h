@@ -79,6 +79,18 @@ extern "C" {
   void STRUMPACK_kernel_predict_float
   (STRUMPACKKernel K, int m, float* test, float* prediction);
 
+  /**
+   * Prediction for a batch of m test points, skipping the clusters of
+   * training points where the kernel is smaller than tol, which
+   * gives an error of at most tol times the 1-norm of the weights.
+   * With tol = 0 this is the same as STRUMPACK_kernel_predict_*. For
+   * an HSS MPI fit, tol is ignored.
+   */
+  void STRUMPACK_kernel_predict_tol_double
+  (STRUMPACKKernel K, int m, double* test, double* prediction, double tol);
+  void STRUMPACK_kernel_predict_tol_float
+  (STRUMPACKKernel K, int m, float* test, float* prediction, float tol);
+
 #ifdef __cplusplus
 }
 #endif
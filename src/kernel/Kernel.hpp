@@ -36,7 +36,11 @@
 #ifndef STRUMPACK_KERNEL_HPP
 #define STRUMPACK_KERNEL_HPP
 
+#include <mutex>
+#include <limits>
+
 #include "Metrics.hpp"
+#include "structured/ClusterTree.hpp"
 #include "HSS/HSSOptions.hpp"
 #include "dense/DenseMatrix.hpp"
 #if defined(STRUMPACK_USE_MPI)
@@ -64,7 +68,10 @@ namespace strumpack {
      *
      * The actual kernel function is implemented in one of the
      * subclasses of this class. Subclasses need to implement the
-     * purely virtual function eval_kernel_function.
+     * purely virtual function eval_kernel_function. Subclasses can
+     * also implement eval_block, to evaluate a submatrix K(I,J) at
+     * once, which is much faster than calling eval_kernel_function
+     * for every element.
      *
      * \tparam scalar_t Scalar type of the input data points and the
      * kernel representation. Can be float, double,
@@ -139,6 +146,7 @@ namespace strumpack {
                       const std::vector<std::size_t>& J,
                       DenseMatrix<real_t>& B) const {
         assert(B.rows() == I.size() && B.cols() == J.size());
+        if (I.empty() || J.empty() || eval_block(I, J, B)) return;
         for (std::size_t j=0; j<J.size(); j++)
           for (std::size_t i=0; i<I.size(); i++) {
             assert(I[i] < n() && J[j] < n());
@@ -193,15 +201,28 @@ namespace strumpack {
        * Return prediction scores for the test points, using the
        * weights computed in fit_HSS() or fit_HODLR().
        *
+       * The test points are processed in tiles, in parallel, and the
+       * kernel is evaluated for a tile of test points and a block of
+       * training points at once. If tol > 0 and a cluster tree is
+       * available, see cluster_tree(), clusters of training points
+       * that are far enough from a tile of test points that the
+       * kernel is smaller than tol are skipped. The error on each
+       * score is then at most tol times the 1-norm of the
+       * weights. This is only possible for kernels which decay with
+       * the distance, see decay_bound().
+       *
        * \param test Test data set, should be test.rows() == this->d()
        * \param weights Weights computed by fit_HSS() or fit_HODLR()
+       * \param tol Tolerance for skipping far away training points,
+       * with tol = 0 all training points are used.
        * \return Vector with prediction scores. One can use the sign
        * (threshold zero), to decide which of 2 classes each test
        * point belongs to.
        * \see fit_HSS, fit_HODLR
        */
       std::vector<scalar_t> predict
-      (const DenseM_t& test, const DenseM_t& weights) const;
+      (const DenseM_t& test, const DenseM_t& weights,
+       real_t tol=real_t(0.)) const;
 
 #if defined(STRUMPACK_USE_MPI)
       /**
@@ -276,22 +297,124 @@ namespace strumpack {
       const DenseM_t& data() const { return data_; }
       /**
        * Returns a reference to the data used to define this
-       * kernel.
+       * kernel. Since the data can be modified, this invalidates the
+       * cached norms of the data points, see squared_norms().
        * \return reference to the datapoint, a matrix of size d x n.
        */
-      DenseM_t& data() { return data_; }
+      DenseM_t& data() {
+        sqnorms_.clear();
+        return data_;
+      }
 
       std::vector<int>& permutation() { return perm_; }
       const std::vector<int>& permutation() const { return perm_; }
 
+      /**
+       * The cluster tree for the data points, defined by the
+       * clustering done in fit_HSS() or fit_HODLR(), or empty (size
+       * 0). This is used in predict().
+       */
+      const structured::ClusterTree& cluster_tree() const { return tree_; }
+      void set_cluster_tree(const structured::ClusterTree& t) { tree_ = t; }
+
       virtual void permute() {
         data_.lapmr(perm_, true);
+        sqnorms_.clear();
       }
 
     protected:
       DenseM_t& data_;
       scalar_t lambda_;
       std::vector<int> perm_;
+      structured::ClusterTree tree_;
+
+      /**
+       * Evaluate the submatrix K(I,J), including lambda on the
+       * diagonal, at once. The default returns false, meaning this
+       * kernel has no block evaluation, and then eval() is called for
+       * every element. I and J are not empty.
+       *
+       * \param I set of row indices of elements to extract
+       * \param J set of col indices of elements to extract
+       * \param B B should be set to K(I,J), B.rows() == I.size()
+       * and B.cols() == J.size()
+       * \return true if B was computed
+       */
+      virtual bool eval_block(const std::vector<std::size_t>& I,
+                              const std::vector<std::size_t>& J,
+                              DenseMatrix<real_t>& B) const {
+        return false;
+      }
+
+      /**
+       * Evaluate the kernel function for all pairs of points from X
+       * and Y, without lambda. This is used in predict(), with
+       * training points X and test points Y. The default returns
+       * false, and then eval_kernel_function is used.
+       *
+       * \param X d x m matrix with data points
+       * \param Y d x k matrix with data points
+       * \param B B should be set to k(X(:,i), Y(:,j)), B is m x k
+       * \return true if B was computed
+       */
+      virtual bool eval_points(const DenseMatrix<real_t>& X,
+                               const DenseMatrix<real_t>& Y,
+                               DenseMatrix<real_t>& B) const {
+        return false;
+      }
+
+      /**
+       * Upper bound for |k(x,y)| for all points x and y with
+       * ||x-y||_2 >= dist. The default is infinity, meaning the
+       * kernel does not decay, and predict() can not skip any
+       * training points.
+       */
+      virtual real_t decay_bound(real_t dist) const {
+        return std::numeric_limits<real_t>::infinity();
+      }
+
+      /**
+       * Squared 2-norms of all data points, computed on first use and
+       * kept until the data is permuted or modified.
+       */
+      const std::vector<real_t>& squared_norms() const {
+        std::lock_guard<std::mutex> lock(sqnorms_mtx_);
+        if (sqnorms_.size() != n()) {
+          sqnorms_.resize(n());
+          for (std::size_t j=0; j<n(); j++) {
+            real_t nrm(0.);
+            for (std::size_t k=0; k<d(); k++) {
+              auto x = std::real(data_(k, j));
+              nrm += x * x;
+            }
+            sqnorms_[j] = nrm;
+          }
+        }
+        return sqnorms_;
+      }
+
+      /**
+       * Copy the data points I to the columns of a d x I.size()
+       * matrix.
+       */
+      DenseMatrix<real_t> points(const std::vector<std::size_t>& I) const {
+        DenseMatrix<real_t> X(d(), I.size());
+        for (std::size_t i=0; i<I.size(); i++)
+          for (std::size_t k=0; k<d(); k++)
+            X(k, i) = std::real(data_(k, I[i]));
+        return X;
+      }
+
+      /**
+       * Add lambda to the elements of K(I,J) on the diagonal of K.
+       */
+      void add_lambda(const std::vector<std::size_t>& I,
+                      const std::vector<std::size_t>& J,
+                      DenseMatrix<real_t>& B) const {
+        for (std::size_t j=0; j<J.size(); j++)
+          for (std::size_t i=0; i<I.size(); i++)
+            if (I[i] == J[j]) B(i, j) += std::real(lambda_);
+      }
 
       /**
        * Purely virtual function that needs to be defined in the
@@ -309,6 +432,10 @@ namespace strumpack {
        */
       virtual scalar_t eval_kernel_function
       (const scalar_t* x, const scalar_t* y) const = 0;
+
+    private:
+      mutable std::vector<real_t> sqnorms_;
+      mutable std::mutex sqnorms_mtx_;
     };
 
 
@@ -331,6 +458,7 @@ namespace strumpack {
      */
     template<typename scalar_t>
     class GaussKernel : public Kernel<scalar_t> {
+      using real_t = typename RealType<scalar_t>::value_type;
     public:
       /**
        * Constructor of the kernel object.
@@ -354,6 +482,73 @@ namespace strumpack {
           (-Euclidean_distance_squared(this->d(), x, y)
            / (scalar_t(2.) * h_ * h_));
       }
+
+      /**
+       * The squared distances are computed as ||x||^2 + ||y||^2 - 2
+       * x^T y, with a single gemm for the inner products and the
+       * cached norms of the points.
+       */
+      bool eval_block(const std::vector<std::size_t>& I,
+                      const std::vector<std::size_t>& J,
+                      DenseMatrix<real_t>& B) const override {
+        if (is_complex<scalar_t>()) return false;
+        const auto& nrm = this->squared_norms();
+        auto XI = this->points(I), XJ = this->points(J);
+        gemm(Trans::T, Trans::N, real_t(-2.), XI, XJ, real_t(0.), B);
+        std::vector<real_t> nI(I.size()), nJ(J.size());
+        for (std::size_t i=0; i<I.size(); i++) nI[i] = nrm[I[i]];
+        for (std::size_t j=0; j<J.size(); j++) nJ[j] = nrm[J[j]];
+        exp_distance(nI, nJ, B);
+        for (std::size_t j=0; j<J.size(); j++)
+          for (std::size_t i=0; i<I.size(); i++)
+            if (I[i] == J[j]) B(i, j) = real_t(1.);
+        this->add_lambda(I, J, B);
+        return true;
+      }
+
+      bool eval_points(const DenseMatrix<real_t>& X,
+                       const DenseMatrix<real_t>& Y,
+                       DenseMatrix<real_t>& B) const override {
+        if (is_complex<scalar_t>()) return false;
+        gemm(Trans::T, Trans::N, real_t(-2.), X, Y, real_t(0.), B);
+        exp_distance(column_norms(X), column_norms(Y), B);
+        return true;
+      }
+
+      real_t decay_bound(real_t dist) const override {
+        return std::exp(-dist * dist / (real_t(2.) * std::real(h_ * h_)));
+      }
+
+    private:
+      static std::vector<real_t>
+      column_norms(const DenseMatrix<real_t>& X) {
+        std::vector<real_t> nrm(X.cols());
+        for (std::size_t j=0; j<X.cols(); j++) {
+          auto x = X.ptr(0, j);
+          for (std::size_t k=0; k<X.rows(); k++)
+            nrm[j] += x[k] * x[k];
+        }
+        return nrm;
+      }
+
+      /**
+       * On input B(i,j) = -2 x_i^T y_j, on output the kernel
+       * exp(-(nX[i] + nY[j] + B(i,j)) / (2 h^2)).
+       */
+      void exp_distance(const std::vector<real_t>& nX,
+                        const std::vector<real_t>& nY,
+                        DenseMatrix<real_t>& B) const {
+        const real_t s = real_t(-1.) / (real_t(2.) * std::real(h_ * h_));
+        const std::size_t m = B.rows();
+        for (std::size_t j=0; j<B.cols(); j++) {
+          const auto nj = nY[j];
+          auto b = B.ptr(0, j);
+          // rounding can make the distance slightly negative
+#pragma omp simd
+          for (std::size_t i=0; i<m; i++)
+            b[i] = std::exp(s * std::max(real_t(0.), b[i] + nX[i] + nj));
+        }
+      }
     };
 
 
@@ -376,6 +571,7 @@ namespace strumpack {
      */
     template<typename scalar_t>
     class LaplaceKernel : public Kernel<scalar_t> {
+      using real_t = typename RealType<scalar_t>::value_type;
     public:
       /**
        * Constructor of the kernel object.
@@ -397,6 +593,52 @@ namespace strumpack {
       (const scalar_t* x, const scalar_t* y) const override {
         return std::exp(-norm1_distance(this->d(), x, y) / h_);
       }
+
+      bool eval_block(const std::vector<std::size_t>& I,
+                      const std::vector<std::size_t>& J,
+                      DenseMatrix<real_t>& B) const override {
+        if (!eval_points(this->points(I), this->points(J), B))
+          return false;
+        this->add_lambda(I, J, B);
+        return true;
+      }
+
+      /**
+       * The 1-norm distance can not be computed with a gemm, instead
+       * the loops are ordered so the innermost loop is over the rows
+       * of the block, with stride 1.
+       */
+      bool eval_points(const DenseMatrix<real_t>& X,
+                       const DenseMatrix<real_t>& Y,
+                       DenseMatrix<real_t>& B) const override {
+        if (is_complex<scalar_t>()) return false;
+        auto Xt = X.transpose();
+        const real_t s = real_t(-1.) / std::real(h_);
+        const std::size_t m = X.cols(), d = this->d();
+        for (std::size_t j=0; j<Y.cols(); j++) {
+          auto y = Y.ptr(0, j);
+          auto b = B.ptr(0, j);
+          std::fill(b, b+m, real_t(0.));
+          for (std::size_t k=0; k<d; k++) {
+            auto x = Xt.ptr(0, k);
+            const real_t yk = y[k];
+#pragma omp simd
+            for (std::size_t i=0; i<m; i++)
+              b[i] += std::abs(x[i] - yk);
+          }
+#pragma omp simd
+          for (std::size_t i=0; i<m; i++)
+            b[i] = std::exp(s * b[i]);
+        }
+        return true;
+      }
+
+      /**
+       * Uses ||x-y||_1 >= ||x-y||_2.
+       */
+      real_t decay_bound(real_t dist) const override {
+        return std::exp(-dist / std::real(h_));
+      }
     };
 
     /**
@@ -422,6 +664,7 @@ namespace strumpack {
      */
     template<typename scalar_t>
     class ANOVAKernel : public Kernel<scalar_t> {
+      using real_t = typename RealType<scalar_t>::value_type;
     public:
       /**
        * Constructor of the kernel object.
@@ -468,6 +711,75 @@ namespace strumpack {
         }
         return Kpp[p_];
       }
+
+      bool eval_block(const std::vector<std::size_t>& I,
+                      const std::vector<std::size_t>& J,
+                      DenseMatrix<real_t>& B) const override {
+        if (!eval_points(this->points(I), this->points(J), B))
+          return false;
+        this->add_lambda(I, J, B);
+        return true;
+      }
+
+      /**
+       * Same recurrence as eval_kernel_function, for all rows of a
+       * column of the block at once. The per feature kernels are
+       * not a function of the distance, so no gemm is used.
+       */
+      bool eval_points(const DenseMatrix<real_t>& X,
+                       const DenseMatrix<real_t>& Y,
+                       DenseMatrix<real_t>& B) const override {
+        if (is_complex<scalar_t>()) return false;
+        auto Xt = X.transpose();
+        const real_t s = real_t(-1.) / (real_t(2.) * std::real(h_ * h_));
+        const std::size_t m = X.cols(), d = this->d();
+        // power sums Kss and elementary symmetric polynomials Kpp, per
+        // row of the block
+        DenseMatrix<real_t> Kss(m, p_), Kpp(m, p_+1);
+        std::vector<real_t> t(m), tq(m);
+        for (std::size_t j=0; j<Y.cols(); j++) {
+          auto y = Y.ptr(0, j);
+          Kss.zero();
+          for (std::size_t k=0; k<d; k++) {
+            auto x = Xt.ptr(0, k);
+            const real_t yk = y[k];
+            auto K1 = Kss.ptr(0, 0);
+#pragma omp simd
+            for (std::size_t i=0; i<m; i++) {
+              auto xy = x[i] - yk;
+              t[i] = tq[i] = std::exp(s * xy * xy);
+              K1[i] += t[i];
+            }
+            for (int q=1; q<p_; q++) {
+              auto Kq = Kss.ptr(0, q);
+#pragma omp simd
+              for (std::size_t i=0; i<m; i++) {
+                tq[i] *= t[i];
+                Kq[i] += tq[i];
+              }
+            }
+          }
+          std::fill(Kpp.ptr(0, 0), Kpp.ptr(0, 0)+m, real_t(1.));
+          for (int q=1; q<=p_; q++) {
+            auto Kq = Kpp.ptr(0, q);
+            std::fill(Kq, Kq+m, real_t(0.));
+            for (int r=1; r<=q; r++) {
+              const real_t sign = (r % 2) ? real_t(1.) : real_t(-1.);
+              auto Kpr = Kpp.ptr(0, q-r);
+              auto Ksr = Kss.ptr(0, r-1);
+#pragma omp simd
+              for (std::size_t i=0; i<m; i++)
+                Kq[i] += sign * Kpr[i] * Ksr[i];
+            }
+            const real_t iq = real_t(1.) / q;
+#pragma omp simd
+            for (std::size_t i=0; i<m; i++)
+              Kq[i] *= iq;
+          }
+          std::copy(Kpp.ptr(0, p_), Kpp.ptr(0, p_)+m, B.ptr(0, j));
+        }
+        return true;
+      }
     };
 
 
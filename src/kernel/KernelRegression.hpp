@@ -36,9 +36,13 @@
 #ifndef STRUMPACK_KERNEL_REGRESSION_HPP
 #define STRUMPACK_KERNEL_REGRESSION_HPP
 
+#include <functional>
+#include <numeric>
+
 #include "misc/TaskTimer.hpp"
 #include "Kernel.hpp"
 #include "HSS/HSSMatrix.hpp"
+#include "clustering/Clustering.hpp"
 #if defined(STRUMPACK_USE_MPI)
 #include "HSS/HSSMatrixMPI.hpp"
 #if defined(STRUMPACK_USE_BPACK)
@@ -109,16 +113,214 @@ namespace strumpack {
       return weights;
     }
 
+    /**
+     * Flattened cluster tree over the training points, with a
+     * bounding ball for every cluster. Used in Kernel::predict to
+     * skip clusters which are far away from the test points.
+     */
+    template<typename real_t> class PredictionTree {
+    public:
+      struct Node {
+        std::size_t lo, hi;    // range of training points
+        int c0 = -1, c1 = -1;  // children, -1 for a leaf
+        real_t r = 0;          // radius of the bounding ball
+        std::vector<real_t> c; // center of the bounding ball
+      };
+      std::vector<Node> nodes;
+
+      template<typename scalar_t> PredictionTree
+      (const structured::ClusterTree& t, const DenseMatrix<scalar_t>& X) {
+        nodes.reserve(t.nodes());
+        add(t, 0, X);
+      }
+
+      /**
+       * Compute center and radius of the ball containing the points
+       * X(:,lo:hi-1).
+       */
+      template<typename scalar_t> static void bounding_ball
+      (const DenseMatrix<scalar_t>& X, std::size_t lo, std::size_t hi,
+       std::vector<real_t>& c, real_t& r) {
+        const auto d = X.rows();
+        c.assign(d, real_t(0.));
+        r = real_t(0.);
+        if (hi == lo) return;
+        for (auto j=lo; j<hi; j++)
+          for (std::size_t k=0; k<d; k++)
+            c[k] += std::real(X(k, j));
+        for (std::size_t k=0; k<d; k++)
+          c[k] /= (hi - lo);
+        for (auto j=lo; j<hi; j++) {
+          real_t r2(0.);
+          for (std::size_t k=0; k<d; k++) {
+            auto t = std::real(X(k, j)) - c[k];
+            r2 += t * t;
+          }
+          r = std::max(r, r2);
+        }
+        r = std::sqrt(r);
+      }
+
+      static real_t distance(const std::vector<real_t>& a,
+                             const std::vector<real_t>& b) {
+        real_t d2(0.);
+        for (std::size_t k=0; k<a.size(); k++)
+          d2 += (a[k] - b[k]) * (a[k] - b[k]);
+        return std::sqrt(d2);
+      }
+
+    private:
+      template<typename scalar_t> int add
+      (const structured::ClusterTree& t, std::size_t lo,
+       const DenseMatrix<scalar_t>& X) {
+        int id = nodes.size();
+        nodes.emplace_back();
+        nodes[id].lo = lo;
+        nodes[id].hi = lo + t.size;
+        if (t.c.empty()) {
+          bounding_ball(X, lo, lo+t.size, nodes[id].c, nodes[id].r);
+          return id;
+        }
+        int c0 = add(t.c[0], lo, X);
+        int c1 = add(t.c[1], lo+t.c[0].size, X);
+        auto& n = nodes[id];
+        n.c0 = c0;
+        n.c1 = c1;
+        const auto& n0 = nodes[c0];
+        const auto& n1 = nodes[c1];
+        const real_t s0 = n0.hi - n0.lo, s1 = n1.hi - n1.lo;
+        n.c.assign(X.rows(), real_t(0.));
+        if (s0 + s1 == 0) return id;
+        for (std::size_t k=0; k<X.rows(); k++)
+          n.c[k] = (s0 * n0.c[k] + s1 * n1.c[k]) / (s0 + s1);
+        if (s0) n.r = distance(n.c, n0.c) + n0.r;
+        if (s1) n.r = std::max(n.r, distance(n.c, n1.c) + n1.r);
+        return id;
+      }
+    };
+
+    /**
+     * Columns [r0,r1) of D as real points, returned as a pointer and
+     * leading dimension. Real data is used in place, for complex data
+     * the real part is copied to the buffer X.
+     */
+    template<typename real_t> const real_t* real_columns
+    (const DenseMatrix<real_t>& D, std::size_t r0, std::size_t r1,
+     DenseMatrix<real_t>& X, std::size_t& ld) {
+      ld = D.ld();
+      return D.ptr(0, r0);
+    }
+    template<typename real_t> const real_t* real_columns
+    (const DenseMatrix<std::complex<real_t>>& D, std::size_t r0,
+     std::size_t r1, DenseMatrix<real_t>& X, std::size_t& ld) {
+      for (auto r=r0; r<r1; r++)
+        for (std::size_t k=0; k<D.rows(); k++)
+          X(k, r-r0) = std::real(D(k, r));
+      ld = X.ld();
+      return X.data();
+    }
+
     template<typename scalar_t>
     std::vector<scalar_t> Kernel<scalar_t>::predict
-    (const DenseM_t& test, const DenseM_t& weights) const {
+    (const DenseM_t& test, const DenseM_t& weights, real_t tol) const {
       assert(test.rows() == d());
-      std::vector<scalar_t> prediction(test.cols());
-#pragma omp parallel for
-      for (std::size_t c=0; c<test.cols(); c++)
-        for (std::size_t r=0; r<n(); r++)
-          prediction[c] += weights(r, 0) *
-            eval_kernel_function(data_.ptr(0, r), test.ptr(0, c));
+      // number of test points per tile, and number of training points
+      // per block evaluated at once, so the block fits in cache
+      const std::size_t nt = 64, nb = 256;
+      const std::size_t m = test.cols();
+      std::vector<scalar_t> prediction(m);
+      if (!m || !n()) return prediction;
+      DenseMatrix<real_t> T(d(), m);
+      for (std::size_t c=0; c<m; c++)
+        for (std::size_t k=0; k<d(); k++)
+          T(k, c) = std::real(test(k, c));
+      // tiles of test points, and index of every column of T in test
+      std::vector<std::pair<std::size_t,std::size_t>> tiles;
+      std::vector<std::size_t> tidx(m);
+      std::iota(tidx.begin(), tidx.end(), 0);
+      std::unique_ptr<PredictionTree<real_t>> tree;
+      if (tol > real_t(0.) && tree_.size == int(n()) && !tree_.c.empty() &&
+          !is_complex<scalar_t>() &&
+          decay_bound(std::numeric_limits<real_t>::max()) <= tol) {
+        tree.reset(new PredictionTree<real_t>(tree_, data_));
+        // cluster the test points, so the tiles are compact
+        std::vector<int> tperm;
+        auto tt = binary_tree_clustering
+          (ClusteringAlgorithm::KD_TREE, T, tperm, nt);
+        for (std::size_t c=0; c<m; c++) tidx[c] = tperm[c] - 1;
+        std::function<void(const structured::ClusterTree&,std::size_t)>
+          leaves = [&](const structured::ClusterTree& t, std::size_t lo) {
+          if (t.c.empty()) {
+            if (t.size) tiles.emplace_back(lo, lo+t.size);
+          } else {
+            leaves(t.c[0], lo);
+            leaves(t.c[1], lo+t.c[0].size);
+          }
+        };
+        leaves(tt, 0);
+      } else
+        for (std::size_t c=0; c<m; c+=nt)
+          tiles.emplace_back(c, std::min(m, c+nt));
+      std::size_t mt = 0;
+      for (auto& t : tiles) mt = std::max(mt, t.second - t.first);
+      // X and B are allocated once per thread and reused for all
+      // blocks, X is only needed to copy complex training points
+      auto add_block = [&](std::size_t lo, std::size_t hi,
+                           std::size_t tlo, std::size_t thi,
+                           DenseMatrix<real_t>& Xbuf,
+                           DenseMatrix<real_t>& Bbuf) {
+        DenseMatrixWrapper<real_t> Y(d(), thi-tlo, T, 0, tlo);
+        for (auto r0=lo; r0<hi; r0+=nb) {
+          const auto r1 = std::min(hi, r0+nb);
+          std::size_t ldx;
+          auto px = real_columns(data_, r0, r1, Xbuf, ldx);
+          DenseMatrixWrapper<real_t>
+            X(d(), r1-r0, const_cast<real_t*>(px), ldx),
+            B(r1-r0, thi-tlo, Bbuf, 0, 0);
+          if (eval_points(X, Y, B)) {
+            for (auto c=tlo; c<thi; c++) {
+              scalar_t p(0.);
+              for (auto r=r0; r<r1; r++)
+                p += weights(r, 0) * B(r-r0, c-tlo);
+              prediction[tidx[c]] += p;
+            }
+          } else {
+            for (auto c=tlo; c<thi; c++)
+              for (auto r=r0; r<r1; r++)
+                prediction[tidx[c]] += weights(r, 0) *
+                  eval_kernel_function(data_.ptr(0, r), test.ptr(0, tidx[c]));
+          }
+        }
+      };
+#pragma omp parallel
+      {
+        DenseMatrix<real_t> Xbuf(is_complex<scalar_t>() ? d() : 0, nb),
+          Bbuf(nb, mt);
+#pragma omp for schedule(dynamic)
+        for (std::size_t t=0; t<tiles.size(); t++) {
+          const auto tlo = tiles[t].first, thi = tiles[t].second;
+          if (!tree) {
+            add_block(0, n(), tlo, thi, Xbuf, Bbuf);
+            continue;
+          }
+          std::vector<real_t> tc;
+          real_t tr;
+          PredictionTree<real_t>::bounding_ball(T, tlo, thi, tc, tr);
+          std::vector<int> todo{0};
+          while (!todo.empty()) {
+            const auto& nd = tree->nodes[todo.back()];
+            todo.pop_back();
+            if (nd.hi == nd.lo) continue;
+            auto dist = PredictionTree<real_t>::distance(tc, nd.c) - tr - nd.r;
+            if (dist > real_t(0.) && decay_bound(dist) <= tol) continue;
+            if (nd.c0 < 0) add_block(nd.lo, nd.hi, tlo, thi, Xbuf, Bbuf);
+            else {
+              todo.push_back(nd.c1);
+              todo.push_back(nd.c0);
+            }
+          }
+        }
+      }
       return prediction;
     }
 
@@ -158,6 +158,51 @@ namespace strumpack {
     MPI_Waitall(reqs.size(), reqs.data(), MPI_STATUSES_IGNORE);
   }
 
+  /**
+   * \class ExchangePattern
+   * \brief Communication pattern for MPIComm::sparse_all_to_all_v.
+   *
+   * Stores the ranks this rank sends data to, and receives data
+   * from, excluding itself. The pattern is determined by the first
+   * sparse_all_to_all_v that uses it, and is then reused, so that
+   * later exchanges only communicate with those ranks.
+   *
+   * \see MPIComm::sparse_all_to_all_v
+   */
+  class ExchangePattern {
+  public:
+    /**
+     * Whether the pattern has been set up.
+     */
+    bool known() const { return known_; }
+
+    /**
+     * Check whether all communication stays on this rank.
+     */
+    bool local() const { return known_ && src_.empty() && dst_.empty(); }
+
+    /**
+     * Ranks this rank receives data from, excluding itself.
+     */
+    const std::vector<int>& sources() const { return src_; }
+
+    /**
+     * Ranks this rank sends data to, excluding itself.
+     */
+    const std::vector<int>& destinations() const { return dst_; }
+
+    /**
+     * Forget the pattern, it will be determined again by the next
+     * exchange.
+     */
+    void reset() { known_ = false; src_.clear(); dst_.clear(); }
+
+  private:
+    bool known_ = false;
+    std::vector<int> src_, dst_;
+    friend class MPIComm;
+  };
+
   /**
    * \class MPIComm
    * \brief Wrapper class around an MPI_Comm object.
@@ -749,6 +794,121 @@ namespace strumpack {
       }
     }
 
+    /**
+     * Sparse version of all_to_all_v, for when every rank only
+     * exchanges data with a few other ranks. Each rank sends sbuf[i]
+     * to process i, and the results are received in rbuf, with
+     * pbuf[i] pointing to the data from rank i, as in all_to_all_v.
+     *
+     * If the pattern is not known yet, the message sizes are
+     * exchanged with an MPI_Alltoall, and the ranks with non-empty
+     * messages are stored in pattern. Afterwards, messages are only
+     * sent to and received from the ranks in the pattern, with the
+     * message sizes obtained with MPI_Probe, so there is no O(P)
+     * communication. The data for this rank itself is copied
+     * directly, and if all data is local, no messages are sent. A
+     * known pattern can only be reused if sbuf[i] is empty for all
+     * ranks i that are not in pattern.destinations(), which is
+     * the case for repeated exchanges with the same structure. This
+     * is collective on all ranks in this communicator.
+     *
+     * \tparam T type of data to send
+     * \tparam A allocator to be used for the receive buffer
+     * \param sbuf send buffers (should be size this->size())
+     * \param rbuf receive buffer, can be empty, will be allocated
+     * \param pbuf pointers (to positions in rbuf) to where data
+     * received from different ranks start
+     * \param pattern communication pattern, set up on first use
+     * \param Ttype MPI_Datatype corresponding to the template
+     * parameter T
+     * \see all_to_all_v, ExchangePattern
+     */
+    template<typename T, typename A=std::allocator<T>> void
+    sparse_all_to_all_v(std::vector<std::vector<T>>& sbuf,
+                        std::vector<T,A>& rbuf, std::vector<T*>& pbuf,
+                        ExchangePattern& pattern,
+                        const MPI_Datatype Ttype=mpi_type<T>()) const {
+      assert(sbuf.size() == std::size_t(size()));
+      const int P = size(), r = rank(), tag = 4321;
+      auto msg_size = [&](int p) {
+        if (sbuf[p].size() >
+            static_cast<std::size_t>(std::numeric_limits<int>::max())) {
+          std::cerr << "# ERROR: 32bit integer overflow in sparse_all_to_all_v!!"
+                    << std::endl;
+          MPI_Abort(comm_, 1);
+        }
+        return int(sbuf[p].size());
+      };
+      std::vector<int> rsizes(P, 0);
+      bool sizes_known = false;
+      if (!pattern.known_) {
+        std::vector<int> ssizes(P);
+        for (int p=0; p<P; p++) ssizes[p] = msg_size(p);
+        MPI_Alltoall(ssizes.data(), 1, mpi_type<int>(),
+                     rsizes.data(), 1, mpi_type<int>(), comm_);
+        pattern.reset();
+        for (int p=0; p<P; p++) {
+          if (p == r) continue;
+          if (ssizes[p]) pattern.dst_.push_back(p);
+          if (rsizes[p]) pattern.src_.push_back(p);
+        }
+        pattern.known_ = true;
+        sizes_known = true;
+      } else {
+        std::vector<bool> dst(P, false);
+        for (auto p : pattern.dst_) dst[p] = true;
+        for (int p=0; p<P; p++)
+          if (p != r && !dst[p] && !sbuf[p].empty()) {
+            std::cerr << "# ERROR: sparse_all_to_all_v, message to rank "
+                      << p << " does not match the communication pattern"
+                      << std::endl;
+            MPI_Abort(comm_, 1);
+          }
+      }
+      rsizes[r] = msg_size(r);
+      const auto& src = pattern.src_;
+      const auto& dst = pattern.dst_;
+      std::vector<MPI_Request> reqs(src.size() + dst.size());
+      // always send to the ranks in the pattern, even an empty
+      // message, since the receiver will wait for it
+      for (std::size_t i=0; i<dst.size(); i++)
+        MPI_Isend(sbuf[dst[i]].data(), msg_size(dst[i]), Ttype, dst[i],
+                  tag, comm_, reqs.data()+src.size()+i);
+      if (!sizes_known)
+        for (auto p : src) {
+          MPI_Status stat;
+          MPI_Probe(p, tag, comm_, &stat);
+          MPI_Get_count(&stat, Ttype, &rsizes[p]);
+        }
+      rbuf.resize(std::accumulate(rsizes.begin(), rsizes.end(), std::size_t(0)));
+      pbuf.resize(P);
+      std::size_t displ = 0;
+      for (int p=0; p<P; p++) {
+        pbuf[p] = rbuf.data() + displ;
+        displ += rsizes[p];
+      }
+      for (std::size_t i=0; i<src.size(); i++)
+        MPI_Irecv(pbuf[src[i]], rsizes[src[i]], Ttype, src[i],
+                  tag, comm_, reqs.data()+i);
+      std::copy(sbuf[r].begin(), sbuf[r].end(), pbuf[r]);
+      MPI_Waitall(reqs.size(), reqs.data(), MPI_STATUSES_IGNORE);
+      std::vector<std::vector<T>>().swap(sbuf);
+    }
+
+    /**
+     * Sparse version of all_to_all_v, where the communication pattern
+     * is determined for this exchange only.
+     *
+     * \see sparse_all_to_all_v, all_to_all_v
+     */
+    template<typename T, typename A=std::allocator<T>> void
+    sparse_all_to_all_v(std::vector<std::vector<T>>& sbuf,
+                        std::vector<T,A>& rbuf,
+                        std::vector<T*>& pbuf) const {
+      ExchangePattern pattern;
+      sparse_all_to_all_v(sbuf, rbuf, pbuf, pattern);
+    }
+
     /**
      * Return a subcommunicator with P ranks, starting from rank P0,
      * using stride stride. Ie., ranks (relative to this communicator)
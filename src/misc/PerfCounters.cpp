@@ -0,0 +1,318 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#include <algorithm>
+#include <iomanip>
+
+#include "PerfCounters.hpp"
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+namespace strumpack {
+
+  std::string get_name(PerfCounterType c) {
+    switch (c) {
+    case PerfCounterType::FLOPS: return "flops";
+    case PerfCounterType::BYTES_MOVED: return "bytes_moved";
+    case PerfCounterType::MEMORY: return "memory";
+    case PerfCounterType::PEAK_MEMORY: return "peak_memory";
+    case PerfCounterType::DEVICE_MEMORY: return "device_memory";
+    case PerfCounterType::PEAK_DEVICE_MEMORY: return "peak_device_memory";
+    case PerfCounterType::CB_SAMPLE_FLOPS: return "CB_sample";
+    case PerfCounterType::SPARSE_SAMPLE_FLOPS: return "sparse_sampling";
+    case PerfCounterType::EXTRACTION_FLOPS: return "extraction";
+    case PerfCounterType::ULV_FACTOR_FLOPS: return "ULV_factor";
+    case PerfCounterType::SCHUR_FLOPS: return "Schur";
+    case PerfCounterType::FULL_RANK_FLOPS: return "full_rank";
+    case PerfCounterType::RANDOM_FLOPS: return "random";
+    case PerfCounterType::ID_FLOPS: return "ID";
+    case PerfCounterType::ORTHO_FLOPS: return "ortho";
+    case PerfCounterType::QR_FLOPS: return "QR";
+    case PerfCounterType::REDUCE_SAMPLE_FLOPS: return "reduce_samples";
+    case PerfCounterType::UPDATE_SAMPLE_FLOPS: return "update_samples";
+    case PerfCounterType::HSS_SOLVE_FLOPS: return "HSS_solve";
+    case PerfCounterType::F11_FILL_FLOPS: return "F11_compression";
+    case PerfCounterType::F12_FILL_FLOPS: return "F12_compression";
+    case PerfCounterType::F21_FILL_FLOPS: return "F21_compression";
+    case PerfCounterType::F22_FILL_FLOPS: return "F22_compression";
+    case PerfCounterType::F21_MULT_FLOPS: return "F21_mult";
+    case PerfCounterType::INVF11_MULT_FLOPS: return "invF11_mult";
+    case PerfCounterType::F12_MULT_FLOPS: return "F12_mult";
+    }
+    return "unknown";
+  }
+
+  std::string get_name(SolverPhase p) {
+    switch (p) {
+    case SolverPhase::REORDERING: return "reordering";
+    case SolverPhase::SYMBOLIC_FACTORIZATION: return "symbolic factorization";
+    case SolverPhase::NUMERICAL_FACTORIZATION: return "numerical factorization";
+    case SolverPhase::SOLVE: return "solve";
+    }
+    return "unknown";
+  }
+
+  namespace {
+    // index in PerfCounterSet::mem_/peak_, for MEMORY or
+    // DEVICE_MEMORY, or their peaks
+    inline int mem_index(PerfCounterType c) {
+      return (c == PerfCounterType::MEMORY ||
+              c == PerfCounterType::PEAK_MEMORY) ? 0 : 1;
+    }
+    inline bool is_memory(PerfCounterType c) {
+      return c == PerfCounterType::MEMORY ||
+        c == PerfCounterType::DEVICE_MEMORY;
+    }
+    inline bool is_peak(PerfCounterType c) {
+      return c == PerfCounterType::PEAK_MEMORY ||
+        c == PerfCounterType::PEAK_DEVICE_MEMORY;
+    }
+    inline void update_peak(std::atomic<long long int>& peak,
+                            long long int v) {
+      auto old = peak.load(std::memory_order_relaxed);
+      while (v > old && !peak.compare_exchange_weak(old, v)) { }
+    }
+    std::atomic<std::uint64_t> perf_counter_set_id(1);
+  }
+
+  PerfCounterSet::Block::Block() {
+    for (auto& ci : c) ci.store(0, std::memory_order_relaxed);
+  }
+
+  PerfCounterSet::PerfCounterSet() : id_(perf_counter_set_id++) {
+    for (int i=0; i<2; i++) {
+      mem_[i].store(0);
+      peak_[i].store(0);
+    }
+  }
+
+  const std::shared_ptr<PerfCounterSet>& PerfCounterSet::process() {
+    // never destroyed, memory can still be released during static
+    // destruction
+    static auto p = new std::shared_ptr<PerfCounterSet>
+      (std::make_shared<PerfCounterSet>());
+    return *p;
+  }
+
+  PerfCounterSet::Block& PerfCounterSet::register_thread() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto& b = blocks_[std::this_thread::get_id()];
+    if (!b) b.reset(new Block());
+    auto& t = tls();
+    t.id = id_;
+    t.b = b.get();
+    return *b;
+  }
+
+  void PerfCounterSet::add_memory(PerfCounterType c, long long int n) {
+    auto& b = block();
+    auto& v = b.c[int(c)];
+    auto& hi = b.hi[mem_index(c)];
+    auto p = v.load(std::memory_order_relaxed) + n;
+    hi = std::max(hi, p);
+    if (p >= memory_flush_threshold || p <= -memory_flush_threshold) {
+      auto i = mem_index(c);
+      auto m = mem_[i].fetch_add(p);
+      update_peak(peak_[i], m + hi);
+      v.store(0, std::memory_order_relaxed);
+      hi = 0;
+    } else v.store(p, std::memory_order_relaxed);
+  }
+
+  long long int PerfCounterSet::count(PerfCounterType c) const {
+    if (is_peak(c)) {
+      auto i = mem_index(c);
+      return std::max
+        (peak_[i].load(), count(i ? PerfCounterType::DEVICE_MEMORY :
+                                PerfCounterType::MEMORY));
+    }
+    long long int v = is_memory(c) ? mem_[mem_index(c)].load() : 0;
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (auto& b : blocks_)
+      v += b.second->c[int(c)].load(std::memory_order_relaxed);
+    return v;
+  }
+
+  PerfCounts PerfCounterSet::counts() const {
+    PerfCounts v = {};
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      for (auto& b : blocks_)
+        for (int i=0; i<PERF_COUNTERS; i++)
+          v[i] += b.second->c[i].load(std::memory_order_relaxed);
+    }
+    v[int(PerfCounterType::MEMORY)] += mem_[0].load();
+    v[int(PerfCounterType::DEVICE_MEMORY)] += mem_[1].load();
+    v[int(PerfCounterType::PEAK_MEMORY)] = std::max
+      (peak_[0].load(), v[int(PerfCounterType::MEMORY)]);
+    v[int(PerfCounterType::PEAK_DEVICE_MEMORY)] = std::max
+      (peak_[1].load(), v[int(PerfCounterType::DEVICE_MEMORY)]);
+    return v;
+  }
+
+  void PerfCounterSet::set(PerfCounterType c, long long int v) {
+    if (is_peak(c))
+      peak_[mem_index(c)].store(v);
+    else if (is_memory(c))
+      mem_[mem_index(c)] += v - count(c);
+    else {
+      auto d = v - count(c);
+      auto& bc = block().c[int(c)];
+      bc.store(bc.load(std::memory_order_relaxed) + d,
+               std::memory_order_relaxed);
+    }
+  }
+
+
+  void PerfCounterSet::add(const PerfCounts& c) {
+    auto& b = block();
+    for (int i=0; i<PERF_COUNTERS; i++) {
+      auto ci = PerfCounterType(i);
+      if (is_peak(ci) || is_memory(ci)) continue;
+      b.c[i].store(b.c[i].load(std::memory_order_relaxed) + c[i],
+                   std::memory_order_relaxed);
+    }
+    for (auto m : {PerfCounterType::MEMORY, PerfCounterType::DEVICE_MEMORY}) {
+      auto i = mem_index(m);
+      auto p = (i ? PerfCounterType::PEAK_DEVICE_MEMORY :
+                PerfCounterType::PEAK_MEMORY);
+      update_peak(peak_[i], count(m) + c[int(p)]);
+      mem_[i] += c[int(m)];
+    }
+  }
+
+  PerfCounterScope::PerfCounterScope
+  (const std::shared_ptr<PerfCounterSet>& s) {
+    auto push = [&s]() {
+      auto& t = PerfCounterSet::tls();
+      t.scopes.push_back(t.active);
+      t.active = s;
+    };
+#if defined(_OPENMP)
+    if (omp_in_parallel()) {
+      // the pool of a nested region does not persist, only use the
+      // calling thread
+      threads_ = 0;
+      push();
+    } else {
+      threads_ = omp_get_max_threads();
+#pragma omp parallel num_threads(threads_)
+      push();
+    }
+#else
+    push();
+#endif
+  }
+
+  PerfCounterScope::~PerfCounterScope() {
+    auto pop = []() {
+      auto& t = PerfCounterSet::tls();
+      if (t.scopes.empty()) t.active.reset();
+      else {
+        t.active = std::move(t.scopes.back());
+        t.scopes.pop_back();
+      }
+    };
+#if defined(_OPENMP)
+    if (!threads_) pop();
+    else {
+#pragma omp parallel num_threads(threads_)
+      pop();
+    }
+#else
+    pop();
+#endif
+  }
+
+
+  PerfReport::PerfReport(const PerfReport& r) {
+    std::lock_guard<std::mutex> lock(r.mtx_);
+    phases_ = r.phases_;
+  }
+
+  PerfReport& PerfReport::operator=(const PerfReport& r) {
+    if (this == &r) return *this;
+    std::scoped_lock lock(mtx_, r.mtx_);
+    phases_ = r.phases_;
+    return *this;
+  }
+
+  PerfReport::Mark
+  PerfReport::start(SolverPhase p, const PerfCounterSet& c) const {
+    return Mark{p, c.counts(), std::chrono::steady_clock::now()};
+  }
+
+  void PerfReport::stop(const Mark& m, const PerfCounterSet& c) {
+    auto cnt = c.counts();
+    auto t = std::chrono::duration<double>
+      (std::chrono::steady_clock::now() - m.t0).count();
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto& ph = phases_[int(m.phase)];
+    ph.calls++;
+    ph.time += t;
+    for (int i=0; i<PERF_COUNTERS; i++) {
+      auto ci = PerfCounterType(i);
+      if (is_peak(ci)) ph.counts[i] = std::max(ph.counts[i], cnt[i]);
+      else ph.counts[i] += cnt[i] - m.counts[i];
+    }
+  }
+
+  void PerfReport::clear() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    phases_ = std::array<PerfPhase,SOLVER_PHASES>();
+  }
+
+  void PerfReport::print(std::ostream& os) const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto f = os.flags();
+    os << "# performance report:" << std::endl;
+    for (int p=0; p<SOLVER_PHASES; p++) {
+      auto& ph = phases_[p];
+      if (!ph.calls) continue;
+      auto flops = double(ph[PerfCounterType::FLOPS]);
+      os << "#   - " << std::left << std::setw(24)
+         << get_name(SolverPhase(p)) << std::right
+         << " calls = " << ph.calls
+         << ", time = " << ph.time
+         << ", flops = " << flops
+         << ", GFlop/s = " << (ph.time > 0. ? flops / ph.time / 1e9 : 0.)
+         << ", bytes = " << double(ph[PerfCounterType::BYTES_MOVED])
+         << ", peak memory = "
+         << double(ph[PerfCounterType::PEAK_MEMORY]) / 1e6 << " MB"
+         << std::endl;
+      for (int i=int(PerfCounterType::CB_SAMPLE_FLOPS);
+           i<PERF_COUNTERS; i++)
+        if (ph.counts[i])
+          os << "#        " << get_name(PerfCounterType(i))
+             << " = " << double(ph.counts[i]) << std::endl;
+    }
+    os.flags(f);
+  }
+
+} // end namespace strumpack
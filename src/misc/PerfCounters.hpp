@@ -0,0 +1,403 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+/**
+ * \file PerfCounters.hpp
+ * \brief Contains the performance (flop, byte and memory) counters,
+ * and the per phase performance report of the sparse solver.
+ */
+#ifndef STRUMPACK_PERF_COUNTERS_HPP
+#define STRUMPACK_PERF_COUNTERS_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <unordered_map>
+
+namespace strumpack {
+
+  /**
+   * Enumeration of the performance counters. These are only updated
+   * when STRUMPACK is configured with STRUMPACK_COUNT_FLOPS.
+   * \ingroup Enumerations
+   */
+  enum class PerfCounterType : int {
+    FLOPS = 0,          /*!< floating point operations              */
+    BYTES_MOVED,        /*!< bytes moved from/to memory             */
+    MEMORY,             /*!< currently allocated memory (bytes)     */
+    PEAK_MEMORY,        /*!< high water mark of MEMORY              */
+    DEVICE_MEMORY,      /*!< currently allocated device memory      */
+    PEAK_DEVICE_MEMORY, /*!< high water mark of DEVICE_MEMORY       */
+    CB_SAMPLE_FLOPS,
+    SPARSE_SAMPLE_FLOPS,
+    EXTRACTION_FLOPS,
+    ULV_FACTOR_FLOPS,
+    SCHUR_FLOPS,
+    FULL_RANK_FLOPS,
+    RANDOM_FLOPS,
+    ID_FLOPS,
+    ORTHO_FLOPS,
+    QR_FLOPS,
+    REDUCE_SAMPLE_FLOPS,
+    UPDATE_SAMPLE_FLOPS,
+    HSS_SOLVE_FLOPS,
+    F11_FILL_FLOPS,
+    F12_FILL_FLOPS,
+    F21_FILL_FLOPS,
+    F22_FILL_FLOPS,
+    F21_MULT_FLOPS,
+    INVF11_MULT_FLOPS,
+    F12_MULT_FLOPS
+  };
+
+  /**
+   * Number of different performance counters, see PerfCounterType.
+   */
+  constexpr int PERF_COUNTERS = int(PerfCounterType::F12_MULT_FLOPS) + 1;
+
+  /**
+   * Return a short string with the name of the counter.
+   */
+  std::string get_name(PerfCounterType c);
+
+  /**
+   * Values for all performance counters, indexed by PerfCounterType.
+   */
+  using PerfCounts = std::array<long long int,PERF_COUNTERS>;
+
+
+  /**
+   * \class PerfCounterSet
+   * \brief A set of performance counters.
+   *
+   * Each thread updating the counters gets its own (cache line
+   * aligned) block of counters in the set, so updates on the hot
+   * paths do not use atomic read-modify-write operations and do not
+   * contend. The values are summed over all threads only when they
+   * are queried. Memory usage is accumulated per thread, and only
+   * merged in the set wide total (and peak) after the change on a
+   * thread exceeds memory_flush_threshold bytes, so the peak memory
+   * is an estimate.
+   *
+   * The counters are updated through the handles in
+   * strumpack::params (params::flops, params::memory, ..), which
+   * refer to the counter set that is active on the calling thread,
+   * see PerfCounterScope. Each sparse solver object has its own
+   * counter set, updates outside of a solver call go to a process
+   * wide set.
+   */
+  class PerfCounterSet {
+  public:
+    PerfCounterSet();
+    PerfCounterSet(const PerfCounterSet&) = delete;
+    PerfCounterSet& operator=(const PerfCounterSet&) = delete;
+
+    /**
+     * Add n to counter c, from the calling thread.
+     */
+    void add(PerfCounterType c, long long int n) {
+      if (c == PerfCounterType::MEMORY ||
+          c == PerfCounterType::DEVICE_MEMORY)
+        add_memory(c, n);
+      else {
+        auto& v = block().c[int(c)];
+        v.store(v.load(std::memory_order_relaxed) + n,
+                std::memory_order_relaxed);
+      }
+    }
+
+    /**
+     * Current value of counter c, summed over all threads.
+     */
+    long long int count(PerfCounterType c) const;
+
+    /**
+     * Current values of all counters, summed over all threads.
+     */
+    PerfCounts counts() const;
+
+    /**
+     * Overwrite the value of counter c, for instance to reset it to
+     * 0. This should not be called while other threads are updating
+     * the same counter.
+     */
+    void set(PerfCounterType c, long long int v);
+
+    /**
+     * Add the counts from another set, for instance the counters of
+     * a single call. The peaks are combined assuming the memory of
+     * that other set was allocated on top of the current memory
+     * usage of this set.
+     */
+    void add(const PerfCounts& c);
+
+    /**
+     * The counter set used by the calling thread.
+     */
+    static PerfCounterSet& active() {
+      auto& t = tls();
+      return t.active ? *t.active : *process();
+    }
+
+    /**
+     * Shared pointer to the counter set used by the calling thread,
+     * to keep updating it from another thread, for instance a
+     * background thread that releases memory.
+     */
+    static std::shared_ptr<PerfCounterSet> active_ptr() {
+      auto& t = tls();
+      return t.active ? t.active : process();
+    }
+
+    /**
+     * The process wide counter set, used when no other set is
+     * active.
+     */
+    static const std::shared_ptr<PerfCounterSet>& process();
+
+    static const long long int memory_flush_threshold = 1 << 20;
+
+  private:
+    struct alignas(64) Block {
+      Block();
+      // for MEMORY and DEVICE_MEMORY, c holds the change not yet
+      // added to mem_, and hi the maximum of that since the last
+      // flush
+      std::array<std::atomic<long long int>,PERF_COUNTERS> c;
+      std::array<long long int,2> hi = {0, 0};
+    };
+
+    struct ThreadState {
+      std::uint64_t id = 0;   // id of the set that owns b
+      Block* b = nullptr;
+      std::shared_ptr<PerfCounterSet> active;
+      std::vector<std::shared_ptr<PerfCounterSet>> scopes;
+    };
+
+    const std::uint64_t id_;
+    mutable std::mutex mtx_;
+    std::unordered_map<std::thread::id,std::unique_ptr<Block>> blocks_;
+    std::array<std::atomic<long long int>,2> mem_, peak_;
+
+    static ThreadState& tls() {
+      static thread_local ThreadState t;
+      return t;
+    }
+
+    Block& block() {
+      auto& t = tls();
+      if (t.id == id_) return *t.b;
+      return register_thread();
+    }
+
+    Block& register_thread();
+    void add_memory(PerfCounterType c, long long int n);
+
+    friend class PerfCounterScope;
+  };
+
+
+  /**
+   * \class PerfCounterScope
+   * \brief Makes a counter set active, for the lifetime of this
+   * object.
+   *
+   * The set is made active on the calling thread and on the threads
+   * of its OpenMP thread pool (this object should be constructed
+   * outside of an OpenMP parallel region, or when nested parallelism
+   * is disabled, the set is activated on the calling thread
+   * only). The previously active sets are restored by the
+   * destructor. Scopes can be nested.
+   */
+  class PerfCounterScope {
+  public:
+    PerfCounterScope(const std::shared_ptr<PerfCounterSet>& s);
+    ~PerfCounterScope();
+    PerfCounterScope(const PerfCounterScope&) = delete;
+    PerfCounterScope& operator=(const PerfCounterScope&) = delete;
+  private:
+    int threads_ = 1;
+  };
+
+
+  /**
+   * \class PerfCounter
+   * \brief Handle to one of the counters in the active counter set.
+   *
+   * These are the counters in strumpack::params, for instance
+   * params::flops. They can be used like the std::atomic<long long
+   * int> global variables they replace, but increments are not
+   * atomic and go to the counter set that is active on the calling
+   * thread.
+   */
+  class PerfCounter {
+  public:
+    constexpr PerfCounter(PerfCounterType c) : c_(c) {}
+    PerfCounter(const PerfCounter&) = delete;
+
+    PerfCounter& operator+=(long long int n) {
+      PerfCounterSet::active().add(c_, n);
+      return *this;
+    }
+    PerfCounter& operator-=(long long int n) {
+      PerfCounterSet::active().add(c_, -n);
+      return *this;
+    }
+    PerfCounter& operator=(long long int v) {
+      PerfCounterSet::active().set(c_, v);
+      return *this;
+    }
+    long long int load() const {
+      return PerfCounterSet::active().count(c_);
+    }
+    operator long long int() const { return load(); }
+
+  private:
+    const PerfCounterType c_;
+  };
+
+
+  /**
+   * Enumeration of the phases of the sparse solver, as reported in
+   * PerfReport.
+   * \ingroup Enumerations
+   */
+  enum class SolverPhase : int {
+    REORDERING = 0,          /*!< matching, scaling, nested dissection */
+    SYMBOLIC_FACTORIZATION,  /*!< symbolic factorization, including
+                                  separator reordering                 */
+    NUMERICAL_FACTORIZATION, /*!< multifrontal factorization           */
+    SOLVE                    /*!< direct or iterative solve            */
+  };
+
+  /**
+   * Number of phases, see SolverPhase.
+   */
+  constexpr int SOLVER_PHASES = int(SolverPhase::SOLVE) + 1;
+
+  /**
+   * Return a short string with the name of the phase.
+   */
+  std::string get_name(SolverPhase p);
+
+  /**
+   * \struct PerfPhase
+   * \brief Time and performance counters for one phase of the
+   * sparse solver, accumulated over all times the phase was run.
+   */
+  struct PerfPhase {
+    /**
+     * number of times the phase was run, the separator reordering
+     * counts as a separate run of the symbolic factorization
+     */
+    int calls = 0;
+    /** total time spent in this phase, in seconds */
+    double time = 0.;
+    /**
+     * Increase of all counters during this phase, except for
+     * PEAK_MEMORY and PEAK_DEVICE_MEMORY, which are the high water
+     * marks reached by the end of the phase.
+     */
+    PerfCounts counts = {};
+
+    long long int operator[](PerfCounterType c) const
+    { return counts[int(c)]; }
+  };
+
+  /**
+   * \class PerfReport
+   * \brief Performance report of a sparse solver, with time and
+   * counters for each SolverPhase.
+   *
+   * The counters are only updated when STRUMPACK is configured with
+   * STRUMPACK_COUNT_FLOPS, the timings are always available. For the
+   * distributed memory solvers, the values are for the calling
+   * process only.
+   *
+   * \see SparseSolverBase::performance_report
+   */
+  class PerfReport {
+  public:
+    /**
+     * Start of a (timed) phase, see start() and stop().
+     */
+    struct Mark {
+      SolverPhase phase;
+      PerfCounts counts;
+      std::chrono::steady_clock::time_point t0;
+    };
+
+    PerfReport() = default;
+    PerfReport(const PerfReport& r);
+    PerfReport& operator=(const PerfReport& r);
+
+    /**
+     * Time and counters for phase p. This should not be called while
+     * the solver is running, in another thread.
+     */
+    const PerfPhase& operator[](SolverPhase p) const
+    { return phases_[int(p)]; }
+
+    /**
+     * Start timing/counting phase p, using the counters in c.
+     */
+    Mark start(SolverPhase p, const PerfCounterSet& c) const;
+
+    /**
+     * Stop timing/counting the phase started with m, and add to the
+     * totals for that phase. This can be called concurrently, for
+     * instance for multiple concurrent solves.
+     */
+    void stop(const Mark& m, const PerfCounterSet& c);
+
+    /**
+     * Reset the report.
+     */
+    void clear();
+
+    /**
+     * Print the report, one line per phase, followed by the non-zero
+     * flop counters for the compression algorithms.
+     */
+    void print(std::ostream& os=std::cout) const;
+
+  private:
+    std::array<PerfPhase,SOLVER_PHASES> phases_;
+    mutable std::mutex mtx_;
+  };
+
+} // end namespace strumpack
+
+#endif // STRUMPACK_PERF_COUNTERS_HPP
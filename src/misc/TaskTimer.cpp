@@ -29,6 +29,11 @@
 #include <iostream>
 #include <iomanip>
 #include <fstream>
+#include <sstream>
+#include <memory>
+#include <unordered_set>
+#include <unordered_map>
+#include <algorithm>
 #include <cassert>
 #if defined(_OPENMP)
 #include <omp.h>
@@ -105,64 +110,65 @@ double TaskTimer::elapsed() {
 #endif
 }
 
-void TaskTimer::print_name(std::ostream& os) {
-  if (type == TaskType::EXPLICITLY_NAMED_TASK) {
-    os << t_name;
-  } else {
-    switch (type) {
-    case TaskType::RANDOM_SAMPLING:       os << "RANDOM_SAMPLING"; break;
-    case TaskType::RANDOM_GENERATE:       os << "RANDOM_GENERATE"; break;
-    case TaskType::FRONT_MULTIPLY_2D:     os << "FRONT_MULTIPLY_2D"; break;
-    case TaskType::UUTXR:                 os << "UUTXR"; break;
-    case TaskType::F22_MULT:              os << "F22_MULT"; break;
-    case TaskType::HSS_SCHUR_PRODUCT:     os << "HSS_SCHUR_PRODUCT"; break;
-    case TaskType::SKINNY_EXTEND_ADD_SEQSEQ: os << "SKINNY_EXTEND_ADD_SEQSEQ"; break;
-    case TaskType::SKINNY_EXTEND_ADD_SEQ1:   os << "SKINNY_EXTEND_ADD_SEQ1"; break;
-    case TaskType::SKINNY_EXTEND_ADD_MPIMPI: os << "SKINNY_EXTEND_ADD_MPIMPI"; break;
-    case TaskType::SKINNY_EXTEND_ADD_MPI1:   os << "SKINNY_EXTEND_ADD_MPI1"; break;
-    case TaskType::HSS_COMPRESS:          os << "HSS_COMPRESS"; break;
-    case TaskType::HSS_COMPRESS_22:       os << "HSS_COMPRESS_22"; break;
-    case TaskType::LRBF_COMPRESS:         os << "LRBF_COMPRESS"; break;
-    case TaskType::CONSTRUCT_HIERARCHY:   os << "CONSTRUCT_HIERARCHY"; break;
-    case TaskType::CONSTRUCT_INIT:        os << "CONSTRUCT_INIT"; break;
-    case TaskType::CONSTRUCT_PTREE:       os << "CONSTRUCT_PTREE"; break;
-    case TaskType::NEIGHBOR_SEARCH:       os << "NEIGHBOR_SEARCH"; break;
-    case TaskType::HSS_PARHQRINTERPOL:    os << "HSS_PARHQRINTERPOL"; break;
-    case TaskType::HSS_SEQHQRINTERPOL:    os << "HSS_SEQHQRINTERPOL"; break;
-    case TaskType::EXTRACT_2D:            os << "EXTRACT_2D"; break;
-    case TaskType::EXTRACT_2D_A2A:        os << "EXTRACT_2D_A2A"; break;
-    case TaskType::EXTRACT_SEP_2D:        os << "EXTRACT_SEP_2D"; break;
-    case TaskType::EXTRACT_ELEMS:         os << "EXTRACT_ELEMS"; break;
-    case TaskType::BF_EXTRACT_TRAVERSE:   os << "BF_EXTRACT_TRAVERSE"; break;
-    case TaskType::BF_EXTRACT_ENTRY:      os << "BF_EXTRACT_ENTRY"; break;
-    case TaskType::BF_EXTRACT_COMM:       os << "BF_EXTRACT_COMM"; break;
-    case TaskType::GET_SUBMATRIX_2D:      os << "GET_SUBMATRIX_2D"; break;
-    case TaskType::GET_SUBMATRIX_2D_A2A:  os << "GET_SUBMATRIX_2D_A2A"; break;
-    case TaskType::HSS_EXTRACT_SCHUR:     os << "HSS_EXTRACT_SCHUR"; break;
-    case TaskType::HSS_PARTIALLY_FACTOR:  os << "HSS_PARTIALLY_FACTOR"; break;
-    case TaskType::F11INV_MULT:           os << "F11INV_MULT"; break;
-    case TaskType::HSS_COMPUTE_SCHUR:     os << "HSS_COMPUTE_SCHUR"; break;
-    case TaskType::HSS_FACTOR:            os << "HSS_FACTOR"; break;
-    case TaskType::FORWARD_SOLVE:         os << "FORWARD_SOLVE"; break;
-    case TaskType::LOOK_LEFT:             os << "LOOK_LEFT"; break;
-    case TaskType::SOLVE_LOWER:           os << "SOLVE_LOWER"; break;
-    case TaskType::SOLVE_LOWER_ROOT:      os << "SOLVE_LOWER_ROOT"; break;
-    case TaskType::BACKWARD_SOLVE:        os << "BACKWARD_SOLVE"; break;
-    case TaskType::SOLVE_UPPER:           os << "SOLVE_UPPER"; break;
-    case TaskType::LOOK_RIGHT:            os << "LOOK_RIGHT"; break;
-    case TaskType::DISTMAT_EXTRACT_ROWS:  os << "DISTMAT_EXTRACT_ROWS"; break;
-    case TaskType::DISTMAT_EXTRACT_COLS:  os << "DISTMAT_EXTRACT_COLS"; break;
-    case TaskType::DISTMAT_EXTRACT:       os << "DISTMAT_EXTRACT"; break;
-    case TaskType::QR:                    os << "QR"; break;
-    case TaskType::REDUCE_SAMPLES:        os << "REDUCE_SAMPLES"; break;
-    case TaskType::COMPUTE_SAMPLES:       os << "COMPUTE_SAMPLES"; break;
-    case TaskType::ORTHO:                 os << "ORTHO"; break;
-    case TaskType::REDIST_2D_TO_HSS:      os << "REDIST_2D_TO_HSS"; break;
-    default: os << "OTHER_TASK";
-    }
+const char* strumpack::get_name(TaskType t) {
+  switch (t) {
+  case TaskType::RANDOM_SAMPLING:        return "RANDOM_SAMPLING";
+  case TaskType::RANDOM_GENERATE:        return "RANDOM_GENERATE";
+  case TaskType::FRONT_MULTIPLY_2D:      return "FRONT_MULTIPLY_2D";
+  case TaskType::UUTXR:                  return "UUTXR";
+  case TaskType::F22_MULT:               return "F22_MULT";
+  case TaskType::HSS_SCHUR_PRODUCT:      return "HSS_SCHUR_PRODUCT";
+  case TaskType::SKINNY_EXTEND_ADD_SEQSEQ: return "SKINNY_EXTEND_ADD_SEQSEQ";
+  case TaskType::SKINNY_EXTEND_ADD_SEQ1: return "SKINNY_EXTEND_ADD_SEQ1";
+  case TaskType::SKINNY_EXTEND_ADD_MPIMPI: return "SKINNY_EXTEND_ADD_MPIMPI";
+  case TaskType::SKINNY_EXTEND_ADD_MPI1: return "SKINNY_EXTEND_ADD_MPI1";
+  case TaskType::HSS_COMPRESS:           return "HSS_COMPRESS";
+  case TaskType::HSS_COMPRESS_22:        return "HSS_COMPRESS_22";
+  case TaskType::LRBF_COMPRESS:          return "LRBF_COMPRESS";
+  case TaskType::CONSTRUCT_HIERARCHY:    return "CONSTRUCT_HIERARCHY";
+  case TaskType::CONSTRUCT_INIT:         return "CONSTRUCT_INIT";
+  case TaskType::CONSTRUCT_PTREE:        return "CONSTRUCT_PTREE";
+  case TaskType::NEIGHBOR_SEARCH:        return "NEIGHBOR_SEARCH";
+  case TaskType::HSS_PARHQRINTERPOL:     return "HSS_PARHQRINTERPOL";
+  case TaskType::HSS_SEQHQRINTERPOL:     return "HSS_SEQHQRINTERPOL";
+  case TaskType::EXTRACT_2D:             return "EXTRACT_2D";
+  case TaskType::EXTRACT_2D_A2A:         return "EXTRACT_2D_A2A";
+  case TaskType::EXTRACT_SEP_2D:         return "EXTRACT_SEP_2D";
+  case TaskType::EXTRACT_ELEMS:          return "EXTRACT_ELEMS";
+  case TaskType::BF_EXTRACT_TRAVERSE:    return "BF_EXTRACT_TRAVERSE";
+  case TaskType::BF_EXTRACT_ENTRY:       return "BF_EXTRACT_ENTRY";
+  case TaskType::BF_EXTRACT_COMM:        return "BF_EXTRACT_COMM";
+  case TaskType::GET_SUBMATRIX_2D:       return "GET_SUBMATRIX_2D";
+  case TaskType::GET_SUBMATRIX_2D_A2A:   return "GET_SUBMATRIX_2D_A2A";
+  case TaskType::HSS_EXTRACT_SCHUR:      return "HSS_EXTRACT_SCHUR";
+  case TaskType::HSS_PARTIALLY_FACTOR:   return "HSS_PARTIALLY_FACTOR";
+  case TaskType::F11INV_MULT:            return "F11INV_MULT";
+  case TaskType::HSS_COMPUTE_SCHUR:      return "HSS_COMPUTE_SCHUR";
+  case TaskType::HSS_FACTOR:             return "HSS_FACTOR";
+  case TaskType::FORWARD_SOLVE:          return "FORWARD_SOLVE";
+  case TaskType::LOOK_LEFT:              return "LOOK_LEFT";
+  case TaskType::SOLVE_LOWER:            return "SOLVE_LOWER";
+  case TaskType::SOLVE_LOWER_ROOT:       return "SOLVE_LOWER_ROOT";
+  case TaskType::BACKWARD_SOLVE:         return "BACKWARD_SOLVE";
+  case TaskType::SOLVE_UPPER:            return "SOLVE_UPPER";
+  case TaskType::LOOK_RIGHT:             return "LOOK_RIGHT";
+  case TaskType::DISTMAT_EXTRACT_ROWS:   return "DISTMAT_EXTRACT_ROWS";
+  case TaskType::DISTMAT_EXTRACT_COLS:   return "DISTMAT_EXTRACT_COLS";
+  case TaskType::DISTMAT_EXTRACT:        return "DISTMAT_EXTRACT";
+  case TaskType::QR:                     return "QR";
+  case TaskType::REDUCE_SAMPLES:         return "REDUCE_SAMPLES";
+  case TaskType::COMPUTE_SAMPLES:        return "COMPUTE_SAMPLES";
+  case TaskType::ORTHO:                  return "ORTHO";
+  case TaskType::REDIST_2D_TO_HSS:       return "REDIST_2D_TO_HSS";
+  default: return "OTHER_TASK";
   }
 }
 
+void TaskTimer::print_name(std::ostream& os) {
+  if (type == TaskType::EXPLICITLY_NAMED_TASK) os << t_name;
+  else os << get_name(type);
+}
+
 void TaskTimer::print(std::ostream& os) {
   if (type == TaskType::EXPLICITLY_NAMED_TASK) return;
   if (!stopped) stop();
@@ -193,12 +199,23 @@ void TaskTimer::print(std::ostream& os) {
 void TaskTimer::start() {
   t_start = GET_TIME_NOW();
   started = true;
+  if (Tracer::enabled() &&
+      (type != TaskType::EXPLICITLY_NAMED_TASK || !t_name.empty()))
+    t_trace = Tracer::now();
 }
 
 void TaskTimer::stop() {
   t_stop = GET_TIME_NOW();
   stopped = true;
-  time_log_list.list[tid].push_back(*this);
+  if (t_trace >= 0) {
+    Tracer::record
+      (type == TaskType::EXPLICITLY_NAMED_TASK ?
+       Tracer::intern(t_name) : get_name(type), t_trace, Tracer::now());
+    t_trace = -1.;
+  }
+#if defined(STRUMPACK_TASK_TIMERS)
+  time_log_list.add(*this);
+#endif
 }
 
 void TaskTimer::set_elapsed(double t) {
@@ -206,7 +223,9 @@ void TaskTimer::set_elapsed(double t) {
   started = stopped = true;
   t_start = 0;
   t_stop = t;
-  time_log_list.list[tid].push_back(*this);
+#if defined(STRUMPACK_TASK_TIMERS)
+  time_log_list.add(*this);
+#endif
 #endif
 }
 
@@ -221,6 +240,14 @@ TimerList::TimerList() : is_finalized(false) {
     list.push_back(std::list<TaskTimer>());
 }
 
+void TimerList::add(const TaskTimer& t) {
+  // timers can be stopped concurrently, also from threads that are
+  // not in the OpenMP thread pool that existed at startup
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (t.tid >= int(list.size())) list.resize(t.tid+1);
+  list[t.tid].push_back(t);
+}
+
 void TimerList::Finalize() {
   TaskTimer::time_log_list.finalize();
 }
@@ -376,3 +403,317 @@ void TimerList::finalize() {
 #endif
 }
 
+
+
+namespace {
+
+  struct TraceEvent {
+    const char* name;
+    double t0, t1;
+    TraceArgs args;
+    std::uint64_t session;
+  };
+
+  struct TraceBuffer {
+    int tid;
+    std::mutex mtx;
+    std::vector<TraceEvent> events;
+    // number of events dropped when the buffer was full, per session
+    std::unordered_map<std::uint64_t,long long> dropped;
+  };
+
+  struct TraceData {
+    std::mutex mtx;
+    std::vector<std::unique_ptr<TraceBuffer>> buffers;
+    std::unordered_set<std::string> names;
+  };
+
+  const auto trace_begin = std::chrono::steady_clock::now();
+
+  // never deleted, solvers with static storage duration can still
+  // write a trace from their destructor
+  TraceData& trace_data() {
+    static TraceData* d = new TraceData();
+    return *d;
+  }
+
+  TraceBuffer& trace_buffer() {
+    thread_local TraceBuffer* b = nullptr;
+    if (!b) {
+      auto& d = trace_data();
+      std::lock_guard<std::mutex> lock(d.mtx);
+      d.buffers.emplace_back(new TraceBuffer());
+      b = d.buffers.back().get();
+      b->tid = d.buffers.size() - 1;
+    }
+    return *b;
+  }
+
+  // session 0 is used for events recorded outside of a
+  // TraceSessionScope
+  struct TraceThreadState {
+    std::uint64_t session = 0;
+    std::vector<std::uint64_t> scopes;
+  };
+
+  TraceThreadState& trace_thread_state() {
+    static thread_local TraceThreadState t;
+    return t;
+  }
+
+  std::atomic<std::uint64_t> trace_session_count(0);
+
+  void write_json_string(std::ostream& os, const char* s) {
+    os << '"';
+    for (; *s; s++) {
+      if (*s == '"' || *s == '\\') os << '\\' << *s;
+      else if (static_cast<unsigned char>(*s) < 0x20) os << ' ';
+      else os << *s;
+    }
+    os << '"';
+  }
+
+  /**
+   * Write the events of this process, without the enclosing JSON
+   * object, with the time shifted by dt seconds. Only the events of
+   * the given session are written, or all events if all is true,
+   * and those are removed from the buffers.
+   */
+  void write_events(std::ostream& os, int pid, double dt,
+                    std::uint64_t session, bool all) {
+    auto& d = trace_data();
+    std::lock_guard<std::mutex> lock(d.mtx);
+    os << std::fixed << std::setprecision(3)
+       << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid
+       << ",\"tid\":0,\"args\":{\"name\":\"rank " << pid << "\"}}";
+    long long dropped = 0;
+    for (auto& b : d.buffers) {
+      std::lock_guard<std::mutex> block(b->mtx);
+      os << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid
+         << ",\"tid\":" << b->tid << ",\"args\":{\"name\":\"thread "
+         << b->tid << "\"}}";
+      std::size_t kept = 0;
+      for (auto& e : b->events) {
+        if (!all && e.session != session) {
+          b->events[kept++] = e;
+          continue;
+        }
+        os << ",\n{\"name\":";
+        write_json_string(os, e.name);
+        os << ",\"cat\":\"strumpack\",\"ph\":\"X\",\"pid\":" << pid
+           << ",\"tid\":" << b->tid
+           << ",\"ts\":" << (e.t0 + dt) * 1e6
+           << ",\"dur\":" << (e.t1 - e.t0) * 1e6;
+        char sep = '{';
+        auto arg = [&](const char* k, long long v) {
+          if (v < 0) return;
+          if (sep == '{') os << ",\"args\":";
+          os << sep << '"' << k << "\":" << v;
+          sep = ',';
+        };
+        arg("dim_sep", e.args.dim_sep);
+        arg("dim_upd", e.args.dim_upd);
+        arg("rank", e.args.rank);
+        arg("level", e.args.level);
+        if (sep == ',') os << '}';
+        os << '}';
+      }
+      if (kept) b->events.resize(kept);
+      else std::vector<TraceEvent>().swap(b->events);
+      if (all) {
+        for (auto& s : b->dropped) dropped += s.second;
+        b->dropped.clear();
+      } else {
+        auto s = b->dropped.find(session);
+        if (s != b->dropped.end()) {
+          dropped += s->second;
+          b->dropped.erase(s);
+        }
+      }
+    }
+    if (dropped) {
+      std::cerr << "# WARNING: trace buffers full, " << dropped
+                << " events were dropped, see Tracer::set_max_events"
+                << std::endl;
+      os << ",\n{\"name\":\"dropped_events\",\"ph\":\"M\",\"pid\":"
+         << pid << ",\"tid\":0,\"args\":{\"count\":" << dropped << "}}";
+    }
+  }
+
+  /**
+   * Remove the events of a session, without writing them.
+   */
+  void discard_events(std::uint64_t session) {
+    auto& d = trace_data();
+    std::lock_guard<std::mutex> lock(d.mtx);
+    for (auto& b : d.buffers) {
+      std::lock_guard<std::mutex> block(b->mtx);
+      b->events.erase
+        (std::remove_if(b->events.begin(), b->events.end(),
+                        [session](const TraceEvent& e) {
+                          return e.session == session; }),
+         b->events.end());
+      b->dropped.erase(session);
+    }
+  }
+
+  bool write_trace_file(const std::string& filename,
+                        const std::string& events) {
+    std::ofstream f(filename);
+    f << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+      << events << "\n]}\n";
+    f.close();
+    return bool(f);
+  }
+
+  bool write_trace(const std::string& filename,
+                   std::uint64_t session, bool all) {
+    std::ostringstream os;
+    write_events(os, 0, 0., session, all);
+    return write_trace_file(filename, os.str());
+  }
+
+#if defined(STRUMPACK_USE_MPI)
+  bool write_trace(const std::string& filename, const MPIComm& c,
+                   std::uint64_t session, bool all) {
+    int rank = c.rank(), P = c.size();
+    // align the clocks of all processes at the barrier, shifting by
+    // the largest local time so all times stay positive
+    c.barrier();
+    auto tsync = Tracer::now();
+    auto dt = c.all_reduce(tsync, MPI_MAX) - tsync;
+    std::ostringstream os;
+    write_events(os, rank, dt, session, all);
+    auto events = os.str();
+    int len = events.size();
+    std::vector<int> rcnts(rank ? 0 : P), displs(rank ? 0 : P+1);
+    c.gather(&len, 1, rcnts.data(), 1, 0);
+    std::vector<char> all;
+    if (!rank) {
+      displs[0] = 0;
+      for (int p=0; p<P; p++)
+        displs[p+1] = displs[p] + rcnts[p];
+      all.resize(displs[P]);
+    }
+    c.gather_v(events.data(), len, all.data(), rcnts.data(),
+               displs.data(), 0);
+    int ok = 1;
+    if (!rank) {
+      std::string joined;
+      for (int p=0; p<P; p++) {
+        if (p) joined += ",\n";
+        joined.append(all.data()+displs[p], rcnts[p]);
+      }
+      ok = write_trace_file(filename, joined);
+    }
+    return c.all_reduce(ok, MPI_MIN);
+  }
+#endif
+
+} // end anonymous namespace
+
+std::atomic<int> Tracer::enabled_(0), Tracer::unscoped_(0);
+std::atomic<std::size_t> Tracer::max_events_(1 << 18);
+
+double Tracer::now() {
+  return duration<double>(steady_clock::now() - trace_begin).count();
+}
+
+void Tracer::record(const char* name, double t0, double t1,
+                    const TraceArgs& a) {
+  auto session = trace_thread_state().session;
+  // this thread does not work for a traced solver
+  if (!session && !unscoped_.load(std::memory_order_relaxed)) return;
+  auto& b = trace_buffer();
+  // only contended while the trace is being written
+  std::lock_guard<std::mutex> lock(b.mtx);
+  if (b.events.size() >= max_events()) b.dropped[session]++;
+  else b.events.push_back({name, t0, t1, a, session});
+}
+
+void Tracer::clear() {
+  auto& d = trace_data();
+  std::lock_guard<std::mutex> lock(d.mtx);
+  for (auto& b : d.buffers) {
+    std::lock_guard<std::mutex> block(b->mtx);
+    b->events.clear();
+    b->dropped.clear();
+  }
+}
+
+const char* Tracer::intern(const std::string& name) {
+  auto& d = trace_data();
+  std::lock_guard<std::mutex> lock(d.mtx);
+  return d.names.insert(name).first->c_str();
+}
+
+bool Tracer::write(const std::string& filename) {
+  return write_trace(filename, 0, true);
+}
+
+#if defined(STRUMPACK_USE_MPI)
+bool Tracer::write(const std::string& filename, const MPIComm& c) {
+  return write_trace(filename, c, 0, true);
+}
+#endif
+
+TraceSession::TraceSession() : id_(++trace_session_count) {}
+
+TraceSession::~TraceSession() {
+  discard_events(id_);
+}
+
+bool TraceSession::write(const std::string& filename) {
+  return write_trace(filename, id_, false);
+}
+
+#if defined(STRUMPACK_USE_MPI)
+bool TraceSession::write(const std::string& filename, const MPIComm& c) {
+  return write_trace(filename, c, id_, false);
+}
+#endif
+
+TraceSessionScope::TraceSessionScope(const TraceSession& s) {
+  Tracer::enabled_++;
+  auto id = s.id_;
+  auto push = [id]() {
+    auto& t = trace_thread_state();
+    t.scopes.push_back(t.session);
+    t.session = id;
+  };
+#if defined(_OPENMP)
+  if (omp_in_parallel()) {
+    // the pool of a nested region does not persist, only use the
+    // calling thread
+    threads_ = 0;
+    push();
+  } else {
+    threads_ = omp_get_max_threads();
+#pragma omp parallel num_threads(threads_)
+    push();
+  }
+#else
+  push();
+#endif
+}
+
+TraceSessionScope::~TraceSessionScope() {
+  auto pop = []() {
+    auto& t = trace_thread_state();
+    if (t.scopes.empty()) t.session = 0;
+    else {
+      t.session = t.scopes.back();
+      t.scopes.pop_back();
+    }
+  };
+#if defined(_OPENMP)
+  if (!threads_) pop();
+  else {
+#pragma omp parallel num_threads(threads_)
+    pop();
+  }
+#else
+  pop();
+#endif
+  Tracer::enabled_--;
+}
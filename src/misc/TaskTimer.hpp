@@ -30,7 +30,10 @@
 #define TASK_TIMER_HPP
 
 #include <list>
+#include <mutex>
+#include <atomic>
 #include <vector>
+#include <cstdint>
 #include <string>
 #include <chrono>
 #include <functional>
@@ -69,6 +72,8 @@ namespace strumpack {
      REDIST_2D_TO_HSS, EXPLICITLY_NAMED_TASK  // leave this one last
     };
 
+  const char* get_name(TaskType t);
+
   class TimerList;
 
   class TaskTimer {
@@ -96,6 +101,9 @@ namespace strumpack {
     int number;
     int tid;
 
+    // start time for the Tracer, negative when not traced
+    double t_trace = -1.;
+
     static tpoint t_begin;
     static TimerList time_log_list;
 
@@ -110,8 +118,189 @@ namespace strumpack {
 
     static void Finalize();
     void finalize();
+    void add(const TaskTimer& t);
     bool is_finalized;
     std::vector<std::list<TaskTimer>> list;
+  private:
+    std::mutex mtx_;
+  };
+
+#if defined(STRUMPACK_USE_MPI)
+  class MPIComm;
+#endif
+
+  /**
+   * Annotation of a traced event for a single front, shown as the
+   * event arguments in the trace viewer. Negative values are left
+   * out.
+   */
+  struct TraceArgs {
+    long long dim_sep = -1, dim_upd = -1, rank = -1;
+    int level = -1;
+  };
+
+  /**
+   * Collects timed events, for every thread, to be written as a
+   * Chrome trace-event JSON file, which can be opened in Perfetto
+   * (ui.perfetto.dev) or chrome://tracing. Each thread gets its own
+   * track, and with MPI, each rank is shown as a separate process.
+   *
+   * Recording is off by default. It is on for all threads between
+   * matching calls to start() and stop(), which can be nested, and
+   * for the threads working for a traced solver, see TraceSession.
+   * When off, a TraceScope only does a relaxed atomic load. When on,
+   * an event costs two clock reads and an append to a buffer owned
+   * by the calling thread. At most max_events() events are kept per
+   * thread, until they are written, later events are dropped, and
+   * the number of dropped events is reported in the trace.
+   *
+   * Besides the per-front events, every stopped TaskTimer is
+   * recorded.
+   */
+  class Tracer {
+  public:
+    static bool enabled() {
+      return enabled_.load(std::memory_order_relaxed) > 0;
+    }
+    static void start() { enabled_++; unscoped_++; }
+    static void stop() { unscoped_--; enabled_--; }
+
+    /**
+     * Remove all recorded events. Should not be called while other
+     * threads are recording.
+     */
+    static void clear();
+
+    /**
+     * Time in seconds since the start of the program.
+     */
+    static double now();
+
+    static void record(const char* name, double t0, double t1,
+                       const TraceArgs& a=TraceArgs());
+
+    /**
+     * Return a pointer to a copy of name, which stays valid until the
+     * end of the program, for events with a name that is not a
+     * string literal.
+     */
+    static const char* intern(const std::string& name);
+
+    /**
+     * Maximum number of events kept in the buffer of a single
+     * thread, default 1 << 18.
+     */
+    static std::size_t max_events() { return max_events_; }
+    static void set_max_events(std::size_t n) { max_events_ = n; }
+
+    /**
+     * Write all events recorded by this process to a JSON file, and
+     * remove them. Returns false if the file could not be written.
+     */
+    static bool write(const std::string& filename);
+
+#if defined(STRUMPACK_USE_MPI)
+    /**
+     * Collective on c. The events of all processes in c are gathered
+     * and written by the root to a single file, with the clocks of
+     * all processes aligned at a barrier.
+     */
+    static bool write(const std::string& filename, const MPIComm& c);
+#endif
+
+  private:
+    // enabled_ counts start() calls and active TraceSessionScopes,
+    // unscoped_ only the start() calls, which record on all threads
+    static std::atomic<int> enabled_, unscoped_;
+    static std::atomic<std::size_t> max_events_;
+
+    friend class TraceSessionScope;
+  };
+
+  /**
+   * The events recorded for a single solver. Every event is tagged
+   * with the session that is active on the recording thread, see
+   * TraceSessionScope, so the events of solvers running at the same
+   * time are kept apart. Events which are not written are discarded
+   * when the session is destroyed.
+   */
+  class TraceSession {
+  public:
+    TraceSession();
+    TraceSession(const TraceSession&) = delete;
+    TraceSession& operator=(const TraceSession&) = delete;
+    ~TraceSession();
+
+    /**
+     * Write the events recorded in this session to a JSON file, and
+     * remove them. Returns false if the file could not be written.
+     */
+    bool write(const std::string& filename);
+
+#if defined(STRUMPACK_USE_MPI)
+    /**
+     * Collective on c, see Tracer::write(filename, c).
+     */
+    bool write(const std::string& filename, const MPIComm& c);
+#endif
+
+  private:
+    const std::uint64_t id_;
+
+    friend class TraceSessionScope;
+  };
+
+  /**
+   * \class TraceSessionScope
+   * \brief Records the events of the calling thread and its OpenMP
+   * thread pool in a TraceSession, for the lifetime of this object.
+   *
+   * Like PerfCounterScope, this should be constructed outside of an
+   * OpenMP parallel region, otherwise only the calling thread is
+   * used. Scopes can be nested, the destructor restores the previous
+   * session.
+   */
+  class TraceSessionScope {
+  public:
+    TraceSessionScope(const TraceSession& s);
+    ~TraceSessionScope();
+    TraceSessionScope(const TraceSessionScope&) = delete;
+    TraceSessionScope& operator=(const TraceSessionScope&) = delete;
+  private:
+    int threads_ = 1;
+  };
+
+  /**
+   * Record the time between construction and destruction as an
+   * event, if the Tracer is enabled. The name should be a string
+   * literal, or see Tracer::intern.
+   */
+  class TraceScope {
+  public:
+    TraceScope(const char* name, const TraceArgs& a=TraceArgs())
+      : name_(Tracer::enabled() ? name : nullptr) {
+      if (name_) {
+        args_ = a;
+        t0_ = Tracer::now();
+      }
+    }
+    ~TraceScope() {
+      if (name_) Tracer::record(name_, t0_, Tracer::now(), args_);
+    }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+    /**
+     * Whether this event is recorded, avoid computing expensive
+     * annotations otherwise.
+     */
+    bool active() const { return name_; }
+    void set_rank(long long r) { args_.rank = r; }
+
+  private:
+    const char* name_;
+    double t0_ = 0.;
+    TraceArgs args_;
   };
 
 #if !defined(STRUMPACK_TASK_TIMERS)
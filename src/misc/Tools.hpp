@@ -30,6 +30,9 @@
 #define STRUMPACK_TOOLS_HPP
 
 #include <vector>
+#include <array>
+#include <mutex>
+#include <atomic>
 #include <iomanip>
 #include "StrumpackConfig.hpp"
 #include "StrumpackParameters.hpp"
@@ -67,49 +70,84 @@ namespace strumpack {
   (const NoInit<T>&, const NoInit<U>&) { return false; }
 
 
+  /**
+   * Pool of work vectors, to avoid repeated allocation of temporary
+   * storage, for instance for the contribution blocks in the
+   * multifrontal factorization. Vectors are stored in bins by
+   * capacity, bin b holds vectors with capacity in [2^b, 2^(b+1)).
+   * Each thread first looks in a small thread private cache, and
+   * then in the shared bins, each of which has its own lock. This
+   * avoids a global critical section on get and restore.
+   */
   template<typename scalar_t> class VectorPool {
+    using vec_t = std::vector<scalar_t,NoInit<scalar_t>>;
+
   public:
+    VectorPool() : caches_(max_threads()) {}
 
-#if defined(STRUMPACK_COUNT_FLOPS)
-    ~VectorPool() {
-      for (auto& v : data_) {
-        STRUMPACK_SUB_MEMORY(v.size()*sizeof(scalar_t));
-      }
-    }
-#endif
+    VectorPool(const VectorPool&) = delete;
+    VectorPool& operator=(const VectorPool&) = delete;
 
-    std::vector<scalar_t,NoInit<scalar_t>> get(std::size_t s=0) {
-      std::vector<scalar_t,NoInit<scalar_t>> v;
-#pragma omp critical
-      {
-        if (!data_.empty()) {
-          // find the vector with smallest capacity, but at least s
-          std::size_t pos = 0, vsize = data_[0].capacity();
-          for (std::size_t i=0; i<data_.size(); i++) {
-            auto c = data_[i].capacity();
-            if (c >= s && c < vsize) {
-              pos = i;
-              vsize = c;
-            }
-          }
-          v = std::move(data_[pos]);
-          auto os = v.size();
-          if (s != os) {
-            STRUMPACK_ADD_MEMORY((s-os)*sizeof(scalar_t));
-            v.resize(s);
+    ~VectorPool() { clear(); }
+
+    vec_t get(std::size_t s=0) {
+      vec_t v;
+      auto& c = cache();
+      std::unique_lock<std::mutex> lc(c.m, std::try_to_lock);
+      for (int b=bin_floor(s); b<BINS; b++) {
+        // the first bin can hold vectors that are too small
+        if (lc.owns_lock() && take(c.bins[b], s, v)) break;
+        if (!shared_[b].n.load(std::memory_order_relaxed)) continue;
+        std::lock_guard<std::mutex> l(shared_[b].m);
+        if (take(shared_[b].v, s, v)) {
+          shared_[b].n--;
+          break;
+        }
+      }
+      if (lc.owns_lock()) lc.unlock();
+      if (v.capacity() < s) {
+        // nothing large enough in the pool, replace one of the
+        // smaller vectors, to bound the number of vectors in the pool
+        for (int b=bin_floor(s); b>=0 && v.empty(); b--) {
+          if (!shared_[b].n.load(std::memory_order_relaxed)) continue;
+          std::lock_guard<std::mutex> l(shared_[b].m);
+          if (!shared_[b].v.empty()) {
+            v = std::move(shared_[b].v.back());
+            shared_[b].v.pop_back();
+            shared_[b].n--;
           }
-          data_.erase(data_.begin()+pos);
-        } else {
-          STRUMPACK_ADD_MEMORY(s*sizeof(scalar_t));
-          v.resize(s);
         }
+        STRUMPACK_SUB_MEMORY(v.size()*sizeof(scalar_t));
+        v = vec_t();
+        STRUMPACK_ADD_MEMORY(s*sizeof(scalar_t));
+        v.resize(s);
+        return v;
+      }
+      if (s > v.size()) {
+        STRUMPACK_ADD_MEMORY((s-v.size())*sizeof(scalar_t));
+      } else {
+        STRUMPACK_SUB_MEMORY((v.size()-s)*sizeof(scalar_t));
       }
+      v.resize(s);
       return v;
     }
-    void restore(std::vector<scalar_t,NoInit<scalar_t>>& v) {
+
+    void restore(vec_t& v) {
       if (v.empty()) return;
-#pragma omp critical
-      data_.push_back(std::move(v));
+      int b = bin_floor(v.capacity());
+      {
+        auto& c = cache();
+        std::unique_lock<std::mutex> lc(c.m, std::try_to_lock);
+        if (lc.owns_lock() && c.bins[b].size() < CACHE_SIZE) {
+          c.bins[b].push_back(std::move(v));
+          v = vec_t();
+          return;
+        }
+      }
+      std::lock_guard<std::mutex> l(shared_[b].m);
+      shared_[b].v.push_back(std::move(v));
+      shared_[b].n++;
+      v = vec_t();
     }
 
 #if defined(STRUMPACK_USE_GPU)
@@ -210,7 +248,23 @@ namespace strumpack {
 #endif
 
     void clear() {
-      data_.clear();
+      auto release = [](std::vector<vec_t>& vs) {
+#if defined(STRUMPACK_COUNT_FLOPS)
+        for (auto& v : vs) {
+          STRUMPACK_SUB_MEMORY(v.size()*sizeof(scalar_t));
+        }
+#endif
+        vs.clear();
+      };
+      for (auto& c : caches_) {
+        std::lock_guard<std::mutex> l(c.m);
+        for (auto& vs : c.bins) release(vs);
+      }
+      for (auto& sb : shared_) {
+        std::lock_guard<std::mutex> l(sb.m);
+        release(sb.v);
+        sb.n = 0;
+      }
 #if defined(STRUMPACK_USE_GPU)
       device_bytes_.clear();
       pinned_data_.clear();
@@ -218,7 +272,56 @@ namespace strumpack {
     }
 
   private:
-    std::vector<std::vector<scalar_t,NoInit<scalar_t>>> data_;
+    static const int BINS = 8 * sizeof(std::size_t);
+    // maximum number of vectors per bin in a thread private cache
+    static const std::size_t CACHE_SIZE = 2;
+
+    struct alignas(64) Cache {
+      std::mutex m;
+      std::array<std::vector<vec_t>,BINS> bins;
+    };
+    struct alignas(64) SharedBin {
+      std::mutex m;
+      std::atomic<std::size_t> n{0};
+      std::vector<vec_t> v;
+    };
+    std::vector<Cache> caches_;
+    std::array<SharedBin,BINS> shared_;
+
+    static int max_threads() {
+#if defined(_OPENMP)
+      return omp_get_max_threads();
+#else
+      return 1;
+#endif
+    }
+    // the cache is only locked to guard against threads from
+    // different (nested) teams with the same thread number
+    Cache& cache() {
+#if defined(_OPENMP)
+      return caches_[omp_get_thread_num() % caches_.size()];
+#else
+      return caches_[0];
+#endif
+    }
+    static int bin_floor(std::size_t s) {
+      int b = 0;
+      while (s >>= 1) b++;
+      return b;
+    }
+    // take the vector with the smallest capacity of at least s
+    static bool take(std::vector<vec_t>& vs, std::size_t s, vec_t& v) {
+      int pos = -1;
+      for (std::size_t i=0; i<vs.size(); i++)
+        if (vs[i].capacity() >= s &&
+            (pos == -1 || vs[i].capacity() < vs[pos].capacity()))
+          pos = i;
+      if (pos == -1) return false;
+      v = std::move(vs[pos]);
+      vs.erase(vs.begin()+pos);
+      return true;
+    }
+
 #if defined(STRUMPACK_USE_GPU)
     std::vector<gpu::DeviceMemory<char>> device_bytes_;
     std::vector<gpu::HostMemory<scalar_t>> pinned_data_;
@@ -31,7 +31,12 @@
 #include <algorithm>
 
 #include "CSRGraph.hpp"
+#include "StrumpackConfig.hpp"
+#if defined(STRUMPACK_USE_METIS)
 #include "ordering/MetisReordering.hpp"
+#else
+#include "ordering/NDReordering.hpp"
+#endif
 
 namespace strumpack {
 
@@ -188,6 +193,7 @@ namespace strumpack {
                                        integer_t* order, integer_t* iorder,
                                        integer_t lo, integer_t sep_begin,
                                        integer_t sep_end) const {
+#if defined(STRUMPACK_USE_METIS)
     int info = 0;
     idx_t cut = 0;
     std::vector<idx_t> part(size());
@@ -198,6 +204,17 @@ namespace strumpack {
         " reordering returned: " << info << std::endl;
       exit(1);
     }
+#else
+    // without Metis: cut the recursive bisection ordering in K
+    // (nearly) equal consecutive pieces
+    std::vector<integer_t> rb(size());
+    recursive_bisection
+      (std::max(integer_t(1), size() / (2*K)), 0, rb.data(), nullptr,
+       0, 0, size());
+    std::vector<int> part(size());
+    for (integer_t i=0; i<size(); i++)
+      part[i] = std::min(integer_t(K-1), rb[i] * K / size());
+#endif
     std::vector<std::size_t> tiles(K), toff(K+1);
     for (integer_t i=0; i<size(); i++)
       tiles[part[i]]++;
@@ -248,6 +265,7 @@ namespace strumpack {
    integer_t count, const Length2Edges& l2) const {
     auto sg = extract_subgraph
       (conn_level, lo, sep_begin, sep_end, part, order+sep_begin, l2);
+#if defined(STRUMPACK_USE_METIS)
     idx_t edge_cut = 0, nvtxs = sg.size();
     std::vector<idx_t> partitioning(nvtxs);
     int info = WRAPPER_METIS_PartGraphRecursive
@@ -257,6 +275,11 @@ namespace strumpack {
         " reordering returned: " << info << std::endl;
       exit(1);
     }
+#else
+    std::vector<int> partitioning;
+    ordering::graph_bisection
+      (sg.size(), sg.ptr(), sg.ind(), partitioning);
+#endif
     tree.c.resize(2);
     for (integer_t i=sep_begin, j=0; i<sep_end; i++)
       if (order[i] == part) {
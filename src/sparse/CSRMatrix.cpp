@@ -34,6 +34,7 @@
 #include <string>
 
 #include "CSRMatrix.hpp"
+#include "MatrixMarket.hpp"
 #include "MC64ad.hpp"
 #if defined(STRUMPACK_USE_MPI)
 #include "dense/DistributedMatrix.hpp"
@@ -104,8 +105,7 @@ namespace strumpack {
     std::ofstream fs(filename, std::ofstream::binary);
     char s = 'R';
     fs.write(&s, sizeof(char));
-    if (std::is_same<integer_t,int>()) s = '4';
-    else if (std::is_same<integer_t,int64_t>()) s = '8';
+    s = '0' + sizeof(integer_t);
     fs.write(&s, sizeof(char));
     if (is_complex<scalar_t>()) {
       if (std::is_same<real_t,float>()) s = 'c';
@@ -119,12 +119,9 @@ namespace strumpack {
     fs.write((char*)&n_, sizeof(integer_t));
     fs.write((char*)&nnz_, sizeof(integer_t));
 
-    for (integer_t i=0; i<n_+1; i++)
-      fs.write((char*)(&ptr_[i]), sizeof(integer_t));
-    for (integer_t i=0; i<nnz_; i++)
-      fs.write((char*)(&ind_[i]), sizeof(integer_t));
-    for (integer_t i=0; i<nnz_; i++)
-      fs.write((char*)(&(val_[i])), sizeof(scalar_t));
+    fs.write((char*)ptr_.data(), sizeof(integer_t)*(n_+1));
+    fs.write((char*)ind_.data(), sizeof(integer_t)*nnz_);
+    fs.write((char*)val_.data(), sizeof(scalar_t)*nnz_);
 
     if (!fs.good()) {
       std::cout << "Error writing to file !!" << std::endl;
@@ -174,12 +171,15 @@ namespace strumpack {
     ptr_.resize(n_+1);
     ind_.resize(nnz_);
     val_.resize(nnz_);
-    for (integer_t i=0; i<n_+1; i++)
-      fs.read((char*)(&ptr_[i]), sizeof(integer_t));
-    for (integer_t i=0; i<nnz_; i++)
-      fs.read((char*)(&ind_[i]), sizeof(integer_t));
-    for (integer_t i=0; i<nnz_; i++)
-      fs.read((char*)(&val_[i]), sizeof(scalar_t));
+    // read each array with a single call
+    fs.read((char*)ptr_.data(), sizeof(integer_t)*(n_+1));
+    fs.read((char*)ind_.data(), sizeof(integer_t)*nnz_);
+    fs.read((char*)val_.data(), sizeof(scalar_t)*nnz_);
+    if (!fs.good()) {
+      std::cerr << "Error: could not read matrix from "
+                << filename << std::endl;
+      return 1;
+    }
     fs.close();
     return 0;
   }
@@ -551,6 +551,8 @@ namespace strumpack {
           if (col < shi)
             F11(row, col-slo) = val_[j];
           else {
+            // F12 is not stored for symmetric fronts
+            if (!F12.cols()) break;
             while (upd_ptr<du && upd[upd_ptr]<col)
               upd_ptr++;
             if (upd_ptr == du) break;
@@ -574,6 +576,56 @@ namespace strumpack {
     }
   }
 
+  /**
+   * Same loops as extract_front, but record the nonzero index and the
+   * offset in the front instead of copying the value.
+   */
+  template<typename scalar_t,typename integer_t> bool
+  CSRMatrix<scalar_t,integer_t>::extract_front_plan
+  (integer_t slo, integer_t shi, const std::vector<integer_t>& upd,
+   bool F12, FrontScatterPlan<scalar_t,integer_t>& plan) const {
+    plan.clear();
+    std::size_t ds = shi - slo, du = upd.size();
+    for (std::size_t row=0; row<ds; row++) { // separator rows
+      std::size_t upd_ptr = 0;
+      const auto hij = ptr_[row+slo+1];
+      for (integer_t j=ptr_[row+slo]; j<hij; j++) {
+        integer_t col = ind_[j];
+        if (col >= slo) {
+          if (col < shi) {
+            plan.v11.push_back(j);
+            plan.f11.push_back(row + (col-slo)*ds);
+          } else {
+            if (!F12) break;
+            while (upd_ptr<du && upd[upd_ptr]<col)
+              upd_ptr++;
+            if (upd_ptr == du) break;
+            if (upd[upd_ptr] == col) {
+              plan.v12.push_back(j);
+              plan.f12.push_back(row + upd_ptr*ds);
+            }
+          }
+        }
+      }
+    }
+    for (std::size_t i=0; i<du; i++) { // update rows
+      auto row = upd[i];
+      const auto hij = ptr_[row+1];
+      for (integer_t j=ptr_[row]; j<hij; j++) {
+        integer_t col = ind_[j];
+        if (col >= slo) {
+          if (col < shi) {
+            plan.v21.push_back(j);
+            plan.f21.push_back(i + (col-slo)*du);
+          } else break;
+        }
+      }
+    }
+    plan.nnz = nnz_;
+    plan.has_F12 = F12;
+    return true;
+  }
+
   template<typename scalar_t,typename integer_t> void
   CSRMatrix<scalar_t,integer_t>::front_multiply
   (integer_t slo, integer_t shi, const std::vector<integer_t>& upd,
@@ -875,35 +927,20 @@ namespace strumpack {
         (ind_.data(), val_.data(), ptr_[r], ptr_[r+1]);
   }
 
+  /**
+   * The file is memory mapped and parsed by multiple threads, and the
+   * CSR storage is built with a parallel counting sort on the rows.
+   */
   template<typename scalar_t,typename integer_t> int
   CSRMatrix<scalar_t,integer_t>::read_matrix_market
   (const std::string& filename) {
-    using Triplet = std::tuple<integer_t,integer_t,scalar_t>;
-    std::vector<Triplet> A;
-    try {
-      A = this->read_matrix_market_entries(filename);
-    } catch (...) { return 1; }
-    std::sort
-      (A.begin(), A.end(),
-       [](const Triplet& a, const Triplet& b) -> bool {
-         // sort based on the row,column indices
-         return std::make_tuple(std::get<0>(a),std::get<1>(a)) <
-           std::make_tuple(std::get<0>(b), std::get<1>(b));
-       });
-    ptr_.resize(n_+1);
-    ind_.resize(nnz_);
-    val_.resize(nnz_);
-    integer_t row = -1;
-    for (integer_t i=0; i<nnz_; i++) {
-      val_[i] = std::get<2>(A[i]);
-      ind_[i] = std::get<1>(A[i]);
-      auto new_row = std::get<0>(A[i]);
-      if (new_row != row) {
-        for (int j=row+1; j<=new_row; j++) ptr_[j] = i;
-        row = new_row;
-      }
-    }
-    for (int j=row+1; j<=n_; j++) ptr_[j] = nnz_;
+    MatrixMarketHeader h;
+    if (strumpack::read_matrix_market(filename, h, ptr_, ind_, val_))
+      return 1;
+    n_ = h.rows;
+    nnz_ = ind_.size();
+    symm_sparse_ = h.symmetric();
+    sort_rows();
     return 0;
   }
 
@@ -932,6 +969,34 @@ namespace strumpack {
     return res;
   }
 
+  template<typename scalar_t,typename integer_t> typename
+  RealType<scalar_t>::value_type
+  CSRMatrix<scalar_t,integer_t>::max_scaled_residual
+  (Trans op, const DenseM_t& x, const DenseM_t& b) const {
+    if (op == Trans::N) return max_scaled_residual(x, b);
+    real_t res = real_t(0.);
+    std::vector<scalar_t> true_res(n_);
+    std::vector<real_t> abs_res(n_);
+    for (std::size_t c=0; c<x.cols(); c++) {
+      for (integer_t r=0; r<n_; r++) {
+        true_res[r] = b(r, c);
+        abs_res[r] = std::abs(b(r, c));
+      }
+      for (integer_t r=0; r<n_; r++) {
+        const auto hij = ptr_[r+1];
+        for (integer_t j=ptr_[r]; j<hij; j++) {
+          const auto v = (op == Trans::C) ? blas::my_conj(val_[j]) : val_[j];
+          const auto cj = ind_[j];
+          true_res[cj] -= v * x(r, c);
+          abs_res[cj] += std::abs(v) * std::abs(x(r, c));
+        }
+      }
+      for (integer_t r=0; r<n_; r++)
+        res = std::max(res, std::abs(true_res[r]) / abs_res[r]);
+    }
+    return res;
+  }
+
   template<typename scalar_t,typename integer_t> typename
   RealType<scalar_t>::value_type
   CSRMatrix<scalar_t,integer_t>::max_scaled_residual
@@ -86,6 +86,12 @@ namespace strumpack {
       const override;
     real_t max_scaled_residual(const DenseM_t& x, const DenseM_t& b)
       const override;
+    /**
+     * Componentwise backward error for op(A) x = b, with op(A) = A,
+     * A^T or A^H.
+     */
+    real_t max_scaled_residual(Trans op, const DenseM_t& x,
+                               const DenseM_t& b) const;
 
     std::unique_ptr<CSRMatrix<scalar_t,integer_t>>
     add_missing_diagonal(const scalar_t& s) const;
@@ -125,6 +131,10 @@ namespace strumpack {
                        integer_t sep_begin, integer_t sep_end,
                        const std::vector<integer_t>& upd,
                        int depth) const override;
+    bool extract_front_plan(integer_t slo, integer_t shi,
+                            const std::vector<integer_t>& upd, bool F12,
+                            FrontScatterPlan<scalar_t,integer_t>& plan)
+      const override;
 
     void push_front_elements(integer_t, integer_t,
                              const std::vector<integer_t>&,
@@ -33,9 +33,12 @@
 #include <memory>
 #include <algorithm>
 #include <exception>
+#include <cstring>
+#include <limits>
 
 
 #include "CSRMatrixMPI.hpp"
+#include "MatrixMarket.hpp"
 #if defined(STRUMPACK_USE_COMBBLAS)
 #include "AWPMCombBLAS.hpp"
 #endif
@@ -508,12 +511,16 @@ namespace strumpack {
       (std::unique(spmv_rind.begin(), spmv_rind.end()), spmv_rind.end());
 
     spmv_bufs_.prbuf.reserve(nr_offdiag_nnz);
-    for (integer_t r=0; r<lrows_; r++)
+    spmv_bufs_.prptr.resize(lrows_+1);
+    for (integer_t r=0; r<lrows_; r++) {
+      spmv_bufs_.prptr[r] = spmv_bufs_.prbuf.size();
       for (integer_t j=offdiag_start_[r]; j<ptr_[r+1]; j++)
         spmv_bufs_.prbuf.push_back
           (std::distance
            (spmv_rind.begin(), std::lower_bound
             (spmv_rind.begin(), spmv_rind.end(), ind_[j])));
+    }
+    spmv_bufs_.prptr[lrows_] = spmv_bufs_.prbuf.size();
 
     // how much to receive from each proc
     std::vector<int> rsizes(P), ssizes(P);
@@ -562,36 +569,83 @@ namespace strumpack {
     spmv_bufs_.sbuf.resize(oset_send);
   }
 
+  // The columns are interleaved in the send/receive buffers: entry i
+  // of column c is at i*d+c, so prbuf can be used, scaled by d.
   template<typename scalar_t,typename integer_t> void
   CSRMatrixMPI<scalar_t,integer_t>::spmv
   (const DenseM_t& x, DenseM_t& y) const {
     assert(x.cols() == y.cols());
     assert(x.rows() == std::size_t(lrows_));
     assert(y.rows() == std::size_t(lrows_));
-    for (std::size_t c=0; c<x.cols(); c++)
-      spmv(x.ptr(0,c), y.ptr(0,c));
+    const std::size_t d = x.cols();
+    if (d == 1) {
+      spmv(x.data(), y.data());
+      return;
+    }
+    setup_spmv_buffers();
+    const auto& B = spmv_bufs_;
+    auto nps = B.sranks.size(), npr = B.rranks.size();
+    std::vector<scalar_t> sbuf(B.sind.size()*d), rbuf(B.rbuf.size()*d);
+    std::vector<MPI_Request> sreq(nps), rreq(npr);
+    for (std::size_t p=0; p<npr; p++)
+      comm_.irecv(rbuf.data() + B.roffs[p]*d,
+                  (B.roffs[p+1] - B.roffs[p])*d,
+                  B.rranks[p], 0, &rreq[p]);
+#pragma omp parallel for
+    for (std::size_t i=0; i<B.sind.size(); i++)
+      for (std::size_t c=0; c<d; c++)
+        sbuf[i*d+c] = x(B.sind[i]-brow_, c);
+    for (std::size_t p=0; p<nps; p++)
+      comm_.isend(sbuf.data() + B.soff[p]*d,
+                  (B.soff[p+1] - B.soff[p])*d,
+                  B.sranks[p], 0, &sreq[p]);
+
+    // block diagonal part, while the communication is going on
+#pragma omp parallel for
+    for (integer_t r=0; r<lrows_; r++) {
+      for (std::size_t c=0; c<d; c++)
+        y(r, c) = scalar_t(0.);
+      for (auto j=ptr_[r]; j<offdiag_start_[r]; j++) {
+        auto v = val_[j];
+        auto xj = ind_[j] - brow_;
+        for (std::size_t c=0; c<d; c++)
+          y(r, c) += v * x(xj, c);
+      }
+    }
+    wait_all(rreq);
+
+    // block off-diagonal part
+#pragma omp parallel for
+    for (integer_t r=0; r<lrows_; r++) {
+      auto pb = B.prptr[r];
+      for (auto j=offdiag_start_[r]; j<ptr_[r+1]; j++) {
+        auto v = val_[j];
+        auto rb = rbuf.data() + B.prbuf[pb++]*d;
+        for (std::size_t c=0; c<d; c++)
+          y(r, c) += v * rb[c];
+      }
+    }
+    wait_all(sreq);
   }
 
   template<typename scalar_t,typename integer_t> void
   CSRMatrixMPI<scalar_t,integer_t>::spmv
   (const scalar_t* x, scalar_t* y) const {
     setup_spmv_buffers();
-
-    for (std::size_t i=0; i<spmv_bufs_.sind.size(); i++)
-      spmv_bufs_.sbuf[i] =
-        x[spmv_bufs_.sind[i]-brow_];
-
-    std::vector<MPI_Request> sreq(spmv_bufs_.sranks.size()),
-      rreq(spmv_bufs_.rranks.size());
-    for (std::size_t p=0; p<spmv_bufs_.sranks.size(); p++)
-      comm_.isend(spmv_bufs_.sbuf.data() + spmv_bufs_.soff[p],
-                  spmv_bufs_.soff[p+1] - spmv_bufs_.soff[p],
-                  spmv_bufs_.sranks[p], 0, &sreq[p]);
-
-    for (std::size_t p=0; p<spmv_bufs_.rranks.size(); p++)
-      comm_.irecv(spmv_bufs_.rbuf.data() + spmv_bufs_.roffs[p],
-                  spmv_bufs_.roffs[p+1] - spmv_bufs_.roffs[p],
-                  spmv_bufs_.rranks[p], 0, &rreq[p]);
+    auto& B = spmv_bufs_;
+    auto nps = B.sranks.size(), npr = B.rranks.size();
+    std::vector<MPI_Request> sreq(nps), rreq(npr);
+    // post the receives first, so incoming messages do not need to
+    // be buffered by MPI
+    for (std::size_t p=0; p<npr; p++)
+      comm_.irecv(B.rbuf.data() + B.roffs[p], B.roffs[p+1] - B.roffs[p],
+                  B.rranks[p], 0, &rreq[p]);
+#pragma omp parallel for
+    for (std::size_t i=0; i<B.sind.size(); i++)
+      B.sbuf[i] = x[B.sind[i]-brow_];
+    for (std::size_t p=0; p<nps; p++)
+      comm_.isend(B.sbuf.data() + B.soff[p], B.soff[p+1] - B.soff[p],
+                  B.sranks[p], 0, &sreq[p]);
 
     // first do the block diagonal part, while the communication is going on
 #pragma omp parallel for
@@ -605,11 +659,14 @@ namespace strumpack {
     wait_all(rreq);
 
     // do the block off-diagonal part of the matrix
-    // TODO some openmp here
-    auto pbuf = spmv_bufs_.prbuf.begin();
-    for (integer_t r=0; r<lrows_; r++)
+#pragma omp parallel for
+    for (integer_t r=0; r<lrows_; r++) {
+      auto pb = B.prptr[r];
+      auto yrow = y[r];
       for (integer_t j=offdiag_start_[r]; j<ptr_[r+1]; j++)
-        y[r] += val_[j] * spmv_bufs_.rbuf[*pbuf++];
+        yrow += val_[j] * B.rbuf[B.prbuf[pb++]];
+      y[r] = yrow;
+    }
 
     // wait for all send messages to finish
     wait_all(sreq);
@@ -754,6 +811,21 @@ namespace strumpack {
       return M;
     }
 
+    if (job == MatchingJob::APPROX_DIAGONAL_PRODUCT_SCALING) {
+      Match_t M(MatchingJob::MAX_DIAGONAL_PRODUCT_SCALING, this->size());
+      if (auction_matching(M)) {
+        if (apply) {
+          scale_real(M.R, M.C);
+          permute_columns(M.Q);
+        }
+        return M;
+      }
+      if (comm_.is_root())
+        std::cerr << "# WARNING: auction matching failed,"
+                  << " falling back to sequential MC64" << std::endl;
+      job = MatchingJob::MAX_DIAGONAL_PRODUCT_SCALING;
+    }
+
     auto Aseq = gather();
     Match_t M;
     int ierr = 0;
@@ -792,6 +864,145 @@ namespace strumpack {
     return M;
   }
 
+  /**
+   * Auction algorithm with epsilon scaling, for the assignment
+   * problem with weights b_ij = log|a_ij| - log max_k |a_kj|, see
+   * Bertsekas, "Auction algorithms for network flow problems: A
+   * tutorial introduction", 1992. The local unassigned rows bid in
+   * parallel (Jacobi auction). All bids are gathered on all ranks, so
+   * every rank resolves the bids in the same way and keeps an
+   * identical copy of the column prices and assignments. Hence the
+   * communication per round is proportional to the number of
+   * unassigned rows, not to the matrix size.
+   *
+   * With row profits pi_i and column prices p_j, and epsilon
+   * complementary slackness, the scaling R_i = exp(-pi_i), C_j =
+   * exp(-p_j) / max_k |a_kj| gives |a_i,q(i)| R_i C_q(i) = 1 and |a_ij|
+   * R_i C_j <= exp(eps) for the other entries, as MC64 job 5.
+   *
+   * Returns false if no perfect matching was found, for instance when
+   * the matrix is structurally singular.
+   */
+  template<typename scalar_t,typename integer_t> bool
+  CSRMatrixMPI<scalar_t,integer_t>::auction_matching(Match_t& M) const {
+    using Bid = Triplet<double,integer_t>;
+    const double inf = std::numeric_limits<double>::infinity(),
+      eps_final = 1e-2;
+    auto P = comm_.size();
+    auto rank = comm_.rank();
+    integer_t n = n_;
+    if (!n) return true;
+    // column maxima of log|a_ij|, then the (nonpositive) weights
+    std::vector<double> cmax(n, -inf), b(lnnz_);
+    for (integer_t r=0; r<lrows_; r++)
+      for (integer_t j=ptr_[r]; j<ptr_[r+1]; j++) {
+        auto a = std::abs(val_[j]);
+        b[j] = a == real_t(0.) ? -inf : std::log(double(a));
+        cmax[ind_[j]] = std::max(cmax[ind_[j]], b[j]);
+      }
+    comm_.all_reduce(cmax, MPI_MAX);
+    int ierr = 0;
+    for (integer_t c=0; c<n; c++)
+      if (cmax[c] == -inf) ierr = 1;
+    double wrange = 0.;
+    for (integer_t r=0; r<lrows_; r++) {
+      bool empty = true;
+      for (integer_t j=ptr_[r]; j<ptr_[r+1]; j++) {
+        if (b[j] == -inf) continue;
+        b[j] -= cmax[ind_[j]];
+        wrange = std::max(wrange, -b[j]);
+        empty = false;
+      }
+      if (empty) ierr = 1;
+    }
+    if (comm_.all_reduce(ierr, MPI_MAX)) return false;
+    wrange = comm_.all_reduce(wrange, MPI_MAX);
+
+    // replicated prices and column assignments, local row assignments
+    std::vector<double> price(n, 0.);
+    std::vector<integer_t> cmatch(n), rmatch(lrows_), best(n, -1), bcols;
+    std::vector<int> cnts(P), displs(P);
+    std::vector<Bid> bids;
+    double eps = std::max(wrange, 1.) / 5.;
+    while (true) {
+      std::fill(cmatch.begin(), cmatch.end(), -1);
+      std::fill(rmatch.begin(), rmatch.end(), -1);
+      // bound on the prices, when reached there is no perfect matching
+      double pmax = *std::max_element(price.begin(), price.end()) +
+        2. * (n + 1) * (wrange + 2. * eps);
+      while (true) {
+        std::vector<integer_t> U;
+        for (integer_t r=0; r<lrows_; r++)
+          if (rmatch[r] == -1) U.push_back(r);
+        cnts[rank] = U.size();
+        comm_.all_gather(cnts.data(), 1);
+        displs[0] = 0;
+        for (int p=1; p<P; p++) displs[p] = displs[p-1] + cnts[p-1];
+        auto nbids = displs[P-1] + cnts[P-1];
+        if (nbids == 0) break;
+        bids.resize(nbids);
+        auto lbids = bids.data() + displs[rank];
+#pragma omp parallel for
+        for (std::size_t i=0; i<U.size(); i++) {
+          auto r = U[i];
+          double v1 = -inf, v2 = -inf;
+          integer_t c1 = -1;
+          for (integer_t j=ptr_[r]; j<ptr_[r+1]; j++) {
+            if (b[j] == -inf) continue;
+            auto v = b[j] - price[ind_[j]];
+            if (v > v1) { v2 = v1; v1 = v; c1 = ind_[j]; }
+            else if (v > v2) v2 = v;
+          }
+          if (v2 == -inf) v2 = v1 - wrange - eps;
+          lbids[i] = Bid(brow_ + r, c1, price[c1] + v1 - v2 + eps);
+        }
+        comm_.all_gather_v(bids.data(), cnts.data(), displs.data());
+        // highest bid wins, ties go to the lowest row
+        for (int i=0; i<nbids; i++) {
+          auto c = bids[i].c;
+          if (best[c] == -1) { best[c] = i; bcols.push_back(c); }
+          else if (bids[i].v > bids[best[c]].v ||
+                   (bids[i].v == bids[best[c]].v &&
+                    bids[i].r < bids[best[c]].r)) best[c] = i;
+        }
+        for (auto c : bcols) {
+          auto& w = bids[best[c]];
+          best[c] = -1;
+          price[c] = w.v;
+          if (price[c] > pmax) ierr = 1;
+          auto old = cmatch[c];
+          if (old >= brow_ && old < brow_ + lrows_) rmatch[old-brow_] = -1;
+          cmatch[c] = w.r;
+          if (w.r >= brow_ && w.r < brow_ + lrows_) rmatch[w.r-brow_] = c;
+        }
+        bcols.clear();
+        // all ranks have the same prices
+        if (ierr) return false;
+      }
+      if (eps <= eps_final) break;
+      eps = std::max(eps / 5., eps_final);
+    }
+
+    for (integer_t c=0; c<n; c++) M.Q[cmatch[c]] = c;
+    // shift prices and profits, to keep the scaling factors balanced
+    auto pmm = std::minmax_element(price.begin(), price.end());
+    auto shift = (*pmm.first + *pmm.second) / 2.;
+    std::vector<real_t> lR(lrows_);
+    for (integer_t r=0; r<lrows_; r++) {
+      auto c = rmatch[r];
+      for (integer_t j=ptr_[r]; j<ptr_[r+1]; j++)
+        if (ind_[j] == c) {
+          // -profit of row r
+          lR[r] = real_t(std::exp(price[c] - b[j] - shift));
+          break;
+        }
+    }
+    M.R = std::move(lR);
+    for (integer_t c=0; c<n; c++)
+      M.C[c] = real_t(std::exp(shift - price[c] - cmax[c]));
+    return true;
+  }
+
   template<typename scalar_t,typename integer_t> Equilibration<scalar_t>
   CSRMatrixMPI<scalar_t,integer_t>::equilibration() const {
     Equil_t eq(lrows_, n_);
@@ -1030,19 +1241,191 @@ namespace strumpack {
     spmv_bufs_ = SPMVBuffers<scalar_t,integer_t>();
   }
 
+  namespace {
+    // read bytes [offset, offset+count) from fh, in pieces that fit
+    // in an int
+    bool read_file_at(MPI_File fh, std::size_t offset,
+                      std::size_t count, char* buf) {
+      const std::size_t max_piece = 1 << 30;
+      for (std::size_t done=0; done<count; ) {
+        int c = std::min(max_piece, count-done);
+        if (MPI_File_read_at(fh, MPI_Offset(offset+done), buf+done, c,
+                             MPI_CHAR, MPI_STATUS_IGNORE) != MPI_SUCCESS)
+          return false;
+        done += c;
+      }
+      return true;
+    }
+  }
+
+  /**
+   * Every rank reads (with MPI-IO) and parses (with multiple threads)
+   * an equal part of the file. The rows are then distributed to
+   * balance the number of nonzeros, based on a coarse histogram of
+   * the row counts, and the entries are sent to their owners.
+   */
   template<typename scalar_t,typename integer_t> int
   CSRMatrixMPI<scalar_t,integer_t>::read_matrix_market
   (const std::string& filename) {
-    std::cout << "ERROR: reading a distributed matrix"
-              << " from file is not supported." << std::endl;
-    abort();
-    // TODO: first read the matrix as a sequential matrix
-    // then make a Distributed matrix from the sequential one
-    // Aydin has code for MPI-IO input of matrix-market file
+    using Trip = Triplet<scalar_t,integer_t>;
+    auto P = comm_.size();
+    auto rank = comm_.rank();
+    MPI_File fh;
+    if (MPI_File_open(comm(), filename.c_str(), MPI_MODE_RDONLY,
+                      MPI_INFO_NULL, &fh) != MPI_SUCCESS) {
+      if (comm_.is_root())
+        std::cerr << "ERROR: could not read file " << filename << std::endl;
+      return 1;
+    }
+    MPI_Offset fsize;
+    MPI_File_get_size(fh, &fsize);
+    std::size_t size = fsize;
+    // the root reads the header, with a growing buffer in case of
+    // many comment lines
+    MatrixMarketHeader h;
+    int ierr = 0;
+    if (comm_.is_root()) {
+      std::cout << "# opening file \'" << filename << "\'" << std::endl;
+      std::vector<char> hbuf;
+      std::size_t hsize = 1 << 16;
+      while (true) {
+        hsize = std::min(hsize, size);
+        hbuf.resize(hsize);
+        if (!read_file_at(fh, 0, hsize, hbuf.data())) { ierr = 1; break; }
+        if (parse_matrix_market_header(hbuf.data(), hsize, h)) break;
+        if (hsize == size) { ierr = 1; break; }
+        hsize *= 2;
+      }
+      if (ierr)
+        std::cerr << "ERROR: could not read the Matrix Market header"
+                  << std::endl;
+      else {
+        std::cout << "# " << h.banner << std::endl;
+        std::cout << "# reading " << number_format_with_commas(h.rows)
+                  << " by " << number_format_with_commas(h.cols)
+                  << " matrix with " << number_format_with_commas(h.entries)
+                  << " nnz's from " << filename << std::endl;
+        if (h.pattern) {
+          std::cerr << "ERROR: This is not a matrix,"
+                    << " but just a sparsity pattern" << std::endl;
+          ierr = 1;
+        } else if (h.complex && !is_complex<scalar_t>()) {
+          std::cerr << "ERROR: Complex matrix" << std::endl;
+          ierr = 1;
+        } else if (h.rows != h.cols) {
+          std::cerr << "ERROR: matrix is not square!" << std::endl;
+          ierr = 1;
+        }
+      }
+    }
+    comm_.broadcast(ierr);
+    if (ierr) {
+      MPI_File_close(&fh);
+      return 1;
+    }
+    MPI_Bcast(&h, sizeof(h), MPI_BYTE, 0, comm());
+
+    // this rank parses the lines starting in [begin, end), the last
+    // line can extend past end
+    auto dsize = size - h.data_begin;
+    std::size_t begin = h.data_begin + dsize * rank / P,
+      end = h.data_begin + dsize * (rank+1) / P,
+      lo = (begin > h.data_begin) ? begin - 1 : begin,
+      hi = std::min(size, end + 1024);
+    std::vector<char> buf;
+    while (end > begin) {
+      buf.resize(hi - lo);
+      if (!read_file_at(fh, lo, hi - lo, buf.data())) { ierr = 1; break; }
+      if (hi == size || std::memchr
+          (buf.data() + (end-1-lo), '\n', hi-end+1)) break;
+      hi = std::min(size, end + 2 * (hi - end));
+    }
+    MPI_File_close(&fh);
+    if (comm_.all_reduce(ierr, MPI_MAX)) {
+      if (comm_.is_root())
+        std::cerr << "ERROR: could not read from file" << std::endl;
+      return 1;
+    }
+    std::vector<std::vector<Trip>> parts;
+    integer_t min_index = std::numeric_limits<integer_t>::max();
+    long long entries = 0;
+    if (end > begin)
+      entries = parse_matrix_market_entries
+        (h, buf.data(), buf.size(), begin-lo, end-lo, parts, min_index);
+    buf = std::vector<char>();
+    entries = comm_.all_reduce(entries, MPI_SUM);
+    if (entries != (long long)h.entries) {
+      if (comm_.is_root())
+        std::cerr << "ERROR: found " << entries << " valid entries, "
+                  << "expected " << h.entries << std::endl;
+      return 1;
+    }
+    // indices are one based, unless a zero index is found
+    integer_t base = comm_.all_reduce(min_index, MPI_MIN) == 0 ? 0 : 1;
+    for (auto& A : parts)
+      for (auto& t : A)
+        if (t.r < base || t.r >= integer_t(h.rows) + base ||
+            t.c < base || t.c >= integer_t(h.cols) + base)
+          ierr = 1;
+    if (comm_.all_reduce(ierr, MPI_MAX)) {
+      if (comm_.is_root())
+        std::cerr << "ERROR: row or column index out of range"
+                  << std::endl;
+      return 1;
+    }
+
+    // histogram of the nonzeros over (coarse) blocks of rows, to
+    // balance the nonzeros over the ranks
+    n_ = h.rows;
+    integer_t nbins = std::min(n_, integer_t(64 * P)),
+      bin_rows = (n_ + nbins - 1) / std::max(nbins, integer_t(1));
+    std::vector<long long> bins(nbins+1, 0);
+    for (auto& A : parts)
+      for (auto& t : A)
+        bins[(t.r-base) / bin_rows + 1]++;
+    comm_.all_reduce(bins, MPI_SUM);
+    for (integer_t b=0; b<nbins; b++) bins[b+1] += bins[b];
+    dist_.assign(P+1, 0);
+    for (int p=1; p<P; p++) {
+      auto target = bins[nbins] * p / P;
+      auto b = std::lower_bound(bins.begin(), bins.end(), target)
+        - bins.begin();
+      dist_[p] = std::max(dist_[p-1], std::min(n_, integer_t(b*bin_rows)));
+    }
+    dist_[P] = n_;
+
+    // send the entries to the owner of their row
+    std::vector<std::vector<Trip>> sbuf(P);
+    for (auto& A : parts) {
+      for (auto& t : A) {
+        auto p = std::upper_bound
+          (dist_.begin(), dist_.end(), t.r-base) - dist_.begin() - 1;
+        sbuf[p].push_back(t);
+      }
+      A = std::vector<Trip>();
+    }
+    std::vector<Trip> rbuf;
+    std::vector<Trip*> pbuf;
+    comm_.all_to_all_v(sbuf, rbuf, pbuf);
+    sbuf = std::vector<std::vector<Trip>>();
+
+    brow_ = dist_[rank];
+    lrows_ = dist_[rank+1] - brow_;
+    std::vector<std::pair<const Trip*,const Trip*>> ranges
+      {{rbuf.data(), rbuf.data()+rbuf.size()}};
+    // indices were checked above, so this cannot fail
+    triplets_to_csr<scalar_t,integer_t>
+      (brow_, dist_[rank+1], n_, base, ranges, ptr_, ind_, val_);
+    lnnz_ = ind_.size();
+    nnz_ = comm_.all_reduce(lnnz_, MPI_SUM);
+    symm_sparse_ = h.symmetric();
+    sort_rows();
+    split_diag_offdiag();
+    spmv_bufs_ = SPMVBuffers<scalar_t,integer_t>();
+    check();
     return 0;
   }
 
-
   template<typename scalar_t,typename integer_t>
   typename RealType<scalar_t>::value_type
   CSRMatrixMPI<scalar_t,integer_t>::max_scaled_residual
@@ -53,6 +53,8 @@ namespace strumpack {
     // for each off-diagonal entry spmv_prbuf stores the
     // corresponding index in the receive buffer
     std::vector<integer_t> prbuf;
+    // start of each row in prbuf
+    std::vector<integer_t> prptr;
   };
 
 
@@ -108,6 +110,12 @@ namespace strumpack {
 
     real_t norm1() const override;
 
+    /**
+     * Sparse matrix times (multiple) vector(s), y = A x. The halo
+     * exchange with the neighbouring ranks is overlapped with the
+     * product with the diagonal block. All columns of x are sent in
+     * a single message per neighbour.
+     */
     void spmv(const DenseM_t& x, DenseM_t& y) const override;
     void spmv(const scalar_t* x, scalar_t* y) const override;
 
@@ -120,7 +128,10 @@ namespace strumpack {
     /**
      * This gathers the matrix to 1 process, then applies MC64
      * sequentially. lDr and gDc are only set when job ==
-     * MatchingJob::MAX_DIAGONAL_PRODUCT_SCALING.
+     * MatchingJob::MAX_DIAGONAL_PRODUCT_SCALING. For job ==
+     * MatchingJob::APPROX_DIAGONAL_PRODUCT_SCALING, the matching is
+     * computed on the distributed matrix, with an auction algorithm,
+     * and the returned job is MAX_DIAGONAL_PRODUCT_SCALING.
      *
      * \param job The job type.
      * \param perm Output, column permutation vector containing the
@@ -272,6 +283,8 @@ namespace strumpack {
 
     void sort_rows();
 
+    bool auction_matching(Match_t& M) const;
+
     using CSM_t::n_;
     using CSM_t::nnz_;
     using CSM_t::ptr_;
@@ -94,6 +94,10 @@ namespace strumpack {
   MatchingData<scalar_t,integer_t>
   CompressedSparseMatrix<scalar_t,integer_t>::matching
   (MatchingJob job, bool apply) {
+    // the exact (sequential) MC64 is used instead of the distributed
+    // approximation, with the same type of output
+    if (job == MatchingJob::APPROX_DIAGONAL_PRODUCT_SCALING)
+      job = MatchingJob::MAX_DIAGONAL_PRODUCT_SCALING;
     Match_t M(job, n_);
     if (job == MatchingJob::NONE)
       return M;
@@ -191,136 +195,6 @@ namespace strumpack {
     symm_sparse_ = true;
   }
 
-  template<typename scalar_t> scalar_t get_scalar(double vr, double vi) {
-    return scalar_t(vr);
-  }
-  template<> inline std::complex<double> get_scalar(double vr, double vi) {
-    return std::complex<double>(vr, vi);
-  }
-  template<> inline std::complex<float> get_scalar(double vr, double vi) {
-    return std::complex<float>(vr, vi);
-  }
-
-  template<typename scalar_t,typename integer_t>
-  std::vector<std::tuple<integer_t,integer_t,scalar_t>>
-  CompressedSparseMatrix<scalar_t,integer_t>::read_matrix_market_entries
-  (const std::string& filename) {
-    std::cout << "# opening file \'" << filename << "\'" << std::endl;
-    FILE *fp = fopen(filename.c_str(), "r");
-    if (fp == NULL) {
-      std::cerr << "ERROR: could not read file";
-      exit(1);
-    }
-    const int max_cline = 256;
-    char cline[max_cline];
-    if (fgets(cline, max_cline, fp) == NULL) {
-      std::cerr << "ERROR: could not read from file" << std::endl;
-      exit(1);
-    }
-    printf("# %s", cline);
-    if (strstr(cline, "pattern")) {
-      std::cerr << "ERROR: This is not a matrix,"
-                << " but just a sparsity pattern" << std::endl;
-      exit(1);
-    }
-    else if (strstr(cline, "complex")) {
-      if (!is_complex<scalar_t>()) {
-        fclose(fp);
-        throw "ERROR: Complex matrix";
-      }
-    }
-    MMsym s = GENERAL;
-    if (strstr(cline, "skew-symmetric")) {
-      s = SKEWSYMMETRIC;
-      symm_sparse_ = true;
-    } else if (strstr(cline, "symmetric")) {
-      s = SYMMETRIC;
-      symm_sparse_ = true;
-    } else if (strstr(cline, "hermitian")) {
-      s = HERMITIAN;
-      symm_sparse_ = true;
-    }
-
-    while (fgets(cline, max_cline, fp)) {
-      if (cline[0] != '%') { // first line should be: m n nnz
-        int m, in, innz;
-        sscanf(cline, "%d %d %d", &m, &in, &innz);
-        nnz_ = static_cast<integer_t>(innz);
-        n_ = static_cast<integer_t>(in);
-        std::cout << "# reading " << number_format_with_commas(m) << " by "
-                  << number_format_with_commas(n_) << " matrix with "
-                  << number_format_with_commas(nnz_) << " nnz's from "
-                  << filename << std::endl;
-        if (s != GENERAL) nnz_ = 2 * nnz_;
-        if (m != n_) {
-          std::cerr << "ERROR: matrix is not square!" << std::endl;
-          exit(1);
-        }
-        break;
-      }
-    }
-    std::vector<std::tuple<integer_t,integer_t,scalar_t>> A;
-    A.reserve(nnz_);
-    bool zero_based = false;
-    if (!is_complex<scalar_t>()) {
-      int ir, ic;
-      double dv;
-      while (fscanf(fp, "%d %d %lf\n", &ir, &ic, &dv) != EOF) {
-        scalar_t v = static_cast<scalar_t>(dv);
-        integer_t r = static_cast<integer_t>(ir);
-        integer_t c = static_cast<integer_t>(ic);
-        if (r==0 || c==0) zero_based = true;
-        A.push_back(std::make_tuple(r, c, v));
-        if (r != c) {
-          switch (s) {
-          case SKEWSYMMETRIC:
-            A.push_back(std::make_tuple(c, r, -v));
-            break;
-          case SYMMETRIC:
-            A.push_back(std::make_tuple(c, r, v));
-            break;
-          case HERMITIAN:
-            A.push_back(std::make_tuple(c, r, blas::my_conj(v)));
-            break;
-          default: break;
-          }
-        }
-      }
-    } else {
-      double vr=0, vi=0;
-      int ir, ic;
-      while (fscanf(fp, "%d %d %lf %lf\n", &ir, &ic, &vr, &vi) != EOF) {
-        scalar_t v = get_scalar<scalar_t>(vr, vi);
-        integer_t r = static_cast<integer_t>(ir),
-          c = static_cast<integer_t>(ic);
-        if (r==0 || c==0) zero_based = true;
-        A.push_back(std::make_tuple(r, c, v));
-        if (r != c) {
-          switch (s) {
-          case SKEWSYMMETRIC:
-            A.push_back(std::make_tuple(c, r, -v));
-            break;
-          case SYMMETRIC:
-            A.push_back(std::make_tuple(c, r, v));
-            break;
-          case HERMITIAN:
-            A.push_back(std::make_tuple(c, r, blas::my_conj(v)));
-            break;
-          default: break;
-          }
-        }
-      }
-    }
-    nnz_ = A.size();
-    fclose(fp);
-    if (!zero_based)
-      for (auto& t : A) {
-        std::get<0>(t)--;
-        std::get<1>(t)--;
-      }
-    return A;
-  }
-
   template<typename scalar_t,typename integer_t> void
   CompressedSparseMatrix<scalar_t,integer_t>::permute
   (const integer_t* iorder, const integer_t* order) {
@@ -126,6 +126,69 @@ namespace strumpack {
     }
   };
 
+  /**
+   * Precomputed scatter plan for the extraction of a front
+   * [F11 F12; F21 0] from the sparse matrix, see
+   * CompressedSparseMatrix::extract_front_plan. For each of the
+   * blocks F11, F12 and F21, this stores a list of pairs: the index
+   * of the nonzero in the sparse matrix (in val()), and the offset in
+   * the (column major) block, computed with a leading dimension equal
+   * to the number of rows of the block. The plan only depends on the
+   * sparsity pattern, so it can be reused for matrices with the same
+   * pattern, but different values.
+   */
+  template<typename scalar_t,typename integer_t> class FrontScatterPlan {
+    using DenseM_t = DenseMatrix<scalar_t>;
+  public:
+    std::vector<integer_t> v11, v12, v21;
+    std::vector<std::size_t> f11, f12, f21;
+    // number of nonzeros of the matrix for which this plan was built
+    integer_t nnz = -1;
+    // whether F12 was extracted (not for symmetric fronts)
+    bool has_F12 = false;
+
+    /**
+     * Check if this plan was built for a matrix with nnz nonzeros,
+     * for fronts with the dimensions/storage of F11, F12 and F21.
+     */
+    bool valid(integer_t n, const DenseM_t& F11, const DenseM_t& F12,
+               const DenseM_t& F21) const {
+      return nnz == n && has_F12 == (F12.cols() > 0) &&
+        (!F11.rows() || F11.ld() == F11.rows()) &&
+        (!F12.rows() || F12.ld() == F12.rows()) &&
+        (!F21.rows() || F21.ld() == F21.rows());
+    }
+
+    void clear() {
+      v11.clear(); v12.clear(); v21.clear();
+      f11.clear(); f12.clear(); f21.clear();
+      nnz = -1;
+    }
+
+    /**
+     * Scatter the values of the sparse matrix to the front. F11, F12
+     * and F21 should be set to zero, and the plan should be valid for
+     * these blocks.
+     */
+    void apply(const scalar_t* val, DenseM_t& F11, DenseM_t& F12,
+               DenseM_t& F21) const {
+      scatter(val, v11, f11, F11.data());
+      scatter(val, v12, f12, F12.data());
+      scatter(val, v21, f21, F21.data());
+    }
+
+  private:
+    static void scatter(const scalar_t* val, const std::vector<integer_t>& v,
+                        const std::vector<std::size_t>& f, scalar_t* F) {
+      const std::size_t n = v.size();
+      const auto vi = v.data();
+      const auto fi = f.data();
+#pragma omp simd
+      for (std::size_t i=0; i<n; i++)
+        F[fi[i]] = val[vi[i]];
+    }
+  };
+
   /**
    * \class CompressedSparseMatrix
    * \brief Abstract base class for compressed sparse matrix storage.
@@ -385,6 +448,19 @@ namespace strumpack {
                   integer_t slo, integer_t shi,
                   const std::vector<integer_t>& upd,
                   int depth) const = 0;
+    /**
+     * Build a scatter plan for extract_front, which can then be used
+     * instead of extract_front for matrices with the same sparsity
+     * pattern, see FrontScatterPlan. Returns false if this is not
+     * supported for this matrix type, in which case extract_front
+     * should be used.
+     */
+    virtual bool
+    extract_front_plan(integer_t slo, integer_t shi,
+                       const std::vector<integer_t>& upd, bool F12,
+                       FrontScatterPlan<scalar_t,integer_t>& plan) const {
+      return false;
+    }
     virtual void
     push_front_elements(integer_t, integer_t, const std::vector<integer_t>&,
                         std::vector<Triplet<scalar_t>>&,
@@ -454,8 +530,6 @@ namespace strumpack {
     std::vector<scalar_t> val_;
     bool symm_sparse_;
 
-    enum MMsym {GENERAL, SYMMETRIC, SKEWSYMMETRIC, HERMITIAN};
-
     CompressedSparseMatrix();
     CompressedSparseMatrix(integer_t n, integer_t nnz,
                            bool symm_sparse=false);
@@ -464,9 +538,6 @@ namespace strumpack {
                            const integer_t* col_ind,
                            const scalar_t* values, bool symm_sparsity);
 
-    std::vector<std::tuple<integer_t,integer_t,scalar_t>>
-    read_matrix_market_entries(const std::string& filename);
-
     virtual int strumpack_mc64(MatchingJob, Match_t&) { return 0; }
 
     virtual void scale(const std::vector<scalar_t>&,
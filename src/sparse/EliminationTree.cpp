@@ -28,11 +28,14 @@
  */
 #include <iostream>
 #include <algorithm>
+#include <tuple>
 
 #include "EliminationTree.hpp"
 #include "fronts/FrontFactory.hpp"
 #include "fronts/FrontalMatrix.hpp"
 #include "SeparatorTree.hpp"
+#include "OutOfCoreStorage.hpp"
+#include "FactorFile.hpp"
 
 namespace strumpack {
 
@@ -41,10 +44,11 @@ namespace strumpack {
   (const SPOptions<scalar_t>& opts, const SpMat_t& A,
    SeparatorTree<integer_t>& sep_tree) {
     std::vector<std::vector<integer_t>> upd(sep_tree.separators());
-#pragma omp parallel default(shared)
-#pragma omp single
-    symbolic_factorization(A, sep_tree, sep_tree.root(), upd);
-    root_ = setup_tree(opts, A, sep_tree, upd, sep_tree.root(), 0);
+    symbolic_factorization(A, sep_tree, upd);
+    std::vector<integer_t> amalg;
+    if (opts.amalgamation())
+      amalg = amalgamate(opts, sep_tree, upd);
+    root_ = setup_tree(opts, A, sep_tree, upd, amalg);
   }
 
   template<typename scalar_t,typename integer_t>
@@ -62,26 +66,45 @@ namespace strumpack {
     root_->print_rank_statistics(out);
   }
 
+  /**
+   * The update indices of each separator, bottom-up, without
+   * recursion. The separators in the top task_recursion_cutoff_level
+   * levels of the tree are handled level by level, those below are
+   * handled per subtree, each subtree sequentially, in postorder.
+   */
   template<typename scalar_t,typename integer_t> void
   EliminationTree<scalar_t,integer_t>::symbolic_factorization
   (const SpMat_t& A, const SeparatorTree<integer_t>& sep_tree,
-   integer_t sep, std::vector<std::vector<integer_t>>& upd, int depth) const {
+   std::vector<std::vector<integer_t>>& upd) const {
+    if (!sep_tree.separators()) return;
+    const int L = params::task_recursion_cutoff_level;
+    std::vector<std::vector<integer_t>> top(L+1);
+    top[0].push_back(sep_tree.root());
+    for (int l=0; l<L; l++)
+      for (auto sep : top[l])
+        for (auto ch : {sep_tree.lch[sep], sep_tree.rch[sep]})
+          if (ch != -1) top[l+1].push_back(ch);
+#pragma omp parallel for schedule(dynamic)
+    for (std::size_t i=0; i<top[L].size(); i++)
+      for (auto sep : sep_tree.postorder(top[L][i]))
+        symbolic_factorization(A, sep_tree, sep, upd);
+    for (int l=L-1; l>=0; l--) {
+#pragma omp parallel for schedule(dynamic)
+      for (std::size_t i=0; i<top[l].size(); i++)
+        symbolic_factorization(A, sep_tree, top[l][i], upd);
+    }
+  }
+
+  /**
+   * The update indices of separator sep, from the sparse matrix and
+   * from the update indices of its children.
+   */
+  template<typename scalar_t,typename integer_t> void
+  EliminationTree<scalar_t,integer_t>::symbolic_factorization
+  (const SpMat_t& A, const SeparatorTree<integer_t>& sep_tree,
+   integer_t sep, std::vector<std::vector<integer_t>>& upd) const {
     auto chl = sep_tree.lch[sep];
     auto chr = sep_tree.rch[sep];
-    if (depth < params::task_recursion_cutoff_level) {
-      if (chl != -1)
-#pragma omp task untied default(shared)                                 \
-  final(depth >= params::task_recursion_cutoff_level-1) mergeable
-        symbolic_factorization(A, sep_tree, chl, upd, depth+1);
-      if (chr != -1)
-#pragma omp task untied default(shared)                                 \
-  final(depth >= params::task_recursion_cutoff_level-1) mergeable
-        symbolic_factorization(A, sep_tree, chr, upd, depth+1);
-#pragma omp taskwait
-    } else {
-      if (chl != -1) symbolic_factorization(A, sep_tree, chl, upd, depth);
-      if (chr != -1) symbolic_factorization(A, sep_tree, chr, upd, depth);
-    }
     auto sep_begin = sep_tree.sizes[sep];
     auto sep_end = sep_tree.sizes[sep+1];
     if (sep != sep_tree.root()) { // not necessary for the root
@@ -122,41 +145,276 @@ namespace strumpack {
     }
   }
 
+  /**
+   * Relaxed supernode amalgamation. Going bottom-up, the two leaf
+   * children of a node are merged with that node, when the merged
+   * separator is small enough, or when the number of explicit zeros
+   * in the merged front is small enough compared to the size of the
+   * merged front. Since the subtree of a node is numbered
+   * contiguously, before the separator of the node itself, the
+   * merged front corresponds to a contiguous range of unknowns. The
+   * update indices of the merged front are those of the node.
+   *
+   * This returns, for each node, the first index of its merged
+   * front, or -1 if the node was not merged with its children.
+   */
+  template<typename scalar_t,typename integer_t> std::vector<integer_t>
+  EliminationTree<scalar_t,integer_t>::amalgamate
+  (const SPOptions<scalar_t>& opts, const SeparatorTree<integer_t>& sep_tree,
+   const std::vector<std::vector<integer_t>>& upd) {
+    auto nsep = sep_tree.separators();
+    std::vector<integer_t> amalg(nsep, -1);
+    // number of entries in the fronts of the original (unmerged)
+    // subtree, and explicit zeros in the merged front
+    std::vector<long long> orig(nsep, 0), zeros(nsep, 0);
+    auto front_size = [](long long ds, long long du) {
+      return ds * (ds + 2 * du); };
+    auto begin = [&](integer_t s) {
+      return amalg[s] == -1 ? sep_tree.sizes[s] : amalg[s]; };
+    // leaf[sep]: sep is a leaf after amalgamation
+    std::vector<bool> leaf(nsep, false);
+    for (auto sep : sep_tree.postorder(sep_tree.root())) {
+      auto sep_begin = sep_tree.sizes[sep], sep_end = sep_tree.sizes[sep+1];
+      long long dupd = upd[sep].size();
+      orig[sep] = front_size(sep_end - sep_begin, dupd);
+      auto chl = sep_tree.lch[sep], chr = sep_tree.rch[sep];
+      if (chl == -1 && chr == -1) {
+        leaf[sep] = true;
+        continue;
+      }
+      // the ranges should be contiguous, this excludes the dummy
+      // nodes added to the top of the tree
+      if (chl == -1 || chr == -1 || !leaf[chl] || !leaf[chr] ||
+          sep_end == sep_begin ||
+          sep_tree.sizes[chl+1] != begin(chr) ||
+          sep_tree.sizes[chr+1] != sep_begin)
+        continue;
+      long long dm = sep_end - begin(chl), fm = front_size(dm, dupd),
+        om = orig[chl] + orig[chr] + orig[sep], zm = fm - om;
+      if (dm > opts.amalgamation_size() &&
+          zm > opts.amalgamation_ratio() * fm)
+        continue;
+      amalg[sep] = begin(chl);
+      nr_fronts_.amalgamated += 2;
+      nr_fronts_.amalgamation_zeros += zm - zeros[chl] - zeros[chr];
+      orig[sep] = om;
+      zeros[sep] = zm;
+      leaf[sep] = true;
+    }
+    return amalg;
+  }
+
+  /**
+   * Create the fronts, in preorder, without recursion. A merged
+   * front, see amalgamate, also holds the separators of its subtree,
+   * so its children are not created.
+   */
   template<typename scalar_t,typename integer_t>
   std::unique_ptr<FrontalMatrix<scalar_t,integer_t>>
   EliminationTree<scalar_t,integer_t>::setup_tree
   (const SPOptions<scalar_t>& opts, const SpMat_t& A,
    SeparatorTree<integer_t>& sep_tree,
    std::vector<std::vector<integer_t>>& upd,
-   integer_t sep, int level) {
-    auto sep_begin = sep_tree.sizes[sep];
-    auto sep_end = sep_tree.sizes[sep+1];
-    auto dim_sep = sep_end - sep_begin;
-    // dummy nodes added at the end of the separator tree have
-    // dim_sep==0, but they have sep_begin=sep_end=N, which is wrong
-    // So fix this here!
-    if (dim_sep == 0 && sep_tree.lch[sep] != -1)
-      sep_begin = sep_end = sep_tree.sizes[sep_tree.rch[sep]+1];
-    auto front = create_frontal_matrix<scalar_t,integer_t>
-      (opts, sep, sep_begin, sep_end, upd[sep], level, nr_fronts_);
-    if (sep_tree.lch[sep] != -1)
-      front->set_lchild
-        (setup_tree(opts, A, sep_tree, upd, sep_tree.lch[sep], level+1));
-    if (sep_tree.rch[sep] != -1)
-      front->set_rchild
-        (setup_tree(opts, A, sep_tree, upd, sep_tree.rch[sep], level+1));
-    return front;
+   const std::vector<integer_t>& amalg) {
+    std::unique_ptr<F_t> root;
+    if (!sep_tree.separators()) return root;
+    // separator, level, parent front (nullptr for the root), and
+    // whether it is the left child
+    std::vector<std::tuple<integer_t,int,F_t*,bool>> s
+      {std::make_tuple(sep_tree.root(), 0, nullptr, true)};
+    while (!s.empty()) {
+      integer_t sep;
+      int level;
+      F_t* pa;
+      bool left;
+      std::tie(sep, level, pa, left) = s.back();
+      s.pop_back();
+      auto sep_begin = sep_tree.sizes[sep];
+      auto sep_end = sep_tree.sizes[sep+1];
+      auto dim_sep = sep_end - sep_begin;
+      // dummy nodes added at the end of the separator tree have
+      // dim_sep==0, but they have sep_begin=sep_end=N, which is wrong
+      // So fix this here!
+      if (dim_sep == 0 && sep_tree.lch[sep] != -1)
+        sep_begin = sep_end = sep_tree.sizes[sep_tree.rch[sep]+1];
+      bool merged = !amalg.empty() && amalg[sep] != -1;
+      if (merged) sep_begin = amalg[sep];
+      auto front = create_frontal_matrix<scalar_t,integer_t>
+        (opts, sep, sep_begin, sep_end, upd[sep], level, nr_fronts_);
+      auto f = front.get();
+      if (!pa) root = std::move(front);
+      else if (left) pa->set_lchild(std::move(front));
+      else pa->set_rchild(std::move(front));
+      if (merged) continue;
+      // push the right child first, to create the left subtree first
+      if (sep_tree.rch[sep] != -1)
+        s.emplace_back(sep_tree.rch[sep], level+1, f, false);
+      if (sep_tree.lch[sep] != -1)
+        s.emplace_back(sep_tree.lch[sep], level+1, f, true);
+    }
+    return root;
   }
 
   template<typename scalar_t,typename integer_t> ReturnCode
   EliminationTree<scalar_t,integer_t>::multifrontal_factorization
   (const SpMat_t& A, const SPOptions<scalar_t>& opts) {
-    return root_->multifrontal_factorization(A, opts);
+    return factor_root(A, opts);
+  }
+
+  /**
+   * With numeric refactorization, the upd_to_parent maps are computed
+   * once, and the workspace, holding the contribution blocks, is kept
+   * (with its memory) for the next factorization.
+   */
+  template<typename scalar_t,typename integer_t> ReturnCode
+  EliminationTree<scalar_t,integer_t>::factor_root
+  (const SpMat_t& A, const SPOptions<scalar_t>& opts) {
+    // a new file for every factorization, the previous one is
+    // removed when it is closed
+    if (opts.out_of_core()) {
+      ooc_.reset(new OutOfCoreStorage<scalar_t>(opts.out_of_core_path()));
+      root_->set_out_of_core(ooc_.get());
+    } else if (ooc_) {
+      root_->set_out_of_core(nullptr);
+      ooc_.reset();
+    }
+    ReturnCode err;
+    if (!opts.numeric_refactorization())
+      err = root_->multifrontal_factorization(A, opts);
+    else {
+      if (!upd_maps_) {
+        root_->store_upd_to_parent_maps();
+        upd_maps_ = true;
+      }
+      err = root_->factor(A, opts, workspace_);
+    }
+    if (ooc_) ooc_->flush();
+    // the new factors no longer refer to a loaded factor file
+    factor_file_.reset();
+    return err;
   }
 
   template<typename scalar_t,typename integer_t> void
   EliminationTree<scalar_t,integer_t>::delete_factors() {
     root_->delete_factors();
+    workspace_.clear();
+    if (ooc_) {
+      root_->set_out_of_core(nullptr);
+      ooc_.reset();
+    }
+    factor_file_.reset();
+  }
+
+  template<typename scalar_t,typename integer_t> bool
+  EliminationTree<scalar_t,integer_t>::save(FactorFileWriter& f) const {
+    if (!root_) return false;
+    f.write(nr_fronts_.dense);
+    f.write(nr_fronts_.HSS);
+    f.write(nr_fronts_.BLR);
+    f.write(nr_fronts_.HODLR);
+    f.write(nr_fronts_.lossy);
+    f.write(nr_fronts_.amalgamated);
+    f.write(nr_fronts_.amalgamation_zeros);
+    return save_front(f, root_.get());
+  }
+
+  /**
+   * Fronts are stored in preorder: type, separator, update indices,
+   * the factors, a flag for the left child, followed by the left
+   * subtree, and a flag for the right child, followed by the right
+   * subtree. The tree is traversed with an explicit stack.
+   */
+  template<typename scalar_t,typename integer_t> bool
+  EliminationTree<scalar_t,integer_t>::save_front
+  (FactorFileWriter& f, const F_t* F) const {
+    auto write_front = [&](const F_t* F) {
+      f.write(F->type());
+      f.write(F->sep());
+      f.write(F->sep_begin());
+      f.write(F->sep_end());
+      f.write(F->upd());
+      return F->save_factors(f);
+    };
+    if (!write_front(F)) return false;
+    // front, and the number of child flags already written
+    std::vector<std::pair<const F_t*,int>> s{{F, 0}};
+    while (!s.empty()) {
+      auto& t = s.back();
+      if (t.second == 2) {
+        s.pop_back();
+        continue;
+      }
+      auto ch = t.second++ ? t.first->rchild() : t.first->lchild();
+      f.write(char(ch != nullptr));
+      if (!ch) continue;
+      if (!write_front(ch)) return false;
+      s.emplace_back(ch, 0);
+    }
+    return f.good();
+  }
+
+  template<typename scalar_t,typename integer_t> bool
+  EliminationTree<scalar_t,integer_t>::load
+  (const std::shared_ptr<FactorFileReader>& f) {
+    f->read(nr_fronts_.dense);
+    f->read(nr_fronts_.HSS);
+    f->read(nr_fronts_.BLR);
+    f->read(nr_fronts_.HODLR);
+    f->read(nr_fronts_.lossy);
+    f->read(nr_fronts_.amalgamated);
+    f->read(nr_fronts_.amalgamation_zeros);
+    workspace_.clear();
+    upd_maps_ = false;
+    ooc_.reset();
+    root_ = load_front(*f);
+    if (!root_) return false;
+    factor_file_ = f;
+    return true;
+  }
+
+  template<typename scalar_t,typename integer_t>
+  std::unique_ptr<FrontalMatrix<scalar_t,integer_t>>
+  EliminationTree<scalar_t,integer_t>::load_front
+  (FactorFileReader& f) {
+    auto read_front = [&]() -> std::unique_ptr<F_t> {
+      std::string type;
+      f.read(type);
+      auto sep = f.read<integer_t>();
+      auto sep_begin = f.read<integer_t>();
+      auto sep_end = f.read<integer_t>();
+      std::vector<integer_t> upd;
+      f.read(upd);
+      if (!f.good()) return nullptr;
+      auto front = create_frontal_matrix<scalar_t,integer_t>
+        (type, sep, sep_begin, sep_end, upd);
+      if (!front) {
+        std::cerr << "# ERROR: front type " << type
+                  << " not supported in this build" << std::endl;
+        return nullptr;
+      }
+      if (!front->load_factors(f)) return nullptr;
+      return front;
+    };
+    auto root = read_front();
+    if (!root) return nullptr;
+    // same order as save_front, front and number of child flags read
+    std::vector<std::pair<F_t*,int>> s{{root.get(), 0}};
+    while (!s.empty()) {
+      auto& t = s.back();
+      if (t.second == 2) {
+        s.pop_back();
+        continue;
+      }
+      bool left = !t.second++;
+      auto pa = t.first;
+      if (!f.read<char>()) continue;
+      auto ch = read_front();
+      if (!ch) return nullptr;
+      s.emplace_back(ch.get(), 0);
+      if (left) pa->set_lchild(std::move(ch));
+      else pa->set_rchild(std::move(ch));
+    }
+    return root;
   }
 
   template<typename scalar_t,typename integer_t> void
@@ -165,6 +423,12 @@ namespace strumpack {
     root_->multifrontal_solve(x);
   }
 
+  template<typename scalar_t,typename integer_t> void
+  EliminationTree<scalar_t,integer_t>::multifrontal_solve
+  (Trans op, DenseM_t& x) const {
+    root_->multifrontal_solve(op, x);
+  }
+
   template<typename scalar_t,typename integer_t> integer_t
   EliminationTree<scalar_t,integer_t>::maximum_rank() const {
     integer_t max_rank;
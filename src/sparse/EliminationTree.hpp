@@ -39,6 +39,10 @@
 
 namespace strumpack {
 
+  template<typename scalar_t> class OutOfCoreStorage;
+  class FactorFileWriter;
+  class FactorFileReader;
+
   template<typename scalar_t,typename integer_t> class FrontalMatrix;
   template<typename integer_t> class SeparatorTree;
 
@@ -64,6 +68,7 @@ namespace strumpack {
     virtual void delete_factors();
 
     virtual void multifrontal_solve(DenseM_t& x) const;
+    void multifrontal_solve(Trans op, DenseM_t& x) const;
 
     virtual void
     multifrontal_solve_dist(DenseM_t& x,
@@ -85,27 +90,79 @@ namespace strumpack {
 
     virtual FrontCounter front_counter() const { return nr_fronts_; }
 
+    /**
+     * Whether multifrontal_solve can be called concurrently, from
+     * different threads. This is not the case for HSS fronts, which
+     * store the ULV solve workspace, HODLR fronts, and when the
+     * factors are stored out-of-core.
+     */
+    bool reentrant_solve() const {
+      return !nr_fronts_.HSS && !nr_fronts_.HODLR && !ooc_;
+    }
+
     void draw(const SpMat_t& A, const std::string& name) const;
 
     F_t* root() const;
 
+    /**
+     * Storage for the factors, when stored out-of-core, see
+     * SPOptions::set_out_of_core_path, or nullptr.
+     */
+    const OutOfCoreStorage<scalar_t>* out_of_core() const
+    { return ooc_.get(); }
+
+    /**
+     * Write the tree and the factors of all fronts to a factor
+     * file. Returns false if a front does not support this.
+     */
+    bool save(FactorFileWriter& f) const;
+
+    /**
+     * Rebuild the tree and its factors from a factor file. Fronts may
+     * refer to the (memory mapped) file, which is therefore kept open
+     * until the factors are deleted or recomputed.
+     */
+    bool load(const std::shared_ptr<FactorFileReader>& f);
+
   protected:
     FrontCounter nr_fronts_;
     std::unique_ptr<F_t> root_;
 
+    // for numeric refactorization: workspace kept between
+    // factorizations, and whether the upd_to_parent maps are stored
+    VectorPool<scalar_t> workspace_;
+    bool upd_maps_ = false;
+
+    std::unique_ptr<OutOfCoreStorage<scalar_t>> ooc_;
+    std::shared_ptr<FactorFileReader> factor_file_;
+
+    ReturnCode factor_root(const SpMat_t& A,
+                           const SPOptions<scalar_t>& opts);
+
   private:
     std::unique_ptr<F_t>
     setup_tree(const SPOptions<scalar_t>& opts, const SpMat_t& A,
                SeparatorTree<integer_t>& sep_tree,
                std::vector<std::vector<integer_t>>& upd,
-               integer_t sep, int level);
+               const std::vector<integer_t>& amalg);
 
+    std::vector<integer_t>
+    amalgamate(const SPOptions<scalar_t>& opts,
+               const SeparatorTree<integer_t>& sep_tree,
+               const std::vector<std::vector<integer_t>>& upd);
+
+    bool save_front(FactorFileWriter& f, const F_t* F) const;
+    std::unique_ptr<F_t> load_front(FactorFileReader& f);
+
+    void
+    symbolic_factorization(const SpMat_t& A,
+                           const SeparatorTree<integer_t>& sep_tree,
+                           std::vector<std::vector<integer_t>>& upd) const;
     void
     symbolic_factorization(const SpMat_t& A,
                            const SeparatorTree<integer_t>& sep_tree,
                            integer_t sep,
-                           std::vector<std::vector<integer_t>>& upd,
-                           int depth=0) const;
+                           std::vector<std::vector<integer_t>>& upd) const;
   };
 
 } // end namespace strumpack
@@ -237,7 +237,7 @@ namespace strumpack {
   EliminationTreeMPIDist<scalar_t,integer_t>::multifrontal_factorization
   (const CompressedSparseMatrix<scalar_t,integer_t>& A,
    const Opts_t& opts) {
-    return this->root_->multifrontal_factorization(Aprop_, opts);
+    return this->factor_root(Aprop_, opts);
   }
 
   template<typename scalar_t,typename integer_t> void
@@ -0,0 +1,193 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "FactorFile.hpp"
+#include "StrumpackConfig.hpp"
+
+namespace strumpack {
+
+  namespace {
+    const char factor_file_magic[16] = "STRUMPACKfactor";
+    const std::uint32_t byte_order_marker = 0x01020304;
+  }
+
+  FactorFileWriter::FactorFileWriter(const std::string& fname)
+    : os_(fname, std::ios::out | std::ios::trunc | std::ios::binary) {}
+
+  void FactorFileWriter::align() {
+    auto pos = std::size_t(os_.tellp());
+    auto pad = (alignment - pos % alignment) % alignment;
+    char zeros[alignment] = {0};
+    os_.write(zeros, pad);
+  }
+
+  void FactorFileWriter::write_header
+  (std::uint32_t scalar_size, bool complex, std::uint32_t integer_size) {
+    os_.write(factor_file_magic, sizeof(factor_file_magic));
+    write(format_version);
+    write(byte_order_marker);
+    int v[3];
+    get_version(v, v+1, v+2);
+    write(v);
+    write(scalar_size);
+    write(std::uint32_t(complex));
+    write(integer_size);
+  }
+
+  void FactorFileWriter::write_footer() {
+    os_.write(factor_file_magic, sizeof(factor_file_magic));
+    os_.flush();
+  }
+
+
+  FactorFileReader::FactorFileReader(const std::string& fname)
+    : fname_(fname) {
+    int fd = open(fname.c_str(), O_RDONLY);
+    if (fd < 0) {
+      std::cerr << "# ERROR: could not open " << fname << " ("
+                << std::strerror(errno) << ")" << std::endl;
+      return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      // shared, read-only: processes mapping the same file share the
+      // page cache
+      auto p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+      if (p != MAP_FAILED) {
+        data_ = static_cast<const char*>(p);
+        size_ = st.st_size;
+        ok_ = true;
+      } else
+        std::cerr << "# ERROR: could not map " << fname << " ("
+                  << std::strerror(errno) << ")" << std::endl;
+    } else
+      std::cerr << "# ERROR: " << fname << " is empty" << std::endl;
+    // the mapping stays valid after the file is closed
+    close(fd);
+  }
+
+  FactorFileReader::~FactorFileReader() {
+    if (data_) munmap(const_cast<char*>(data_), size_);
+  }
+
+  const char* FactorFileReader::take(std::size_t bytes) {
+    if (!ok_ || bytes > size_ - pos_) {
+      ok_ = false;
+      return nullptr;
+    }
+    auto p = data_ + pos_;
+    pos_ += bytes;
+    return p;
+  }
+
+  void FactorFileReader::align() {
+    auto a = FactorFileWriter::alignment;
+    take((a - pos_ % a) % a);
+  }
+
+  void FactorFileReader::stream
+  (const std::function<void(std::ifstream&)>& f) {
+    if (!ok_) return;
+    std::ifstream is(fname_, std::ios::in | std::ios::binary);
+    is.seekg(pos_);
+    f(is);
+    if (!is.good()) {
+      ok_ = false;
+      return;
+    }
+    pos_ = std::size_t(is.tellg());
+    if (pos_ > size_) ok_ = false;
+  }
+
+  bool FactorFileReader::read_footer() {
+    auto magic = take(sizeof(factor_file_magic));
+    if (!magic || std::memcmp(magic, factor_file_magic,
+                              sizeof(factor_file_magic))) {
+      std::cerr << "# ERROR: " << fname_ << " is truncated or corrupt"
+                << std::endl;
+      ok_ = false;
+    }
+    return ok_;
+  }
+
+  bool FactorFileReader::read_header
+  (std::uint32_t scalar_size, bool complex, std::uint32_t integer_size) {
+    auto magic = take(sizeof(factor_file_magic));
+    if (!magic || std::memcmp(magic, factor_file_magic,
+                              sizeof(factor_file_magic))) {
+      std::cerr << "# ERROR: " << fname_ << " is not a STRUMPACK factor file"
+                << std::endl;
+      ok_ = false;
+      return false;
+    }
+    auto fv = read<std::uint32_t>();
+    if (fv != FactorFileWriter::format_version) {
+      std::cerr << "# ERROR: " << fname_ << " has file format version "
+                << fv << ", expected version "
+                << FactorFileWriter::format_version << std::endl;
+      ok_ = false;
+      return false;
+    }
+    if (read<std::uint32_t>() != byte_order_marker) {
+      std::cerr << "# ERROR: " << fname_ << " was written on a machine"
+                << " with a different byte order" << std::endl;
+      ok_ = false;
+      return false;
+    }
+    int v[3], vf[3];
+    get_version(v, v+1, v+2);
+    for (int i=0; i<3; i++) vf[i] = read<int>();
+    if (v[0] != vf[0] || v[1] != vf[1] || v[2] != vf[2])
+      std::cerr << "# WARNING: " << fname_ << " was created with a different"
+                << " strumpack version (v"
+                << vf[0] << "." << vf[1] << "." << vf[2]
+                << " instead of v"
+                << v[0] << "." << v[1] << "." << v[2]
+                << ")" << std::endl;
+    auto ss = read<std::uint32_t>();
+    auto sc = read<std::uint32_t>();
+    auto is = read<std::uint32_t>();
+    if (ss != scalar_size || sc != std::uint32_t(complex) ||
+        is != integer_size) {
+      std::cerr << "# ERROR: " << fname_ << " was written with a different"
+                << " scalar or integer type" << std::endl;
+      ok_ = false;
+      return false;
+    }
+    return ok_;
+  }
+
+} // end namespace strumpack
@@ -0,0 +1,243 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+/*! \file FactorFile.hpp
+ * \brief Binary file format to store a sparse factorization.
+ */
+#ifndef STRUMPACK_FACTOR_FILE_HPP
+#define STRUMPACK_FACTOR_FILE_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <type_traits>
+
+#include "dense/DenseMatrix.hpp"
+
+namespace strumpack {
+
+  /**
+   * \class FactorFileWriter
+   *
+   * \brief Writes the binary file format used to store a complete
+   * sparse factorization, see SparseSolverBase::save_factors.
+   *
+   * The file starts with a header, see write_header, followed by
+   * scalars and arrays, in native byte order. Each array is preceded
+   * by its length and is aligned on FactorFileWriter::alignment
+   * bytes relative to the start of the file, so that when the file
+   * is memory mapped, see FactorFileReader, the arrays (the factors)
+   * can be used in place.
+   */
+  class FactorFileWriter {
+  public:
+    static constexpr std::size_t alignment = 64;
+    static constexpr std::uint32_t format_version = 2;
+
+    FactorFileWriter(const std::string& fname);
+
+    bool good() const { return os_.good(); }
+
+    /**
+     * Write the header: a magic string, the version of the file
+     * format and of STRUMPACK, a byte order marker, and the scalar
+     * and integer types.
+     */
+    template<typename scalar_t,typename integer_t> void write_header() {
+      write_header(sizeof(scalar_t), is_complex<scalar_t>(),
+                   sizeof(integer_t));
+    }
+
+    /**
+     * Write the magic string again, to mark the end of the file.
+     */
+    void write_footer();
+
+    template<typename T> void write(const T& v) {
+      static_assert(std::is_trivially_copyable<T>::value,
+                    "FactorFileWriter::write requires a POD type");
+      os_.write(reinterpret_cast<const char*>(&v), sizeof(T));
+    }
+    template<typename T> void write(const T* v, std::size_t n) {
+      static_assert(std::is_trivially_copyable<T>::value,
+                    "FactorFileWriter::write requires a POD type");
+      write(n);
+      align();
+      os_.write(reinterpret_cast<const char*>(v), n*sizeof(T));
+    }
+    template<typename T> void write(const std::vector<T>& v) {
+      write(v.data(), v.size());
+    }
+    void write(const std::string& s) { write(s.data(), s.size()); }
+
+    /**
+     * Write the dimensions, followed by the matrix as a column major
+     * array (with leading dimension equal to the number of rows).
+     */
+    template<typename T> void write_matrix(const DenseMatrix<T>& D) {
+      std::size_t m = D.rows(), n = D.cols();
+      write(m);
+      write(n);
+      write(m*n);
+      align();
+      if (m)
+        for (std::size_t j=0; j<n; j++)
+          os_.write(reinterpret_cast<const char*>(D.ptr(0, j)),
+                    m*sizeof(T));
+    }
+
+    /**
+     * The underlying stream, for objects which serialize themselves
+     * to a std::ofstream, such as HSS::HSSMatrix.
+     */
+    std::ofstream& stream() { return os_; }
+
+  private:
+    std::ofstream os_;
+
+    void align();
+    void write_header(std::uint32_t scalar_size, bool complex,
+                      std::uint32_t integer_size);
+  };
+
+
+  /**
+   * \class FactorFileReader
+   *
+   * \brief Reads a file written by FactorFileWriter. The file is
+   * memory mapped, read-only. Arrays can be copied out, or used in
+   * place, see map and read_matrix, as long as this object is alive.
+   *
+   * Reading past the end of the file does not throw, but returns
+   * zeros (or empty arrays) and sets good() to false.
+   */
+  class FactorFileReader {
+  public:
+    FactorFileReader(const std::string& fname);
+    ~FactorFileReader();
+
+    FactorFileReader(const FactorFileReader&) = delete;
+    FactorFileReader& operator=(const FactorFileReader&) = delete;
+
+    bool good() const { return ok_; }
+    const std::string& name() const { return fname_; }
+
+    /**
+     * Check the header, see FactorFileWriter::write_header. Prints a
+     * message and returns false if the file is not a STRUMPACK
+     * factor file, or was written with a different file format
+     * version, byte order, or scalar or integer type.
+     */
+    template<typename scalar_t,typename integer_t> bool read_header() {
+      return read_header(sizeof(scalar_t), is_complex<scalar_t>(),
+                         sizeof(integer_t));
+    }
+
+    /**
+     * Check the end of file marker, see
+     * FactorFileWriter::write_footer.
+     */
+    bool read_footer();
+
+    template<typename T> T read() {
+      static_assert(std::is_trivially_copyable<T>::value,
+                    "FactorFileReader::read requires a POD type");
+      T v{};
+      auto p = take(sizeof(T));
+      if (p) std::copy(p, p+sizeof(T), reinterpret_cast<char*>(&v));
+      return v;
+    }
+    template<typename T> void read(T& v) { v = read<T>(); }
+    template<typename T> void read(std::vector<T>& v) {
+      std::size_t n = 0;
+      auto p = map<T>(n);
+      v.assign(p, p+n);
+    }
+    void read(std::string& s) {
+      std::size_t n = 0;
+      auto p = map<char>(n);
+      s.assign(p, p+n);
+    }
+
+    /**
+     * Return a pointer to an array of n elements, in the memory
+     * mapped file. Returns nullptr (and n = 0) on error.
+     */
+    template<typename T> const T* map(std::size_t& n) {
+      n = read<std::size_t>();
+      align();
+      // n comes from the file, n*sizeof(T) can overflow
+      if (!ok_ || n > (size_ - pos_) / sizeof(T)) {
+        ok_ = false;
+        n = 0;
+        return nullptr;
+      }
+      return reinterpret_cast<const T*>(take(n*sizeof(T)));
+    }
+
+    /**
+     * Return a matrix written with FactorFileWriter::write_matrix,
+     * as a wrapper around the memory mapped file. This must not be
+     * modified, the memory is read-only.
+     */
+    template<typename T> DenseMatrixWrapper<T> read_matrix() {
+      auto m = read<std::size_t>();
+      auto n = read<std::size_t>();
+      std::size_t mn = 0;
+      auto p = map<T>(mn);
+      if (!p || mn != m*n || (m && mn / m != n)) {
+        ok_ = false;
+        return DenseMatrixWrapper<T>();
+      }
+      return DenseMatrixWrapper<T>(m, n, const_cast<T*>(p), m);
+    }
+
+    /**
+     * Read with a std::ifstream, positioned at the current offset,
+     * for objects which serialize themselves to a std::ofstream,
+     * see FactorFileWriter::stream.
+     */
+    void stream(const std::function<void(std::ifstream&)>& f);
+
+  private:
+    std::string fname_;
+    const char* data_ = nullptr;
+    std::size_t size_ = 0, pos_ = 0;
+    bool ok_ = false;
+
+    const char* take(std::size_t bytes);
+    void align();
+    bool read_header(std::uint32_t scalar_size, bool complex,
+                     std::uint32_t integer_size);
+  };
+
+} // end namespace strumpack
+
+#endif // STRUMPACK_FACTOR_FILE_HPP
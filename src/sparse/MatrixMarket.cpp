@@ -0,0 +1,498 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#include <iostream>
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cctype>
+#include <limits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+#include "MatrixMarket.hpp"
+#include "misc/Tools.hpp"
+#include "dense/BLASLAPACKWrapper.hpp"
+
+namespace strumpack {
+
+  namespace {
+    template<typename scalar_t> scalar_t get_scalar(double vr, double vi) {
+      return scalar_t(vr);
+    }
+    template<> inline std::complex<double> get_scalar(double vr, double vi) {
+      return std::complex<double>(vr, vi);
+    }
+    template<> inline std::complex<float> get_scalar(double vr, double vi) {
+      return std::complex<float>(vr, vi);
+    }
+
+    // byte offset of the first line starting at or after pos
+    std::size_t next_line(const char* buf, std::size_t size,
+                          std::size_t pos) {
+      if (pos == 0 || buf[pos-1] == '\n') return pos;
+      auto nl = static_cast<const char*>
+        (std::memchr(buf+pos, '\n', size-pos));
+      return nl ? (nl - buf) + 1 : size;
+    }
+  }
+
+  bool parse_matrix_market_header(const char* buf, std::size_t size,
+                                  MatrixMarketHeader& h) {
+    std::size_t pos = 0;
+    while (pos < size) {
+      auto nl = static_cast<const char*>
+        (std::memchr(buf+pos, '\n', size-pos));
+      if (!nl) return false;
+      std::string line(buf+pos, nl);
+      if (pos == 0) {
+        line.copy(h.banner, std::min(line.size(), sizeof(h.banner)-1));
+        std::transform(line.begin(), line.end(), line.begin(),
+                       [](unsigned char c) { return std::tolower(c); });
+        h.pattern = line.find("pattern") != std::string::npos;
+        h.complex = line.find("complex") != std::string::npos;
+        if (line.find("skew-symmetric") != std::string::npos)
+          h.sym = MMSymmetry::SKEWSYMMETRIC;
+        else if (line.find("symmetric") != std::string::npos)
+          h.sym = MMSymmetry::SYMMETRIC;
+        else if (line.find("hermitian") != std::string::npos)
+          h.sym = MMSymmetry::HERMITIAN;
+      }
+      pos = (nl - buf) + 1;
+      auto first = line.find_first_not_of(" \t\r");
+      if (first == std::string::npos || line[first] == '%') continue;
+      long long m, n, nnz;
+      if (std::sscanf(line.c_str(), "%lld %lld %lld", &m, &n, &nnz) != 3)
+        return false;
+      h.rows = m;
+      h.cols = n;
+      h.entries = nnz;
+      h.data_begin = pos;
+      return true;
+    }
+    return false;
+  }
+
+  template<typename scalar_t,typename integer_t> std::size_t
+  parse_matrix_market_entries
+  (const MatrixMarketHeader& h, const char* buf, std::size_t size,
+   std::size_t begin, std::size_t end,
+   std::vector<std::vector<Triplet<scalar_t,integer_t>>>& parts,
+   integer_t& min_index) {
+    using Trip = Triplet<scalar_t,integer_t>;
+#if defined(_OPENMP)
+    int T = omp_get_max_threads();
+#else
+    int T = 1;
+#endif
+    parts.assign(T, std::vector<Trip>());
+    std::vector<integer_t> mins(T, std::numeric_limits<integer_t>::max());
+    std::vector<std::size_t> counts(T, 0);
+    double fill = double(h.entries) / std::max(std::size_t(1), size);
+#pragma omp parallel num_threads(T)
+    {
+#if defined(_OPENMP)
+      int t = omp_get_thread_num();
+#else
+      int t = 0;
+#endif
+      // each thread parses the lines which start in its chunk
+      auto len = end - begin;
+      auto pos = next_line(buf, size, begin + len * t / T),
+        cend = begin + len * (t+1) / T;
+      auto& A = parts[t];
+      A.reserve(std::size_t(fill * (cend - (begin + len * t / T))) *
+                (h.symmetric() ? 2 : 1));
+      auto& mi = mins[t];
+      const std::size_t max_line = 256;
+      char line[max_line];
+      while (pos < cend) {
+        auto nl = static_cast<const char*>
+          (std::memchr(buf+pos, '\n', size-pos));
+        std::size_t lend = nl ? nl - buf : size;
+        auto l = std::min(lend - pos, max_line-1);
+        std::memcpy(line, buf+pos, l);
+        line[l] = '\0';
+        pos = lend + 1;
+        char *p = line, *q;
+        integer_t r = std::strtoll(p, &q, 10);
+        if (q == p) continue; // empty line or comment
+        p = q;
+        integer_t c = std::strtoll(p, &q, 10);
+        if (q == p) continue; // malformed, not counted
+        p = q;
+        double vr = std::strtod(p, &q), vi = 0.;
+        if (q == p) continue;
+        if (h.complex) {
+          p = q;
+          vi = std::strtod(p, &q);
+          if (q == p) continue;
+        }
+        counts[t]++;
+        auto v = get_scalar<scalar_t>(vr, vi);
+        mi = std::min(mi, std::min(r, c));
+        A.emplace_back(r, c, v);
+        if (r != c) {
+          switch (h.sym) {
+          case MMSymmetry::SKEWSYMMETRIC: A.emplace_back(c, r, -v); break;
+          case MMSymmetry::SYMMETRIC: A.emplace_back(c, r, v); break;
+          case MMSymmetry::HERMITIAN:
+            A.emplace_back(c, r, blas::my_conj(v)); break;
+          default: break;
+          }
+        }
+      }
+    }
+    min_index = *std::min_element(mins.begin(), mins.end());
+    return std::accumulate(counts.begin(), counts.end(), std::size_t(0));
+  }
+
+  template<typename scalar_t,typename integer_t> bool
+  triplets_to_csr
+  (integer_t rbegin, integer_t rend, integer_t cols, integer_t base,
+   const std::vector<std::pair<const Triplet<scalar_t,integer_t>*,
+   const Triplet<scalar_t,integer_t>*>>& ranges,
+   std::vector<integer_t>& ptr, std::vector<integer_t>& ind,
+   std::vector<scalar_t>& val) {
+    using Trip = Triplet<scalar_t,integer_t>;
+    // split the ranges in blocks, to balance the work over threads
+    const std::size_t B = 1 << 16;
+    std::vector<std::pair<const Trip*,const Trip*>> blocks;
+    for (auto& rg : ranges)
+      for (auto b=rg.first; b<rg.second; b+=std::min
+             (B, std::size_t(rg.second-b)))
+        blocks.emplace_back(b, b+std::min(B, std::size_t(rg.second-b)));
+    integer_t rows = rend - rbegin, nb = blocks.size();
+    ptr.assign(rows+1, 0);
+    auto shift = rbegin + base;
+    bool valid = true;
+#pragma omp parallel for schedule(dynamic)
+    for (integer_t b=0; b<nb; b++)
+      for (auto t=blocks[b].first; t<blocks[b].second; t++) {
+        if (t->r < rbegin + base || t->r >= rend + base ||
+            t->c < base || t->c >= cols + base) {
+#pragma omp atomic write
+          valid = false;
+          continue;
+        }
+#pragma omp atomic
+        ptr[t->r-shift+1]++;
+      }
+    if (!valid) {
+      ptr.clear();
+      return false;
+    }
+    for (integer_t r=0; r<rows; r++)
+      ptr[r+1] += ptr[r];
+    auto nnz = ptr[rows];
+    ind.resize(nnz);
+    val.resize(nnz);
+    std::vector<integer_t> pos(ptr.begin(), ptr.end()-1);
+#pragma omp parallel for schedule(dynamic)
+    for (integer_t b=0; b<nb; b++)
+      for (auto t=blocks[b].first; t<blocks[b].second; t++) {
+        integer_t k;
+#pragma omp atomic capture
+        k = pos[t->r-shift]++;
+        ind[k] = t->c - base;
+        val[k] = t->v;
+      }
+    return true;
+  }
+
+  template<typename scalar_t,typename integer_t> int
+  read_matrix_market
+  (const std::string& fname, MatrixMarketHeader& h,
+   std::vector<integer_t>& ptr, std::vector<integer_t>& ind,
+   std::vector<scalar_t>& val) {
+    std::cout << "# opening file \'" << fname << "\'" << std::endl;
+    int fd = open(fname.c_str(), O_RDONLY);
+    if (fd < 0) {
+      std::cerr << "ERROR: could not read file " << fname << std::endl;
+      return 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+      std::cerr << "ERROR: could not read from file" << std::endl;
+      close(fd);
+      return 1;
+    }
+    std::size_t size = st.st_size;
+    auto m = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED) {
+      std::cerr << "ERROR: could not map file " << fname << std::endl;
+      return 1;
+    }
+    auto buf = static_cast<const char*>(m);
+    madvise(m, size, MADV_SEQUENTIAL);
+    int ierr = 0;
+    if (!parse_matrix_market_header(buf, size, h)) {
+      std::cerr << "ERROR: could not read the Matrix Market header"
+                << std::endl;
+      ierr = 1;
+    } else {
+      std::cout << "# " << h.banner << std::endl;
+      std::cout << "# reading " << number_format_with_commas(h.rows)
+                << " by " << number_format_with_commas(h.cols)
+                << " matrix with " << number_format_with_commas(h.entries)
+                << " nnz's from " << fname << std::endl;
+      if (h.pattern) {
+        std::cerr << "ERROR: This is not a matrix,"
+                  << " but just a sparsity pattern" << std::endl;
+        ierr = 1;
+      } else if (h.complex && !is_complex<scalar_t>()) {
+        std::cerr << "ERROR: Complex matrix" << std::endl;
+        ierr = 1;
+      } else if (h.rows != h.cols) {
+        std::cerr << "ERROR: matrix is not square!" << std::endl;
+        ierr = 1;
+      }
+    }
+    if (!ierr) {
+      std::vector<std::vector<Triplet<scalar_t,integer_t>>> parts;
+      integer_t min_index = 0;
+      auto entries = parse_matrix_market_entries
+        (h, buf, size, h.data_begin, size, parts, min_index);
+      std::vector<std::pair<const Triplet<scalar_t,integer_t>*,
+                            const Triplet<scalar_t,integer_t>*>> ranges;
+      for (auto& p : parts)
+        ranges.emplace_back(p.data(), p.data()+p.size());
+      // indices are one based, unless a zero index is found
+      integer_t base = min_index == 0 ? 0 : 1;
+      if (entries != h.entries) {
+        std::cerr << "ERROR: found " << entries << " valid entries, "
+                  << "expected " << h.entries << std::endl;
+        ierr = 1;
+      } else if (!triplets_to_csr<scalar_t,integer_t>
+                 (0, h.rows, h.cols, base, ranges, ptr, ind, val)) {
+        std::cerr << "ERROR: row or column index out of range"
+                  << std::endl;
+        ierr = 1;
+      }
+    }
+    munmap(m, size);
+    return ierr;
+  }
+
+  // explicit template instantiations
+  template std::size_t parse_matrix_market_entries
+  (const MatrixMarketHeader& h, const char* buf, std::size_t size,
+   std::size_t begin, std::size_t end,
+   std::vector<std::vector<Triplet<float,int>>>& parts,
+   int& min_index);
+  template bool triplets_to_csr
+  (int rbegin, int rend, int cols, int base,
+   const std::vector<std::pair<const Triplet<float,int>*,
+   const Triplet<float,int>*>>& ranges,
+   std::vector<int>& ptr, std::vector<int>& ind,
+   std::vector<float>& val);
+  template int read_matrix_market
+  (const std::string& fname, MatrixMarketHeader& h,
+   std::vector<int>& ptr, std::vector<int>& ind,
+   std::vector<float>& val);
+  template std::size_t parse_matrix_market_entries
+  (const MatrixMarketHeader& h, const char* buf, std::size_t size,
+   std::size_t begin, std::size_t end,
+   std::vector<std::vector<Triplet<double,int>>>& parts,
+   int& min_index);
+  template bool triplets_to_csr
+  (int rbegin, int rend, int cols, int base,
+   const std::vector<std::pair<const Triplet<double,int>*,
+   const Triplet<double,int>*>>& ranges,
+   std::vector<int>& ptr, std::vector<int>& ind,
+   std::vector<double>& val);
+  template int read_matrix_market
+  (const std::string& fname, MatrixMarketHeader& h,
+   std::vector<int>& ptr, std::vector<int>& ind,
+   std::vector<double>& val);
+  template std::size_t parse_matrix_market_entries
+  (const MatrixMarketHeader& h, const char* buf, std::size_t size,
+   std::size_t begin, std::size_t end,
+   std::vector<std::vector<Triplet<std::complex<float>,int>>>& parts,
+   int& min_index);
+  template bool triplets_to_csr
+  (int rbegin, int rend, int cols, int base,
+   const std::vector<std::pair<const Triplet<std::complex<float>,int>*,
+   const Triplet<std::complex<float>,int>*>>& ranges,
+   std::vector<int>& ptr, std::vector<int>& ind,
+   std::vector<std::complex<float>>& val);
+  template int read_matrix_market
+  (const std::string& fname, MatrixMarketHeader& h,
+   std::vector<int>& ptr, std::vector<int>& ind,
+   std::vector<std::complex<float>>& val);
+  template std::size_t parse_matrix_market_entries
+  (const MatrixMarketHeader& h, const char* buf, std::size_t size,
+   std::size_t begin, std::size_t end,
+   std::vector<std::vector<Triplet<std::complex<double>,int>>>& parts,
+   int& min_index);
+  template bool triplets_to_csr
+  (int rbegin, int rend, int cols, int base,
+   const std::vector<std::pair<const Triplet<std::complex<double>,int>*,
+   const Triplet<std::complex<double>,int>*>>& ranges,
+   std::vector<int>& ptr, std::vector<int>& ind,
+   std::vector<std::complex<double>>& val);
+  template int read_matrix_market
+  (const std::string& fname, MatrixMarketHeader& h,
+   std::vector<int>& ptr, std::vector<int>& ind,
+   std::vector<std::complex<double>>& val);
+
+  template std::size_t parse_matrix_market_entries
+  (const MatrixMarketHeader& h, const char* buf, std::size_t size,
+   std::size_t begin, std::size_t end,
+   std::vector<std::vector<Triplet<float,long int>>>& parts,
+   long int& min_index);
+  template bool triplets_to_csr
+  (long int rbegin, long int rend, long int cols, long int base,
+   const std::vector<std::pair<const Triplet<float,long int>*,
+   const Triplet<float,long int>*>>& ranges,
+   std::vector<long int>& ptr, std::vector<long int>& ind,
+   std::vector<float>& val);
+  template int read_matrix_market
+  (const std::string& fname, MatrixMarketHeader& h,
+   std::vector<long int>& ptr, std::vector<long int>& ind,
+   std::vector<float>& val);
+  template std::size_t parse_matrix_market_entries
+  (const MatrixMarketHeader& h, const char* buf, std::size_t size,
+   std::size_t begin, std::size_t end,
+   std::vector<std::vector<Triplet<double,long int>>>& parts,
+   long int& min_index);
+  template bool triplets_to_csr
+  (long int rbegin, long int rend, long int cols, long int base,
+   const std::vector<std::pair<const Triplet<double,long int>*,
+   const Triplet<double,long int>*>>& ranges,
+   std::vector<long int>& ptr, std::vector<long int>& ind,
+   std::vector<double>& val);
+  template int read_matrix_market
+  (const std::string& fname, MatrixMarketHeader& h,
+   std::vector<long int>& ptr, std::vector<long int>& ind,
+   std::vector<double>& val);
+  template std::size_t parse_matrix_market_entries
+  (const MatrixMarketHeader& h, const char* buf, std::size_t size,
+   std::size_t begin, std::size_t end,
+   std::vector<std::vector<Triplet<std::complex<float>,long int>>>& parts,
+   long int& min_index);
+  template bool triplets_to_csr
+  (long int rbegin, long int rend, long int cols, long int base,
+   const std::vector<std::pair<const Triplet<std::complex<float>,long int>*,
+   const Triplet<std::complex<float>,long int>*>>& ranges,
+   std::vector<long int>& ptr, std::vector<long int>& ind,
+   std::vector<std::complex<float>>& val);
+  template int read_matrix_market
+  (const std::string& fname, MatrixMarketHeader& h,
+   std::vector<long int>& ptr, std::vector<long int>& ind,
+   std::vector<std::complex<float>>& val);
+  template std::size_t parse_matrix_market_entries
+  (const MatrixMarketHeader& h, const char* buf, std::size_t size,
+   std::size_t begin, std::size_t end,
+   std::vector<std::vector<Triplet<std::complex<double>,long int>>>& parts,
+   long int& min_index);
+  template bool triplets_to_csr
+  (long int rbegin, long int rend, long int cols, long int base,
+   const std::vector<std::pair<const Triplet<std::complex<double>,long int>*,
+   const Triplet<std::complex<double>,long int>*>>& ranges,
+   std::vector<long int>& ptr, std::vector<long int>& ind,
+   std::vector<std::complex<double>>& val);
+  template int read_matrix_market
+  (const std::string& fname, MatrixMarketHeader& h,
+   std::vector<long int>& ptr, std::vector<long int>& ind,
+   std::vector<std::complex<double>>& val);
+
+  template std::size_t parse_matrix_market_entries
+  (const MatrixMarketHeader& h, const char* buf, std::size_t size,
+   std::size_t begin, std::size_t end,
+   std::vector<std::vector<Triplet<float,long long int>>>& parts,
+   long long int& min_index);
+  template bool triplets_to_csr
+  (long long int rbegin, long long int rend, long long int cols,
+   long long int base,
+   const std::vector<std::pair<const Triplet<float,long long int>*,
+   const Triplet<float,long long int>*>>& ranges,
+   std::vector<long long int>& ptr, std::vector<long long int>& ind,
+   std::vector<float>& val);
+  template int read_matrix_market
+  (const std::string& fname, MatrixMarketHeader& h,
+   std::vector<long long int>& ptr, std::vector<long long int>& ind,
+   std::vector<float>& val);
+  template std::size_t parse_matrix_market_entries
+  (const MatrixMarketHeader& h, const char* buf, std::size_t size,
+   std::size_t begin, std::size_t end,
+   std::vector<std::vector<Triplet<double,long long int>>>& parts,
+   long long int& min_index);
+  template bool triplets_to_csr
+  (long long int rbegin, long long int rend, long long int cols,
+   long long int base,
+   const std::vector<std::pair<const Triplet<double,long long int>*,
+   const Triplet<double,long long int>*>>& ranges,
+   std::vector<long long int>& ptr, std::vector<long long int>& ind,
+   std::vector<double>& val);
+  template int read_matrix_market
+  (const std::string& fname, MatrixMarketHeader& h,
+   std::vector<long long int>& ptr, std::vector<long long int>& ind,
+   std::vector<double>& val);
+  template std::size_t parse_matrix_market_entries
+  (const MatrixMarketHeader& h, const char* buf, std::size_t size,
+   std::size_t begin, std::size_t end,
+   std::vector<std::vector<Triplet<std::complex<float>,long long int>>>& parts,
+   long long int& min_index);
+  template bool triplets_to_csr
+  (long long int rbegin, long long int rend, long long int cols,
+   long long int base,
+   const std::vector<std::pair<const Triplet<std::complex<float>,long long int>*,
+   const Triplet<std::complex<float>,long long int>*>>& ranges,
+   std::vector<long long int>& ptr, std::vector<long long int>& ind,
+   std::vector<std::complex<float>>& val);
+  template int read_matrix_market
+  (const std::string& fname, MatrixMarketHeader& h,
+   std::vector<long long int>& ptr, std::vector<long long int>& ind,
+   std::vector<std::complex<float>>& val);
+  template std::size_t parse_matrix_market_entries
+  (const MatrixMarketHeader& h, const char* buf, std::size_t size,
+   std::size_t begin, std::size_t end,
+   std::vector<std::vector<Triplet<std::complex<double>,long long int>>>& parts,
+   long long int& min_index);
+  template bool triplets_to_csr
+  (long long int rbegin, long long int rend, long long int cols,
+   long long int base,
+   const std::vector<std::pair<const Triplet<std::complex<double>,long long int>*,
+   const Triplet<std::complex<double>,long long int>*>>& ranges,
+   std::vector<long long int>& ptr, std::vector<long long int>& ind,
+   std::vector<std::complex<double>>& val);
+  template int read_matrix_market
+  (const std::string& fname, MatrixMarketHeader& h,
+   std::vector<long long int>& ptr, std::vector<long long int>& ind,
+   std::vector<std::complex<double>>& val);
+
+} // end namespace strumpack
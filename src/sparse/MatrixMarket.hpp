@@ -0,0 +1,119 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+/*! \file MatrixMarket.hpp
+ * \brief Parallel parsing of Matrix Market files.
+ */
+#ifndef STRUMPACK_MATRIX_MARKET_HPP
+#define STRUMPACK_MATRIX_MARKET_HPP
+
+#include <string>
+#include <vector>
+#include <utility>
+
+#include "misc/Triplet.hpp"
+
+namespace strumpack {
+
+  enum class MMSymmetry { GENERAL, SYMMETRIC, SKEWSYMMETRIC, HERMITIAN };
+
+  /**
+   * The information from the banner and the size line of a Matrix
+   * Market file.
+   */
+  struct MatrixMarketHeader {
+    bool complex = false, pattern = false;
+    MMSymmetry sym = MMSymmetry::GENERAL;
+    std::size_t rows = 0, cols = 0, entries = 0;
+    /** byte offset of the first entry in the file */
+    std::size_t data_begin = 0;
+    /** the banner, the first line of the file */
+    char banner[128] = {0};
+
+    bool symmetric() const { return sym != MMSymmetry::GENERAL; }
+  };
+
+  /**
+   * Parse the banner, comments and size line from the first size
+   * bytes of a Matrix Market file. Returns false if the size line is
+   * not found in buf.
+   */
+  bool parse_matrix_market_header(const char* buf, std::size_t size,
+                                  MatrixMarketHeader& h);
+
+  /**
+   * Parse the entries on all lines which start at an offset in
+   * [begin, end) in buf. The last line may extend beyond end (but
+   * not beyond size). The work is split over the OpenMP threads, and
+   * the entries of each thread are returned in a separate vector of
+   * parts, with the row and column indices as in the file. For a
+   * symmetric, skew-symmetric or Hermitian matrix, the off-diagonal
+   * entries are also added in the upper triangular part.
+   *
+   * \param min_index set to the smallest row or column index found,
+   * to detect zero based files
+   * \return the number of entries read, malformed lines are skipped
+   * and not counted
+   */
+  template<typename scalar_t,typename integer_t> std::size_t
+  parse_matrix_market_entries
+  (const MatrixMarketHeader& h, const char* buf, std::size_t size,
+   std::size_t begin, std::size_t end,
+   std::vector<std::vector<Triplet<scalar_t,integer_t>>>& parts,
+   integer_t& min_index);
+
+  /**
+   * Build (with a parallel counting sort) the CSR storage for the
+   * rows [rbegin, rend) from the triplets in the given ranges. All
+   * triplets should have rbegin <= r < rend and 0 <= c < cols,
+   * after the row and column indices are shifted by -base. The
+   * columns in each row are not sorted. Returns false, and leaves
+   * ptr empty, if any index is out of range.
+   */
+  template<typename scalar_t,typename integer_t> bool
+  triplets_to_csr
+  (integer_t rbegin, integer_t rend, integer_t cols, integer_t base,
+   const std::vector<std::pair<const Triplet<scalar_t,integer_t>*,
+   const Triplet<scalar_t,integer_t>*>>& ranges,
+   std::vector<integer_t>& ptr, std::vector<integer_t>& ind,
+   std::vector<scalar_t>& val);
+
+  /**
+   * Read a Matrix Market file to CSR storage, using multiple threads.
+   * The file is memory mapped. The columns in each row are not
+   * sorted. Returns nonzero on failure.
+   */
+  template<typename scalar_t,typename integer_t> int
+  read_matrix_market
+  (const std::string& fname, MatrixMarketHeader& h,
+   std::vector<integer_t>& ptr, std::vector<integer_t>& ind,
+   std::vector<scalar_t>& val);
+
+} // end namespace strumpack
+
+#endif // STRUMPACK_MATRIX_MARKET_HPP
@@ -0,0 +1,350 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#include <iostream>
+#include <algorithm>
+#include <complex>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "OutOfCoreStorage.hpp"
+#include "StrumpackParameters.hpp"
+
+namespace strumpack {
+
+  namespace {
+    double elapsed(std::chrono::steady_clock::time_point t0) {
+      return std::chrono::duration<double>
+        (std::chrono::steady_clock::now() - t0).count();
+    }
+  }
+
+  template<typename scalar_t>
+  OutOfCoreStorage<scalar_t>::OutOfCoreStorage(const std::string& dir) {
+    std::string tmpl = (dir.empty() ? std::string(".") : dir)
+      + "/strumpack_factors_XXXXXX";
+    std::vector<char> name(tmpl.begin(), tmpl.end());
+    name.push_back('\0');
+    fd_ = mkstemp(name.data());
+    if (fd_ < 0) {
+      std::cerr << "# WARNING: could not create out-of-core file in "
+                << dir << " (" << std::strerror(errno)
+                << "), keeping the factors in memory" << std::endl;
+      return;
+    }
+    // the file is removed when it is closed
+    fname_ = name.data();
+    unlink(fname_.c_str());
+  }
+
+  template<typename scalar_t>
+  OutOfCoreStorage<scalar_t>::~OutOfCoreStorage() {
+    stop_read_ahead();
+    {
+      std::lock_guard<std::mutex> lk(mtx_);
+      stop_writer_ = true;
+      cv_.notify_all();
+    }
+    if (writer_.joinable()) writer_.join();
+    for (auto& b : blocks_)
+      if (b.mem) release_memory(b);
+    if (fd_ >= 0) close(fd_);
+  }
+
+  template<typename scalar_t> std::size_t
+  OutOfCoreStorage<scalar_t>::write
+  (std::unique_ptr<scalar_t[]> data, std::size_t n) {
+    STRUMPACK_ADD_MEMORY(n*sizeof(scalar_t));
+    std::lock_guard<std::mutex> lk(mtx_);
+    std::size_t id = blocks_.size();
+    blocks_.emplace_back();
+    auto& b = blocks_.back();
+    b.offset = end_;
+    b.n = n;
+    b.mem = std::move(data);
+#if defined(STRUMPACK_COUNT_FLOPS)
+    b.counters = PerfCounterSet::active_ptr();
+#endif
+    end_ += n * sizeof(scalar_t);
+    if (fd_ >= 0 && n) {
+      write_queue_.push_back(id);
+      if (!writer_.joinable())
+        writer_ = std::thread(&OutOfCoreStorage<scalar_t>::write_loop, this);
+      cv_.notify_all();
+    }
+    return id;
+  }
+
+  template<typename scalar_t> void
+  OutOfCoreStorage<scalar_t>::write_loop() {
+    std::unique_lock<std::mutex> lk(mtx_);
+    bool warned = false;
+    while (true) {
+      cv_.wait(lk, [&]{ return stop_writer_ || !write_queue_.empty(); });
+      if (write_queue_.empty()) break;
+      auto& b = blocks_[write_queue_.front()];
+      write_queue_.pop_front();
+      writing_ = true;
+      lk.unlock();
+      auto t0 = std::chrono::steady_clock::now();
+      bool ok = write_block(b.mem.get(), b.n, b.offset);
+      auto t = elapsed(t0);
+      lk.lock();
+      write_time_ += t;
+      if (ok) {
+        release_memory(b);
+        bytes_written_ += b.n * sizeof(scalar_t);
+      } else if (!warned) {
+        // keep the block in memory
+        std::cerr << "# WARNING: writing out-of-core factors to "
+                  << fname_ << " failed (" << std::strerror(errno)
+                  << "), keeping them in memory" << std::endl;
+        warned = true;
+      }
+      writing_ = false;
+      cv_.notify_all();
+    }
+  }
+
+  template<typename scalar_t> void
+  OutOfCoreStorage<scalar_t>::flush() {
+    std::unique_lock<std::mutex> lk(mtx_);
+    auto t0 = std::chrono::steady_clock::now();
+    cv_.wait(lk, [&]{ return write_queue_.empty() && !writing_; });
+    write_wait_ += elapsed(t0);
+  }
+
+  template<typename scalar_t> void
+  OutOfCoreStorage<scalar_t>::start_read_ahead(bool forward) {
+    stop_read_ahead();
+    flush();
+    {
+      std::lock_guard<std::mutex> lk(mtx_);
+      for (auto& b : blocks_) b.taken = false;
+    }
+    if (fd_ >= 0 && !blocks_.empty())
+      reader_ = std::thread
+        (&OutOfCoreStorage<scalar_t>::read_loop, this, forward);
+  }
+
+  template<typename scalar_t> void
+  OutOfCoreStorage<scalar_t>::stop_read_ahead() {
+    {
+      std::lock_guard<std::mutex> lk(mtx_);
+      stop_reader_ = true;
+      cv_.notify_all();
+    }
+    if (reader_.joinable()) reader_.join();
+    std::lock_guard<std::mutex> lk(mtx_);
+    for (auto& b : blocks_) {
+      b.ahead.reset();
+      b.loading = b.loaded = false;
+    }
+    ahead_bytes_ = 0;
+    stop_reader_ = false;
+  }
+
+  template<typename scalar_t> void
+  OutOfCoreStorage<scalar_t>::read_loop(bool forward) {
+    std::size_t nb;
+    {
+      std::lock_guard<std::mutex> lk(mtx_);
+      nb = blocks_.size();
+    }
+    for (std::size_t k=0; k<nb; k++) {
+      std::unique_lock<std::mutex> lk(mtx_);
+      auto& b = blocks_[forward ? k : nb-1-k];
+      if (b.taken || b.mem || !b.n) continue;
+      const auto bytes = b.n * sizeof(scalar_t);
+      cv_.wait(lk, [&]{
+        return stop_reader_ || b.taken || !ahead_bytes_ ||
+          ahead_bytes_ + bytes <= read_ahead_bytes; });
+      if (stop_reader_) return;
+      if (b.taken) continue;
+      b.loading = true;
+      ahead_bytes_ += bytes;
+      lk.unlock();
+      std::unique_ptr<scalar_t[]> buf(new scalar_t[b.n]);
+      auto t0 = std::chrono::steady_clock::now();
+      bool ok = read_block(buf.get(), b.n, b.offset);
+      auto t = elapsed(t0);
+      lk.lock();
+      if (!ok) {
+        // leave it to read()
+        b.loading = false;
+        ahead_bytes_ -= bytes;
+        cv_.notify_all();
+        return;
+      }
+      read_time_ += t;
+      bytes_read_ += bytes;
+      b.ahead = std::move(buf);
+      b.loaded = true;
+      cv_.notify_all();
+    }
+  }
+
+  template<typename scalar_t> std::unique_ptr<scalar_t[]>
+  OutOfCoreStorage<scalar_t>::read(std::size_t id) {
+    std::unique_lock<std::mutex> lk(mtx_);
+    auto& b = blocks_[id];
+    if (b.mem) {
+      // not written yet, or the write failed
+      std::unique_ptr<scalar_t[]> r(new scalar_t[b.n]);
+      std::copy(b.mem.get(), b.mem.get()+b.n, r.get());
+      return r;
+    }
+    // after a failed read, the file can no longer be trusted
+    if (read_errors_) {
+      read_errors_++;
+      return nullptr;
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    if (b.loading) {
+      cv_.wait(lk, [&]{ return b.loaded || !b.loading; });
+      read_wait_ += elapsed(t0);
+    }
+    b.taken = true;
+    if (b.loaded) {
+      b.loaded = b.loading = false;
+      ahead_bytes_ -= b.n * sizeof(scalar_t);
+      cv_.notify_all();
+      return std::move(b.ahead);
+    }
+    lk.unlock();
+    std::unique_ptr<scalar_t[]> r(new scalar_t[b.n]);
+    if (!read_block(r.get(), b.n, b.offset)) {
+      std::cerr << "# ERROR: reading out-of-core factors from "
+                << fname_ << " failed (" << std::strerror(errno)
+                << ")" << std::endl;
+      lk.lock();
+      read_errors_++;
+      return nullptr;
+    }
+    auto t = elapsed(t0);
+    lk.lock();
+    read_time_ += t;
+    read_wait_ += t;
+    bytes_read_ += b.n * sizeof(scalar_t);
+    return r;
+  }
+
+  template<typename scalar_t> std::size_t
+  OutOfCoreStorage<scalar_t>::read_errors() const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return read_errors_;
+  }
+
+  template<typename scalar_t> std::size_t
+  OutOfCoreStorage<scalar_t>::file_size() const {
+    struct stat st;
+    if (fd_ < 0 || fstat(fd_, &st)) return 0;
+    return st.st_size;
+  }
+
+  /**
+   * Called with mtx_ locked, or from the destructor.
+   */
+  template<typename scalar_t> void
+  OutOfCoreStorage<scalar_t>::release_memory(Block& b) {
+    b.mem.reset();
+#if defined(STRUMPACK_COUNT_FLOPS)
+    if (b.counters)
+      b.counters->add(PerfCounterType::MEMORY,
+                      -static_cast<long long int>(b.n*sizeof(scalar_t)));
+    b.counters.reset();
+#endif
+  }
+
+  template<typename scalar_t> std::size_t
+  OutOfCoreStorage<scalar_t>::size(std::size_t id) const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return blocks_[id].n;
+  }
+
+  template<typename scalar_t> double
+  OutOfCoreStorage<scalar_t>::write_overlap() const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (write_time_ <= 0.) return 1.;
+    return std::max(0., 1. - write_wait_ / write_time_);
+  }
+
+  template<typename scalar_t> double
+  OutOfCoreStorage<scalar_t>::read_overlap() const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (read_time_ <= 0.) return 1.;
+    return std::max(0., 1. - read_wait_ / read_time_);
+  }
+
+  template<typename scalar_t> bool
+  OutOfCoreStorage<scalar_t>::write_block
+  (const scalar_t* data, std::size_t n, std::size_t off) {
+    auto p = reinterpret_cast<const char*>(data);
+    std::size_t bytes = n * sizeof(scalar_t);
+    while (bytes) {
+      auto w = pwrite(fd_, p, bytes, off);
+      if (w < 0) {
+        if (errno == EINTR) continue;
+        return false;
+      }
+      p += w;  off += w;  bytes -= w;
+    }
+    return true;
+  }
+
+  template<typename scalar_t> bool
+  OutOfCoreStorage<scalar_t>::read_block
+  (scalar_t* data, std::size_t n, std::size_t off) {
+    auto p = reinterpret_cast<char*>(data);
+    std::size_t bytes = n * sizeof(scalar_t);
+    while (bytes) {
+      auto r = pread(fd_, p, bytes, off);
+      if (r < 0) {
+        if (errno == EINTR) continue;
+        return false;
+      }
+      if (r == 0) {
+        errno = EIO;
+        return false;
+      }
+      p += r;  off += r;  bytes -= r;
+    }
+    return true;
+  }
+
+  // explicit template instantiations
+  template class OutOfCoreStorage<float>;
+  template class OutOfCoreStorage<double>;
+  template class OutOfCoreStorage<std::complex<float>>;
+  template class OutOfCoreStorage<std::complex<double>>;
+
+} // end namespace strumpack
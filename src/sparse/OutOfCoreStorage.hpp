@@ -0,0 +1,197 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+/*! \file OutOfCoreStorage.hpp
+ * \brief Storage of the dense factors of the fronts in a file.
+ */
+#ifndef STRUMPACK_OUT_OF_CORE_STORAGE_HPP
+#define STRUMPACK_OUT_OF_CORE_STORAGE_HPP
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+
+namespace strumpack {
+
+  class PerfCounterSet;
+
+  /**
+   * \class OutOfCoreStorage
+   *
+   * \brief Stores blocks of memory (front factors) in a file, with a
+   * background writer and a background reader thread.
+   *
+   * During the factorization, the fronts call write() when they are
+   * done, which hands over the memory to the writer thread and
+   * returns immediately. The blocks are stored one after the other
+   * in a temporary file, created in the given directory, and removed
+   * when this object is destroyed (or the program exits). The memory
+   * is released once the block is written.
+   *
+   * In the solve phase, start_read_ahead() starts a thread that
+   * reads the blocks in the order in which they were written (for
+   * the forward solve) or the reverse order (backward solve), up to
+   * a limited amount of memory ahead of the blocks requested with
+   * read(). If a block is requested which is not (being) read ahead,
+   * it is read synchronously.
+   *
+   * If the file cannot be created, or a write fails, the blocks are
+   * simply kept in memory. If a read fails, read() returns nullptr
+   * and the failure is counted in read_errors(), the solver reports
+   * this as ReturnCode::FILE_ERROR. After a failed read, all reads
+   * fail, until the factors are recomputed.
+   *
+   * The memory of a block is counted, and released from the
+   * counters, in the performance counter set that was active on the
+   * thread calling write(), not in the set of the writer thread.
+   */
+  template<typename scalar_t> class OutOfCoreStorage {
+  public:
+    /**
+     * Create a temporary file in directory dir.
+     */
+    OutOfCoreStorage(const std::string& dir);
+    ~OutOfCoreStorage();
+
+    OutOfCoreStorage(const OutOfCoreStorage&) = delete;
+    OutOfCoreStorage& operator=(const OutOfCoreStorage&) = delete;
+
+    /**
+     * Whether the file was created, if not, the blocks are kept in
+     * memory.
+     */
+    bool on_disk() const { return fd_ >= 0; }
+
+    /**
+     * Asynchronously write the block data of size n. This takes
+     * ownership of data, and returns an id to be used for read().
+     * This is thread safe.
+     */
+    std::size_t write(std::unique_ptr<scalar_t[]> data, std::size_t n);
+
+    /**
+     * Wait until all blocks passed to write() have been written.
+     */
+    void flush();
+
+    /**
+     * Start reading ahead, in the order in which the blocks were
+     * written (forward) or in the reverse order.
+     */
+    void start_read_ahead(bool forward);
+
+    /**
+     * Stop the read ahead thread, and release the blocks that were
+     * read ahead, but not requested.
+     */
+    void stop_read_ahead();
+
+    /**
+     * Get block id (as returned by write). This is thread safe.
+     * Returns nullptr if the block could not be read.
+     */
+    std::unique_ptr<scalar_t[]> read(std::size_t id);
+
+    /**
+     * Number of calls to read() that failed.
+     */
+    std::size_t read_errors() const;
+
+    /** Size (number of elements) of block id. */
+    std::size_t size(std::size_t id) const;
+
+    /** Size of the file in bytes, 0 if it was not created. */
+    std::size_t file_size() const;
+    /** Total number of bytes written to the file. */
+    std::size_t bytes_written() const { return bytes_written_; }
+    /** Total number of bytes read from the file. */
+    std::size_t bytes_read() const { return bytes_read_; }
+    /**
+     * Fraction of the write time that was overlapped with the
+     * factorization, ie., not spent waiting in flush().
+     */
+    double write_overlap() const;
+    /**
+     * Fraction of the read time that was overlapped with the solve,
+     * ie., not spent waiting in read().
+     */
+    double read_overlap() const;
+
+    /**
+     * Maximum number of bytes read ahead, ie., read but not yet
+     * requested.
+     */
+    static const std::size_t read_ahead_bytes = 1 << 26;
+
+  private:
+    struct Block {
+      std::size_t offset = 0, n = 0;
+      // only while waiting to be written, or if the write failed
+      std::unique_ptr<scalar_t[]> mem;
+      // read ahead, or being read ahead
+      std::unique_ptr<scalar_t[]> ahead;
+      bool loading = false, loaded = false, taken = false;
+      // counters of the thread that called write, for mem
+      std::shared_ptr<PerfCounterSet> counters;
+    };
+
+    int fd_ = -1;
+    std::string fname_;
+    std::deque<Block> blocks_;
+    std::size_t end_ = 0;
+
+    mutable std::mutex mtx_;
+    std::condition_variable cv_;
+
+    std::thread writer_;
+    std::deque<std::size_t> write_queue_;
+    bool writing_ = false, stop_writer_ = false;
+
+    std::thread reader_;
+    std::size_t ahead_bytes_ = 0;
+    bool stop_reader_ = false;
+    std::size_t read_errors_ = 0;
+
+    std::size_t bytes_written_ = 0, bytes_read_ = 0;
+    double write_time_ = 0., write_wait_ = 0.;
+    double read_time_ = 0., read_wait_ = 0.;
+
+    void write_loop();
+    void read_loop(bool forward);
+    void release_memory(Block& b);
+    bool write_block(const scalar_t* data, std::size_t n, std::size_t off);
+    bool read_block(scalar_t* data, std::size_t n, std::size_t off);
+  };
+
+} // end namespace strumpack
+
+#endif // STRUMPACK_OUT_OF_CORE_STORAGE_HPP
@@ -419,6 +419,7 @@ namespace strumpack {
         }
       }
     }
+    if (!F12.cols()) return; // F12 is not stored for symmetric fronts
     for (integer_t i=0; i<dim_upd; ++i) { // update columns
       //while (c < local_cols_ && global_col_[c] < upd[i]) c++;
       c = find_global(upd[i], c);
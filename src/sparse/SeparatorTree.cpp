@@ -35,6 +35,7 @@
 
 #include "StrumpackConfig.hpp"
 #include "SeparatorTree.hpp"
+#include "FactorFile.hpp"
 
 namespace strumpack {
 
@@ -76,9 +77,30 @@ namespace strumpack {
   SeparatorTree<integer_t>::level(integer_t i) const {
     assert(0 <= i && i <= nr_seps_);
     integer_t lvl = 0;
-    if (lch[i] != -1) lvl = level(lch[i]);
-    if (rch[i] != -1) lvl = std::max(lvl, level(rch[i]));
-    return lvl+1;
+    std::vector<std::pair<integer_t,integer_t>> s{{i, 1}};
+    while (!s.empty()) {
+      auto n = s.back().first, l = s.back().second;
+      s.pop_back();
+      lvl = std::max(lvl, l);
+      if (lch[n] != -1) s.emplace_back(lch[n], l+1);
+      if (rch[n] != -1) s.emplace_back(rch[n], l+1);
+    }
+    return lvl;
+  }
+
+  template<typename integer_t> std::vector<integer_t>
+  SeparatorTree<integer_t>::postorder(integer_t i) const {
+    // preorder, with the right child first, reversed, is postorder
+    std::vector<integer_t> po, s{i};
+    while (!s.empty()) {
+      auto n = s.back();
+      s.pop_back();
+      po.push_back(n);
+      if (lch[n] != -1) s.push_back(lch[n]);
+      if (rch[n] != -1) s.push_back(rch[n]);
+    }
+    std::reverse(po.begin(), po.end());
+    return po;
   }
 
   template<typename integer_t> integer_t
@@ -110,24 +132,16 @@ namespace strumpack {
       if (sizes[i+1]-sizes[i] == 0) empty++;
     std::vector<int> subtree(nr_seps_);
     std::vector<float> inbalance(nr_seps_);
-    std::function<void(integer_t)> compute_subtree_size =
-      [&](integer_t node) {
+    for (auto node : postorder(root())) {
       subtree[node] = sizes[node+1]-sizes[node];
-      if (lch[node] != -1) {
-        compute_subtree_size(lch[node]);
-        subtree[node] += subtree[lch[node]];
-      }
-      if (rch[node] != -1) {
-        compute_subtree_size(rch[node]);
-        subtree[node] += subtree[rch[node]];
-      }
+      if (lch[node] != -1) subtree[node] += subtree[lch[node]];
+      if (rch[node] != -1) subtree[node] += subtree[rch[node]];
       inbalance[node] = 1.;
       if (lch[node] != -1 && rch[node] != -1)
         inbalance[node] =
           float(std::max(subtree[rch[node]], subtree[lch[node]])) /
           float(std::min(subtree[rch[node]], subtree[lch[node]]));
-    };
-    compute_subtree_size(root());
+    }
     float avg_inbalance = 0, max_inbalance = 0;
     for (integer_t i=0; i<nr_seps_; i++) {
       avg_inbalance += inbalance[i];
@@ -159,12 +173,7 @@ namespace strumpack {
     assert(std::count(parent, parent+nr_seps_, -1) == 1); // 1 root
     auto mark = new bool[nr_seps_];
     std::fill(mark, mark+nr_seps_, false);
-    std::function<void(integer_t)> traverse = [&](integer_t node) {
-      mark[node] = true;
-      if (lch[node] != -1) traverse(lch[node]);
-      if (rch[node] != -1) traverse(rch[node]);
-    };
-    traverse(root());
+    for (auto node : postorder(root())) mark[node] = true;
     assert(std::count(mark, mark+nr_seps_, false) == 0);
     delete[] mark;
     integer_t nr_leafs = 0;
@@ -571,6 +580,25 @@ namespace strumpack {
     return parent;
   }
 
+  template<typename integer_t> void
+  SeparatorTree<integer_t>::save(FactorFileWriter& f) const {
+    f.write(nr_seps_);
+    f.write(iwork_);
+  }
+
+  template<typename integer_t> bool
+  SeparatorTree<integer_t>::load(FactorFileReader& f) {
+    auto nseps = f.read<integer_t>();
+    std::size_t n = 0;
+    auto w = f.map<integer_t>(n);
+    if (!f.good() || nseps < 0 || (nseps && n != std::size_t(4*nseps+1)))
+      return false;
+    allocate(nseps);
+    std::copy(w, w+n, iwork_.data());
+    root_ = -1;
+    return true;
+  }
+
 
   // explicit template instantiations
   template class SeparatorTree<int>;
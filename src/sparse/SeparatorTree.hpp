@@ -37,6 +37,9 @@
 
 namespace strumpack {
 
+  class FactorFileWriter;
+  class FactorFileReader;
+
   /**
    * Helper class to construct a SeparatorTree.
    */
@@ -63,6 +66,14 @@ namespace strumpack {
     integer_t levels() const;
     integer_t level(integer_t i) const;
     integer_t root() const;
+
+    /**
+     * The nodes in the subtree of node i, in postorder (left
+     * subtree, right subtree, i). This does not use recursion, so it
+     * can be used for arbitrarily deep trees.
+     */
+    std::vector<integer_t> postorder(integer_t i) const;
+
     void print() const;
     void printm(const std::string& name) const;
     void check() const;
@@ -80,6 +91,13 @@ namespace strumpack {
     void broadcast(const MPIComm& c);
 #endif
 
+    /**
+     * Write to/read from a factor file, see
+     * SparseSolverBase::save_factors.
+     */
+    void save(FactorFileWriter& f) const;
+    bool load(FactorFileReader& f);
+
     integer_t *sizes = nullptr,
       *parent = nullptr,
       *lch = nullptr,
@@ -206,6 +206,80 @@ namespace strumpack {
                         int level, FrontCounter& fc, bool root);
 
 
+  template<typename scalar_t, typename integer_t>
+  std::unique_ptr<FrontalMatrix<scalar_t,integer_t>> create_frontal_matrix
+  (const std::string& type, integer_t s, integer_t sbegin,
+   integer_t send, std::vector<integer_t>& upd) {
+    std::unique_ptr<FrontalMatrix<scalar_t,integer_t>> front;
+    if (type == "FrontalMatrixDense")
+      front.reset
+        (new FrontalMatrixDense<scalar_t,integer_t>(s, sbegin, send, upd));
+    else if (type == "FrontalMatrixBLR")
+      front.reset
+        (new FrontalMatrixBLR<scalar_t,integer_t>(s, sbegin, send, upd));
+    else if (type == "FrontalMatrixHSS")
+      front.reset
+        (new FrontalMatrixHSS<scalar_t,integer_t>(s, sbegin, send, upd));
+#if defined(STRUMPACK_USE_ZFP)
+    else if (type == "FrontalMatrixLossy")
+      front.reset
+        (new FrontalMatrixLossy<scalar_t,integer_t>(s, sbegin, send, upd));
+#endif
+    return front;
+  }
+
+  // explicit template instantiations
+  template std::unique_ptr<FrontalMatrix<float,int>>
+  create_frontal_matrix<float,int>
+  (const std::string& type, int s, int sbegin, int send,
+   std::vector<int>& upd);
+  template std::unique_ptr<FrontalMatrix<double,int>>
+  create_frontal_matrix<double,int>
+  (const std::string& type, int s, int sbegin, int send,
+   std::vector<int>& upd);
+  template std::unique_ptr<FrontalMatrix<std::complex<float>,int>>
+  create_frontal_matrix<std::complex<float>,int>
+  (const std::string& type, int s, int sbegin, int send,
+   std::vector<int>& upd);
+  template std::unique_ptr<FrontalMatrix<std::complex<double>,int>>
+  create_frontal_matrix<std::complex<double>,int>
+  (const std::string& type, int s, int sbegin, int send,
+   std::vector<int>& upd);
+
+  template std::unique_ptr<FrontalMatrix<float,long int>>
+  create_frontal_matrix<float,long int>
+  (const std::string& type, long int s, long int sbegin, long int send,
+   std::vector<long int>& upd);
+  template std::unique_ptr<FrontalMatrix<double,long int>>
+  create_frontal_matrix<double,long int>
+  (const std::string& type, long int s, long int sbegin, long int send,
+   std::vector<long int>& upd);
+  template std::unique_ptr<FrontalMatrix<std::complex<float>,long int>>
+  create_frontal_matrix<std::complex<float>,long int>
+  (const std::string& type, long int s, long int sbegin, long int send,
+   std::vector<long int>& upd);
+  template std::unique_ptr<FrontalMatrix<std::complex<double>,long int>>
+  create_frontal_matrix<std::complex<double>,long int>
+  (const std::string& type, long int s, long int sbegin, long int send,
+   std::vector<long int>& upd);
+
+  template std::unique_ptr<FrontalMatrix<float,long long int>>
+  create_frontal_matrix<float,long long int>
+  (const std::string& type, long long int s, long long int sbegin, long long int send,
+   std::vector<long long int>& upd);
+  template std::unique_ptr<FrontalMatrix<double,long long int>>
+  create_frontal_matrix<double,long long int>
+  (const std::string& type, long long int s, long long int sbegin, long long int send,
+   std::vector<long long int>& upd);
+  template std::unique_ptr<FrontalMatrix<std::complex<float>,long long int>>
+  create_frontal_matrix<std::complex<float>,long long int>
+  (const std::string& type, long long int s, long long int sbegin, long long int send,
+   std::vector<long long int>& upd);
+  template std::unique_ptr<FrontalMatrix<std::complex<double>,long long int>>
+  create_frontal_matrix<std::complex<double>,long long int>
+  (const std::string& type, long long int s, long long int sbegin, long long int send,
+   std::vector<long long int>& upd);
+
 #if defined(STRUMPACK_USE_MPI)
   template<typename scalar_t, typename integer_t>
   std::unique_ptr<FrontalMatrixMPI<scalar_t,integer_t>> create_frontal_matrix
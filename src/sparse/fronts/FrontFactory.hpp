@@ -42,14 +42,20 @@ namespace strumpack {
 
   struct FrontCounter {
     int dense, HSS, BLR, HODLR, lossy;
+    // fronts removed by amalgamation, and explicit zeros added
+    int amalgamated = 0;
+    long long amalgamation_zeros = 0;
     FrontCounter() : dense(0), HSS(0), BLR(0), HODLR(0), lossy(0) {}
     FrontCounter(int* c) :
-      dense(c[0]), HSS(c[1]), BLR(c[2]), HODLR(c[3]), lossy(c[4]) {}
+      dense(c[0]), HSS(c[1]), BLR(c[2]), HODLR(c[3]), lossy(c[4]),
+      amalgamated(c[5]) {}
 #if defined(STRUMPACK_USE_MPI)
     FrontCounter reduce(const MPIComm& comm) const {
-      std::array<int,5> w = {dense, HSS, BLR, HODLR, lossy};
+      std::array<int,6> w = {dense, HSS, BLR, HODLR, lossy, amalgamated};
       comm.reduce(w.data(), w.size(), MPI_SUM);
-      return FrontCounter(w.data());
+      FrontCounter fc(w.data());
+      fc.amalgamation_zeros = comm.reduce(amalgamation_zeros, MPI_SUM);
+      return fc;
     }
 #endif
   };
@@ -126,6 +132,15 @@ namespace strumpack {
    integer_t send, std::vector<integer_t>& upd,
    int level, FrontCounter& fc, bool root=true);
 
+  /**
+   * Create a front of the given type, as returned by
+   * FrontalMatrix::type(), for instance when reading the factors
+   * from file. Returns nullptr if that type is not available.
+   */
+  template<typename scalar_t, typename integer_t>
+  std::unique_ptr<FrontalMatrix<scalar_t,integer_t>> create_frontal_matrix
+  (const std::string& type, integer_t s, integer_t sbegin,
+   integer_t send, std::vector<integer_t>& upd);
 
 #if defined(STRUMPACK_USE_MPI)
   template<typename scalar_t, typename integer_t>
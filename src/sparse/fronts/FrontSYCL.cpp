@@ -738,9 +738,7 @@ namespace strumpack {
     F22_ = DenseMW_t(dupd, dupd, host_Schur_.get(), dupd);
     F11_.zero(); F12_.zero();
     F21_.zero(); F22_.zero();
-    A.extract_front
-      (F11_, F12_, F21_, this->sep_begin_, this->sep_end_,
-       this->upd_, task_depth);
+    this->extract_front(A, opts, F11_, F12_, F21_, task_depth);
     if (lchild_) {
 #pragma omp parallel
 #pragma omp single
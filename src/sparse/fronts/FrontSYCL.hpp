@@ -70,6 +70,7 @@ namespace strumpack {
     void backward_multifrontal_solve(DenseM_t& y, DenseM_t* work,
                                      int etree_level=0, int task_depth=0)
       const override;
+    bool front_local_solve() const override { return false; }
 
     void extract_CB_sub_matrix(const std::vector<std::size_t>& I,
                                const std::vector<std::size_t>& J,
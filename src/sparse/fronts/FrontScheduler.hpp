@@ -0,0 +1,527 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#ifndef FRONT_SCHEDULER_HPP
+#define FRONT_SCHEDULER_HPP
+
+#include <vector>
+#include <queue>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "StrumpackParameters.hpp"
+#include "StrumpackOptions.hpp"
+
+namespace strumpack {
+
+  /**
+   * Non-recursive traversal of a tree of fronts, for the numerical
+   * factorization and the solve.
+   *
+   * The tree is flattened into a postorder array, so that the fronts
+   * in the subtree of node i are first(i), .., i. Nodes for which
+   * expand returns false are not further expanded, their subtree is a
+   * single node in the schedule, which is handled by the callback
+   * (for instance through the recursive routines of that front type).
+   *
+   * The children of every node are ordered as proposed by Liu, by
+   * decreasing difference between the peak active memory of the
+   * child subtree and the contribution block of the child. This
+   * postorder minimizes the peak memory of the contribution blocks
+   * for a sequential traversal, see peak_memory().
+   *
+   * For a parallel traversal, the tree is split, based on the
+   * estimated cost of the fronts, in at least subtrees_per_thread
+   * subtrees per thread, by repeatedly splitting the most expensive
+   * subtree. These subtrees are processed sequentially, without
+   * recursion, each as one OpenMP task, starting with the most
+   * expensive ones, and the OpenMP runtime balances these tasks over
+   * the threads. Alternatively, see map_to_threads(), the subtrees
+   * are statically mapped to the threads. The remaining nodes, at
+   * the top of the tree, have an atomic counter for their unfinished
+   * children. The thread that finishes the last child of a node
+   * continues with that node, so there is no waiting, and no
+   * recursion, however deep or unbalanced the tree is.
+   */
+  template<typename node_t> class FrontScheduler {
+  public:
+    /**
+     * \param root root of the tree, node_t should have lchild() and
+     * rchild() members, and dim_sep() and dim_upd()
+     * \param expand expand(f) returns whether the children of f
+     * should be separate nodes in the schedule
+     * \param cost cost(f) returns the (estimated) flops for front f
+     */
+    template<typename Expand, typename Cost>
+    FrontScheduler(node_t* root, Expand&& expand, Cost&& cost) {
+      flatten(root, expand, cost);
+      liu_order();
+      partition();
+    }
+
+    /**
+     * Replace the dynamic partitioning of the tree by a static
+     * proportional mapping of the subtrees to the threads, as is done
+     * for the MPI processes in EliminationTreeMPIDist. The threads
+     * of a node are divided over its children proportionally to the
+     * subtree weights, the flops, the factor memory or the peak
+     * memory, depending on pmap. A child that would get less than
+     * half a thread shares the last thread of its sibling. Subtrees
+     * with a single thread are processed sequentially, by that
+     * thread, in the memory minimizing order. This is only used by
+     * bottom_up with task_depth 0, outside of a parallel region.
+     */
+    void map_to_threads(ProportionalMapping pmap) {
+      const int N = size(), P = threads();
+      thread_units_.clear();
+      if (!N || P <= 1) return;
+      auto w = weights(pmap);
+      top_.assign(N, false);
+      units_.clear();
+      thread_units_.resize(P);
+      // node, first thread, number of threads
+      std::vector<std::array<int,3>> s{{N-1, 0, P}};
+      while (!s.empty()) {
+        auto i = s.back()[0], t0 = s.back()[1], nt = s.back()[2];
+        s.pop_back();
+        if (nt == 1 || first_[i] == i) {
+          thread_units_[t0].push_back(i);
+          units_.push_back(i);
+          continue;
+        }
+        top_[i] = true;
+        int ch[2], nc = 0;
+        for_each_child(i, [&](int c) { ch[nc++] = c; });
+        if (nc == 1) {
+          s.push_back({ch[0], t0, nt});
+          continue;
+        }
+        auto wl = w[ch[0]], wr = w[ch[1]];
+        int nl = (wl + wr > 0.) ? int(std::round(nt * wl / (wl + wr))) : nt / 2;
+        if (nl == 0) {
+          s.push_back({ch[0], t0+nt-1, 1});
+          s.push_back({ch[1], t0, nt});
+        } else if (nl == nt) {
+          s.push_back({ch[0], t0, nt});
+          s.push_back({ch[1], t0+nt-1, 1});
+        } else {
+          s.push_back({ch[0], t0, nl});
+          s.push_back({ch[1], t0+nl, nt-nl});
+        }
+      }
+      for (auto& u : thread_units_)
+        std::sort(u.begin(), u.end());
+      std::sort(units_.begin(), units_.end(), [&](int a, int b) {
+        return subtree_cost_[a] > subtree_cost_[b]; });
+    }
+
+    /**
+     * Estimated peak memory, in number of scalars, for the
+     * contribution blocks during a sequential bottom-up traversal.
+     */
+    double peak_memory() const { return size() ? peak_.back() : 0.; }
+
+    /** number of nodes in the schedule, the root is size()-1 */
+    std::size_t size() const { return node_.size(); }
+    node_t* node(std::size_t i) const { return node_[i]; }
+    /** index of the parent, -1 for the root */
+    int parent(std::size_t i) const { return parent_[i]; }
+    /** level in the tree, 0 for the root */
+    int level(std::size_t i) const { return level_[i]; }
+    /** whether the subtree of node i is handled as a single node */
+    bool expanded(std::size_t i) const { return expanded_[i]; }
+
+    /**
+     * Call f(c) for all children c of node i, from left to right.
+     */
+    template<typename F> void for_each_child(std::size_t i, F&& f) const {
+      int ch[2], nc = 0;
+      for (int c=int(i)-1; c>=first_[i]; c=first_[c]-1) ch[nc++] = c;
+      while (nc) f(ch[--nc]);
+    }
+
+    /**
+     * Call f(i, task_depth) for all nodes i, for each node after its
+     * children. With parallel, this uses OpenMP tasks (in a parallel
+     * region if task_depth is 0), otherwise the nodes are visited in
+     * postorder, all with the given task_depth.
+     */
+    template<typename F> void
+    bottom_up(F&& f, int task_depth, bool parallel) const {
+      const int N = size();
+      if (!parallel || task_depth >= params::task_recursion_cutoff_level) {
+        for (int i=0; i<N; i++) f(i, task_depth);
+        return;
+      }
+      std::unique_ptr<std::atomic<int>[]> pending
+        (new std::atomic<int>[N]);
+      for (int i=0; i<N; i++) {
+        int nc = 0;
+        for_each_child(i, [&](int) { nc++; });
+        pending[i] = nc;
+      }
+      auto run = [&](int u) {
+        for (int i=first_[u]; i<=u; i++)
+          f(i, params::task_recursion_cutoff_level);
+        for (int p=parent_[u]; p!=-1; p=parent_[p]) {
+          if (--pending[p]) break;
+          f(p, depth(p, task_depth));
+        }
+      };
+#if defined(_OPENMP)
+      if (!thread_units_.empty() && task_depth == 0 && !omp_in_parallel()) {
+        const int P = thread_units_.size();
+#pragma omp parallel num_threads(P) default(shared)
+        {
+          // with fewer threads than requested, threads take over the
+          // subtrees of the missing ones
+          int t = omp_get_thread_num(), nt = omp_get_num_threads();
+          for (int g=t; g<P; g+=nt)
+            for (auto u : thread_units_[g])
+              run(u);
+        }
+        return;
+      }
+#endif
+      spawn([&]() {
+        for (auto u : units_)
+#pragma omp task default(shared) firstprivate(u)
+          run(u);
+      }, task_depth);
+    }
+
+    /**
+     * Call f(i, task_depth) for all nodes i, for each node before its
+     * children. With parallel, this uses OpenMP tasks (in a parallel
+     * region if task_depth is 0), otherwise the nodes are visited in
+     * reverse postorder, all with the given task_depth.
+     */
+    template<typename F> void
+    top_down(F&& f, int task_depth, bool parallel) const {
+      const int N = size();
+      if (!parallel || task_depth >= params::task_recursion_cutoff_level) {
+        for (int i=N-1; i>=0; i--) f(i, task_depth);
+        return;
+      }
+      spawn([&]() { run_down(N-1, f, task_depth); }, task_depth);
+    }
+
+  private:
+    std::vector<node_t*> node_;
+    std::vector<int> parent_, first_, level_;
+    std::vector<bool> expanded_;
+    // estimated cost of the node, and of its subtree
+    std::vector<double> cost_, subtree_cost_;
+    // contribution block size, factor size (of the whole subtree for
+    // an unexpanded node), factor size of the subtree, and peak
+    // active memory for the subtree
+    std::vector<double> cb_, fact_, subtree_fact_, peak_;
+    // top_[i]: node above the subtrees that are processed as tasks
+    std::vector<bool> top_;
+    // roots of the subtrees processed as tasks, most expensive first
+    std::vector<int> units_;
+    // with a static mapping, the subtrees for each thread
+    std::vector<std::vector<int>> thread_units_;
+
+    static const int subtrees_per_thread = 4;
+
+    static int threads() {
+#if defined(_OPENMP)
+      return omp_get_max_threads();
+#else
+      return 1;
+#endif
+    }
+
+    int depth(int i, int task_depth) const {
+      return std::min(task_depth + level_[i],
+                      params::task_recursion_cutoff_level);
+    }
+
+    template<typename F> void spawn(F&& f, int task_depth) const {
+      if (task_depth == 0) {
+#pragma omp parallel if(!omp_in_parallel()) default(shared)
+#pragma omp single nowait
+        f();
+      } else {
+#pragma omp taskgroup
+        f();
+      }
+    }
+
+    template<typename Expand, typename Cost>
+    void flatten(node_t* root, Expand& expand, Cost& cost) {
+      if (!root) return;
+      // preorder, with the right child first, reversed, is postorder
+      std::vector<std::pair<node_t*,int>> s{{root, -1}};
+      std::vector<int> pre_parent, pre_level;
+      while (!s.empty()) {
+        auto n = s.back().first;
+        auto p = s.back().second;
+        s.pop_back();
+        pre_parent.push_back(p);
+        pre_level.push_back(p == -1 ? 0 : pre_level[p] + 1);
+        node_.push_back(n);
+        expanded_.push_back(expand(n));
+        if (expanded_.back()) {
+          int i = node_.size() - 1;
+          for (node_t* c : {n->lchild(), n->rchild()})
+            if (c) s.emplace_back(c, i);
+        }
+      }
+      const int N = node_.size();
+      std::reverse(node_.begin(), node_.end());
+      std::reverse(expanded_.begin(), expanded_.end());
+      parent_.resize(N);
+      level_.resize(N);
+      for (int i=0; i<N; i++) {
+        auto p = pre_parent[N-1-i];
+        parent_[i] = (p == -1) ? -1 : N-1-p;
+        level_[i] = pre_level[N-1-i];
+      }
+      cost_.resize(N);
+      cb_.resize(N);
+      fact_.resize(N);
+      peak_.resize(N);
+      for (int i=0; i<N; i++) {
+        double u = node_[i]->dim_upd();
+        cb_[i] = u * u;
+        if (expanded_[i]) {
+          double s = node_[i]->dim_sep();
+          cost_[i] = cost(node_[i]);
+          fact_[i] = s * (s + 2. * u);
+          peak_[i] = cb_[i];
+          continue;
+        }
+        // the whole subtree of an unexpanded node, in postorder
+        std::vector<node_t*> st{node_[i]}, sub;
+        std::vector<int> spar, pre_par{-1};
+        while (!st.empty()) {
+          auto n = st.back();
+          st.pop_back();
+          int k = sub.size();
+          sub.push_back(n);
+          spar.push_back(pre_par.back());
+          pre_par.pop_back();
+          for (node_t* ch : {n->lchild(), n->rchild()})
+            if (ch) {
+              st.push_back(ch);
+              pre_par.push_back(k);
+            }
+        }
+        const int M = sub.size();
+        std::vector<int> par(M);
+        std::vector<double> cb(M), pk(M);
+        double c = 0., fs = 0.;
+        for (int k=0; k<M; k++) {
+          auto n = sub[M-1-k];
+          double s = n->dim_sep(), u = n->dim_upd();
+          par[k] = (spar[M-1-k] == -1) ? -1 : M-1-spar[M-1-k];
+          cb[k] = pk[k] = u * u;
+          c += cost(n);
+          fs += s * (s + 2. * u);
+        }
+        liu_peaks(par, cb, pk);
+        cost_[i] = c;
+        fact_[i] = fs;
+        peak_[i] = pk.back();
+      }
+    }
+
+    /**
+     * Peak active memory, for the contribution blocks, for the
+     * sequential traversal of the subtree of each node, with the
+     * children in Liu's order. The nodes should be in postorder and
+     * peak should be set for the leaves. Returns the children of each
+     * node, two entries per node, -1 if missing, in that order.
+     */
+    static std::vector<int>
+    liu_peaks(const std::vector<int>& parent, const std::vector<double>& cb,
+              std::vector<double>& peak) {
+      const int N = parent.size();
+      std::vector<int> ch(2*N, -1);
+      for (int i=0; i<N; i++) {
+        auto& c0 = ch[2*i];
+        auto& c1 = ch[2*i+1];
+        if (c0 != -1) {
+          if (c1 != -1 && peak[c1] - cb[c1] > peak[c0] - cb[c0])
+            std::swap(c0, c1);
+          double p = peak[c0], s = cb[c0];
+          if (c1 != -1) {
+            p = std::max(p, s + peak[c1]);
+            s += cb[c1];
+          }
+          peak[i] = std::max(p, s + cb[i]);
+        }
+        if (parent[i] != -1)
+          ch[2*parent[i] + (ch[2*parent[i]] != -1)] = i;
+      }
+      return ch;
+    }
+
+    /**
+     * Reorder the postorder with the children in Liu's order, and set
+     * up first_ and the subtree sums.
+     */
+    void liu_order() {
+      const int N = size();
+      if (!N) return;
+      auto ch = liu_peaks(parent_, cb_, peak_);
+      // preorder, pushing the children in postorder, reversed
+      std::vector<int> s{N-1}, old;
+      old.reserve(N);
+      while (!s.empty()) {
+        auto i = s.back();
+        s.pop_back();
+        old.push_back(i);
+        for (int k=0; k<2; k++)
+          if (ch[2*i+k] != -1) s.push_back(ch[2*i+k]);
+      }
+      std::reverse(old.begin(), old.end());
+      std::vector<int> inv(N);
+      for (int k=0; k<N; k++) inv[old[k]] = k;
+      auto permute = [&](auto& v) {
+        auto w = v;
+        for (int k=0; k<N; k++) v[k] = w[old[k]];
+      };
+      permute(node_);
+      permute(expanded_);
+      permute(level_);
+      permute(cost_);
+      permute(cb_);
+      permute(fact_);
+      permute(peak_);
+      permute(parent_);
+      for (auto& p : parent_)
+        if (p != -1) p = inv[p];
+      std::vector<int> size(N, 1);
+      subtree_cost_ = cost_;
+      subtree_fact_ = fact_;
+      for (int i=0; i<N; i++)
+        if (parent_[i] != -1) {
+          size[parent_[i]] += size[i];
+          subtree_cost_[parent_[i]] += subtree_cost_[i];
+          subtree_fact_[parent_[i]] += subtree_fact_[i];
+        }
+      first_.resize(N);
+      for (int i=0; i<N; i++)
+        first_[i] = i - size[i] + 1;
+    }
+
+    /**
+     * Subtree weights for the proportional mapping, computed as in
+     * EliminationTreeMPIDist::symb_fact_loc.
+     */
+    std::vector<double> weights(ProportionalMapping pmap) const {
+      switch (pmap) {
+      case ProportionalMapping::FACTOR_MEMORY: return subtree_fact_;
+      case ProportionalMapping::PEAK_MEMORY: {
+        const int N = size();
+        // factors of the subtree, F22, and F22 of the children
+        std::vector<double> w(N);
+        for (int i=0; i<N; i++)
+          w[i] = subtree_fact_[i] + (expanded_[i] ? cb_[i] : peak_[i]);
+        for (int i=0; i<N-1; i++)
+          w[parent_[i]] += cb_[i];
+        for (int i=0; i<N-1; i++)
+          w[parent_[i]] = std::max(w[parent_[i]], w[i]);
+        return w;
+      }
+      case ProportionalMapping::FLOPS:
+      default: return subtree_cost_;
+      }
+    }
+
+    void partition() {
+      const int N = size();
+      top_.assign(N, false);
+      units_.clear();
+      if (!N) return;
+      const std::size_t P = threads();
+      if (P <= 1) {
+        units_.push_back(N-1);
+        return;
+      }
+      const std::size_t max_units = subtrees_per_thread * P;
+      const double min_cost = subtree_cost_[N-1] / max_units;
+      auto cmp = [&](int a, int b) {
+        return subtree_cost_[a] < subtree_cost_[b]; };
+      std::priority_queue<int,std::vector<int>,decltype(cmp)> q(cmp);
+      q.push(N-1);
+      while (!q.empty() && q.size() + units_.size() < max_units) {
+        auto i = q.top();
+        if (subtree_cost_[i] <= min_cost) break;
+        q.pop();
+        if (first_[i] == i) units_.push_back(i);
+        else {
+          top_[i] = true;
+          for_each_child(i, [&](int c) { q.push(c); });
+        }
+      }
+      while (!q.empty()) {
+        units_.push_back(q.top());
+        q.pop();
+      }
+      std::sort(units_.begin(), units_.end(), [&](int a, int b) {
+        return subtree_cost_[a] > subtree_cost_[b]; });
+    }
+
+    /**
+     * Nodes above the subtrees continue with their last child in the
+     * same task, and spawn a task for the others. Spawning only
+     * happens where the top of the tree branches, so this does not
+     * nest deeper than the number of subtrees.
+     */
+    template<typename F> void
+    run_down(int i, F& f, int task_depth) const {
+      while (true) {
+        if (!top_[i]) {
+          for (int j=i; j>=first_[i]; j--)
+            f(j, params::task_recursion_cutoff_level);
+          return;
+        }
+        f(i, depth(i, task_depth));
+        int ch[2], nc = 0;
+        for_each_child(i, [&](int c) { ch[nc++] = c; });
+        if (!nc) return;
+        for (int k=0; k<nc-1; k++) {
+          int c = ch[k];
+#pragma omp task default(shared) firstprivate(c, task_depth)
+          run_down(c, f, task_depth);
+        }
+        i = ch[nc-1];
+      }
+    }
+  };
+
+} // end namespace strumpack
+
+#endif // FRONT_SCHEDULER_HPP
@@ -31,8 +31,12 @@
 #include <random>
 #include <vector>
 #include <cmath>
+#include <atomic>
+#include <memory>
 
 #include "FrontalMatrix.hpp"
+#include "FrontScheduler.hpp"
+#include "sparse/OutOfCoreStorage.hpp"
 #if defined(STRUMPACK_USE_MPI)
 #include "ExtendAdd.hpp"
 #include "FrontalMatrixMPI.hpp"
@@ -50,24 +54,57 @@ namespace strumpack {
       upd_(std::move(upd)), lchild_(lchild), rchild_(rchild) {
   }
 
+  /**
+   * The subtree is released with an explicit stack, each front is
+   * destroyed after its children have been detached, so that very
+   * deep trees do not overflow the stack.
+   */
+  template<typename scalar_t,typename integer_t>
+  FrontalMatrix<scalar_t,integer_t>::~FrontalMatrix() {
+    std::vector<std::unique_ptr<F_t>> s;
+    if (lchild_) s.push_back(std::move(lchild_));
+    if (rchild_) s.push_back(std::move(rchild_));
+    while (!s.empty()) {
+      auto f = std::move(s.back());
+      s.pop_back();
+      if (f->lchild_) s.push_back(std::move(f->lchild_));
+      if (f->rchild_) s.push_back(std::move(f->rchild_));
+    }
+  }
+
+  template<typename scalar_t,typename integer_t> int
+  FrontalMatrix<scalar_t,integer_t>::levels() const {
+    int lvl = 0;
+    std::vector<std::pair<const F_t*,int>> s{{this, 1}};
+    while (!s.empty()) {
+      auto f = s.back().first;
+      auto l = s.back().second;
+      s.pop_back();
+      lvl = std::max(lvl, l);
+      for (auto ch : {f->lchild_.get(), f->rchild_.get()})
+        if (ch) s.emplace_back(ch, l+1);
+    }
+    return lvl;
+  }
+
   template<typename scalar_t,typename integer_t> void
   FrontalMatrix<scalar_t,integer_t>::draw
   (std::ostream& of, int etree_level) const {
-    draw_node(of, etree_level == 0);
-    for (auto u : upd_) {
-      char prev = std::cout.fill('0');
-      of << "set obj rect from "
-         << sep_begin_ << ", " << u << " to "
-         << sep_end_ << ", " << u+1
-         << " fc rgb '#FF0000'" << std::endl
-         << "set obj rect from "
-         << u << ", " << sep_begin_ << " to "
-         << u+1 << ", " << sep_end_
-         << " fc rgb '#FF0000'" << std::endl;
-      std::cout.fill(prev);
-    }
-    if (lchild_) lchild_->draw(of, etree_level+1);
-    if (rchild_) rchild_->draw(of, etree_level+1);
+    for_each_front([&](const F_t* f) {
+      f->draw_node(of, f == this && etree_level == 0);
+      for (auto u : f->upd_) {
+        char prev = std::cout.fill('0');
+        of << "set obj rect from "
+           << f->sep_begin_ << ", " << u << " to "
+           << f->sep_end_ << ", " << u+1
+           << " fc rgb '#FF0000'" << std::endl
+           << "set obj rect from "
+           << u << ", " << f->sep_begin_ << " to "
+           << u+1 << ", " << f->sep_end_
+           << " fc rgb '#FF0000'" << std::endl;
+        std::cout.fill(prev);
+      }
+    });
   }
 
   template<typename scalar_t,typename integer_t> void
@@ -107,6 +144,11 @@ namespace strumpack {
   template<typename scalar_t,typename integer_t> void
   FrontalMatrix<scalar_t,integer_t>::upd_to_parent
   (const F_t* pa, std::size_t& upd2sep, std::size_t* I) const {
+    if (pa == upd2pa_parent_) {
+      std::copy(upd2pa_.begin(), upd2pa_.end(), I);
+      upd2sep = upd2pa_sep_;
+      return;
+    }
     integer_t r = 0, dupd = dim_upd(), pa_dsep = pa->dim_sep();
     for (; r<dupd; r++) {
       auto up = upd_[r];
@@ -123,6 +165,10 @@ namespace strumpack {
   template<typename scalar_t,typename integer_t> void
   FrontalMatrix<scalar_t,integer_t>::upd_to_parent
   (const F_t* pa, std::size_t* I) const {
+    if (pa == upd2pa_parent_) {
+      std::copy(upd2pa_.begin(), upd2pa_.end(), I);
+      return;
+    }
     integer_t r = 0, dupd = dim_upd(), pa_dsep = pa->dim_sep();
     for (; r<dupd; r++) {
       auto up = upd_[r];
@@ -146,11 +192,43 @@ namespace strumpack {
   template<typename scalar_t,typename integer_t> std::vector<std::size_t>
   FrontalMatrix<scalar_t,integer_t>::upd_to_parent
   (const F_t* pa, std::size_t& upd2sep) const {
+    if (pa == upd2pa_parent_) {
+      upd2sep = upd2pa_sep_;
+      return upd2pa_;
+    }
     std::vector<std::size_t> I(dim_upd());
     upd_to_parent(pa, upd2sep, I.data());
     return I;
   }
 
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrix<scalar_t,integer_t>::extract_front
+  (const SpMat_t& A, const Opts_t& opts, DenseM_t& F11, DenseM_t& F12,
+   DenseM_t& F21, int task_depth) {
+    if (opts.numeric_refactorization()) {
+      if (!scatter_.valid(A.nnz(), F11, F12, F21))
+        A.extract_front_plan
+          (sep_begin_, sep_end_, upd_, F12.cols() > 0, scatter_);
+      if (scatter_.valid(A.nnz(), F11, F12, F21)) {
+        scatter_.apply(A.val(), F11, F12, F21);
+        return;
+      }
+    }
+    A.extract_front(F11, F12, F21, sep_begin_, sep_end_, upd_, task_depth);
+  }
+
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrix<scalar_t,integer_t>::store_upd_to_parent_maps() {
+    for_each_front([](F_t* f) {
+      for (auto ch : {f->lchild_.get(), f->rchild_.get()}) {
+        if (!ch) continue;
+        ch->upd2pa_parent_ = nullptr;
+        ch->upd2pa_ = ch->upd_to_parent(f, ch->upd2pa_sep_);
+        ch->upd2pa_parent_ = f;
+      }
+    });
+  }
+
   template<typename scalar_t,typename integer_t> inline void
   FrontalMatrix<scalar_t,integer_t>::extend_add_b
   (DenseM_t& b, DenseM_t& bupd, const DenseM_t& CB, const F_t* pa) const {
@@ -197,51 +275,167 @@ namespace strumpack {
 
   template<typename scalar_t,typename integer_t> integer_t
   FrontalMatrix<scalar_t,integer_t>::maximum_rank(int task_depth) const {
-    integer_t r = front_rank(), rl = 0, rr = 0;
-    if (lchild_)
-#pragma omp task untied default(shared)                                 \
-  final(task_depth >= params::task_recursion_cutoff_level-1) mergeable
-      rl = lchild_->maximum_rank(task_depth+1);
-    if (rchild_)
-#pragma omp task untied default(shared)                                 \
-  final(task_depth >= params::task_recursion_cutoff_level-1) mergeable
-      rr = rchild_->maximum_rank(task_depth+1);
-#pragma omp taskwait
-    return std::max(r, std::max(rl, rr));
+    integer_t r = 0;
+    for_each_front([&r](const F_t* f) {
+      r = std::max(r, f->front_rank()); });
+    return r;
   }
 
   template<typename scalar_t,typename integer_t> void
   FrontalMatrix<scalar_t,integer_t>::multifrontal_solve(DenseM_t& b) const {
-    auto max_dupd = max_dim_upd();
-    auto lvls = levels();
-    std::vector<DenseM_t> CB(lvls);
-    // for (auto& cb : CB)
-    //   cb = DenseM_t(max_dupd, b.cols());
-    for (std::size_t i=0; i<CB.size(); i++)
-      CB[i] = DenseM_t(max_dupd, b.cols());
+    tree_solve(Trans::N, b);
+  }
+
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrix<scalar_t,integer_t>::multifrontal_solve
+  (Trans op, DenseM_t& b) const {
+    if (op == Trans::N) {
+      multifrontal_solve(b);
+      return;
+    }
+    tree_solve(op, b);
+  }
+
+  /**
+   * Forward and backward sweep over the tree, without recursion, see
+   * FrontScheduler. Each front gets its own buffer for bupd/yupd,
+   * which is returned to a pool as soon as it has been used by the
+   * parent (forward) or by all children (backward). The pool is kept
+   * with this front, so repeated solves do not allocate. Fronts with
+   * a specialized solve (HSS, HODLR, ..) are a single node in the
+   * schedule, and solve for their subtree through the (recursive)
+   * virtual solve routines.
+   */
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrix<scalar_t,integer_t>::tree_solve
+  (Trans op, DenseM_t& b) const {
+    FrontScheduler<const F_t> sched
+      (this, [](const F_t* f) { return f->front_local_solve(); },
+       [](const F_t* f) {
+        double s = f->dim_sep(), u = f->dim_upd();
+        return s * (s + 2 * u); });
+    const std::size_t N = sched.size(), root = N - 1;
+    const auto nrhs = b.cols();
+    // VectorPool is thread safe, so concurrent solves can share it
+    std::call_once(solve_work_once_, [this]() {
+      solve_work_.reset(new VectorPool<scalar_t>()); });
+    auto& pool = *solve_work_;
+    std::vector<std::vector<scalar_t,NoInit<scalar_t>>> CBmem(N);
+    std::vector<DenseMW_t> CB(N);
+    auto get_CB = [&](std::size_t i, std::size_t rows) {
+      CBmem[i] = pool.get(rows * nrhs);
+      CB[i] = DenseMW_t(rows, nrhs, CBmem[i].data(), rows);
+    };
+    auto release_CB = [&](std::size_t i) {
+      CB[i].clear();
+      pool.restore(CBmem[i]);
+    };
+    // for an unexpanded node, the subtree is solved with the work
+    // space for all its levels, CB takes over work[0]
+    auto work = [&](const F_t* f) {
+      std::vector<DenseM_t> w(f->levels());
+      for (std::size_t i=0; i<w.size(); i++)
+        w[i] = DenseM_t(f->max_dim_upd(), nrhs);
+      return w;
+    };
+    auto fwd = [&](std::size_t i, int d) {
+      auto f = sched.node(i);
+      auto l = sched.level(i);
+      if (!sched.expanded(i)) {
+        auto w = work(f);
+        if (op == Trans::N)
+          f->forward_multifrontal_solve(b, w.data(), l, d);
+        else f->forward_multifrontal_solve(op, b, w.data(), l, d);
+        get_CB(i, f->dim_upd());
+        CB[i].copy(DenseMW_t(f->dim_upd(), nrhs, w[0], 0, 0));
+        return;
+      }
+      get_CB(i, f->dim_upd());
+      CB[i].zero();
+      sched.for_each_child(i, [&](std::size_t c) {
+        auto ch = sched.node(c);
+        DenseMW_t CBch(ch->dim_upd(), nrhs, CB[c], 0, 0);
+        ch->extend_add_b(b, CB[i], CBch, f);
+        release_CB(c);
+      });
+      TraceScope trace("fwd_solve", f->trace_args(l));
+      f->fwd_solve_phase2(op, b, CB[i], l, d);
+    };
+    std::unique_ptr<std::atomic<int>[]> pending(new std::atomic<int>[N]);
+    auto bwd = [&](std::size_t i, int d) {
+      auto f = sched.node(i);
+      auto l = sched.level(i);
+      if (i != root) {
+        auto p = sched.parent(i);
+        get_CB(i, f->dim_upd());
+        f->extract_b(b, CB[p], CB[i], sched.node(p));
+        if (!--pending[p]) release_CB(p);
+      }
+      if (!sched.expanded(i)) {
+        auto w = work(f);
+        DenseMW_t(f->dim_upd(), nrhs, w[0], 0, 0).copy
+          (DenseMW_t(f->dim_upd(), nrhs, CB[i], 0, 0));
+        if (op == Trans::N)
+          f->backward_multifrontal_solve(b, w.data(), l, d);
+        else f->backward_multifrontal_solve(op, b, w.data(), l, d);
+      } else {
+        TraceScope trace("bwd_solve", f->trace_args(l));
+        f->bwd_solve_phase1(op, b, CB[i], l, d);
+      }
+      int nc = 0;
+      sched.for_each_child(i, [&](std::size_t) { nc++; });
+      if (nc) pending[i] = nc;
+      else release_CB(i);
+    };
+    // no tasking for the root node computations, use system blas
+    // threading, unless the root has its own (tasked) solve
+    const int root_depth = sched.expanded(root) ?
+      params::task_recursion_cutoff_level : 0;
+    // the out-of-core factors are read in the order in which the
+    // fronts were factored for the forward solve, reverse for the
+    // backward solve
+    if (ooc_) ooc_->start_read_ahead(true);
     TIMER_TIME(TaskType::FORWARD_SOLVE, 0, t_fwd);
-    forward_multifrontal_solve(b, CB.data());
+    if (N > 1)
+      sched.bottom_up([&](std::size_t i, int d) {
+        if (i != root) fwd(i, d); }, 0, true);
+    fwd(root, root_depth);
     TIMER_STOP(t_fwd);
+    if (ooc_) ooc_->start_read_ahead(false);
     TIMER_TIME(TaskType::BACKWARD_SOLVE, 0, t_bwd);
-    backward_multifrontal_solve(b, CB.data());
+    bwd(root, root_depth);
+    if (N > 1)
+      sched.top_down([&](std::size_t i, int d) {
+        if (i != root) bwd(i, d); }, 0, true);
     TIMER_STOP(t_bwd);
+    if (ooc_) ooc_->stop_read_ahead();
   }
 
   template<typename scalar_t,typename integer_t> void
   FrontalMatrix<scalar_t,integer_t>::forward_multifrontal_solve
   (DenseM_t& b, DenseM_t* work, int etree_level, int task_depth) const {
+    forward_multifrontal_solve(Trans::N, b, work, etree_level, task_depth);
+  }
+
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrix<scalar_t,integer_t>::forward_multifrontal_solve
+  (Trans op, DenseM_t& b, DenseM_t* work,
+   int etree_level, int task_depth) const {
     DenseMW_t bupd(dim_upd(), b.cols(), work[0], 0, 0);
     bupd.zero();
     if (task_depth == 0) {
       // tasking when calling the children
 #pragma omp parallel if(!omp_in_parallel())
 #pragma omp single nowait
-      this->fwd_solve_phase1(b, bupd, work, etree_level, task_depth);
+      fwd_solve_phase1(op, b, bupd, work, etree_level, task_depth);
+      TraceScope trace("fwd_solve", trace_args(etree_level));
       // no tasking for the root node computations, use system blas threading!
-      fwd_solve_phase2(b, bupd, etree_level, params::task_recursion_cutoff_level);
+      fwd_solve_phase2
+        (op, b, bupd, etree_level, params::task_recursion_cutoff_level);
     } else {
-      this->fwd_solve_phase1(b, bupd, work, etree_level, task_depth);
-      fwd_solve_phase2(b, bupd, etree_level, task_depth);
+      fwd_solve_phase1(op, b, bupd, work, etree_level, task_depth);
+      TraceScope trace("fwd_solve", trace_args(etree_level));
+      fwd_solve_phase2(op, b, bupd, etree_level, task_depth);
     }
   }
 
@@ -249,12 +443,25 @@ namespace strumpack {
   FrontalMatrix<scalar_t,integer_t>::fwd_solve_phase1
   (DenseM_t& b, DenseM_t& bupd, DenseM_t* work,
    int etree_level, int task_depth) const {
+    fwd_solve_phase1(Trans::N, b, bupd, work, etree_level, task_depth);
+  }
+
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrix<scalar_t,integer_t>::fwd_solve_phase1
+  (Trans op, DenseM_t& b, DenseM_t& bupd, DenseM_t* work,
+   int etree_level, int task_depth) const {
+    // for op == Trans::N, go through the virtual solve routines, so
+    // that fronts with a specialized solve (HSS, HODLR, ..) are used
+    auto fwd_child = [&](const F_t* ch, DenseM_t* w, int d) {
+      if (op == Trans::N)
+        ch->forward_multifrontal_solve(b, w, etree_level+1, d);
+      else ch->forward_multifrontal_solve(op, b, w, etree_level+1, d);
+    };
     if (task_depth < params::task_recursion_cutoff_level) {
       if (lchild_)
 #pragma omp task untied default(shared)                                 \
   final(task_depth >= params::task_recursion_cutoff_level-1) mergeable
-        lchild_->forward_multifrontal_solve
-          (b, work+1, etree_level+1, task_depth+1);
+        fwd_child(lchild_.get(), work+1, task_depth+1);
       if (rchild_)
 #pragma omp task untied default(shared)                                 \
   final(task_depth >= params::task_recursion_cutoff_level-1) mergeable
@@ -264,8 +471,7 @@ namespace strumpack {
           //   cb = DenseM_t(rchild_->max_dim_upd(), b.cols());
           for (std::size_t i=0; i<work2.size(); i++)
             work2[i] = DenseM_t(rchild_->max_dim_upd(), b.cols());
-          rchild_->forward_multifrontal_solve
-            (b, work2.data(), etree_level+1, task_depth+1);
+          fwd_child(rchild_.get(), work2.data(), task_depth+1);
           DenseMW_t CBch(rchild_->dim_upd(), b.cols(), work2[0], 0, 0);
           rchild_->extend_add_b(b, bupd, CBch, this);
         }
@@ -276,42 +482,97 @@ namespace strumpack {
       }
     } else {
       if (lchild_) {
-        lchild_->forward_multifrontal_solve
-          (b, work+1, etree_level+1, task_depth);
+        fwd_child(lchild_.get(), work+1, task_depth);
         DenseMW_t CBch(lchild_->dim_upd(), b.cols(), work[1], 0, 0);
         lchild_->extend_add_b(b, bupd, CBch, this);
       }
       if (rchild_) {
-        rchild_->forward_multifrontal_solve
-          (b, work+1, etree_level+1, task_depth);
+        fwd_child(rchild_.get(), work+1, task_depth);
         DenseMW_t CBch(rchild_->dim_upd(), b.cols(), work[1], 0, 0);
         rchild_->extend_add_b(b, bupd, CBch, this);
       }
     }
   }
 
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrix<scalar_t,integer_t>::fwd_solve_phase2
+  (Trans op, DenseM_t& b, DenseM_t& bupd,
+   int etree_level, int task_depth) const {
+    if (op == Trans::N) {
+      fwd_solve_phase2(b, bupd, etree_level, task_depth);
+      return;
+    }
+    std::cerr << "FrontalMatrix::fwd_solve_phase2"
+              << " with op(A) = A^T or A^H"
+              << " not implemented for this front type: "
+              << typeid(*this).name()
+              << std::endl;
+    abort();
+  }
+
   template<typename scalar_t,typename integer_t> void
   FrontalMatrix<scalar_t,integer_t>::backward_multifrontal_solve
   (DenseM_t& y, DenseM_t* work, int etree_level, int task_depth) const {
+    backward_multifrontal_solve(Trans::N, y, work, etree_level, task_depth);
+  }
+
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrix<scalar_t,integer_t>::backward_multifrontal_solve
+  (Trans op, DenseM_t& y, DenseM_t* work,
+   int etree_level, int task_depth) const {
     DenseMW_t yupd(dim_upd(), y.cols(), work[0], 0, 0);
     if (task_depth == 0) {
-      // no tasking in blas routines, use system threaded blas instead
-      bwd_solve_phase1
-        (y, yupd, etree_level, params::task_recursion_cutoff_level);
+      {
+        TraceScope trace("bwd_solve", trace_args(etree_level));
+        // no tasking in blas routines, use system threaded blas instead
+        bwd_solve_phase1
+          (op, y, yupd, etree_level, params::task_recursion_cutoff_level);
+      }
 #pragma omp parallel if(!omp_in_parallel())
 #pragma omp single nowait
       // tasking when calling children
-      this->bwd_solve_phase2(y, yupd, work, etree_level, task_depth);
+      bwd_solve_phase2(op, y, yupd, work, etree_level, task_depth);
     } else {
+      {
+        TraceScope trace("bwd_solve", trace_args(etree_level));
+        bwd_solve_phase1(op, y, yupd, etree_level, task_depth);
+      }
+      bwd_solve_phase2(op, y, yupd, work, etree_level, task_depth);
+    }
+  }
+
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrix<scalar_t,integer_t>::bwd_solve_phase1
+  (Trans op, DenseM_t& y, DenseM_t& yupd,
+   int etree_level, int task_depth) const {
+    if (op == Trans::N) {
       bwd_solve_phase1(y, yupd, etree_level, task_depth);
-      this->bwd_solve_phase2(y, yupd, work, etree_level, task_depth);
+      return;
     }
+    std::cerr << "FrontalMatrix::bwd_solve_phase1"
+              << " with op(A) = A^T or A^H"
+              << " not implemented for this front type: "
+              << typeid(*this).name()
+              << std::endl;
+    abort();
   }
 
   template<typename scalar_t,typename integer_t> void
   FrontalMatrix<scalar_t,integer_t>::bwd_solve_phase2
   (DenseM_t& y, DenseM_t& yupd, DenseM_t* work,
    int etree_level, int task_depth) const {
+    bwd_solve_phase2(Trans::N, y, yupd, work, etree_level, task_depth);
+  }
+
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrix<scalar_t,integer_t>::bwd_solve_phase2
+  (Trans op, DenseM_t& y, DenseM_t& yupd, DenseM_t* work,
+   int etree_level, int task_depth) const {
+    auto bwd_child = [&](const F_t* ch, DenseM_t* w, int d) {
+      if (op == Trans::N)
+        ch->backward_multifrontal_solve(y, w, etree_level+1, d);
+      else ch->backward_multifrontal_solve(op, y, w, etree_level+1, d);
+    };
     if (task_depth < params::task_recursion_cutoff_level) {
       if (lchild_) {
 #pragma omp task untied default(shared)                                 \
@@ -319,8 +580,7 @@ namespace strumpack {
         {
           DenseMW_t CB(lchild_->dim_upd(), y.cols(), work[1], 0, 0);
           lchild_->extract_b(y, yupd, CB, this);
-          lchild_->backward_multifrontal_solve
-            (y, work+1, etree_level+1, task_depth+1);
+          bwd_child(lchild_.get(), work+1, task_depth+1);
         }
       }
       if (rchild_) {
@@ -334,8 +594,7 @@ namespace strumpack {
             work2[i] = DenseM_t(rchild_->max_dim_upd(), y.cols());
           DenseMW_t CB(rchild_->dim_upd(), y.cols(), work2[0], 0, 0);
           rchild_->extract_b(y, yupd, CB, this);
-          rchild_->backward_multifrontal_solve
-            (y, work2.data(), etree_level+1, task_depth+1);
+          bwd_child(rchild_.get(), work2.data(), task_depth+1);
         }
       }
 #pragma omp taskwait
@@ -343,80 +602,64 @@ namespace strumpack {
       if (lchild_) {
         DenseMW_t CB(lchild_->dim_upd(), y.cols(), work[1], 0, 0);
         lchild_->extract_b(y, yupd, CB, this);
-        lchild_->backward_multifrontal_solve
-          (y, work+1, etree_level+1, task_depth);
+        bwd_child(lchild_.get(), work+1, task_depth);
       }
       if (rchild_) {
         DenseMW_t CB(rchild_->dim_upd(), y.cols(), work[1], 0, 0);
         rchild_->extract_b(y, yupd, CB, this);
-        rchild_->backward_multifrontal_solve
-          (y, work+1, etree_level+1, task_depth);
+        bwd_child(rchild_.get(), work+1, task_depth);
       }
     }
   }
 
   template<typename scalar_t,typename integer_t> long long
   FrontalMatrix<scalar_t,integer_t>::factor_nonzeros(int task_depth) const {
-    long long nnz = node_factor_nonzeros(), nnzl = 0, nnzr = 0;
-    if (lchild_)
-#pragma omp task default(shared)                        \
-  if(task_depth < params::task_recursion_cutoff_level)
-      nnzl = lchild_->factor_nonzeros(task_depth+1);
-    if (rchild_)
-#pragma omp task default(shared)                        \
-  if(task_depth < params::task_recursion_cutoff_level)
-      nnzr = rchild_->factor_nonzeros(task_depth+1);
-#pragma omp taskwait
-    return nnz + nnzl + nnzr;
+    long long nnz = 0;
+    for_each_front([&nnz](const F_t* f) {
+      nnz += f->node_factor_nonzeros(); });
+    return nnz;
   }
 
   template<typename scalar_t,typename integer_t> long long
   FrontalMatrix<scalar_t,integer_t>::dense_factor_nonzeros
   (int task_depth) const {
-    long long nnz = dense_node_factor_nonzeros(), nnzl = 0, nnzr = 0;
-    if (lchild_)
-#pragma omp task default(shared)                        \
-  if(task_depth < params::task_recursion_cutoff_level)
-      nnzl = lchild_->dense_factor_nonzeros(task_depth+1);
-    if (rchild_)
-#pragma omp task default(shared)                        \
-  if(task_depth < params::task_recursion_cutoff_level)
-      nnzr = rchild_->dense_factor_nonzeros(task_depth+1);
-#pragma omp taskwait
-    return nnz + nnzl + nnzr;
+    long long nnz = 0;
+    for_each_front([&nnz](const F_t* f) {
+      nnz += f->dense_node_factor_nonzeros(); });
+    return nnz;
   }
 
   template<typename scalar_t,typename integer_t> ReturnCode
   FrontalMatrix<scalar_t,integer_t>::inertia
   (integer_t& neg, integer_t& zero, integer_t& pos) const {
-    ReturnCode el = ReturnCode::SUCCESS, er = ReturnCode::SUCCESS;
-    if (lchild_) el = lchild_->inertia(neg, zero, pos);
-    if (rchild_) er = rchild_->inertia(neg, zero, pos);
-    if (el != ReturnCode::SUCCESS) return el;
-    if (er != ReturnCode::SUCCESS) return er;
-    return node_inertia(neg, zero, pos);
+    ReturnCode e = ReturnCode::SUCCESS;
+    for_each_front([&](const F_t* f) {
+      auto ef = f->node_inertia(neg, zero, pos);
+      if (e == ReturnCode::SUCCESS) e = ef;
+    });
+    return e;
   }
 
   template<typename scalar_t,typename integer_t> ReturnCode
   FrontalMatrix<scalar_t,integer_t>::subnormals(std::size_t& ns,
                                                 std::size_t& nz) const {
-    ReturnCode el = ReturnCode::SUCCESS, er = ReturnCode::SUCCESS;
-    if (lchild_) el = lchild_->subnormals(ns, nz);
-    if (rchild_) er = rchild_->subnormals(ns, nz);
-    if (el != ReturnCode::SUCCESS) return el;
-    if (er != ReturnCode::SUCCESS) return er;
-    return node_subnormals(ns, nz);
+    ReturnCode e = ReturnCode::SUCCESS;
+    for_each_front([&](const F_t* f) {
+      auto ef = f->node_subnormals(ns, nz);
+      if (e == ReturnCode::SUCCESS) e = ef;
+    });
+    return e;
   }
 
   template<typename scalar_t,typename integer_t> ReturnCode
   FrontalMatrix<scalar_t,integer_t>::pivot_growth(scalar_t& pgL,
                                                   scalar_t& pgU) const {
-    ReturnCode el = ReturnCode::SUCCESS, er = ReturnCode::SUCCESS;
-    if (lchild_) el = lchild_->pivot_growth(pgL, pgU);
-    if (rchild_) er = rchild_->pivot_growth(pgL, pgU);
-    if (el != ReturnCode::SUCCESS) return el;
-    if (er != ReturnCode::SUCCESS) return er;
-    return node_pivot_growth(pgL, pgU);
+    ReturnCode e = ReturnCode::SUCCESS;
+    for_each_front([&](const F_t* f) {
+      auto ef = f->node_pivot_growth(pgL, pgU);
+      if (e == ReturnCode::SUCCESS) e = ef;
+    });
+    return e;
   }
 
 #if defined(STRUMPACK_USE_MPI)
@@ -31,6 +31,7 @@
 
 #include <iostream>
 #include <vector>
+#include <mutex>
 #include <cmath>
 #include <typeinfo>
 
@@ -51,6 +52,9 @@ namespace strumpack {
 
   template<typename scalar_t,typename integer_t> class FrontalMatrixMPI;
   template<typename scalar_t,typename integer_t> class FrontalMatrixBLRMPI;
+  template<typename scalar_t> class OutOfCoreStorage;
+  class FactorFileWriter;
+  class FactorFileReader;
 
 
   template<typename scalar_t,typename integer_t> class FrontalMatrix {
@@ -71,8 +75,9 @@ namespace strumpack {
     FrontalMatrix(F_t* lchild, F_t* rchild,
                   integer_t sep, integer_t sep_begin,
                   integer_t sep_end, std::vector<integer_t>& upd);
-    virtual ~FrontalMatrix() = default;
+    virtual ~FrontalMatrix();
 
+    integer_t sep() const { return sep_; }
     integer_t sep_begin() const { return sep_begin_; }
     integer_t sep_end() const { return sep_end_; }
     integer_t dim_sep() const { return sep_end_ - sep_begin_; }
@@ -93,6 +98,39 @@ namespace strumpack {
                                            std::size_t& upd2sep) const;
     std::vector<std::size_t> upd_to_parent(const F_t* pa) const;
 
+    /**
+     * Compute the upd_to_parent maps for all fronts in this subtree
+     * (not for this front itself) and store them in the fronts, so
+     * that subsequent calls to upd_to_parent (for instance in the
+     * extend-add) do not need to recompute them. This is used for
+     * numeric refactorization.
+     */
+    void store_upd_to_parent_maps();
+
+    /**
+     * Set the out-of-core storage for the factors of all fronts in
+     * this subtree, or nullptr to keep the factors in memory. Only
+     * used by the dense fronts, see FrontalMatrixDense, others
+     * ignore this.
+     */
+    void set_out_of_core(OutOfCoreStorage<scalar_t>* ooc) {
+      for_each_front([ooc](F_t* f) { f->set_node_out_of_core(ooc); });
+    }
+
+    /**
+     * Write the factors of this front (not of its children) to a
+     * factor file, see SparseSolverBase::save_factors. Returns false
+     * if this is not supported for this type of front.
+     */
+    virtual bool save_factors(FactorFileWriter& f) const { return false; }
+
+    /**
+     * Read the factors written by save_factors. Large arrays can be
+     * used in place, in the memory mapped file, so f should outlive
+     * this front, or the next factorization.
+     */
+    virtual bool load_factors(FactorFileReader& f) { return false; }
+
     virtual void release_work_memory() {
       VectorPool<scalar_t> workspace;
       release_work_memory(workspace);
@@ -116,6 +154,13 @@ namespace strumpack {
     virtual void delete_factors() {}
 
     virtual void multifrontal_solve(DenseM_t& b) const;
+    /**
+     * Solve op(A) x = b, with op(A) = A, A^T or A^H. For op ==
+     * Trans::N this calls the (virtual) multifrontal_solve(b). For
+     * the (conjugate) transpose, the forward sweep solves with
+     * U^op, the backward sweep with L^op.
+     */
+    void multifrontal_solve(Trans op, DenseM_t& b) const;
 
     virtual void
     forward_multifrontal_solve(DenseM_t& b, DenseM_t* work,
@@ -125,17 +170,35 @@ namespace strumpack {
     backward_multifrontal_solve(DenseM_t& y, DenseM_t* work,
                                 int etree_level=0,
                                 int task_depth=0) const;
+    void forward_multifrontal_solve(Trans op, DenseM_t& b, DenseM_t* work,
+                                    int etree_level=0,
+                                    int task_depth=0) const;
+    void backward_multifrontal_solve(Trans op, DenseM_t& y, DenseM_t* work,
+                                     int etree_level=0,
+                                     int task_depth=0) const;
 
     void fwd_solve_phase1(DenseM_t& b, DenseM_t& bupd, DenseM_t* work,
                           int etree_level, int task_depth) const;
+    void fwd_solve_phase1(Trans op, DenseM_t& b, DenseM_t& bupd,
+                          DenseM_t* work, int etree_level,
+                          int task_depth) const;
     virtual
     void fwd_solve_phase2(DenseM_t& b, DenseM_t& bupd,
                           int etree_level, int task_depth) const {};
+    virtual
+    void fwd_solve_phase2(Trans op, DenseM_t& b, DenseM_t& bupd,
+                          int etree_level, int task_depth) const;
     void bwd_solve_phase2(DenseM_t& y, DenseM_t& yupd, DenseM_t* work,
                           int etree_level, int task_depth) const;
+    void bwd_solve_phase2(Trans op, DenseM_t& y, DenseM_t& yupd,
+                          DenseM_t* work, int etree_level,
+                          int task_depth) const;
     virtual
     void bwd_solve_phase1(DenseM_t& y, DenseM_t& yupd,
                           int etree_level, int task_depth) const {};
+    virtual
+    void bwd_solve_phase1(Trans op, DenseM_t& y, DenseM_t& yupd,
+                          int etree_level, int task_depth) const;
 
     ReturnCode inertia(integer_t& neg,
                        integer_t& zero,
@@ -159,6 +222,12 @@ namespace strumpack {
                     DenseM_t& CB, const F_t* p) {
       const std::size_t pdsep = F11.rows();
       const std::size_t dupd = CB.rows();
+      // a parent which only stores its lower triangle (symmetric
+      // mode) does not have an F12 block
+      if (F12.rows() != pdsep) {
+        extend_add_symmetric(F11, F21, F22, CB, p);
+        return;
+      }
       std::size_t upd2sep;
       auto I = upd_to_parent(p, upd2sep);
 #if defined(STRUMPACK_USE_OPENMP_TASKLOOP)
@@ -182,6 +251,38 @@ namespace strumpack {
       STRUMPACK_FULL_RANK_FLOPS((is_complex<scalar_t>()?2:1) * dupd * dupd);
     }
 
+    /**
+     * Extend-add of the lower triangular part of CB into the lower
+     * triangular parts of the parent front [F11 ; F21 F22]. Since
+     * the indices of CB map monotonically to the parent, the lower
+     * triangle of CB maps to the lower triangle of the parent.
+     */
+    void extend_add_symmetric(DenseM_t& F11, DenseM_t& F21, DenseM_t& F22,
+                              const DenseM_t& CB, const F_t* p) {
+      const std::size_t pdsep = F11.rows();
+      const std::size_t dupd = CB.rows();
+      std::size_t upd2sep;
+      auto I = upd_to_parent(p, upd2sep);
+#if defined(STRUMPACK_USE_OPENMP_TASKLOOP)
+#pragma omp taskloop default(shared) grainsize(64)
+#endif
+      for (std::size_t c=0; c<dupd; c++) {
+        auto pc = I[c];
+        if (pc < pdsep) {
+          for (std::size_t r=c; r<upd2sep; r++)
+            F11(I[r],pc) += CB(r,c);
+          for (std::size_t r=std::max(c,upd2sep); r<dupd; r++)
+            F21(I[r]-pdsep,pc) += CB(r,c);
+        } else {
+          for (std::size_t r=c; r<dupd; r++)
+            F22(I[r]-pdsep,pc-pdsep) += CB(r,c);
+        }
+      }
+      STRUMPACK_FLOPS((is_complex<scalar_t>()?2:1) * dupd * (dupd+1) / 2);
+      STRUMPACK_FULL_RANK_FLOPS
+        ((is_complex<scalar_t>()?2:1) * dupd * (dupd+1) / 2);
+    }
+
     virtual void
     extend_add_to_dense(DenseM_t& paF11, DenseM_t& paF12,
                         DenseM_t& paF21, DenseM_t& paF22,
@@ -262,6 +363,13 @@ namespace strumpack {
     virtual bool isHSS() const { return false; }
     virtual bool isMPI() const { return false; }
     virtual bool isGPU() const { return false; }
+    /**
+     * Whether the solve with this front is done by fwd_solve_phase2
+     * and bwd_solve_phase1 only, so that multifrontal_solve can visit
+     * it as a separate node, see FrontScheduler. Fronts that override
+     * forward/backward_multifrontal_solve should return false.
+     */
+    virtual bool front_local_solve() const { return true; }
     virtual void print_rank_statistics(std::ostream &out) const {}
     virtual std::string type() const { return "FrontalMatrix"; }
 
@@ -270,23 +378,22 @@ namespace strumpack {
                      bool is_root=true, int task_depth=0);
     void permute_CB(const integer_t* perm, int task_depth=0);
 
-    int levels() const {
-      int ll = 0, lr = 0;
-      if (lchild_) ll = lchild_->levels();
-      if (rchild_) lr = rchild_->levels();
-      return std::max(ll, lr) + 1;
-    }
+    int levels() const;
 
     void set_lchild(std::unique_ptr<F_t> ch) { lchild_ = std::move(ch); }
     void set_rchild(std::unique_ptr<F_t> ch) { rchild_ = std::move(ch); }
+    const F_t* lchild() const { return lchild_.get(); }
+    const F_t* rchild() const { return rchild_.get(); }
+    F_t* lchild() { return lchild_.get(); }
+    F_t* rchild() { return rchild_.get(); }
 
     // TODO compute this (and levels) once, store it
     // maybe compute it when setting pointers to the children
     // create setters/getters for the children
     integer_t max_dim_upd() const {
-      integer_t max_dupd = dim_upd();
-      if (lchild_) max_dupd = std::max(max_dupd, lchild_->max_dim_upd());
-      if (rchild_) max_dupd = std::max(max_dupd, rchild_->max_dim_upd());
+      integer_t max_dupd = 0;
+      for_each_front([&max_dupd](const F_t* f) {
+        max_dupd = std::max(max_dupd, f->dim_upd()); });
       return max_dupd;
     }
 
@@ -427,10 +534,76 @@ namespace strumpack {
     std::vector<integer_t> upd_;
     std::unique_ptr<F_t> lchild_, rchild_;
 
+    // upd_to_parent map, only stored for numeric refactorization
+    std::vector<std::size_t> upd2pa_;
+    std::size_t upd2pa_sep_ = 0;
+    const F_t* upd2pa_parent_ = nullptr;
+    // storage for the factors, when stored out-of-core
+    OutOfCoreStorage<scalar_t>* ooc_ = nullptr;
+    // scatter plan for extract_front, only for numeric refactorization
+    FrontScatterPlan<scalar_t,integer_t> scatter_;
+
+    /**
+     * Extract the front [F11 F12; F21 0] from the sparse matrix A.
+     * F11, F12 and F21 should be set to zero. With numeric
+     * refactorization, a scatter plan is built on the first call and
+     * used afterwards, see CompressedSparseMatrix::extract_front_plan.
+     */
+    void extract_front(const SpMat_t& A, const Opts_t& opts,
+                       DenseM_t& F11, DenseM_t& F12, DenseM_t& F21,
+                       int task_depth);
+
+    /**
+     * Annotation for an event on this front in the trace, see
+     * TraceScope and SPOptions::set_trace_file.
+     */
+    TraceArgs trace_args(int etree_level) const {
+      TraceArgs a;
+      a.dim_sep = dim_sep();
+      a.dim_upd = dim_upd();
+      a.level = etree_level;
+      return a;
+    }
+
     virtual long long node_factor_nonzeros() const {
       return dense_node_factor_nonzeros();
     }
 
+    /**
+     * Out-of-core storage for the factors of this front only, see
+     * set_out_of_core.
+     */
+    virtual void set_node_out_of_core(OutOfCoreStorage<scalar_t>* ooc) {
+      ooc_ = ooc;
+    }
+
+    /**
+     * Call f(F) for all fronts F in this subtree, each front before
+     * its children, the left subtree before the right subtree. This
+     * uses an explicit stack, not recursion, so it works for
+     * arbitrarily deep trees.
+     */
+    template<typename Visit> void for_each_front(Visit&& f) const {
+      std::vector<const F_t*> s{this};
+      while (!s.empty()) {
+        auto F = s.back();
+        s.pop_back();
+        f(F);
+        if (F->rchild_) s.push_back(F->rchild_.get());
+        if (F->lchild_) s.push_back(F->lchild_.get());
+      }
+    }
+    template<typename Visit> void for_each_front(Visit&& f) {
+      std::vector<F_t*> s{this};
+      while (!s.empty()) {
+        auto F = s.back();
+        s.pop_back();
+        f(F);
+        if (F->rchild_) s.push_back(F->rchild_.get());
+        if (F->lchild_) s.push_back(F->lchild_.get());
+      }
+    }
+
     virtual void partition(const Opts_t& opts, const SpMat_t& A,
                            integer_t* sorder,
                            bool is_root=true, int task_depth=0);
@@ -456,6 +629,13 @@ namespace strumpack {
 
     virtual void draw_node(std::ostream& of, bool is_root) const;
 
+    void tree_solve(Trans op, DenseM_t& b) const;
+
+    // work memory for tree_solve, kept between solves, created on
+    // the first solve
+    mutable std::unique_ptr<VectorPool<scalar_t>> solve_work_;
+    mutable std::once_flag solve_work_once_;
+
     virtual long long dense_node_factor_nonzeros() const {
       long long dsep = dim_sep(), dupd = dim_upd();
       return dsep * (dsep + 2 * dupd);
@@ -33,6 +33,7 @@
 #include "FrontalMatrixBLR.hpp"
 #include "sparse/CSRGraph.hpp"
 #include "misc/TaskTimer.hpp"
+#include "sparse/FactorFile.hpp"
 #include "dense/BLASLAPACKWrapper.hpp"
 #if defined(STRUMPACK_USE_MPI)
 #include "ExtendAdd.hpp"
@@ -306,6 +307,8 @@ namespace strumpack {
         er = rchild_->factor(A, opts, workspace, etree_level+1, task_depth);
     }
     ReturnCode err_code = (el == ReturnCode::SUCCESS) ? er : el;
+    // BLR compression and factorization are interleaved
+    TraceScope trace("compress_factor", this->trace_args(etree_level));
     TaskTimer t("");
 #if defined(STRUMPACK_COUNT_FLOPS)
     long long int f0 = 0, ftot = 0;
@@ -414,19 +417,21 @@ namespace strumpack {
           {
             DenseM_t F11(dsep, dsep), F12(dsep, dupd), F21(dupd, dsep);
             F11.zero(); F12.zero(); F21.zero();
-            A.extract_front
-              (F11, F12, F21, sep_begin_, sep_end_, this->upd_, task_depth);
+            this->extract_front(A, opts, F11, F12, F21, task_depth);
             if (dupd) {
               CBstorage_ = workspace.get(dupd*dupd);
               F22_ = DenseMW_t(dupd, dupd, CBstorage_.data(), dupd);
               F22_.zero();
             }
-            if (lchild_)
-              lchild_->extend_add_to_dense
-                (F11, F12, F21, F22_, this, task_depth);
-            if (rchild_)
-              rchild_->extend_add_to_dense
-                (F11, F12, F21, F22_, this, task_depth);
+            if (lchild_ || rchild_) {
+              TraceScope trace("extend_add", this->trace_args(etree_level));
+              if (lchild_)
+                lchild_->extend_add_to_dense
+                  (F11, F12, F21, F22_, this, task_depth);
+              if (rchild_)
+                rchild_->extend_add_to_dense
+                  (F11, F12, F21, F22_, this, task_depth);
+            }
             if (dsep) {
               auto nF11 = F11.normF();
               auto nF12 = F12.normF();
@@ -484,6 +489,7 @@ namespace strumpack {
     }
     if (lchild_) lchild_->release_work_memory(workspace);
     if (rchild_) rchild_->release_work_memory(workspace);
+    if (trace.active()) trace.set_rank(F11blr_.rank());
     if (opts.print_compressed_front_stats()) {
       auto time = t.elapsed();
       auto nnz = F11blr_.nonzeros();
@@ -578,6 +584,35 @@ namespace strumpack {
     }
   }
 
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrixBLR<scalar_t,integer_t>::fwd_solve_phase2
+  (Trans op, DenseM_t& b, DenseM_t& bupd,
+   int etree_level, int task_depth) const {
+    if (op == Trans::N) {
+      fwd_solve_phase2(b, bupd, etree_level, task_depth);
+      return;
+    }
+    if (dim_sep()) {
+      DenseMW_t bloc(dim_sep(), b.cols(), b, this->sep_begin_, 0);
+      BLRM_t::trsmUN_gemm(op, F11blr_, F12blr_, bloc, bupd, task_depth);
+    }
+  }
+
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrixBLR<scalar_t,integer_t>::bwd_solve_phase1
+  (Trans op, DenseM_t& y, DenseM_t& yupd,
+   int etree_level, int task_depth) const {
+    if (op == Trans::N) {
+      bwd_solve_phase1(y, yupd, etree_level, task_depth);
+      return;
+    }
+    if (dim_sep()) {
+      DenseMW_t yloc(dim_sep(), y.cols(), y, this->sep_begin_, 0);
+      BLRM_t::gemm_trsmLU(op, F11blr_, F21blr_, yloc, yupd, task_depth);
+      yloc.laswp(F11blr_.piv(), false);
+    }
+  }
+
   template<typename scalar_t,typename integer_t> void
   FrontalMatrixBLR<scalar_t,integer_t>::extract_CB_sub_matrix
   (const std::vector<std::size_t>& I, const std::vector<std::size_t>& J,
@@ -737,6 +772,74 @@ namespace strumpack {
   }
 #endif
 
+  template<typename scalar_t> void
+  save_blr_matrix(FactorFileWriter& f, const BLR::BLRMatrix<scalar_t>& M) {
+    std::vector<std::size_t> rt(M.rowblocks()), ct(M.colblocks());
+    for (std::size_t i=0; i<rt.size(); i++) rt[i] = M.tilerows(i);
+    for (std::size_t j=0; j<ct.size(); j++) ct[j] = M.tilecols(j);
+    f.write(M.rows());
+    f.write(rt);
+    f.write(M.cols());
+    f.write(ct);
+    f.write(M.piv());
+    for (std::size_t j=0; j<ct.size(); j++)
+      for (std::size_t i=0; i<rt.size(); i++) {
+        auto& t = M.tile(i, j);
+        f.write(char(t.is_low_rank()));
+        if (t.is_low_rank()) {
+          f.write_matrix(t.U());
+          f.write_matrix(t.V());
+        } else f.write_matrix(t.D());
+      }
+  }
+
+  template<typename scalar_t> void
+  load_blr_matrix(FactorFileReader& f, BLR::BLRMatrix<scalar_t>& M) {
+    std::vector<std::size_t> rt, ct;
+    auto m = f.read<std::size_t>();
+    f.read(rt);
+    auto n = f.read<std::size_t>();
+    f.read(ct);
+    if (!f.good()) return;
+    M = BLR::BLRMatrix<scalar_t>(m, rt, n, ct);
+    f.read(M.piv());
+    for (std::size_t j=0; j<ct.size(); j++)
+      for (std::size_t i=0; i<rt.size(); i++) {
+        if (f.read<char>()) {
+          auto U = f.read_matrix<scalar_t>();
+          auto V = f.read_matrix<scalar_t>();
+          M.block(i, j) = BLR::LRTile<scalar_t>::create_as_wrapper(U, V);
+        } else {
+          auto D = f.read_matrix<scalar_t>();
+          M.block(i, j) = BLR::DenseTile<scalar_t>::create_as_wrapper(D);
+        }
+      }
+  }
+
+  template<typename scalar_t,typename integer_t> bool
+  FrontalMatrixBLR<scalar_t,integer_t>::save_factors
+  (FactorFileWriter& f) const {
+    save_blr_matrix(f, F11blr_);
+    save_blr_matrix(f, F12blr_);
+    save_blr_matrix(f, F21blr_);
+    return f.good();
+  }
+
+  /**
+   * The dense and low-rank tiles are wrappers around the memory
+   * mapped factor file, they are not copied.
+   */
+  template<typename scalar_t,typename integer_t> bool
+  FrontalMatrixBLR<scalar_t,integer_t>::load_factors
+  (FactorFileReader& f) {
+    F22blr_.clear();
+    F22_.clear();
+    load_blr_matrix(f, F11blr_);
+    load_blr_matrix(f, F12blr_);
+    load_blr_matrix(f, F21blr_);
+    return f.good();
+  }
+
   // explicit template instantiations
   template class FrontalMatrixBLR<float,int>;
   template class FrontalMatrixBLR<double,int>;
@@ -98,6 +98,9 @@ namespace strumpack {
 
     std::string type() const override { return "FrontalMatrixBLR"; }
 
+    bool save_factors(FactorFileWriter& f) const override;
+    bool load_factors(FactorFileReader& f) override;
+
 #if defined(STRUMPACK_USE_MPI)
     void
     extend_add_copy_to_buffers(std::vector<std::vector<scalar_t>>& sbuf,
@@ -132,6 +135,10 @@ namespace strumpack {
                           int etree_level, int task_depth) const override;
     void bwd_solve_phase1(DenseM_t& y, DenseM_t& yupd,
                           int etree_level, int task_depth) const override;
+    void fwd_solve_phase2(Trans op, DenseM_t& b, DenseM_t& bupd,
+                          int etree_level, int task_depth) const override;
+    void bwd_solve_phase1(Trans op, DenseM_t& y, DenseM_t& yupd,
+                          int etree_level, int task_depth) const override;
 
     void draw_node(std::ostream& of, bool is_root) const override;
 
@@ -65,7 +65,7 @@ namespace strumpack {
     }
     std::vector<scalar_t,NoInit<scalar_t>> rbuf;
     std::vector<scalar_t*> pbuf;
-    Comm().all_to_all_v(sbuf, rbuf, pbuf);
+    Comm().sparse_all_to_all_v(sbuf, rbuf, pbuf, this->ea_pattern_);
     for (auto& ch : {lchild_.get(), rchild_.get()}) {
       if (!ch) continue;
       ch->extadd_blr_copy_from_buffers
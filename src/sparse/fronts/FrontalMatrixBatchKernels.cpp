@@ -0,0 +1,192 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#include <complex>
+#include <cmath>
+#include <algorithm>
+
+#include "FrontalMatrixBatchKernels.hpp"
+#include "StrumpackParameters.hpp"
+#include "misc/TaskTimer.hpp"
+
+namespace strumpack {
+  namespace batch {
+
+    // same as used by LAPACK i?amax: |re| + |im|
+    template<typename T> inline typename RealType<T>::value_type
+    abs1(const T& a) { return std::abs(a); }
+    template<typename T> inline T abs1(const std::complex<T>& a) {
+      return std::abs(a.real()) + std::abs(a.imag());
+    }
+
+    /*
+     * Partial factorization of a single front, with n1 <= NB. F11 is
+     * copied to a local array with leading dimension NB, which is
+     * factored in place with an unblocked right-looking LU (like
+     * getf2), and then used for the triangular solves with F12 and
+     * F21. F22 is updated column by column, with the inner loop over
+     * the (contiguous) rows of F21 and F22.
+     */
+    template<typename T, int NB, typename real_t> bool
+    factor_block(const FrontData<T>& f, bool replace, real_t thresh) {
+      const int n1 = f.n1, n2 = f.n2;
+      T a[NB*NB];
+      for (int j=0; j<n1; j++)
+        for (int i=0; i<n1; i++)
+          a[i+j*NB] = f.F11[i+j*n1];
+      bool zero_pivot = false;
+      for (int k=0; k<n1; k++) {
+        int p = k;
+        auto pmax = abs1(a[k+k*NB]);
+        for (int i=k+1; i<n1; i++) {
+          auto ai = abs1(a[i+k*NB]);
+          if (ai > pmax) { p = i; pmax = ai; }
+        }
+        f.piv[k] = p + 1;
+        if (a[p+k*NB] == T(0.)) {
+          zero_pivot = true;
+          continue;
+        }
+        if (p != k)
+          for (int j=0; j<n1; j++)
+            std::swap(a[k+j*NB], a[p+j*NB]);
+        const T ikk = T(1.) / a[k+k*NB];
+        for (int i=k+1; i<n1; i++)
+          a[i+k*NB] *= ikk;
+        for (int j=k+1; j<n1; j++) {
+          const T akj = a[k+j*NB];
+          for (int i=k+1; i<n1; i++)
+            a[i+j*NB] -= a[i+k*NB] * akj;
+        }
+      }
+      if (replace)
+        for (int i=0; i<n1; i++)
+          if (std::abs(a[i+i*NB]) < thresh)
+            a[i+i*NB] = (std::real(a[i+i*NB]) < 0) ? -thresh : thresh;
+      for (int j=0; j<n1; j++)
+        for (int i=0; i<n1; i++)
+          f.F11[i+j*n1] = a[i+j*NB];
+      if (!n2) return zero_pivot;
+      // F12 <- L^{-1} P^T F12
+      for (int j=0; j<n2; j++) {
+        T* x = f.F12 + j*n1;
+        for (int k=0; k<n1; k++)
+          if (f.piv[k]-1 != k) std::swap(x[k], x[f.piv[k]-1]);
+        for (int k=0; k<n1; k++) {
+          const T xk = x[k];
+          for (int i=k+1; i<n1; i++)
+            x[i] -= a[i+k*NB] * xk;
+        }
+      }
+      // F21 <- F21 U^{-1}
+      for (int k=0; k<n1; k++) {
+        T* xk = f.F21 + k*n2;
+        for (int l=0; l<k; l++) {
+          const T ulk = a[l+k*NB];
+          const T* xl = f.F21 + l*n2;
+          for (int i=0; i<n2; i++)
+            xk[i] -= xl[i] * ulk;
+        }
+        const T iukk = T(1.) / a[k+k*NB];
+        for (int i=0; i<n2; i++)
+          xk[i] *= iukk;
+      }
+      // F22 <- F22 - F21 F12
+      for (int j=0; j<n2; j++) {
+        T* c = f.F22 + j*n2;
+        for (int l=0; l<n1; l++) {
+          const T blj = f.F12[l+j*n1];
+          const T* al = f.F21 + l*n2;
+          for (int i=0; i<n2; i++)
+            c[i] -= al[i] * blj;
+        }
+      }
+      return zero_pivot;
+    }
+
+    template<typename T, int NB, typename real_t> bool
+    factor_bucket(const std::vector<const FrontData<T>*>& fronts,
+                  bool replace, real_t thresh,
+                  int etree_level, int task_depth) {
+      const std::size_t n = fronts.size();
+      std::vector<char> zero_pivot(n, 0);
+#pragma omp taskloop default(shared)                                    \
+  if(n > 1 && task_depth < params::task_recursion_cutoff_level)
+      for (std::size_t i=0; i<n; i++) {
+        TraceArgs a;
+        a.dim_sep = fronts[i]->n1;
+        a.dim_upd = fronts[i]->n2;
+        a.level = etree_level;
+        TraceScope trace("factor_batch", a);
+        zero_pivot[i] = factor_block<T,NB>(*fronts[i], replace, thresh);
+      }
+      return std::find(zero_pivot.begin(), zero_pivot.end(), 1)
+        != zero_pivot.end();
+    }
+
+    template<typename T, typename real_t> bool
+    factor_batch(const std::vector<FrontData<T>>& fronts,
+                 bool replace, real_t thresh,
+                 int etree_level, int task_depth) {
+      static_assert(max_front_size == 32,
+                    "size buckets should cover max_front_size");
+      std::vector<const FrontData<T>*> b4, b8, b16, b32;
+      for (auto& f : fronts) {
+        if (f.n1 <= 0) continue;
+        assert(f.n1 <= max_front_size);
+        if (f.n1 <= 4) b4.push_back(&f);
+        else if (f.n1 <= 8) b8.push_back(&f);
+        else if (f.n1 <= 16) b16.push_back(&f);
+        else b32.push_back(&f);
+      }
+      bool zero_pivot = false;
+      if (factor_bucket<T,4>(b4, replace, thresh, etree_level, task_depth))
+        zero_pivot = true;
+      if (factor_bucket<T,8>(b8, replace, thresh, etree_level, task_depth))
+        zero_pivot = true;
+      if (factor_bucket<T,16>(b16, replace, thresh, etree_level, task_depth))
+        zero_pivot = true;
+      if (factor_bucket<T,32>(b32, replace, thresh, etree_level, task_depth))
+        zero_pivot = true;
+      return zero_pivot;
+    }
+
+    // explicit template instantiations
+    template bool factor_batch(const std::vector<FrontData<float>>&,
+                               bool, float, int, int);
+    template bool factor_batch(const std::vector<FrontData<double>>&,
+                               bool, double, int, int);
+    template bool factor_batch
+    (const std::vector<FrontData<std::complex<float>>>&, bool, float,
+     int, int);
+    template bool factor_batch
+    (const std::vector<FrontData<std::complex<double>>>&, bool, double,
+     int, int);
+
+  } // end namespace batch
+} // end namespace strumpack
@@ -0,0 +1,100 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#ifndef FRONTAL_MATRIX_BATCH_KERNELS_HPP
+#define FRONTAL_MATRIX_BATCH_KERNELS_HPP
+
+#include <vector>
+
+#include "dense/BLASLAPACKWrapper.hpp"
+
+namespace strumpack {
+  namespace batch {
+
+    /**
+     * Fronts with a separator up to this size can be factored with
+     * the batched small front kernels.
+     */
+    constexpr int max_front_size = 32;
+
+    /**
+     * Maximum update (contribution block) size of a front factored
+     * with the batched kernels. The F12/F21 solves and the F22 update
+     * are plain loops, which are only competitive with BLAS for small
+     * n2. This also bounds the contribution blocks of a level, which
+     * are all allocated at the same time.
+     */
+    constexpr int max_update_size = 2 * max_front_size;
+
+    /**
+     * Maximum number of fronts in a subtree that is factored with the
+     * batched kernels. Larger subtrees are split, so the tree
+     * scheduler still has independent subtrees to run in parallel.
+     */
+    constexpr int max_subtree_fronts = 256;
+
+    /**
+     * Pointers to the blocks of a front, all stored column major,
+     * without padding: F11 is n1 x n1, F12 is n1 x n2, F21 is n2 x n1
+     * and F22 is n2 x n2. piv should have room for n1 (1-based, as
+     * LAPACK) pivots. This is the CPU counterpart of gpu::FrontData.
+     */
+    template<typename T> struct FrontData {
+      FrontData() {}
+      FrontData(int n1_, int n2_, T* F11_, T* F12_,
+                T* F21_, T* F22_, int* piv_)
+        : n1(n1_), n2(n2_), F11(F11_), F12(F12_),
+          F21(F21_), F22(F22_), piv(piv_) {}
+      int n1 = 0, n2 = 0;
+      T *F11 = nullptr, *F12 = nullptr, *F21 = nullptr, *F22 = nullptr;
+      int* piv = nullptr;
+    };
+
+    /**
+     * Partial factorization of a batch of small fronts, with n1 <=
+     * max_front_size and n2 <= max_update_size: F11 = P L U, F12 <- L^{-1} P^T F12, F21 <- F21
+     * U^{-1} and F22 <- F22 - F21 F12. The fronts are grouped by
+     * size, and each group is handled by a kernel with a compile time
+     * bound on n1, which works on a local copy of F11. The fronts in
+     * a group are factored as OpenMP tasks if task_depth is below
+     * params::task_recursion_cutoff_level. Each front is traced as a
+     * "factor_batch" event, at the given etree level.
+     *
+     * \return true if an exact zero pivot was encountered in one of
+     * the fronts (before replacement of tiny pivots)
+     */
+    template<typename T,
+             typename real_t = typename RealType<T>::value_type>
+    bool factor_batch(const std::vector<FrontData<T>>& fronts,
+                      bool replace, real_t thresh,
+                      int etree_level, int task_depth);
+
+  } // end namespace batch
+} // end namespace strumpack
+
+#endif // FRONTAL_MATRIX_BATCH_KERNELS_HPP
@@ -28,6 +28,10 @@
  */
 
 #include "FrontalMatrixDense.hpp"
+#include "FrontalMatrixBatchKernels.hpp"
+#include "FrontScheduler.hpp"
+#include "sparse/OutOfCoreStorage.hpp"
+#include "sparse/FactorFile.hpp"
 #if defined(STRUMPACK_USE_MPI)
 #include "ExtendAdd.hpp"
 #include "FrontalMatrixMPI.hpp"
@@ -75,14 +79,47 @@ namespace strumpack {
   template<typename scalar_t,typename integer_t> ReturnCode
   FrontalMatrixDense<scalar_t,integer_t>::node_inertia
   (integer_t& neg, integer_t& zero, integer_t& pos) const {
-    return matrix_inertia(F11_, neg, zero, pos);
+    using real_t = typename RealType<scalar_t>::value_type;
+    if (sym_ == MatrixSymmetry::POSITIVE_DEFINITE) {
+      pos += dim_sep();
+      return ReturnCode::SUCCESS;
+    }
+    std::unique_ptr<scalar_t[]> buf;
+    DenseMW_t F11, F12, F21;
+    if (!factors(buf, F11, F12, F21)) return ReturnCode::FILE_ERROR;
+    if (sym_ == MatrixSymmetry::SYMMETRIC) {
+      // D from Bunch-Kaufman has 1x1 and 2x2 diagonal blocks, a 2x2
+      // block has one positive and one negative eigenvalue
+      for (std::size_t i=0; i<F11.rows(); i++) {
+        if (piv_[i] < 0) {
+          pos++; neg++; i++;
+        } else {
+          auto Dii = std::real(F11(i, i));
+          if (Dii > real_t(0.)) pos++;
+          else if (Dii < real_t(0.)) neg++;
+          else zero++;
+        }
+      }
+      return ReturnCode::SUCCESS;
+    }
+    return matrix_inertia(F11, neg, zero, pos);
+  }
+
+  template<typename scalar_t,typename integer_t> long long
+  FrontalMatrixDense<scalar_t,integer_t>::node_factor_nonzeros() const {
+    long long dsep = dim_sep(), dupd = dim_upd();
+    if (symmetric()) return dsep * (dsep + 1) / 2 + dsep * dupd;
+    return dsep * (dsep + 2 * dupd);
   }
 
   template<typename scalar_t,typename integer_t> ReturnCode
   FrontalMatrixDense<scalar_t,integer_t>::node_subnormals
   (std::size_t& ns, std::size_t& nz) const {
-    auto dns = F11_.subnormals() + F12_.subnormals() + F21_.subnormals();
-    auto dnz = F11_.zeros() + F12_.zeros() + F21_.zeros();
+    std::unique_ptr<scalar_t[]> buf;
+    DenseMW_t F11, F12, F21;
+    if (!factors(buf, F11, F12, F21)) return ReturnCode::FILE_ERROR;
+    auto dns = F11.subnormals() + F12.subnormals() + F21.subnormals();
+    auto dnz = F11.zeros() + F12.zeros() + F21.zeros();
     // if (dns || dnz)
     //   std::cout << "DENSE front ds= " << this->dim_sep()
     //             << " du= " << this->dim_upd()
@@ -96,8 +133,11 @@ namespace strumpack {
   template<typename scalar_t,typename integer_t> ReturnCode
   FrontalMatrixDense<scalar_t,integer_t>::node_pivot_growth
   (scalar_t& pgL, scalar_t& pgU) const {
-    for (std::size_t i=0; i<F11_.rows(); i++)
-      pgU = std::max(std::abs(pgU), std::abs(F11_(i, i)));
+    std::unique_ptr<scalar_t[]> buf;
+    DenseMW_t F11, F12, F21;
+    if (!factors(buf, F11, F12, F21)) return ReturnCode::FILE_ERROR;
+    for (std::size_t i=0; i<F11.rows(); i++)
+      pgU = std::max(std::abs(pgU), std::abs(F11(i, i)));
     pgL = std::max(std::abs(pgL), std::abs(scalar_t(1.)));
     return ReturnCode::SUCCESS;
   }
@@ -185,74 +225,369 @@ namespace strumpack {
     STRUMPACK_FULL_RANK_FLOPS((is_complex<scalar_t>()?2:1) * dupd * dupd);
   }
 
+  template<typename scalar_t,typename integer_t>
+  FrontalMatrixDense<scalar_t,integer_t>*
+  FrontalMatrixDense<scalar_t,integer_t>::dense_child(F_t* ch) const {
+    if (!ch || !share_factor_memory()) return nullptr;
+    auto d = dynamic_cast<FrontalMatrixDense<scalar_t,integer_t>*>(ch);
+    return (d && d->share_factor_memory()) ? d : nullptr;
+  }
+
+  template<typename scalar_t,typename integer_t> std::size_t
+  FrontalMatrixDense<scalar_t,integer_t>::node_factor_size(bool sym) const {
+    std::size_t dsep = dim_sep(), dupd = dim_upd();
+    return dsep * (dsep + (sym ? 1 : 2) * dupd);
+  }
+
+  template<typename scalar_t,typename integer_t>
+  std::vector<FrontalMatrixDense<scalar_t,integer_t>*>
+  FrontalMatrixDense<scalar_t,integer_t>::dense_subtree() {
+    // preorder, with the right child first, reversed, is postorder
+    std::vector<FrontalMatrixDense<scalar_t,integer_t>*> fs, s{this};
+    while (!s.empty()) {
+      auto f = s.back();
+      s.pop_back();
+      fs.push_back(f);
+      for (auto c : {f->lchild_.get(), f->rchild_.get()})
+        if (auto ch = f->dense_child(c)) s.push_back(ch);
+    }
+    std::reverse(fs.begin(), fs.end());
+    return fs;
+  }
+
+  template<typename scalar_t,typename integer_t> std::size_t
+  FrontalMatrixDense<scalar_t,integer_t>::subtree_factor_size
+  (bool sym, const std::vector<FrontalMatrixDense<scalar_t,integer_t>*>& fs) {
+    std::size_t s = 0;
+    for (auto f : fs) s += f->node_factor_size(sym);
+    return s;
+  }
+
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrixDense<scalar_t,integer_t>::set_factor_memory
+  (bool sym, scalar_t* mem,
+   const std::vector<FrontalMatrixDense<scalar_t,integer_t>*>& fs) {
+    for (auto f : fs) {
+      if (f != this) f->factor_mem_shared_ = true;
+      const std::size_t dsep = f->dim_sep(), dupd = f->dim_upd();
+      f->F11_ = DenseMW_t(dsep, dsep, mem, dsep);  mem += dsep*dsep;
+      if (sym) f->F12_ = DenseMW_t();
+      else { f->F12_ = DenseMW_t(dsep, dupd, mem, dsep);  mem += dsep*dupd; }
+      f->F21_ = DenseMW_t(dupd, dsep, mem, dupd);  mem += dupd*dsep;
+    }
+  }
+
+  /**
+   * Called from the top front of a dense subtree. Computes the total
+   * factor size of that subtree, and (re)allocates it if needed, so
+   * there is no allocation for the factors of the individual fronts
+   * during the numerical factorization.
+   */
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrixDense<scalar_t,integer_t>::allocate_factor_memory
+  (const Opts_t& opts) {
+    bool sym = opts.matrix_symmetry() != MatrixSymmetry::UNSYMMETRIC;
+    auto fs = dense_subtree();
+    auto s = subtree_factor_size(sym, fs);
+    if (s != factor_mem_size_) {
+      release_factor_memory();
+      if (s) factor_mem_.reset(new scalar_t[s]);
+      factor_mem_size_ = s;
+      STRUMPACK_ADD_MEMORY(s*sizeof(scalar_t));
+    }
+    set_factor_memory(sym, factor_mem_.get(), fs);
+  }
+
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrixDense<scalar_t,integer_t>::release_factor_memory() {
+    F11_.clear();
+    F12_.clear();
+    F21_.clear();
+    STRUMPACK_SUB_MEMORY(factor_mem_size_*sizeof(scalar_t));
+    factor_mem_.reset();
+    factor_mem_size_ = 0;
+  }
+
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrixDense<scalar_t,integer_t>::set_node_out_of_core
+  (OutOfCoreStorage<scalar_t>* ooc) {
+    // the factors are no longer stored per dense subtree (or they
+    // are again), so the factor memory needs to be reallocated
+    release_factor_memory();
+    factor_mem_shared_ = false;
+    small_subtree_ = -1;
+    ooc_stored_ = false;
+    F_t::set_node_out_of_core(ooc);
+  }
+
+  template<typename scalar_t,typename integer_t> bool
+  FrontalMatrixDense<scalar_t,integer_t>::save_factors
+  (FactorFileWriter& f) const {
+    std::unique_ptr<scalar_t[]> buf;
+    DenseMW_t F11, F12, F21;
+    if (!factors(buf, F11, F12, F21)) return false;
+    f.write(sym_);
+    f.write(piv_);
+    f.write_matrix(F11);
+    f.write_matrix(F12);
+    f.write_matrix(F21);
+    return f.good();
+  }
+
+  /**
+   * The factors are used in place, in the memory mapped file. They
+   * are not owned by this front, so they are not shared with the
+   * dense subtree, and the next factorization allocates new memory.
+   */
+  template<typename scalar_t,typename integer_t> bool
+  FrontalMatrixDense<scalar_t,integer_t>::load_factors
+  (FactorFileReader& f) {
+    release_factor_memory();
+    factor_mem_shared_ = false;
+    ooc_stored_ = false;
+    f.read(sym_);
+    f.read(piv_);
+    F11_ = f.read_matrix<scalar_t>();
+    F12_ = f.read_matrix<scalar_t>();
+    F21_ = f.read_matrix<scalar_t>();
+    return f.good();
+  }
+
+  /**
+   * Hand over the factors of this front to the out-of-core storage,
+   * if used. The pivots are kept in memory.
+   */
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrixDense<scalar_t,integer_t>::write_factors() {
+    if (!this->ooc_ || !factor_mem_) return;
+    F11_.clear();
+    F12_.clear();
+    F21_.clear();
+    STRUMPACK_SUB_MEMORY(factor_mem_size_*sizeof(scalar_t));
+    ooc_id_ = this->ooc_->write(std::move(factor_mem_), factor_mem_size_);
+    factor_mem_size_ = 0;
+    ooc_stored_ = true;
+  }
+
+  /**
+   * Get (wrappers to) the factors, reading them from the out-of-core
+   * storage into buf if needed. The layout is the same as in
+   * set_factor_memory. Returns false if the factors could not be
+   * read.
+   */
+  template<typename scalar_t,typename integer_t> bool
+  FrontalMatrixDense<scalar_t,integer_t>::factors
+  (std::unique_ptr<scalar_t[]>& buf, DenseMW_t& F11, DenseMW_t& F12,
+   DenseMW_t& F21) const {
+    if (!ooc_stored_) {
+      F11 = DenseMW_t(F11_.rows(), F11_.cols(),
+                      const_cast<scalar_t*>(F11_.data()), F11_.ld());
+      F12 = DenseMW_t(F12_.rows(), F12_.cols(),
+                      const_cast<scalar_t*>(F12_.data()), F12_.ld());
+      F21 = DenseMW_t(F21_.rows(), F21_.cols(),
+                      const_cast<scalar_t*>(F21_.data()), F21_.ld());
+      return true;
+    }
+    buf = this->ooc_->read(ooc_id_);
+    if (!buf) return false;
+    const std::size_t dsep = dim_sep(), dupd = dim_upd();
+    auto mem = buf.get();
+    F11 = DenseMW_t(dsep, dsep, mem, dsep);  mem += dsep*dsep;
+    if (!symmetric()) {
+      F12 = DenseMW_t(dsep, dupd, mem, dsep);  mem += dsep*dupd;
+    }
+    F21 = DenseMW_t(dupd, dsep, mem, dupd);
+    return true;
+  }
+
+  /**
+   * The dense fronts in this subtree are factored from a postorder
+   * list, without recursion, see FrontScheduler. Other fronts
+   * (compressed, lossy, ..) and subtrees for the batched small front
+   * kernels are a single node in the schedule, factored through
+   * their own factor routine. With use_static_tree_mapping, the
+   * subtrees are mapped to the threads with proportional mapping.
+   */
   template<typename scalar_t,typename integer_t> ReturnCode
   FrontalMatrixDense<scalar_t,integer_t>::factor
   (const SpMat_t& A, const Opts_t& opts, VectorPool<scalar_t>& workspace,
    int etree_level, int task_depth) {
-    ReturnCode e1, e2;
-    if (task_depth == 0) {
-#pragma omp parallel if(!omp_in_parallel()) default(shared)
-#pragma omp single nowait
-      {
-        e1 = factor_phase1(A, opts, workspace, etree_level, task_depth+1);
-        e2 = factor_phase2(A, opts, etree_level, task_depth);
+    using FD_t = FrontalMatrixDense<scalar_t,integer_t>;
+    // with out-of-core storage, the factor memory is only allocated
+    // after the children are done
+    if (!factor_mem_shared_ && !this->ooc_)
+      allocate_factor_memory(opts);
+    const bool batch = !opts.symmetric() && opts.small_front_batching();
+    if (batch && small_subtree())
+      return factor_small_subtree
+        (A, opts, workspace, etree_level, task_depth);
+    auto dense = [&](F_t* f) -> FD_t* {
+      if (f == this) return this;
+      if (typeid(*f) != typeid(FD_t)) return nullptr;
+      auto d = static_cast<FD_t*>(f);
+      return (batch && d->small_subtree()) ? nullptr : d;
+    };
+    FrontScheduler<F_t> sched
+      (this, [&](F_t* f) { return dense(f) != nullptr; },
+       [](const F_t* f) {
+        double s = f->dim_sep(), u = f->dim_upd();
+        return s * s * (2. / 3. * s + 2. * u) + 2. * s * u * u; });
+    if (opts.use_static_tree_mapping() && opts.use_openmp_tree())
+      sched.map_to_threads(opts.proportional_mapping());
+    const auto N = sched.size();
+    std::vector<FD_t*> fd(N);
+    for (std::size_t i=0; i<N; i++)
+      fd[i] = sched.expanded(i) ? static_cast<FD_t*>(sched.node(i)) : nullptr;
+    // the children of a symmetric dense front only need to compute
+    // the lower triangle of their contribution block
+    if (opts.symmetric())
+      for (auto f : fd)
+        if (f)
+          for (auto c : {f->lchild_.get(), f->rchild_.get()})
+            if (c && typeid(*c) == typeid(FD_t))
+              static_cast<FD_t*>(c)->lower_CB_only_ = true;
+    // the factor memory is allocated top-down, before the children
+    // are factored, by the top front of each dense subtree
+    for (std::size_t i=N-1; i-->0; )
+      if (fd[i] && !fd[i]->factor_mem_shared_ && !fd[i]->ooc_)
+        fd[i]->allocate_factor_memory(opts);
+    std::vector<ReturnCode> err(N, ReturnCode::SUCCESS);
+    sched.bottom_up([&](std::size_t i, int d) {
+      auto l = etree_level + sched.level(i);
+      auto f = fd[i];
+      if (!f) {
+        err[i] = sched.node(i)->factor(A, opts, workspace, l, d);
+        return;
       }
-    } else {
-      e1 = factor_phase1(A, opts, workspace, etree_level, task_depth);
-      e2 = factor_phase2(A, opts, etree_level, task_depth);
-    }
-    return (e1 == ReturnCode::SUCCESS) ? e2 : e1;
+      if (f->ooc_) f->allocate_factor_memory(opts);
+      f->assemble(A, opts, workspace, l, d);
+      err[i] = f->factor_phase2(A, opts, l, d);
+      f->write_factors();
+    }, task_depth, opts.use_openmp_tree());
+    for (auto e : err)
+      if (e != ReturnCode::SUCCESS) return e;
+    return ReturnCode::SUCCESS;
   }
 
-  template<typename scalar_t,typename integer_t> ReturnCode
-  FrontalMatrixDense<scalar_t,integer_t>::factor_phase1
+  /**
+   * Assemble the front from the sparse matrix and the contribution
+   * blocks of the children, which should already be factored.
+   */
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrixDense<scalar_t,integer_t>::assemble
   (const SpMat_t& A, const Opts_t& opts, VectorPool<scalar_t>& workspace,
    int etree_level, int task_depth) {
-    ReturnCode el = ReturnCode::SUCCESS, er = ReturnCode::SUCCESS;
-    if (opts.use_openmp_tree() &&
-        task_depth < params::task_recursion_cutoff_level) {
-      if (lchild_)
-#pragma omp task default(shared)                                        \
-  final(task_depth >= params::task_recursion_cutoff_level-1) mergeable
-        el = lchild_->factor(A, opts, workspace, etree_level+1, task_depth+1);
-      if (rchild_)
-#pragma omp task default(shared)                                        \
-  final(task_depth >= params::task_recursion_cutoff_level-1) mergeable
-        er = rchild_->factor(A, opts, workspace, etree_level+1, task_depth+1);
-#pragma omp taskwait
-    } else {
-      if (lchild_)
-        el = lchild_->factor(A, opts, workspace, etree_level+1, task_depth);
-      if (rchild_)
-        er = rchild_->factor(A, opts, workspace, etree_level+1, task_depth);
-    }
-    ReturnCode err_code = (el == ReturnCode::SUCCESS) ? er : el;
-    // TODO can we allocate the memory in one go??
-    const auto dsep = dim_sep();
     const auto dupd = dim_upd();
-    F11_ = DenseM_t(dsep, dsep); F11_.zero();
-    F12_ = DenseM_t(dsep, dupd); F12_.zero();
-    F21_ = DenseM_t(dupd, dsep); F21_.zero();
-    A.extract_front
-      (F11_, F12_, F21_, this->sep_begin_, this->sep_end_,
-       this->upd_, task_depth);
+    sym_ = opts.matrix_symmetry();
+    // F11, F12 and F21 are (contiguous) views in the factor memory,
+    // see allocate_factor_memory. For symmetric fronts, only F11
+    // (lower) and F21 are stored.
+    F11_.zero();
+    F12_.zero();
+    F21_.zero();
+    this->extract_front(A, opts, F11_, F12_, F21_, task_depth);
     if (dupd) {
-      CBstorage_ = workspace.get();
-      integer_t old_size = CBstorage_.size();
-      if (dupd*dupd > old_size) {
-        STRUMPACK_ADD_MEMORY((dupd*dupd - old_size)*sizeof(scalar_t));
-      }
-      CBstorage_.resize(dupd*dupd);
+      CBstorage_ = workspace.get(dupd*dupd);
       F22_ = DenseMW_t(dupd, dupd, CBstorage_.data(), dupd);
       F22_.zero();
     }
-    if (lchild_)
-      lchild_->extend_add_to_dense
-        (F11_, F12_, F21_, F22_, this, workspace, task_depth);
-    if (rchild_)
-      rchild_->extend_add_to_dense
-        (F11_, F12_, F21_, F22_, this, workspace, task_depth);
+    if (lchild_ || rchild_) {
+      TraceScope trace("extend_add", this->trace_args(etree_level));
+      if (lchild_)
+        lchild_->extend_add_to_dense
+          (F11_, F12_, F21_, F22_, this, workspace, task_depth);
+      if (rchild_)
+        rchild_->extend_add_to_dense
+          (F11_, F12_, F21_, F22_, this, workspace, task_depth);
+    }
     if (etree_level == 0 && opts.write_root_front()) F11_.write("Froot");
+  }
+
+  /**
+   * Check whether all fronts in the subtree rooted at this front are
+   * dense, with a separator and update set small enough for the
+   * batched kernels, and whether the subtree has at most
+   * batch::max_subtree_fronts fronts.
+   */
+  template<typename scalar_t,typename integer_t> bool
+  FrontalMatrixDense<scalar_t,integer_t>::small_subtree() {
+    if (small_subtree_ == -1) {
+      // children are evaluated before their parents, without recursion
+      std::vector<FrontalMatrixDense<scalar_t,integer_t>*> fs{this};
+      for (std::size_t i=0; i<fs.size(); i++)
+        for (auto c : {fs[i]->lchild_.get(), fs[i]->rchild_.get()}) {
+          auto ch = fs[i]->dense_child(c);
+          if (ch && ch->small_subtree_ == -1) fs.push_back(ch);
+        }
+      for (auto f=fs.rbegin(); f!=fs.rend(); f++) {
+        bool small = (*f)->share_factor_memory() &&
+          (*f)->dim_sep() <= batch::max_front_size &&
+          (*f)->dim_upd() <= batch::max_update_size;
+        int nf = 1;
+        for (auto c : {(*f)->lchild_.get(), (*f)->rchild_.get()})
+          if (c) {
+            auto ch = (*f)->dense_child(c);
+            small = small && ch && ch->small_subtree_;
+            if (small) nf += ch->small_subtree_;
+          }
+        (*f)->small_subtree_ =
+          (small && nf <= batch::max_subtree_fronts) ? nf : 0;
+      }
+    }
+    return small_subtree_;
+  }
+
+  /**
+   * Factor a subtree with only small dense fronts, level by level
+   * from the leaves up. All fronts in a level are assembled, and then
+   * factored as a batch, see batch::factor_batch. Both steps use
+   * OpenMP tasks over the fronts of the level, if task_depth allows.
+   */
+  template<typename scalar_t,typename integer_t> ReturnCode
+  FrontalMatrixDense<scalar_t,integer_t>::factor_small_subtree
+  (const SpMat_t& A, const Opts_t& opts, VectorPool<scalar_t>& workspace,
+   int etree_level, int task_depth) {
+    std::vector<std::vector<FrontalMatrixDense<scalar_t,integer_t>*>> lvls;
+    lvls.push_back({this});
+    while (true) {
+      std::vector<FrontalMatrixDense<scalar_t,integer_t>*> next;
+      for (auto f : lvls.back())
+        for (auto c : {f->lchild_.get(), f->rchild_.get()})
+          if (c) next.push_back(dense_child(c));
+      if (next.empty()) break;
+      lvls.push_back(std::move(next));
+    }
+    ReturnCode err_code = ReturnCode::SUCCESS;
+    std::vector<batch::FrontData<scalar_t>> fd;
+    const bool tasks = task_depth < params::task_recursion_cutoff_level;
+    for (int l=lvls.size()-1; l>=0; l--) {
+      const std::size_t nl = lvls[l].size();
+      fd.resize(nl);
+#pragma omp taskloop default(shared) if(tasks && nl > 1)
+      for (std::size_t i=0; i<nl; i++) {
+        auto f = lvls[l][i];
+        f->assemble(A, opts, workspace, etree_level+l, task_depth+1);
+        f->piv_.resize(f->dim_sep());
+        fd[i] = batch::FrontData<scalar_t>
+          (f->dim_sep(), f->dim_upd(), f->F11_.data(), f->F12_.data(),
+           f->F21_.data(), f->F22_.data(), f->piv_.data());
+      }
+      if (batch::factor_batch
+          (fd, opts.replace_tiny_pivots(), opts.pivot_threshold(),
+           etree_level+l, task_depth))
+        err_code = ReturnCode::ZERO_PIVOT;
+#if defined(STRUMPACK_COUNT_FLOPS)
+      for (auto f : lvls[l]) {
+        auto flops = LU_flops(f->F11_) +
+          gemm_flops(Trans::N, Trans::N, scalar_t(-1.),
+                     f->F21_, f->F12_, scalar_t(1.)) +
+          trsm_flops(Side::L, scalar_t(1.), f->F11_, f->F12_) +
+          trsm_flops(Side::R, scalar_t(1.), f->F11_, f->F21_);
+        STRUMPACK_FLOPS(flops);
+        STRUMPACK_FULL_RANK_FLOPS(flops);
+      }
+#endif
+    }
     return err_code;
   }
 
@@ -260,6 +595,9 @@ namespace strumpack {
   FrontalMatrixDense<scalar_t,integer_t>::factor_phase2
   (const SpMat_t& A, const Opts_t& opts,
    int etree_level, int task_depth) {
+    TraceScope trace("factor", this->trace_args(etree_level));
+    if (symmetric())
+      return factor_phase2_symmetric(opts, task_depth);
     ReturnCode err_code = ReturnCode::SUCCESS;
     if (dim_sep()) {
       if (F11_.LU(piv_, task_depth))
@@ -288,22 +626,142 @@ namespace strumpack {
     return err_code;
   }
 
+  /**
+   * Symmetric factorization of the front, storing only the lower
+   * triangular part: F11 = L11 L11^H (Cholesky) or F11 = L11 D11
+   * L11^T (Bunch-Kaufman), and the lower triangle of the Schur
+   * complement F22 - F21 F11^{-1} F21^{T/H}. For Cholesky, F21 is
+   * overwritten with F21 L11^{-H}. For LDL^T, F21 is kept as is and
+   * F11^{-1} is applied through the LDL^T factors in the solve.
+   */
+  template<typename scalar_t,typename integer_t> ReturnCode
+  FrontalMatrixDense<scalar_t,integer_t>::factor_phase2_symmetric
+  (const Opts_t& opts, int task_depth) {
+    using real_t = typename RealType<scalar_t>::value_type;
+    ReturnCode err_code = ReturnCode::SUCCESS;
+    const int dsep = dim_sep(), dupd = dim_upd();
+    if (!dsep) return err_code;
+    if (sym_ == MatrixSymmetry::POSITIVE_DEFINITE) {
+      // potrf stops at the first non-positive pivot, so when tiny
+      // pivots should be replaced, keep a copy of F11 and redo the
+      // factorization column by column if potrf fails
+      DenseM_t F11copy;
+      if (opts.replace_tiny_pivots()) F11copy = F11_;
+      if (blas::potrf('L', dsep, F11_.data(), F11_.ld())) {
+        err_code = ReturnCode::ZERO_PIVOT;
+        if (opts.replace_tiny_pivots()) {
+          F11_.copy(F11copy);
+          auto thresh = opts.pivot_threshold();
+          for (int j=0; j<dsep; j++) {
+            auto d = std::real(F11_(j,j));
+            for (int k=0; k<j; k++)
+              d -= std::norm(F11_(j,k));
+            d = (d < thresh) ? std::sqrt(thresh) : std::sqrt(d);
+            F11_(j,j) = d;
+            for (int i=j+1; i<dsep; i++) {
+              auto s = F11_(i,j);
+              for (int k=0; k<j; k++)
+                s -= F11_(i,k) * blas::my_conj(F11_(j,k));
+              F11_(i,j) = s / d;
+            }
+          }
+        }
+      }
+      if (dupd) {
+        trsm(Side::R, UpLo::L, Trans::C, Diag::N,
+             scalar_t(1.), F11_, F21_, task_depth);
+        blas::herk('L', 'N', dupd, dsep, real_t(-1.), F21_.data(), F21_.ld(),
+                   real_t(1.), F22_.data(), F22_.ld());
+      }
+      STRUMPACK_FULL_RANK_FLOPS
+        ((is_complex<scalar_t>() ? 4 : 1) *
+         (blas::potrf_flops(dsep) + blas::herk_flops(dupd, dsep)) +
+         trsm_flops(Side::R, scalar_t(1.), F11_, F21_));
+    } else {
+      piv_.resize(dsep);
+      if (blas::sytrf('L', dsep, F11_.data(), F11_.ld(), piv_.data()))
+        err_code = ReturnCode::ZERO_PIVOT;
+      if (opts.replace_tiny_pivots()) {
+        // only the 1x1 blocks of D, the 2x2 blocks are only selected
+        // by sytrf when they are well conditioned
+        auto thresh = opts.pivot_threshold();
+        for (int i=0; i<dsep; i++)
+          if (piv_[i] > 0 && std::abs(F11_(i,i)) < thresh)
+            F11_(i,i) = (std::real(F11_(i,i)) < 0) ? -thresh : thresh;
+      }
+      if (dupd) {
+        // X = F11^{-1} F21^T, then the lower triangle of F22 - F21 X
+        // is updated per block column, halving the gemm flops
+        DenseM_t X(dsep, dupd);
+        blas::omatcopy('T', dupd, dsep, F21_.data(), F21_.ld(),
+                       X.data(), X.ld());
+        F11_.solve_LDLt_in_place(X, piv_, task_depth);
+        const int B = 64;
+        for (int c=0; c<dupd; c+=B) {
+          const int nc = std::min(B, dupd-c);
+          DenseMW_t F22c(dupd-c, nc, F22_, c, c),
+            F21c(dupd-c, dsep, F21_, c, 0), Xc(dsep, nc, X, 0, c);
+          gemm(Trans::N, Trans::N, scalar_t(-1.), F21c, Xc,
+               scalar_t(1.), F22c, task_depth);
+        }
+      }
+      STRUMPACK_FULL_RANK_FLOPS
+        ((is_complex<scalar_t>() ? 4 : 1) *
+         (blas::sytrf_flops(dsep) + blas::sytrs_flops(dsep, dsep, dupd) +
+          blas::herk_flops(dupd, dsep)));
+    }
+    // The upper triangle of the contribution block is not needed by
+    // a symmetric dense parent, but other (compressed or distributed)
+    // parents expect the full CB.
+    if (lower_CB_only_) return err_code;
+    if (sym_ == MatrixSymmetry::POSITIVE_DEFINITE) {
+      for (int c=1; c<dupd; c++)
+        for (int r=0; r<c; r++)
+          F22_(r, c) = blas::my_conj(F22_(c, r));
+    } else {
+      for (int c=1; c<dupd; c++)
+        for (int r=0; r<c; r++)
+          F22_(r, c) = F22_(c, r);
+    }
+    return err_code;
+  }
+
   template<typename scalar_t,typename integer_t> void
   FrontalMatrixDense<scalar_t,integer_t>::fwd_solve_phase2
   (DenseM_t& b, DenseM_t& bupd, int etree_level, int task_depth) const {
+    std::unique_ptr<scalar_t[]> buf;
+    DenseMW_t F11, F12, F21;
+    // a read error is reported by the solver, see
+    // OutOfCoreStorage::read_errors
+    if (!factors(buf, F11, F12, F21)) return;
+    if (dim_sep() && symmetric()) {
+      DenseMW_t bloc(dim_sep(), b.cols(), b, this->sep_begin_, 0);
+      if (sym_ == MatrixSymmetry::POSITIVE_DEFINITE) {
+        // bloc = L11^{-1} bloc, bupd -= (F21 L11^{-H}) bloc
+        trsm(Side::L, UpLo::L, Trans::N, Diag::N,
+             scalar_t(1.), F11, bloc, task_depth);
+      } else {
+        // bloc = F11^{-1} bloc, bupd -= F21 bloc
+        F11.solve_LDLt_in_place(bloc, piv_, task_depth);
+      }
+      if (dim_upd())
+        gemm(Trans::N, Trans::N, scalar_t(-1.), F21, bloc,
+             scalar_t(1.), bupd, task_depth);
+      return;
+    }
     if (dim_sep()) {
       DenseMW_t bloc(dim_sep(), b.cols(), b, this->sep_begin_, 0);
       bloc.laswp(piv_, true);
       if (b.cols() == 1) {
-        trsv(UpLo::L, Trans::N, Diag::U, F11_, bloc, task_depth);
+        trsv(UpLo::L, Trans::N, Diag::U, F11, bloc, task_depth);
         if (dim_upd())
-          gemv(Trans::N, scalar_t(-1.), F21_, bloc,
+          gemv(Trans::N, scalar_t(-1.), F21, bloc,
                scalar_t(1.), bupd, task_depth);
       } else {
         trsm(Side::L, UpLo::L, Trans::N, Diag::U,
-             scalar_t(1.), F11_, bloc, task_depth);
+             scalar_t(1.), F11, bloc, task_depth);
         if (dim_upd())
-          gemm(Trans::N, Trans::N, scalar_t(-1.), F21_, bloc,
+          gemm(Trans::N, Trans::N, scalar_t(-1.), F21, bloc,
                scalar_t(1.), bupd, task_depth);
       }
     }
@@ -312,23 +770,99 @@ namespace strumpack {
   template<typename scalar_t,typename integer_t> void
   FrontalMatrixDense<scalar_t,integer_t>::bwd_solve_phase1
   (DenseM_t& y, DenseM_t& yupd, int etree_level, int task_depth) const {
+    std::unique_ptr<scalar_t[]> buf;
+    DenseMW_t F11, F12, F21;
+    if (!factors(buf, F11, F12, F21)) return;
+    if (dim_sep() && symmetric()) {
+      DenseMW_t yloc(dim_sep(), y.cols(), y, this->sep_begin_, 0);
+      if (sym_ == MatrixSymmetry::POSITIVE_DEFINITE) {
+        // yloc = L11^{-H} (yloc - (F21 L11^{-H})^H yupd)
+        if (dim_upd())
+          gemm(Trans::C, Trans::N, scalar_t(-1.), F21, yupd,
+               scalar_t(1.), yloc, task_depth);
+        trsm(Side::L, UpLo::L, Trans::C, Diag::N, scalar_t(1.),
+             F11, yloc, task_depth);
+      } else if (dim_upd()) {
+        // yloc = yloc - F11^{-1} F21^T yupd
+        DenseM_t t(dim_sep(), y.cols());
+        gemm(Trans::T, Trans::N, scalar_t(1.), F21, yupd,
+             scalar_t(0.), t, task_depth);
+        F11.solve_LDLt_in_place(t, piv_, task_depth);
+        yloc.scaled_add(scalar_t(-1.), t);
+      }
+      return;
+    }
     if (dim_sep()) {
       DenseMW_t yloc(dim_sep(), y.cols(), y, this->sep_begin_, 0);
       if (y.cols() == 1) {
         if (dim_upd())
-          gemv(Trans::N, scalar_t(-1.), F12_, yupd,
+          gemv(Trans::N, scalar_t(-1.), F12, yupd,
                scalar_t(1.), yloc, task_depth);
-        trsv(UpLo::U, Trans::N, Diag::N, F11_, yloc, task_depth);
+        trsv(UpLo::U, Trans::N, Diag::N, F11, yloc, task_depth);
       } else {
         if (dim_upd())
-          gemm(Trans::N, Trans::N, scalar_t(-1.), F12_, yupd,
+          gemm(Trans::N, Trans::N, scalar_t(-1.), F12, yupd,
                scalar_t(1.), yloc, task_depth);
         trsm(Side::L, UpLo::U, Trans::N, Diag::N, scalar_t(1.),
-             F11_, yloc, task_depth);
+             F11, yloc, task_depth);
       }
     }
   }
 
+  /**
+   * With F11 = P^T L11 U11, F12 <- L11^{-1} P F12 and F21 <- F21
+   * U11^{-1}, the forward solve with op(A) is y1 = U11^{-op} b1,
+   * bupd -= F12^op y1.
+   */
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrixDense<scalar_t,integer_t>::fwd_solve_phase2
+  (Trans op, DenseM_t& b, DenseM_t& bupd,
+   int etree_level, int task_depth) const {
+    if (op == Trans::N) {
+      fwd_solve_phase2(b, bupd, etree_level, task_depth);
+      return;
+    }
+    std::unique_ptr<scalar_t[]> buf;
+    DenseMW_t F11, F12, F21;
+    if (!factors(buf, F11, F12, F21)) return;
+    // symmetric fronts are handled by the solver, op(A) is A or conj(A)
+    assert(!symmetric());
+    if (dim_sep()) {
+      DenseMW_t bloc(dim_sep(), b.cols(), b, this->sep_begin_, 0);
+      trsm(Side::L, UpLo::U, op, Diag::N, scalar_t(1.), F11, bloc,
+           task_depth);
+      if (dim_upd())
+        gemm(op, Trans::N, scalar_t(-1.), F12, bloc,
+             scalar_t(1.), bupd, task_depth);
+    }
+  }
+
+  /**
+   * Backward solve with op(A): y1 = P^T L11^{-op} (y1 - F21^op yupd).
+   */
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrixDense<scalar_t,integer_t>::bwd_solve_phase1
+  (Trans op, DenseM_t& y, DenseM_t& yupd,
+   int etree_level, int task_depth) const {
+    if (op == Trans::N) {
+      bwd_solve_phase1(y, yupd, etree_level, task_depth);
+      return;
+    }
+    std::unique_ptr<scalar_t[]> buf;
+    DenseMW_t F11, F12, F21;
+    if (!factors(buf, F11, F12, F21)) return;
+    assert(!symmetric());
+    if (dim_sep()) {
+      DenseMW_t yloc(dim_sep(), y.cols(), y, this->sep_begin_, 0);
+      if (dim_upd())
+        gemm(op, Trans::N, scalar_t(-1.), F21, yupd,
+             scalar_t(1.), yloc, task_depth);
+      trsm(Side::L, UpLo::L, op, Diag::U, scalar_t(1.), F11, yloc,
+           task_depth);
+      yloc.laswp(piv_, false);
+    }
+  }
+
   template<typename scalar_t,typename integer_t> void
   FrontalMatrixDense<scalar_t,integer_t>::extract_CB_sub_matrix
   (const std::vector<std::size_t>& I, const std::vector<std::size_t>& J,
@@ -499,13 +1033,25 @@ namespace strumpack {
 
   template<typename scalar_t,typename integer_t> void
   FrontalMatrixDense<scalar_t,integer_t>::delete_factors() {
-    if (lchild_) lchild_->delete_factors();
-    if (rchild_) rchild_->delete_factors();
-    F11_ = DenseM_t();
-    F12_ = DenseM_t();
-    F21_ = DenseM_t();
-    F22_ = DenseMW_t();
-    piv_ = std::vector<int>();
+    // the dense fronts in the subtree are handled here, without
+    // recursion, other front types through their own delete_factors
+    std::vector<F_t*> s{this};
+    while (!s.empty()) {
+      auto f = s.back();
+      s.pop_back();
+      auto fd = dynamic_cast<FrontalMatrixDense<scalar_t,integer_t>*>(f);
+      if (!fd) {
+        f->delete_factors();
+        continue;
+      }
+      for (auto ch : {fd->lchild_.get(), fd->rchild_.get()})
+        if (ch) s.push_back(ch);
+      fd->release_factor_memory();
+      fd->factor_mem_shared_ = false;
+      fd->ooc_stored_ = false;
+      fd->F22_ = DenseMW_t();
+      fd->piv_ = std::vector<int>();
+    }
   }
 
 #if defined(STRUMPACK_USE_MPI)
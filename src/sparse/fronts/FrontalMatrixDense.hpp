@@ -34,6 +34,7 @@
 #include <algorithm>
 #include <cmath>
 #include <random>
+#include <memory>
 
 #include "FrontalMatrix.hpp"
 #if defined(STRUMPACK_USE_MPI)
@@ -91,6 +92,11 @@ namespace strumpack {
     void sample_CB_to_F22(Trans op, const DenseM_t& R, DenseM_t& S, F_t* pa,
                           int task_depth=0) const override;
 
+    void set_node_out_of_core(OutOfCoreStorage<scalar_t>* ooc) override;
+
+    bool save_factors(FactorFileWriter& f) const override;
+    bool load_factors(FactorFileReader& f) override;
+
     virtual ReturnCode
     multifrontal_factorization(const SpMat_t& A, const Opts_t& opts,
                                int etree_level=0, int task_depth=0) override {
@@ -130,19 +136,70 @@ namespace strumpack {
     scalar_t* get_device_F22(scalar_t* dF22) override;
 
   protected:
-    DenseM_t F11_, F12_, F21_;
-    DenseMW_t F22_;
+    DenseMW_t F11_, F12_, F21_, F22_;
     std::vector<scalar_t,NoInit<scalar_t>> CBstorage_;
+    /**
+     * Memory for the factors F11, F12 and F21 of all fronts in the
+     * dense subtree rooted at this front, allocated in one go before
+     * the numerical factorization. This is only owned by the top
+     * front of such a subtree. The factors of each front are stored
+     * contiguously, in postorder, and F11_, F12_ and F21_ are views
+     * into this memory.
+     */
+    std::unique_ptr<scalar_t[]> factor_mem_;
+    std::size_t factor_mem_size_ = 0;
+    bool factor_mem_shared_ = false;
     std::vector<int> piv_; // regular int because it is passed to BLAS
+    MatrixSymmetry sym_ = MatrixSymmetry::UNSYMMETRIC;
 
     FrontalMatrixDense(const FrontalMatrixDense&) = delete;
     FrontalMatrixDense& operator=(FrontalMatrixDense const&) = delete;
 
-    ReturnCode factor_phase1(const SpMat_t& A, const Opts_t& opts,
-                             VectorPool<scalar_t>& workspace,
-                             int etree_level, int task_depth);
+    void assemble(const SpMat_t& A, const Opts_t& opts,
+                  VectorPool<scalar_t>& workspace,
+                  int etree_level, int task_depth);
     ReturnCode factor_phase2(const SpMat_t& A, const Opts_t& opts,
                              int etree_level, int task_depth);
+    ReturnCode factor_phase2_symmetric(const Opts_t& opts, int task_depth);
+
+    bool symmetric() const { return sym_ != MatrixSymmetry::UNSYMMETRIC; }
+
+    /**
+     * Whether the factors of this front can be stored in the memory
+     * of the enclosing dense subtree. This is not the case when the
+     * factors are released (compressed or stored out-of-core) after
+     * factorization.
+     */
+    virtual bool share_factor_memory() const { return !this->ooc_; }
+    std::size_t node_factor_size(bool sym) const;
+    std::vector<FrontalMatrixDense<scalar_t,integer_t>*> dense_subtree();
+    static std::size_t subtree_factor_size
+    (bool sym, const std::vector<FrontalMatrixDense<scalar_t,integer_t>*>& fs);
+    void set_factor_memory
+    (bool sym, scalar_t* mem,
+     const std::vector<FrontalMatrixDense<scalar_t,integer_t>*>& fs);
+    void allocate_factor_memory(const Opts_t& opts);
+    void release_factor_memory();
+    FrontalMatrixDense<scalar_t,integer_t>* dense_child(F_t* ch) const;
+
+    // id of the factors in the out-of-core storage, if stored there
+    std::size_t ooc_id_ = 0;
+    bool ooc_stored_ = false;
+    // only the lower triangle of F22 is needed by the parent, see
+    // factor_phase2_symmetric
+    bool lower_CB_only_ = false;
+    void write_factors();
+    bool factors(std::unique_ptr<scalar_t[]>& buf, DenseMW_t& F11,
+                 DenseMW_t& F12, DenseMW_t& F21) const;
+
+    // -1: not yet computed, otherwise the number of fronts in the
+    // subtree if it can be factored with the small batched kernels,
+    // or 0 if it cannot
+    int small_subtree_ = -1;
+    bool small_subtree();
+    ReturnCode factor_small_subtree(const SpMat_t& A, const Opts_t& opts,
+                                    VectorPool<scalar_t>& workspace,
+                                    int etree_level, int task_depth);
 
     virtual void
     fwd_solve_phase2(DenseM_t& b, DenseM_t& bupd, int etree_level,
@@ -150,6 +207,10 @@ namespace strumpack {
     virtual void
     bwd_solve_phase1(DenseM_t& y, DenseM_t& yupd, int etree_level,
                      int task_depth) const override;
+    void fwd_solve_phase2(Trans op, DenseM_t& b, DenseM_t& bupd,
+                          int etree_level, int task_depth) const override;
+    void bwd_solve_phase1(Trans op, DenseM_t& y, DenseM_t& yupd,
+                          int etree_level, int task_depth) const override;
 
     ReturnCode matrix_inertia(const DenseM_t& F,
                               integer_t& neg,
@@ -163,6 +224,8 @@ namespace strumpack {
     virtual ReturnCode node_pivot_growth(scalar_t& pgL,
                                          scalar_t& pgU) const override;
 
+    long long node_factor_nonzeros() const override;
+
     using F_t::lchild_;
     using F_t::rchild_;
     using F_t::dim_sep;
@@ -113,7 +113,7 @@ namespace strumpack {
     }
     std::vector<scalar_t,NoInit<scalar_t>> rbuf;
     std::vector<scalar_t*> pbuf;
-    Comm().all_to_all_v(sbuf, rbuf, pbuf);
+    Comm().sparse_all_to_all_v(sbuf, rbuf, pbuf, this->ea_pattern_);
     for (auto& ch : {lchild_.get(), rchild_.get()}) {
       if (!ch) continue;
       ch->extend_add_copy_from_buffers
@@ -247,7 +247,11 @@ namespace strumpack {
         (A, opts, etree_level+1, task_depth);
       if (er != ReturnCode::SUCCESS) err_code = er;
     }
-    build_front(A);
+    {
+      // extraction from A and the (all-to-all) extend-add
+      TraceScope trace("extend_add", this->trace_args(etree_level));
+      build_front(A);
+    }
     if (etree_level == 0 && opts.write_root_front()) {
       auto Fs = F11_.gather();
       std::string fname = is_complex<scalar_t>() ?
@@ -262,7 +266,11 @@ namespace strumpack {
     }
     if (lchild_) lchild_->release_work_memory();
     if (rchild_) rchild_->release_work_memory();
-    auto ef = partial_factorization(opts);
+    ReturnCode ef;
+    {
+      TraceScope trace("factor", this->trace_args(etree_level));
+      ef = partial_factorization(opts);
+    }
     if (ef != ReturnCode::SUCCESS) err_code = ef;
 #if defined(STRUMPACK_USE_ZFP) || defined(STRUMPACK_USE_SZ3)
     compress(opts);
@@ -365,6 +373,7 @@ namespace strumpack {
     bupd = DistM_t(grid(), this->dim_upd(), b.cols());
     bupd.zero();
     this->extend_add_b(b, bupd, CBl, CBr, seqCBl, seqCBr);
+    TraceScope trace("fwd_solve", this->trace_args(etree_level));
 #if defined(STRUMPACK_USE_ZFP) || defined(STRUMPACK_USE_SZ3)
     if (compressed_) {
       const auto dupd = this->dim_upd();
@@ -421,17 +430,20 @@ namespace strumpack {
   (DenseM_t& yloc, DistM_t* ydist, DistM_t& yupd, DenseM_t&,
    int etree_level) const {
     DistM_t& y = ydist[this->sep_];
+    {
+      TraceScope trace("bwd_solve", this->trace_args(etree_level));
 #if defined(STRUMPACK_USE_ZFP) || defined(STRUMPACK_USE_SZ3)
-    if (compressed_) {
-      const auto dupd = this->dim_upd();
-      const auto dsep = this->dim_sep();
-      DistM_t F11(grid(), dsep, dsep), F12(grid(), dsep, dupd),
-        F21(grid(), dupd, dsep);
-      decompress(F11, F12, F21);
-      bwd_solve_phase1(F11, F12, F21, y, yupd);
-    } else
+      if (compressed_) {
+        const auto dupd = this->dim_upd();
+        const auto dsep = this->dim_sep();
+        DistM_t F11(grid(), dsep, dsep), F12(grid(), dsep, dupd),
+          F21(grid(), dupd, dsep);
+        decompress(F11, F12, F21);
+        bwd_solve_phase1(F11, F12, F21, y, yupd);
+      } else
 #endif
-      bwd_solve_phase1(F11_, F12_, F21_, y, yupd);
+        bwd_solve_phase1(F11_, F12_, F21_, y, yupd);
+    }
     DistM_t CBl, CBr;
     DenseM_t seqCBl, seqCBr;
     this->extract_b(y, yupd, CBl, CBr, seqCBl, seqCBr);
@@ -466,7 +478,7 @@ namespace strumpack {
     std::vector<scalar_t*> pbuf;
     {
       TIMER_TIME(TaskType::GET_SUBMATRIX_2D_A2A, 2, t_a2a);
-      Comm().all_to_all_v(sbuf, rbuf, pbuf);
+      Comm().sparse_all_to_all_v(sbuf, rbuf, pbuf);
     }
     for (std::size_t i=0; i<nB; i++)
       ExtAdd::extract_copy_from_buffers
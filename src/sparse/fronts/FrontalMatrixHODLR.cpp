@@ -104,32 +104,9 @@ namespace strumpack {
   FrontalMatrixHODLR<scalar_t,integer_t>::extend_add_to_dense
   (DenseM_t& paF11, DenseM_t& paF12, DenseM_t& paF21, DenseM_t& paF22,
    const F_t* p, int task_depth) {
-    const std::size_t dupd = dim_upd();
-    if (!dupd) return;
-    const std::size_t pdsep = paF11.rows();
-    std::size_t upd2sep;
-    auto I = this->upd_to_parent(p, upd2sep);
+    if (!dim_upd()) return;
     auto CB = get_dense_CB();
-#if defined(STRUMPACK_USE_OPENMP_TASKLOOP)
-#pragma omp taskloop default(shared) grainsize(64)      \
-  if(task_depth < params::task_recursion_cutoff_level)
-#endif
-    for (std::size_t c=0; c<dupd; c++) {
-      auto pc = I[c];
-      if (pc < pdsep) {
-        for (std::size_t r=0; r<upd2sep; r++)
-          paF11(I[r],pc) += CB(r,c);
-        for (std::size_t r=upd2sep; r<dupd; r++)
-          paF21(I[r]-pdsep,pc) += CB(r,c);
-      } else {
-        for (std::size_t r=0; r<upd2sep; r++)
-          paF12(I[r],pc-pdsep) += CB(r, c);
-        for (std::size_t r=upd2sep; r<dupd; r++)
-          paF22(I[r]-pdsep,pc-pdsep) += CB(r,c);
-      }
-    }
-    STRUMPACK_FLOPS((is_complex<scalar_t>()?2:1) * dupd * dupd);
-    STRUMPACK_FULL_RANK_FLOPS((is_complex<scalar_t>()?2:1) * dupd * dupd);
+    this->extend_add(paF11, paF12, paF21, paF22, CB, p);
     release_work_memory();
   }
 
@@ -436,6 +413,8 @@ namespace strumpack {
       if (er != ReturnCode::SUCCESS) err_code = er;
     }
     if (!this->dim_blk()) return err_code;
+    // HODLR compression includes the factorization of F11
+    TraceScope trace("compress_factor", this->trace_args(etree_level));
     TaskTimer t("");
     if (opts.print_compressed_front_stats()) t.start();
     construct_hierarchy(A, opts, task_depth);
@@ -497,6 +476,7 @@ namespace strumpack {
                 << " MB" << std::endl;
 #endif
     }
+    if (trace.active()) trace.set_rank(F11_.rank());
     if (lchild_) lchild_->release_work_memory();
     if (rchild_) rchild_->release_work_memory();
     return err_code;
@@ -130,6 +130,7 @@ namespace strumpack {
     void backward_multifrontal_solve(DenseM_t& y, DenseM_t* work,
                                      int etree_level=0, int task_depth=0)
       const override;
+    bool front_local_solve() const override { return false; }
 
     integer_t front_rank(int task_depth=0) const override;
     void print_rank_statistics(std::ostream &out) const override;
@@ -29,6 +29,7 @@
 
 #include "FrontalMatrixHSS.hpp"
 #include "sparse/CSRGraph.hpp"
+#include "sparse/FactorFile.hpp"
 
 namespace strumpack {
 
@@ -358,10 +359,15 @@ namespace strumpack {
     HSSopts.set_d0(std::max(child_samples - HSSopts.dd(), HSSopts.d0()));
     if (opts.indirect_sampling())
       HSSopts.set_user_defined_random(true);
-    H_.compress(mult, elem, HSSopts);
+    {
+      TraceScope trace("compress", this->trace_args(etree_level));
+      H_.compress(mult, elem, HSSopts);
+      if (trace.active()) trace.set_rank(H_.rank());
+    }
     if (lchild_) lchild_->release_work_memory();
     if (rchild_) rchild_->release_work_memory();
     if (dim_sep()) {
+      TraceScope trace("factor", this->trace_args(etree_level));
       if (etree_level > 0) {
         TIMER_TIME(TaskType::HSS_PARTIALLY_FACTOR, 0, t_pfact);
         H_.partial_factor();
@@ -425,6 +431,7 @@ namespace strumpack {
     DenseMW_t bupd(dim_upd(), b.cols(), work[0], 0, 0);
     bupd.zero();
     this->fwd_solve_phase1(b, bupd, work, etree_level, task_depth);
+    TraceScope trace("fwd_solve", this->trace_args(etree_level));
     if (etree_level) {
       if (Theta_.cols() && Phi_.cols()) {
         DenseMW_t bloc(dim_sep(), b.cols(), b, sep_begin_, 0);
@@ -459,19 +466,22 @@ namespace strumpack {
   FrontalMatrixHSS<scalar_t,integer_t>::bwd_solve_node
   (DenseM_t& y, DenseM_t* work, int etree_level, int task_depth) const {
     DenseMW_t yupd(dim_upd(), y.cols(), work[0], 0, 0);
-    if (etree_level) {
-      if (Phi_.cols() && Theta_.cols()) {
-        if (dim_upd()) {
-          gemm(Trans::C, Trans::N, scalar_t(-1.), Phi_, yupd,
-               scalar_t(1.), ULVwork_->x, task_depth);
+    {
+      TraceScope trace("bwd_solve", this->trace_args(etree_level));
+      if (etree_level) {
+        if (Phi_.cols() && Theta_.cols()) {
+          if (dim_upd()) {
+            gemm(Trans::C, Trans::N, scalar_t(-1.), Phi_, yupd,
+                 scalar_t(1.), ULVwork_->x, task_depth);
+          }
+          DenseMW_t yloc(dim_sep(), y.cols(), y, sep_begin_, 0);
+          H_.child(0)->backward_solve(*ULVwork_, yloc);
+          ULVwork_.reset();
         }
+      } else {
         DenseMW_t yloc(dim_sep(), y.cols(), y, sep_begin_, 0);
-        H_.child(0)->backward_solve(*ULVwork_, yloc);
-        ULVwork_.reset();
+        H_.backward_solve(*ULVwork_, yloc);
       }
-    } else {
-      DenseMW_t yloc(dim_sep(), y.cols(), y, sep_begin_, 0);
-      H_.backward_solve(*ULVwork_, yloc);
     }
     this->bwd_solve_phase2(y, yupd, work, etree_level, task_depth);
   }
@@ -526,6 +536,30 @@ namespace strumpack {
     }
   }
 
+  template<typename scalar_t,typename integer_t> bool
+  FrontalMatrixHSS<scalar_t,integer_t>::save_factors
+  (FactorFileWriter& f) const {
+    auto& os = f.stream();
+    H_.write(os);
+    os << Theta_ << Phi_ << ThetaVhatC_or_VhatCPhiC_ << DUB01_;
+    return f.good();
+  }
+
+  /**
+   * The HSS generators and ULV factors are read (copied) from the
+   * factor file using the HSSMatrix serialization.
+   */
+  template<typename scalar_t,typename integer_t> bool
+  FrontalMatrixHSS<scalar_t,integer_t>::load_factors
+  (FactorFileReader& f) {
+    ULVwork_.reset();
+    f.stream([&](std::ifstream& is) {
+      H_.read(is);
+      is >> Theta_ >> Phi_ >> ThetaVhatC_or_VhatCPhiC_ >> DUB01_;
+    });
+    return f.good();
+  }
+
   // explicit template instantiations
   template class FrontalMatrixHSS<float,int>;
   template class FrontalMatrixHSS<double,int>;
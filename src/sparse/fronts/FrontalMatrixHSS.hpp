@@ -80,12 +80,16 @@ namespace strumpack {
     void backward_multifrontal_solve(DenseM_t& y, DenseM_t* work,
                                      int etree_level=0,
                                      int task_depth=0) const override;
+    bool front_local_solve() const override { return false; }
 
     integer_t front_rank(int task_depth=0) const override;
     void print_rank_statistics(std::ostream &out) const override;
     bool isHSS() const override { return true; };
     std::string type() const override { return "FrontalMatrixHSS"; }
 
+    bool save_factors(FactorFileWriter& f) const override;
+    bool load_factors(FactorFileReader& f) override;
+
     int random_samples() const override { return R1.cols(); };
 
     void partition(const Opts_t& opts, const SpMat_t& A, integer_t* sorder,
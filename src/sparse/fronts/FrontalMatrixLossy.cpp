@@ -27,6 +27,7 @@
  *
  */
 #include "FrontalMatrixLossy.hpp"
+#include "sparse/FactorFile.hpp"
 
 #if defined(STRUMPACK_USE_ZFP)
 #include "zfp.h"
@@ -119,6 +120,36 @@ namespace strumpack {
 #endif
   }
 
+  template<typename T> void
+  LossyMatrix<T>::save(FactorFileWriter& f) const {
+    f.write(rows_);
+    f.write(cols_);
+    f.write(prec_);
+    f.write(acc_);
+#if defined(STRUMPACK_USE_SZ3)
+    f.write(buffer_.get(), out_size_);
+#else // defined(STRUMPACK_USE_ZFP)
+    f.write(buffer_);
+#endif
+  }
+
+  template<typename T> void
+  LossyMatrix<T>::load(FactorFileReader& f) {
+    STRUMPACK_SUB_MEMORY(compressed_size()*sizeof(unsigned char));
+    f.read(rows_);
+    f.read(cols_);
+    f.read(prec_);
+    f.read(acc_);
+#if defined(STRUMPACK_USE_SZ3)
+    auto b = f.map<char>(out_size_);
+    buffer_.reset(new char[out_size_]);
+    std::copy(b, b+out_size_, buffer_.get());
+#else // defined(STRUMPACK_USE_ZFP)
+    f.read(buffer_);
+#endif
+    STRUMPACK_ADD_MEMORY(compressed_size()*sizeof(unsigned char));
+  }
+
   template<typename T> LossyMatrix<std::complex<T>>::LossyMatrix
   (const DenseMatrix<std::complex<T>>& F, int prec, double acc) {
     int rows = F.rows(), cols = F.cols();
@@ -169,9 +200,7 @@ namespace strumpack {
     F11c_ = LossyMatrix<scalar_t>(this->F11_, prec, acc);
     F12c_ = LossyMatrix<scalar_t>(this->F12_, prec, acc);
     F21c_ = LossyMatrix<scalar_t>(this->F21_, prec, acc);
-    this->F11_.clear();
-    this->F12_.clear();
-    this->F21_.clear();
+    this->release_factor_memory();
   }
 
   template<typename scalar_t,typename integer_t> void
@@ -182,11 +211,35 @@ namespace strumpack {
     F21 = F21c_.decompress();
   }
 
+  template<typename scalar_t,typename integer_t> bool
+  FrontalMatrixLossy<scalar_t,integer_t>::save_factors
+  (FactorFileWriter& f) const {
+    f.write(this->sym_);
+    f.write(this->piv_);
+    F11c_.save(f);
+    F12c_.save(f);
+    F21c_.save(f);
+    return f.good();
+  }
+
+  template<typename scalar_t,typename integer_t> bool
+  FrontalMatrixLossy<scalar_t,integer_t>::load_factors
+  (FactorFileReader& f) {
+    this->release_factor_memory();
+    f.read(this->sym_);
+    f.read(this->piv_);
+    F11c_.load(f);
+    F12c_.load(f);
+    F21c_.load(f);
+    return f.good();
+  }
+
   template<typename scalar_t,typename integer_t> ReturnCode
   FrontalMatrixLossy<scalar_t,integer_t>::factor
   (const SpMat_t& A, const Opts_t& opts, VectorPool<scalar_t>& workspace,
    int etree_level, int task_depth) {
     auto e = FD_t::factor(A, opts, workspace, etree_level, task_depth);
+    TraceScope trace("compress", this->trace_args(etree_level));
     compress(opts);
     return e;
   }
@@ -53,6 +53,8 @@ namespace strumpack {
       STRUMPACK_SUB_MEMORY(compressed_size()*sizeof(unsigned char));
     }
     void decompress(DenseMatrix<T>& F) const;
+    void save(FactorFileWriter& f) const;
+    void load(FactorFileReader& f);
 #if defined(STRUMPACK_USE_SZ3)
     std::size_t compressed_size() const { return out_size_; }
 #else // defined(STRUMPACK_USE_ZFP)
@@ -87,6 +89,14 @@ namespace strumpack {
       return F;
     }
     void decompress(DenseMatrix<std::complex<T>>& F) const;
+    void save(FactorFileWriter& f) const {
+      Freal_.save(f);
+      Fimag_.save(f);
+    }
+    void load(FactorFileReader& f) {
+      Freal_.load(f);
+      Fimag_.load(f);
+    }
     std::size_t compressed_size() const {
       return Freal_.compressed_size() + Fimag_.compressed_size();
     }
@@ -126,6 +136,15 @@ namespace strumpack {
 
     long long node_factor_nonzeros() const override;
 
+    // the compressed factors are kept in memory
+    void set_node_out_of_core(OutOfCoreStorage<scalar_t>* ooc) override {
+      FD_t::set_node_out_of_core(ooc);
+      this->ooc_ = nullptr;
+    }
+
+    bool save_factors(FactorFileWriter& f) const override;
+    bool load_factors(FactorFileReader& f) override;
+
   private:
     LossyMatrix<scalar_t> F11c_, F12c_, F21c_;
 
@@ -138,6 +157,9 @@ namespace strumpack {
                                     integer_t& zero,
                                     integer_t& pos) const override;
 
+    // factors are released after compression
+    bool share_factor_memory() const override { return false; }
+
     FrontalMatrixLossy(const FrontalMatrixLossy&) = delete;
     FrontalMatrixLossy& operator=(FrontalMatrixLossy const&) = delete;
   };
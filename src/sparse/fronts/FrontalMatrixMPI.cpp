@@ -105,7 +105,7 @@ namespace strumpack {
     std::vector<scalar_t*> pbuf;
     {
       TIMER_TIME(TaskType::EXTRACT_2D_A2A, 1, t_a2a);
-      Comm().all_to_all_v(sbuf, rbuf, pbuf);
+      Comm().sparse_all_to_all_v(sbuf, rbuf, pbuf);
     }
     BLACSGrid *gl = nullptr, *gr = nullptr;
     if (lchild_) gl = lchild_->grid();
@@ -188,7 +188,8 @@ namespace strumpack {
       rchild_->extend_add_column_copy_to_buffers(CBr, seqCBr, sbuf, this);
     std::vector<scalar_t,NoInit<scalar_t>> rbuf;
     std::vector<scalar_t*> pbuf;
-    Comm().all_to_all_v(sbuf, rbuf, pbuf);
+    if (b.cols()) Comm().sparse_all_to_all_v(sbuf, rbuf, pbuf, ea_b_pattern_);
+    else Comm().sparse_all_to_all_v(sbuf, rbuf, pbuf);
     for (auto& ch : {lchild_.get(), rchild_.get()})
       if (ch) ch->extend_add_column_copy_from_buffers
                 (b, bupd, pbuf.data()+master(ch), this);
@@ -213,7 +214,8 @@ namespace strumpack {
                 (b, bupd, master(ch), sbuf, this);
     std::vector<scalar_t,NoInit<scalar_t>> rbuf;
     std::vector<scalar_t*> pbuf;
-    Comm().all_to_all_v(sbuf, rbuf, pbuf);
+    if (b.cols()) Comm().sparse_all_to_all_v(sbuf, rbuf, pbuf, ex_b_pattern_);
+    else Comm().sparse_all_to_all_v(sbuf, rbuf, pbuf);
     if (visit(lchild_))
       lchild_->extract_column_copy_from_buffers(b, CBl, seqCBl, pbuf, this);
     if (visit(rchild_))
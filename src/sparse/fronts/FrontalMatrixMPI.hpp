@@ -157,6 +157,12 @@ namespace strumpack {
   protected:
     BLACSGrid blacs_grid_;     // 2D processor grid
 
+    // communication patterns for the extend-add in the factorization,
+    // and for the extend-add and extraction in the solve, set up by
+    // the first exchange, see MPIComm::sparse_all_to_all_v
+    ExchangePattern ea_pattern_;
+    mutable ExchangePattern ea_b_pattern_, ex_b_pattern_;
+
     virtual long long node_factor_nonzeros() const override;
 
     using F_t::lchild_;
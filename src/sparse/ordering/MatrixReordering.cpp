@@ -38,6 +38,8 @@
 #include "sparse/fronts/FrontalMatrix.hpp"
 #include "sparse/SeparatorTree.hpp"
 #include "sparse/CSRMatrix.hpp"
+#include "sparse/FactorFile.hpp"
+#include "dense/DenseMatrix.hpp"
 #if defined(STRUMPACK_USE_MPI)
 #include "misc/MPIWrapper.hpp"
 #include "sparse/CSRMatrixMPI.hpp"
@@ -48,12 +50,15 @@
 #if defined(STRUMPACK_USE_PTSCOTCH)
 #include "PTScotchReordering.hpp"
 #endif
+#if defined(STRUMPACK_USE_METIS)
 #include "MetisReordering.hpp"
+#endif
 #if defined(STRUMPACK_USE_PARMETIS)
 #include "ParMetisReordering.hpp"
 #endif
 #include "RCMReordering.hpp"
 #include "ANDSparspak.hpp"
+#include "NDReordering.hpp"
 #include "GeometricReordering.hpp"
 #include "minimum_degree/AMDReordering.hpp"
 #include "minimum_degree/MMDReordering.hpp"
@@ -80,7 +85,13 @@ namespace strumpack {
       break;
     }
     case ReorderingStrategy::METIS: {
+#if defined(STRUMPACK_USE_METIS)
       tree_ = metis_nested_dissection(A, perm_, iperm_, opts);
+#else
+      std::cerr << "# WARNING: STRUMPACK was not configured with Metis"
+        " support, using the built-in nested dissection (nd)" << std::endl;
+      tree_ = ordering::nd_reordering(A, perm_, iperm_, opts.nd_param());
+#endif
       break;
     }
     case ReorderingStrategy::SCOTCH: {
@@ -114,6 +125,10 @@ namespace strumpack {
       tree_ = ordering::and_reordering(A, perm_, iperm_);
       break;
     }
+    case ReorderingStrategy::ND: {
+      tree_ = ordering::nd_reordering(A, perm_, iperm_, opts.nd_param());
+      break;
+    }
     case ReorderingStrategy::MLF: {
       std::cerr << "# ERROR: MLF ordering not supported." << std::endl;
       return 1;
@@ -150,6 +165,22 @@ namespace strumpack {
     return 0;
   }
 
+  template<typename scalar_t,typename integer_t> int
+  MatrixReordering<scalar_t,integer_t>::coordinate_nested_dissection
+  (const Opts_t& opts, const CSR_t& A, const DenseMatrix<real_t>& coords) {
+    if (integer_t(coords.cols()) != A.size() || !coords.rows()) {
+      std::cerr << "# ERROR: coordinates should be a d x N matrix,"
+                << " with N = " << A.size() << "." << std::endl;
+      return 1;
+    }
+    tree_ = ordering::coordinate_nd_reordering
+      (A, coords.rows(), coords.data(), coords.ld(), perm_, iperm_,
+       opts.nd_param());
+    tree_.check();
+    nested_dissection_print(opts, A.nnz(), opts.verbose());
+    return 0;
+  }
+
   template<typename scalar_t,typename integer_t> void
   MatrixReordering<scalar_t,integer_t>::clear_tree_data() {
     tree_ = SeparatorTree<integer_t>();
@@ -175,6 +206,20 @@ namespace strumpack {
     F->permute_CB(sorder.data());
   }
 
+  template<typename scalar_t,typename integer_t> void
+  MatrixReordering<scalar_t,integer_t>::save(FactorFileWriter& f) const {
+    f.write(perm_);
+    f.write(iperm_);
+    tree_.save(f);
+  }
+
+  template<typename scalar_t,typename integer_t> bool
+  MatrixReordering<scalar_t,integer_t>::load(FactorFileReader& f) {
+    f.read(perm_);
+    f.read(iperm_);
+    return tree_.load(f) && f.good() && perm_.size() == iperm_.size();
+  }
+
   template<typename scalar_t,typename integer_t> void
   MatrixReordering<scalar_t,integer_t>::nested_dissection_print
   (const Opts_t& opts, integer_t nnz, bool verbose) const {
@@ -185,7 +230,7 @@ namespace strumpack {
   template<typename scalar_t,typename integer_t> void
   MatrixReordering<scalar_t,integer_t>::nested_dissection_print
   (const Opts_t& opts, integer_t nnz, int max_level,
-   int total_separators, bool verbose) const {
+   int total_separators, bool verbose, bool distributed) const {
     if (verbose) {
       std::cout << "# initial matrix:" << std::endl;
       std::cout << "#   - number of unknowns = "
@@ -228,12 +273,18 @@ namespace strumpack {
                 << number_format_with_commas(max_level)
                 << std::flush << std::endl;
     }
-    if (max_level > 50)
+    // the dense sequential/shared-memory tree is traversed without
+    // recursion, the distributed, compressed and GPU fronts still
+    // recurse over the tree
+    if (max_level > 50 &&
+        (distributed || opts.use_gpu() ||
+         opts.compression() != CompressionType::NONE))
       std::cerr
         << "# ***** WARNING ****************************************************" << std::endl
         << "# Detected a large number of levels in the frontal/elimination tree." << std::endl
-        << "# STRUMPACK currently does not handle this safely, which" << std::endl
-        << "# could lead to segmentation faults due to stack overflows." << std::endl
+        << "# The distributed, compressed and GPU fronts do not handle this" << std::endl
+        << "# safely, which could lead to segmentation faults due to stack" << std::endl
+        << "# overflows." << std::endl
         << "# As a remedy, you can try to increase the stack size," << std::endl
         << "# or try a different ordering (metis, scotch, ..)." << std::endl
         << "# When using metis, it often helps to use --sp_enable_METIS_NodeNDP," << std::endl
@@ -41,13 +41,17 @@
 
 namespace strumpack {
 
+  class FactorFileWriter;
+  class FactorFileReader;
   template<typename scalar_t,typename integer_t> class CSRMatrix;
   template<typename scalar_t,typename integer_t> class FrontalMatrix;
+  template<typename scalar_t> class DenseMatrix;
 
   template<typename scalar_t,typename integer_t> class MatrixReordering {
     using Opts_t = SPOptions<scalar_t>;
     using CSR_t = CSRMatrix<scalar_t,integer_t>;
     using F_t = FrontalMatrix<scalar_t,integer_t>;
+    using real_t = typename RealType<scalar_t>::value_type;
 
   public:
     MatrixReordering(integer_t  n);
@@ -61,6 +65,17 @@ namespace strumpack {
     int set_permutation(const Opts_t& opts, const CSR_t& A,
                         const int* p, int base);
 
+    /**
+     * Nested dissection using the coordinates of the vertices, see
+     * ordering::coordinate_nd_reordering. This ignores the
+     * reordering method set in opts.
+     *
+     * \param coords d x A.size() matrix, column i holds the
+     * coordinates of vertex i
+     */
+    int coordinate_nested_dissection(const Opts_t& opts, const CSR_t& A,
+                                     const DenseMatrix<real_t>& coords);
+
     void separator_reordering(const Opts_t& opts, CSR_t& A, F_t* F);
 
     virtual void clear_tree_data();
@@ -71,6 +86,13 @@ namespace strumpack {
     const SeparatorTree<integer_t>& tree() const { return tree_; }
     SeparatorTree<integer_t>& tree() { return tree_; }
 
+    /**
+     * Write the permutation and separator tree to a factor file, or
+     * read them back, see SparseSolverBase::save_factors.
+     */
+    void save(FactorFileWriter& f) const;
+    bool load(FactorFileReader& f);
+
   protected:
     virtual void
     separator_reordering_print(integer_t max_nr_neighbours,
@@ -79,7 +101,7 @@ namespace strumpack {
     void
     nested_dissection_print(const Opts_t& opts, integer_t nnz,
                             int max_level, int total_separators,
-                            bool verbose) const;
+                            bool verbose, bool distributed=false) const;
 
     std::vector<integer_t> perm_, iperm_;
 
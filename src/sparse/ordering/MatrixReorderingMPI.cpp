@@ -35,19 +35,23 @@
 #include "sparse/CSRGraph.hpp"
 #include "sparse/SeparatorTree.hpp"
 #include "sparse/fronts/FrontalMatrix.hpp"
+#include "dense/DenseMatrix.hpp"
 #if defined(STRUMPACK_USE_SCOTCH)
 #include "ScotchReordering.hpp"
 #endif
 #if defined(STRUMPACK_USE_PTSCOTCH)
 #include "PTScotchReordering.hpp"
 #endif
+#if defined(STRUMPACK_USE_METIS)
 #include "MetisReordering.hpp"
+#endif
 #if defined(STRUMPACK_USE_PARMETIS)
 #include "ParMetisReordering.hpp"
 #endif
 #include "GeometricReorderingMPI.hpp"
 #include "RCMReordering.hpp"
 #include "ANDSparspak.hpp"
+#include "NDReordering.hpp"
 #include "minimum_degree/AMDReordering.hpp"
 #include "minimum_degree/MMDReordering.hpp"
 // #include "spectral/SpectralReordering.hpp"
@@ -69,8 +73,6 @@ namespace strumpack {
   (const Opts_t& opts, const CSRMPI_t& A,
    int nx, int ny, int nz, int components, int width) {
     if (!is_parallel(opts.reordering_method())) {
-      auto rank = comm_->rank();
-      auto P = comm_->size();
       auto Aseq = A.gather_graph();
       SeparatorTree<integer_t> global_sep_tree;
       if (Aseq) { // only root
@@ -82,8 +84,16 @@ namespace strumpack {
           break;
         }
         case ReorderingStrategy::METIS: {
+#if defined(STRUMPACK_USE_METIS)
           global_sep_tree = metis_nested_dissection
             (*Aseq, perm_, iperm_, opts);
+#else
+          std::cerr << "# WARNING: STRUMPACK was not configured with Metis"
+            " support, using the built-in nested dissection (nd)"
+                    << std::endl;
+          global_sep_tree = ordering::nd_reordering
+            (*Aseq, perm_, iperm_, opts.nd_param());
+#endif
           break;
         }
         case ReorderingStrategy::SCOTCH: {
@@ -113,6 +123,11 @@ namespace strumpack {
           global_sep_tree = ordering::and_reordering(*Aseq, perm_, iperm_);
           break;
         }
+        case ReorderingStrategy::ND: {
+          global_sep_tree = ordering::nd_reordering
+            (*Aseq, perm_, iperm_, opts.nd_param());
+          break;
+        }
         case ReorderingStrategy::MLF: {
           std::cerr << "# ERROR: MLF ordering not supported." << std::endl;
           return 1;
@@ -129,21 +144,7 @@ namespace strumpack {
         Aseq.reset();
         global_sep_tree.check();
       }
-      comm_->broadcast(perm_);
-      comm_->broadcast(iperm_);
-      integer_t nbsep;
-      if (!rank) nbsep = global_sep_tree.separators();
-      comm_->broadcast(nbsep);
-      if (rank)
-        global_sep_tree = SeparatorTree<integer_t>(nbsep);
-      global_sep_tree.broadcast(*comm_);
-      ltree_ = global_sep_tree.subtree(rank, P);
-      tree_ = global_sep_tree.toptree(P);
-      ltree_.check();
-      tree_.check();
-      for (std::size_t i=0; i<perm_.size(); i++)
-        iperm_[perm_[i]] = i;
-      get_local_graphs(A);
+      distribute_global_tree(A, global_sep_tree);
     } else {
       switch (opts.reordering_method()) {
       case ReorderingStrategy::GEOMETRIC: {
@@ -206,6 +207,71 @@ namespace strumpack {
     return 0;
   }
 
+  template<typename scalar_t,typename integer_t> int
+  MatrixReorderingMPI<scalar_t,integer_t>::coordinate_nested_dissection
+  (const Opts_t& opts, const CSRMPI_t& A, const DenseM_t& coords) {
+    int d = coords.rows(), ierr = 0;
+    comm_->broadcast(d);
+    if (integer_t(coords.cols()) != A.local_rows() ||
+        int(coords.rows()) != d || !d)
+      ierr = 1;
+    if (comm_->all_reduce(ierr, MPI_MAX)) {
+      if (comm_->is_root())
+        std::cerr << "# ERROR: coordinates should be a d x N_local matrix,"
+                  << " with N_local the number of local rows, and d the"
+                  << " same on all ranks." << std::endl;
+      return 1;
+    }
+    // pack the local coordinates, and gather them on the root
+    std::vector<real_t> Xloc(std::size_t(d)*coords.cols()), X;
+    for (std::size_t j=0; j<coords.cols(); j++)
+      for (int i=0; i<d; i++)
+        Xloc[i+j*d] = coords(i, j);
+    auto P = comm_->size();
+    const auto& dist = A.dist();
+    std::vector<int> rcnts(P), displs(P);
+    for (int p=0; p<P; p++) {
+      rcnts[p] = d * (dist[p+1] - dist[p]);
+      displs[p] = d * dist[p];
+    }
+    if (comm_->is_root()) X.resize(std::size_t(d)*A.size());
+    comm_->gather_v(Xloc.data(), Xloc.size(), X.data(),
+                    rcnts.data(), displs.data(), 0);
+    auto Aseq = A.gather_graph();
+    SeparatorTree<integer_t> global_sep_tree;
+    if (Aseq) {
+      global_sep_tree = ordering::coordinate_nd_reordering
+        (*Aseq, d, X.data(), d, perm_, iperm_, opts.nd_param());
+      Aseq.reset();
+      global_sep_tree.check();
+    }
+    distribute_global_tree(A, global_sep_tree);
+    nested_dissection_print(opts, A.nnz());
+    return 0;
+  }
+
+  template<typename scalar_t,typename integer_t> void
+  MatrixReorderingMPI<scalar_t,integer_t>::distribute_global_tree
+  (const CSRMPI_t& A, SeparatorTree<integer_t>& global_sep_tree) {
+    auto rank = comm_->rank();
+    auto P = comm_->size();
+    comm_->broadcast(perm_);
+    comm_->broadcast(iperm_);
+    integer_t nbsep;
+    if (!rank) nbsep = global_sep_tree.separators();
+    comm_->broadcast(nbsep);
+    if (rank)
+      global_sep_tree = SeparatorTree<integer_t>(nbsep);
+    global_sep_tree.broadcast(*comm_);
+    ltree_ = global_sep_tree.subtree(rank, P);
+    tree_ = global_sep_tree.toptree(P);
+    ltree_.check();
+    tree_.check();
+    for (std::size_t i=0; i<perm_.size(); i++)
+      iperm_[perm_[i]] = i;
+    get_local_graphs(A);
+  }
+
   template<typename scalar_t,typename integer_t> int
   MatrixReorderingMPI<scalar_t,integer_t>::set_permutation
   (const Opts_t& opts, const CSRMPI_t& A, const int* p, int base) {
@@ -354,7 +420,7 @@ namespace strumpack {
       integer_t max_level = comm_->all_reduce(local_levels, MPI_MAX);
       if (comm_->is_root())
         MatrixReordering<scalar_t,integer_t>::nested_dissection_print
-          (opts, nnz, max_level, total_separators, true);
+          (opts, nnz, max_level, total_separators, true, true);
     }
   }
 
@@ -82,6 +82,8 @@ namespace strumpack {
     using CSRMPI_t = CSRMatrixMPI<scalar_t,integer_t>;
     using CSM_t = CompressedSparseMatrix<scalar_t,integer_t>;
     using F_t = FrontalMatrix<scalar_t,integer_t>;
+    using real_t = typename RealType<scalar_t>::value_type;
+    using DenseM_t = DenseMatrix<real_t>;
 
   public:
     MatrixReorderingMPI(integer_t n, const MPIComm& c);
@@ -93,6 +95,16 @@ namespace strumpack {
     int set_permutation(const Opts_t& opts, const CSRMPI_t& A,
                         const int* p, int base);
 
+    /**
+     * Coordinate based nested dissection, computed on the root,
+     * see MatrixReordering::coordinate_nested_dissection.
+     *
+     * \param coords d x A.local_rows() matrix, with the coordinates
+     * of the locally owned vertices
+     */
+    int coordinate_nested_dissection(const Opts_t& opts, const CSRMPI_t& A,
+                                     const DenseM_t& coords);
+
     void separator_reordering(const Opts_t& opts, CSM_t& A, F_t* F);
 
     void clear_tree_data() override;
@@ -143,6 +155,8 @@ namespace strumpack {
      */
     integer_t dsep_leaf_;
 
+    void distribute_global_tree(const CSRMPI_t& A,
+                                SeparatorTree<integer_t>& global_sep_tree);
     void get_local_graphs(const CSRMPI_t& Ampi);
     void build_local_tree(const CSRMPI_t& Ampi);
     void nested_dissection_print(const SPOptions<scalar_t>& opts,
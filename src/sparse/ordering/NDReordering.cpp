@@ -0,0 +1,848 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#include <vector>
+#include <memory>
+#include <random>
+#include <numeric>
+#include <queue>
+#include <cstdint>
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+
+#include "NDReordering.hpp"
+#include "StrumpackParameters.hpp"
+#include "misc/Tools.hpp"
+
+namespace strumpack {
+  namespace ordering {
+
+    namespace nd {
+
+      /**
+       * Undirected graph with vertex and edge weights, used on all
+       * levels of the multilevel hierarchy. The adjacency lists do
+       * not contain the vertex itself.
+       */
+      template<typename integer_t> class Graph {
+      public:
+        integer_t n = 0, weight = 0;
+        std::vector<integer_t> ptr, ind, vw, ew;
+        integer_t nnz() const { return ptr.empty() ? 0 : ptr[n]; }
+      };
+
+      /**
+       * A node in the dissection tree, either a separator or a leaf
+       * (no children), with the original indices of its vertices.
+       */
+      template<typename integer_t> class Node {
+      public:
+        std::vector<integer_t> vertices;
+        std::unique_ptr<Node<integer_t>> left, right;
+      };
+
+      // stop coarsening when the graph has fewer vertices
+      const int coarsen_to = 100;
+      // number of random starting vertices for the initial bisection
+      const int bisection_tries = 4;
+      // maximum number of FM passes on every level
+      const int fm_passes = 4;
+      // abort an FM pass after this many moves without improvement
+      const int fm_max_bad_moves = 50;
+      // power iterations for the principal axis in inertial bisection
+      const int inertia_iterations = 20;
+      // maximum weight of the largest part, as a fraction of the total
+      const double max_imbalance = 0.55;
+      // vertices per task in match and contract
+      const int chunk = 4096;
+      // parallel matching rounds, before the serial clean up
+      const int match_rounds = 4;
+
+      template<typename integer_t> integer_t
+      max_part_weight(const Graph<integer_t>& G) {
+        integer_t maxvw = 0;
+        for (auto w : G.vw) maxvw = std::max(maxvw, w);
+        return std::max(integer_t(max_imbalance * G.weight),
+                        G.weight / 2 + maxvw);
+      }
+
+      /**
+       * Randomized heavy edge matching, mate[v] == v for unmatched
+       * vertices. Returns the number of coarse vertices, cmap maps
+       * fine to coarse vertices.
+       *
+       * For large graphs, most vertices are matched in a few
+       * parallel rounds: every unmatched vertex proposes to its
+       * heaviest unmatched neighbor (ties broken by a random rank),
+       * and mutual proposals are matched. The vertices that are left
+       * are matched serially, in random order. The result does not
+       * depend on the number of threads.
+       */
+      template<typename integer_t> integer_t
+      match(const Graph<integer_t>& G, std::vector<integer_t>& mate,
+            std::vector<integer_t>& cmap, std::mt19937& gen) {
+        auto n = G.n;
+        std::vector<integer_t> order(n);
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), gen);
+        // avoid creating very heavy coarse vertices
+        integer_t maxvw = std::max(integer_t(1), 3 * G.weight / (2*coarsen_to));
+        mate.assign(n, -1);
+        const integer_t nb = (n + chunk - 1) / chunk;
+        if (nb > 1) {
+          std::vector<integer_t> rank(n), prop(n);
+          for (integer_t i=0; i<n; i++) rank[order[i]] = i;
+          for (int r=0; r<match_rounds; r++) {
+#pragma omp taskloop default(shared)
+            for (integer_t b=0; b<nb; b++)
+              for (integer_t v=b*chunk; v<std::min(n, (b+1)*chunk); v++) {
+                prop[v] = -1;
+                if (mate[v] != -1) continue;
+                integer_t bw = 0;
+                for (integer_t e=G.ptr[v]; e<G.ptr[v+1]; e++) {
+                  auto u = G.ind[e];
+                  if (mate[u] != -1 || G.vw[v] + G.vw[u] > maxvw) continue;
+                  if (G.ew[e] > bw || (G.ew[e] == bw && prop[v] != -1 &&
+                                       rank[u] < rank[prop[v]])) {
+                    prop[v] = u;
+                    bw = G.ew[e];
+                  }
+                }
+              }
+            std::vector<integer_t> matched(nb, 0);
+#pragma omp taskloop default(shared)
+            for (integer_t b=0; b<nb; b++)
+              for (integer_t v=b*chunk; v<std::min(n, (b+1)*chunk); v++) {
+                auto u = prop[v];
+                if (u != -1 && prop[u] == v) {
+                  mate[v] = u;
+                  matched[b]++;
+                }
+              }
+            if (std::accumulate(matched.begin(), matched.end(),
+                                integer_t(0)) < n / 100) break;
+          }
+        }
+        for (auto v : order) {
+          if (mate[v] != -1) continue;
+          integer_t best = v, bw = 0;
+          for (integer_t e=G.ptr[v]; e<G.ptr[v+1]; e++) {
+            auto u = G.ind[e];
+            if (mate[u] == -1 && G.ew[e] > bw &&
+                G.vw[v] + G.vw[u] <= maxvw) {
+              best = u;
+              bw = G.ew[e];
+            }
+          }
+          mate[v] = best;
+          mate[best] = v;
+        }
+        cmap.assign(n, -1);
+        integer_t nc = 0;
+        for (integer_t v=0; v<n; v++)
+          if (cmap[v] == -1) cmap[v] = cmap[mate[v]] = nc++;
+        return nc;
+      }
+
+      /**
+       * Construct the coarse graph from a matching. Coarse vertices
+       * are handled in chunks, by different tasks, and the chunks are
+       * concatenated afterwards.
+       */
+      template<typename integer_t> Graph<integer_t>
+      contract(const Graph<integer_t>& G, const std::vector<integer_t>& mate,
+               const std::vector<integer_t>& cmap, integer_t nc) {
+        Graph<integer_t> C;
+        C.n = nc;
+        C.weight = G.weight;
+        C.ptr.assign(nc+1, 0);
+        C.vw.resize(nc);
+        std::vector<integer_t> rep(nc);
+        for (integer_t v=0; v<G.n; v++)
+          if (v <= mate[v]) rep[cmap[v]] = v;
+        const integer_t B = chunk, nb = (nc + B - 1) / B;
+        std::vector<std::vector<integer_t>> cind(nb), cew(nb);
+#pragma omp taskloop default(shared) if(nb > 1)
+        for (integer_t b=0; b<nb; b++) {
+          std::vector<std::pair<integer_t,integer_t>> nbrs;
+          for (integer_t c=b*B; c<std::min(nc, (b+1)*B); c++) {
+            auto v = rep[c], u = mate[v];
+            nbrs.clear();
+            for (auto f : {v, u}) {
+              for (integer_t e=G.ptr[f]; e<G.ptr[f+1]; e++) {
+                auto cu = cmap[G.ind[e]];
+                if (cu != c) nbrs.emplace_back(cu, G.ew[e]);
+              }
+              if (u == v) break;
+            }
+            C.vw[c] = (u == v) ? G.vw[v] : G.vw[v] + G.vw[u];
+            std::sort(nbrs.begin(), nbrs.end());
+            integer_t deg = 0;
+            for (std::size_t i=0; i<nbrs.size(); i++) {
+              if (i && nbrs[i].first == nbrs[i-1].first)
+                cew[b].back() += nbrs[i].second;
+              else {
+                cind[b].push_back(nbrs[i].first);
+                cew[b].push_back(nbrs[i].second);
+                deg++;
+              }
+            }
+            C.ptr[c+1] = deg;
+          }
+        }
+        std::vector<integer_t> boff(nb+1, 0);
+        for (integer_t b=0; b<nb; b++)
+          boff[b+1] = boff[b] + cind[b].size();
+        for (integer_t c=0; c<nc; c++)
+          C.ptr[c+1] += C.ptr[c];
+        C.ind.resize(boff[nb]);
+        C.ew.resize(boff[nb]);
+#pragma omp taskloop default(shared) if(nb > 1)
+        for (integer_t b=0; b<nb; b++) {
+          std::copy(cind[b].begin(), cind[b].end(), C.ind.begin()+boff[b]);
+          std::copy(cew[b].begin(), cew[b].end(), C.ew.begin()+boff[b]);
+        }
+        return C;
+      }
+
+      /**
+       * Fiduccia-Mattheyses refinement of a 2-way partition,
+       * minimizing the (weighted) edge cut while keeping the weight
+       * of each part below maxw. Moves are selected from one priority
+       * queue per side, and every pass is rolled back to the best
+       * partition it encountered.
+       *
+       * This is serial: every move changes the gains of the
+       * neighbors, which determine the next move. The refinement is
+       * cheap compared to the coarsening, and different subgraphs
+       * are refined concurrently, in the tasks of dissect.
+       */
+      template<typename integer_t> void
+      fm_refine(const Graph<integer_t>& G, std::vector<int>& part,
+                integer_t maxw) {
+        auto n = G.n;
+        std::vector<integer_t> id(n, 0), ed(n, 0);
+        integer_t pw[2] = {0, 0};
+        for (integer_t v=0; v<n; v++) {
+          pw[part[v]] += G.vw[v];
+          for (integer_t e=G.ptr[v]; e<G.ptr[v+1]; e++)
+            if (part[G.ind[e]] == part[v]) id[v] += G.ew[e];
+            else ed[v] += G.ew[e];
+        }
+        using entry_t = std::pair<integer_t,integer_t>;
+        auto move = [&](integer_t v) {
+          auto s = part[v];
+          part[v] = 1 - s;
+          pw[s] -= G.vw[v];
+          pw[1-s] += G.vw[v];
+          std::swap(id[v], ed[v]);
+          for (integer_t e=G.ptr[v]; e<G.ptr[v+1]; e++) {
+            auto u = G.ind[e];
+            if (part[u] == s) { id[u] -= G.ew[e]; ed[u] += G.ew[e]; }
+            else { id[u] += G.ew[e]; ed[u] -= G.ew[e]; }
+          }
+        };
+        std::vector<char> locked(n);
+        std::vector<integer_t> moves;
+        for (int pass=0; pass<fm_passes; pass++) {
+          std::priority_queue<entry_t> q[2];
+          std::fill(locked.begin(), locked.end(), 0);
+          for (integer_t v=0; v<n; v++)
+            if (ed[v] > 0) q[part[v]].emplace(ed[v] - id[v], v);
+          moves.clear();
+          integer_t cut = 0, best_cut = 0;
+          auto imbalance = [&]() { return std::abs(pw[0] - pw[1]); };
+          auto best_imb = imbalance();
+          std::size_t best_pos = 0;
+          while (true) {
+            int s = -1;
+            integer_t g = 0;
+            for (int side=0; side<2; side++) {
+              auto& qs = q[side];
+              while (!qs.empty()) {
+                auto v = qs.top().second;
+                if (locked[v] || part[v] != side ||
+                    qs.top().first != ed[v] - id[v]) qs.pop();
+                else break;
+              }
+              if (qs.empty() ||
+                  pw[1-side] + G.vw[qs.top().second] > maxw) continue;
+              if (s == -1 || qs.top().first > g ||
+                  (qs.top().first == g && pw[side] > pw[s])) {
+                s = side;
+                g = qs.top().first;
+              }
+            }
+            if (s == -1) break;
+            auto v = q[s].top().second;
+            q[s].pop();
+            move(v);
+            locked[v] = 1;
+            moves.push_back(v);
+            cut -= g;
+            for (integer_t e=G.ptr[v]; e<G.ptr[v+1]; e++) {
+              auto u = G.ind[e];
+              if (!locked[u] && ed[u] > 0)
+                q[part[u]].emplace(ed[u] - id[u], u);
+            }
+            if (cut < best_cut || (cut == best_cut && imbalance() < best_imb)) {
+              best_cut = cut;
+              best_imb = imbalance();
+              best_pos = moves.size();
+            } else if (moves.size() - best_pos >
+                       std::size_t(fm_max_bad_moves)) break;
+          }
+          for (auto i=moves.size(); i>best_pos; i--)
+            move(moves[i-1]);
+          if (best_pos == 0) break;
+        }
+      }
+
+      /**
+       * Initial bisection of the coarsest graph, by growing one part
+       * in breadth first order from a few random vertices. The best
+       * partition, after FM refinement, is kept.
+       */
+      template<typename integer_t> void
+      initial_bisection(const Graph<integer_t>& G, std::vector<int>& part,
+                        std::mt19937& gen) {
+        auto n = G.n;
+        auto maxw = max_part_weight(G);
+        std::uniform_int_distribution<integer_t> rand_vertex(0, n-1);
+        std::vector<int> p(n);
+        std::vector<integer_t> q(n);
+        integer_t best_cut = -1;
+        for (int t=0; t<bisection_tries; t++) {
+          std::fill(p.begin(), p.end(), 1);
+          integer_t w0 = 0, head = 0, tail = 0, next = 0;
+          q[tail++] = rand_vertex(gen);
+          p[q[0]] = 0;
+          while (w0 < G.weight / 2) {
+            if (head == tail) {
+              // disconnected, restart from an unvisited vertex
+              while (p[next] == 0) next++;
+              q[tail++] = next;
+              p[next] = 0;
+            }
+            auto v = q[head++];
+            w0 += G.vw[v];
+            for (integer_t e=G.ptr[v]; e<G.ptr[v+1]; e++) {
+              auto u = G.ind[e];
+              if (p[u] == 1) {
+                p[u] = 0;
+                q[tail++] = u;
+              }
+            }
+          }
+          // vertices that were queued but not visited stay in part 1
+          for (integer_t i=head; i<tail; i++) p[q[i]] = 1;
+          fm_refine(G, p, maxw);
+          integer_t cut = 0;
+          for (integer_t v=0; v<n; v++)
+            for (integer_t e=G.ptr[v]; e<G.ptr[v+1]; e++)
+              if (p[G.ind[e]] != p[v]) cut += G.ew[e];
+          if (best_cut == -1 || cut < best_cut) {
+            best_cut = cut;
+            part = p;
+          }
+        }
+      }
+
+      /**
+       * Multilevel edge bisection: coarsen, bisect the coarsest graph
+       * and project back, with FM refinement on every level.
+       */
+      template<typename integer_t> void
+      multilevel_bisection(const Graph<integer_t>& G, std::vector<int>& part,
+                           std::mt19937& gen) {
+        std::vector<Graph<integer_t>> levels;
+        std::vector<std::vector<integer_t>> cmaps;
+        std::vector<integer_t> mate, cmap;
+        while (true) {
+          const auto& g = levels.empty() ? G : levels.back();
+          if (g.n <= coarsen_to) break;
+          auto nc = match(g, mate, cmap, gen);
+          // matching stalls, for instance on star like graphs
+          if (nc > 0.95 * g.n) break;
+          auto c = contract(g, mate, cmap, nc);
+          levels.push_back(std::move(c));
+          cmaps.push_back(std::move(cmap));
+        }
+        initial_bisection(levels.empty() ? G : levels.back(), part, gen);
+        while (!levels.empty()) {
+          levels.pop_back();
+          const auto& g = levels.empty() ? G : levels.back();
+          const auto& cm = cmaps.back();
+          std::vector<int> fpart(g.n);
+          for (integer_t v=0; v<g.n; v++)
+            fpart[v] = part[cm[v]];
+          part = std::move(fpart);
+          cmaps.pop_back();
+          fm_refine(g, part, max_part_weight(g));
+        }
+      }
+
+      /**
+       * Inertial bisection: split the vertices at the weighted median
+       * of their projection on the principal axis of the coordinates
+       * X (d x G.n, column major). The edge cut is then improved with
+       * FM, using only the graph.
+       */
+      template<typename integer_t> void
+      inertial_bisection(const Graph<integer_t>& G,
+                         const std::vector<double>& X, int d,
+                         std::vector<int>& part) {
+        auto n = G.n;
+        std::vector<double> c(d, 0.), C(d*d, 0.), a(d), b(d);
+        for (integer_t v=0; v<n; v++)
+          for (int i=0; i<d; i++)
+            c[i] += X[i+std::size_t(v)*d];
+        for (int i=0; i<d; i++) c[i] /= n;
+        for (integer_t v=0; v<n; v++)
+          for (int j=0; j<d; j++)
+            for (int i=0; i<d; i++)
+              C[i+j*d] += (X[i+std::size_t(v)*d] - c[i]) *
+                (X[j+std::size_t(v)*d] - c[j]);
+        // power iteration, starting from the coordinate axis with the
+        // largest spread
+        int imax = 0;
+        for (int i=1; i<d; i++)
+          if (C[i+i*d] > C[imax+imax*d]) imax = i;
+        std::fill(a.begin(), a.end(), 1e-3);
+        a[imax] = 1.;
+        for (int it=0; it<inertia_iterations; it++) {
+          double nrm = 0.;
+          for (int i=0; i<d; i++) {
+            b[i] = 0.;
+            for (int j=0; j<d; j++) b[i] += C[i+j*d] * a[j];
+            nrm += b[i] * b[i];
+          }
+          if (nrm == 0.) break;
+          nrm = std::sqrt(nrm);
+          for (int i=0; i<d; i++) a[i] = b[i] / nrm;
+        }
+        std::vector<std::pair<double,integer_t>> proj(n);
+        for (integer_t v=0; v<n; v++) {
+          double x = 0.;
+          for (int i=0; i<d; i++) x += a[i] * (X[i+std::size_t(v)*d] - c[i]);
+          proj[v] = {x, v};
+        }
+        std::sort(proj.begin(), proj.end());
+        part.resize(n);
+        integer_t w0 = 0;
+        for (auto& pv : proj) {
+          part[pv.second] = (w0 < G.weight / 2) ? 0 : 1;
+          w0 += G.vw[pv.second];
+        }
+        fm_refine(G, part, max_part_weight(G));
+      }
+
+      /**
+       * Turn an edge separator into a vertex separator (part 2), by
+       * computing a minimum vertex cover of the bipartite graph of
+       * cut edges (Koenig's theorem). Then greedily move separator
+       * vertices into one of the parts, when that reduces the size of
+       * the separator, or improves the balance without increasing
+       * it. Assumes unit vertex weights.
+       *
+       * Like fm_refine, this is serial, the augmenting path search
+       * and the greedy moves depend on the previous steps. It only
+       * touches the boundary of the edge separator.
+       */
+      template<typename integer_t> void
+      vertex_separator(const Graph<integer_t>& G, std::vector<int>& part) {
+        auto n = G.n;
+        std::vector<integer_t> L, mate(n, -1);
+        for (integer_t v=0; v<n; v++) {
+          if (part[v] != 0) continue;
+          bool boundary = false;
+          for (integer_t e=G.ptr[v]; e<G.ptr[v+1]; e++) {
+            auto u = G.ind[e];
+            if (part[u] != 1) continue;
+            boundary = true;
+            if (mate[u] == -1) {
+              mate[u] = v;
+              mate[v] = u;
+              break;
+            }
+          }
+          if (boundary) L.push_back(v);
+        }
+        // augmenting paths (Kuhn), visited marks are only reset after
+        // an augmentation, since a failed search cannot succeed later
+        // with the same matching
+        std::vector<integer_t> visit(n, 0), prev(n), q;
+        integer_t stamp = 1;
+        for (auto r : L) {
+          if (mate[r] != -1) continue;
+          q.assign(1, r);
+          visit[r] = stamp;
+          integer_t found = -1;
+          for (std::size_t h=0; h<q.size() && found == -1; h++) {
+            auto x = q[h];
+            for (integer_t e=G.ptr[x]; e<G.ptr[x+1]; e++) {
+              auto u = G.ind[e];
+              if (part[u] != 1 || visit[u] == stamp) continue;
+              visit[u] = stamp;
+              prev[u] = x;
+              if (mate[u] == -1) { found = u; break; }
+              visit[mate[u]] = stamp;
+              q.push_back(mate[u]);
+            }
+          }
+          if (found == -1) continue;
+          for (auto u=found; ; ) {
+            auto x = prev[u], xm = mate[x];
+            mate[x] = u;
+            mate[u] = x;
+            if (x == r) break;
+            u = xm;
+          }
+          stamp++;
+        }
+        // Z: reachable from unmatched left vertices by alternating paths
+        std::vector<char> Z(n, 0);
+        q.clear();
+        for (auto v : L)
+          if (mate[v] == -1) { Z[v] = 1; q.push_back(v); }
+        for (std::size_t h=0; h<q.size(); h++) {
+          auto x = q[h];
+          for (integer_t e=G.ptr[x]; e<G.ptr[x+1]; e++) {
+            auto u = G.ind[e];
+            if (part[u] != 1 || Z[u]) continue;
+            Z[u] = 1;
+            auto y = mate[u];
+            if (y != -1 && !Z[y]) { Z[y] = 1; q.push_back(y); }
+          }
+        }
+        // cover = (L \ Z) U (R n Z)
+        std::vector<integer_t> sep;
+        for (auto v : L)
+          if (!Z[v]) sep.push_back(v);
+        for (integer_t v=0; v<n; v++)
+          if (part[v] == 1 && Z[v]) sep.push_back(v);
+        for (auto v : sep) part[v] = 2;
+
+        integer_t pw[2] = {0, 0};
+        for (integer_t v=0; v<n; v++)
+          if (part[v] < 2) pw[part[v]]++;
+        auto maxw = max_part_weight(G);
+        for (int pass=0; pass<fm_passes; pass++) {
+          bool moved = false;
+          for (std::size_t i=0; i<sep.size(); i++) {
+            auto v = sep[i];
+            if (part[v] != 2) continue;
+            integer_t nb[2] = {0, 0};
+            for (integer_t e=G.ptr[v]; e<G.ptr[v+1]; e++) {
+              auto p = part[G.ind[e]];
+              if (p < 2) nb[p]++;
+            }
+            int s = -1;
+            integer_t bg = 0;
+            for (int side=0; side<2; side++) {
+              // moving v to side pulls its neighbors in 1-side into
+              // the separator
+              integer_t gain = 1 - nb[1-side];
+              if (pw[side] + 1 > maxw) continue;
+              auto imb = std::abs((pw[side] + 1) - (pw[1-side] - nb[1-side]));
+              if (gain > bg ||
+                  (gain == 0 && gain >= bg &&
+                   imb < std::abs(pw[0] - pw[1]))) {
+                s = side;
+                bg = gain;
+              }
+            }
+            if (s == -1) continue;
+            part[v] = s;
+            pw[s]++;
+            for (integer_t e=G.ptr[v]; e<G.ptr[v+1]; e++) {
+              auto u = G.ind[e];
+              if (part[u] == 1 - s) {
+                part[u] = 2;
+                pw[1-s]--;
+                sep.push_back(u);
+              }
+            }
+            moved = true;
+          }
+          if (!moved) break;
+          sep.erase(std::remove_if(sep.begin(), sep.end(),
+                                   [&](integer_t v){ return part[v] != 2; }),
+                    sep.end());
+        }
+      }
+
+      /**
+       * Extract the subgraph induced by the vertices in part p, and
+       * their coordinates, if any.
+       */
+      template<typename integer_t> void
+      extract(const Graph<integer_t>& G, const std::vector<integer_t>& gid,
+              const std::vector<double>& X, int d,
+              const std::vector<int>& part, const std::vector<integer_t>& loc,
+              int p, Graph<integer_t>& S, std::vector<integer_t>& sgid,
+              std::vector<double>& SX) {
+        S.ptr.assign(1, 0);
+        for (integer_t v=0; v<G.n; v++) {
+          if (part[v] != p) continue;
+          if (!X.empty())
+            SX.insert(SX.end(), X.begin()+std::size_t(v)*d,
+                      X.begin()+std::size_t(v+1)*d);
+          for (integer_t e=G.ptr[v]; e<G.ptr[v+1]; e++) {
+            auto u = G.ind[e];
+            if (part[u] == p) {
+              S.ind.push_back(loc[u]);
+              S.ew.push_back(1);
+            }
+          }
+          S.ptr.push_back(S.ind.size());
+          sgid.push_back(gid[v]);
+        }
+        S.n = sgid.size();
+        S.weight = S.n;
+        S.vw.assign(S.n, 1);
+      }
+
+      /**
+       * Recursively dissect G. When coordinates X (d per vertex) are
+       * given, inertial bisection is used instead of the multilevel
+       * bisection.
+       */
+      template<typename integer_t> void
+      dissect(Graph<integer_t>& G, std::vector<integer_t>& gid,
+              std::vector<double>& X, int d, Node<integer_t>& node,
+              int leaf_size, std::uint64_t path, int depth) {
+        if (G.n <= leaf_size) {
+          node.vertices = std::move(gid);
+          return;
+        }
+        std::vector<int> part;
+        if (X.empty()) {
+          // seed depends on the position in the tree only, so the
+          // ordering does not depend on the number of threads
+          std::seed_seq seed{std::uint32_t(path), std::uint32_t(path >> 32)};
+          std::mt19937 gen(seed);
+          multilevel_bisection(G, part, gen);
+        } else inertial_bisection(G, X, d, part);
+        vertex_separator(G, part);
+        integer_t cnt[3] = {0, 0, 0};
+        for (auto p : part) cnt[p]++;
+        if (cnt[2] == 0 && cnt[0] && cnt[1]) {
+          // disconnected parts, use one vertex as separator
+          int p = (cnt[0] > cnt[1]) ? 0 : 1;
+          *std::find(part.begin(), part.end(), p) = 2;
+          cnt[p]--;
+          cnt[2]++;
+        }
+        if (!cnt[0] || !cnt[1]) {
+          // no (balanced) separator, for instance for a dense block
+          node.vertices = std::move(gid);
+          return;
+        }
+        std::vector<integer_t> loc(G.n), c(3, 0);
+        for (integer_t v=0; v<G.n; v++) {
+          loc[v] = c[part[v]]++;
+          if (part[v] == 2) node.vertices.push_back(gid[v]);
+        }
+        Graph<integer_t> G0, G1;
+        std::vector<integer_t> gid0, gid1;
+        std::vector<double> X0, X1;
+        extract(G, gid, X, d, part, loc, 0, G0, gid0, X0);
+        extract(G, gid, X, d, part, loc, 1, G1, gid1, X1);
+        G = Graph<integer_t>();
+        std::vector<integer_t>().swap(gid);
+        std::vector<double>().swap(X);
+        node.left.reset(new Node<integer_t>());
+        node.right.reset(new Node<integer_t>());
+#pragma omp task default(shared)                                        \
+  if(depth < params::task_recursion_cutoff_level)                       \
+  final(depth >= params::task_recursion_cutoff_level-1) mergeable
+        dissect(G0, gid0, X0, d, *node.left, leaf_size, 2*path, depth+1);
+#pragma omp task default(shared)                                        \
+  if(depth < params::task_recursion_cutoff_level)                       \
+  final(depth >= params::task_recursion_cutoff_level-1) mergeable
+        dissect(G1, gid1, X1, d, *node.right, leaf_size, 2*path+1, depth+1);
+#pragma omp taskwait
+      }
+
+      /**
+       * Number the vertices in postorder, and add the separators to
+       * seps, returning the index of node.
+       */
+      template<typename integer_t> integer_t
+      number(const Node<integer_t>& node, integer_t& pos,
+             std::vector<integer_t>& perm, std::vector<integer_t>& iperm,
+             std::vector<Separator<integer_t>>& seps) {
+        integer_t lch = -1, rch = -1;
+        if (node.left) {
+          lch = number(*node.left, pos, perm, iperm, seps);
+          rch = number(*node.right, pos, perm, iperm, seps);
+        }
+        for (auto v : node.vertices) {
+          perm[v] = pos;
+          iperm[pos++] = v;
+        }
+        seps.emplace_back(pos, -1, lch, rch);
+        integer_t id = seps.size() - 1;
+        if (lch != -1) seps[lch].pa = seps[rch].pa = id;
+        return id;
+      }
+
+      /**
+       * Graph with unit weights, without the diagonal entries.
+       */
+      template<typename integer_t> Graph<integer_t>
+      make_graph(integer_t n, const integer_t* ptr, const integer_t* ind) {
+        Graph<integer_t> G;
+        G.n = G.weight = n;
+        G.ptr.resize(n+1);
+        G.ind.reserve(ptr[n]);
+        for (integer_t j=0; j<n; j++) {
+          G.ptr[j] = G.ind.size();
+          for (integer_t t=ptr[j]; t<ptr[j+1]; t++)
+            if (ind[t] != j) G.ind.push_back(ind[t]);
+        }
+        G.ptr[n] = G.ind.size();
+        G.vw.assign(n, 1);
+        G.ew.assign(G.ind.size(), 1);
+        return G;
+      }
+
+      template<typename integer_t> SeparatorTree<integer_t>
+      reorder(integer_t n, const integer_t* ptr, const integer_t* ind,
+              std::vector<double>& X, int d, std::vector<integer_t>& perm,
+              std::vector<integer_t>& iperm, int leaf_size) {
+        auto G = make_graph(n, ptr, ind);
+        if (G.ind.empty())
+          if (mpi_root())
+            std::cerr << "# WARNING: matrix seems to be diagonal!" << std::endl;
+        std::vector<integer_t> gid(n);
+        std::iota(gid.begin(), gid.end(), 0);
+        Node<integer_t> root;
+#pragma omp parallel if(!omp_in_parallel())
+#pragma omp single nowait
+        dissect(G, gid, X, d, root, std::max(1, leaf_size), 1, 0);
+        std::vector<Separator<integer_t>> seps;
+        integer_t pos = 0;
+        number(root, pos, perm, iperm, seps);
+        return SeparatorTree<integer_t>(seps);
+      }
+
+    } // end namespace nd
+
+    template<typename integer_t> SeparatorTree<integer_t>
+    nd_reordering(integer_t n, const integer_t* ptr, const integer_t* ind,
+                  std::vector<integer_t>& perm,
+                  std::vector<integer_t>& iperm, int leaf_size) {
+      std::vector<double> X;
+      return nd::reorder(n, ptr, ind, X, 0, perm, iperm, leaf_size);
+    }
+
+    template<typename integer_t> void
+    graph_bisection(integer_t n, const integer_t* ptr, const integer_t* ind,
+                    std::vector<int>& part) {
+      part.assign(n, 0);
+      if (n < 2) return;
+      auto G = nd::make_graph(n, ptr, ind);
+      std::mt19937 gen(1);
+      nd::multilevel_bisection(G, part, gen);
+    }
+
+    template<typename integer_t,typename real_t> SeparatorTree<integer_t>
+    coordinate_nd_reordering(integer_t n, const integer_t* ptr,
+                             const integer_t* ind, int d, const real_t* X,
+                             int ldX, std::vector<integer_t>& perm,
+                             std::vector<integer_t>& iperm, int leaf_size) {
+      std::vector<double> Xd(std::size_t(n)*d);
+      for (integer_t v=0; v<n; v++)
+        for (int i=0; i<d; i++)
+          Xd[i+std::size_t(v)*d] = X[i+std::size_t(v)*ldX];
+      return nd::reorder(n, ptr, ind, Xd, d, perm, iperm, leaf_size);
+    }
+
+    // explicit template instantiations
+    template SeparatorTree<int>
+    nd_reordering(int n, const int* ptr, const int* ind,
+                  std::vector<int>& perm, std::vector<int>& iperm,
+                  int leaf_size);
+    template SeparatorTree<long>
+    nd_reordering(long n, const long* ptr, const long* ind,
+                  std::vector<long>& perm, std::vector<long>& iperm,
+                  int leaf_size);
+    template SeparatorTree<long long int>
+    nd_reordering(long long int n, const long long int* ptr,
+                  const long long int* ind,
+                  std::vector<long long int>& perm,
+                  std::vector<long long int>& iperm, int leaf_size);
+
+    template void
+    graph_bisection(int n, const int* ptr, const int* ind,
+                    std::vector<int>& part);
+    template void
+    graph_bisection(long n, const long* ptr, const long* ind,
+                    std::vector<int>& part);
+    template void
+    graph_bisection(long long int n, const long long int* ptr,
+                    const long long int* ind, std::vector<int>& part);
+
+    template SeparatorTree<int>
+    coordinate_nd_reordering(int n, const int* ptr, const int* ind,
+                             int d, const float* X, int ldX,
+                             std::vector<int>& perm,
+                             std::vector<int>& iperm, int leaf_size);
+    template SeparatorTree<int>
+    coordinate_nd_reordering(int n, const int* ptr, const int* ind,
+                             int d, const double* X, int ldX,
+                             std::vector<int>& perm,
+                             std::vector<int>& iperm, int leaf_size);
+    template SeparatorTree<long>
+    coordinate_nd_reordering(long n, const long* ptr, const long* ind,
+                             int d, const float* X, int ldX,
+                             std::vector<long>& perm,
+                             std::vector<long>& iperm, int leaf_size);
+    template SeparatorTree<long>
+    coordinate_nd_reordering(long n, const long* ptr, const long* ind,
+                             int d, const double* X, int ldX,
+                             std::vector<long>& perm,
+                             std::vector<long>& iperm, int leaf_size);
+    template SeparatorTree<long long int>
+    coordinate_nd_reordering(long long int n, const long long int* ptr,
+                             const long long int* ind,
+                             int d, const float* X, int ldX,
+                             std::vector<long long int>& perm,
+                             std::vector<long long int>& iperm, int leaf_size);
+    template SeparatorTree<long long int>
+    coordinate_nd_reordering(long long int n, const long long int* ptr,
+                             const long long int* ind,
+                             int d, const double* X, int ldX,
+                             std::vector<long long int>& perm,
+                             std::vector<long long int>& iperm, int leaf_size);
+
+  } // end namespace ordering
+} // end namespace strumpack
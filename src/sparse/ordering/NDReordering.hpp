@@ -0,0 +1,132 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#ifndef STRUMPACK_ORDERING_ND_REORDERING_HPP
+#define STRUMPACK_ORDERING_ND_REORDERING_HPP
+
+#include <vector>
+
+#include "sparse/SeparatorTree.hpp"
+
+namespace strumpack {
+  namespace ordering {
+
+    /**
+     * Multilevel nested dissection, using heavy edge matching for the
+     * coarsening, greedy graph growing for the initial bisection and
+     * Fiduccia-Mattheyses refinement during uncoarsening. The edge
+     * separator is converted to a minimum vertex separator, which is
+     * then further refined. The two halves are ordered recursively,
+     * as separate OpenMP tasks, and the separator tree is constructed
+     * directly from the recursion.
+     *
+     * Within one bisection, the matching and the construction of the
+     * coarse graphs are multithreaded. The FM refinement and the
+     * vertex separator computation are serial, so the top levels of
+     * the recursion, before there are enough independent subgraphs,
+     * do not use all threads during these phases.
+     *
+     * \param n number of vertices in the graph
+     * \param ptr row pointers, the sparsity pattern should be
+     * symmetric, diagonal entries are ignored
+     * \param ind column indices
+     * \param perm output, perm[i] is the new position of vertex i
+     * \param iperm output, inverse of perm
+     * \param leaf_size stop the recursion for subgraphs with at most
+     * leaf_size vertices
+     * \return the separator tree, in postorder, matching perm
+     */
+    template<typename integer_t> SeparatorTree<integer_t>
+    nd_reordering(integer_t n, const integer_t* ptr, const integer_t* ind,
+                  std::vector<integer_t>& perm,
+                  std::vector<integer_t>& iperm, int leaf_size);
+
+    template<typename integer_t,typename G> SeparatorTree<integer_t>
+    nd_reordering(const G& A, std::vector<integer_t>& perm,
+                  std::vector<integer_t>& iperm, int leaf_size) {
+      return nd_reordering<integer_t>
+        (A.size(), A.ptr(), A.ind(), perm, iperm, leaf_size);
+    }
+
+    /**
+     * Multilevel edge bisection, as used by nd_reordering, without
+     * the conversion to a vertex separator. This replaces
+     * METIS_PartGraphRecursive (with 2 parts) when STRUMPACK is built
+     * without Metis.
+     *
+     * \param n number of vertices in the graph
+     * \param ptr row pointers, the sparsity pattern should be
+     * symmetric, diagonal entries are ignored
+     * \param ind column indices
+     * \param part output, part[i] is 0 or 1, the part of vertex i
+     */
+    template<typename integer_t> void
+    graph_bisection(integer_t n, const integer_t* ptr, const integer_t* ind,
+                    std::vector<int>& part);
+
+    /**
+     * Geometric nested dissection for (unstructured) meshes with
+     * known vertex coordinates. Every subgraph is bisected at the
+     * median of its principal (inertial) axis, the edge cut is then
+     * improved with FM refinement, and converted to a minimum vertex
+     * separator as in nd_reordering. This avoids the coarsening
+     * phase, and is much cheaper than graph based nested dissection.
+     *
+     * \param n number of vertices in the graph
+     * \param ptr row pointers, the sparsity pattern should be
+     * symmetric, diagonal entries are ignored
+     * \param ind column indices
+     * \param d number of spatial dimensions
+     * \param X coordinates, d x n, column major, with leading
+     * dimension ldX, column i holds the coordinates of vertex i
+     * \param ldX leading dimension of X, ldX >= d
+     * \param perm output, perm[i] is the new position of vertex i
+     * \param iperm output, inverse of perm
+     * \param leaf_size stop the recursion for subgraphs with at most
+     * leaf_size vertices
+     * \return the separator tree, in postorder, matching perm
+     */
+    template<typename integer_t,typename real_t> SeparatorTree<integer_t>
+    coordinate_nd_reordering(integer_t n, const integer_t* ptr,
+                             const integer_t* ind, int d, const real_t* X,
+                             int ldX, std::vector<integer_t>& perm,
+                             std::vector<integer_t>& iperm, int leaf_size);
+
+    template<typename integer_t,typename real_t,typename G>
+    SeparatorTree<integer_t>
+    coordinate_nd_reordering(const G& A, int d, const real_t* X, int ldX,
+                             std::vector<integer_t>& perm,
+                             std::vector<integer_t>& iperm, int leaf_size) {
+      return coordinate_nd_reordering<integer_t,real_t>
+        (A.size(), A.ptr(), A.ind(), d, X, ldX, perm, iperm, leaf_size);
+    }
+
+  } // end namespace ordering
+} // end namespace strumpack
+
+#endif // STRUMPACK_ORDERING_ND_REORDERING_HPP
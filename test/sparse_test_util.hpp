@@ -0,0 +1,145 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#ifndef STRUMPACK_SPARSE_TEST_UTIL_HPP
+#define STRUMPACK_SPARSE_TEST_UTIL_HPP
+
+#include <iostream>
+#include <random>
+#include <cmath>
+
+#include "StrumpackSparseSolver.hpp"
+#include "sparse/CSRMatrix.hpp"
+#include "sparse/fronts/FrontFactory.hpp"
+
+namespace strumpack {
+
+  /**
+   * 2D 5-point convection-diffusion operator on an n x n grid, with
+   * convection velocity (c, c). This matrix is not symmetric, unless
+   * c = 0. With scale_rows, row i is scaled by 1 + (i % 7), so that
+   * equilibration and matching have an effect.
+   */
+  template<typename scalar_t,typename integer_t>
+  CSRMatrix<scalar_t,integer_t>
+  convection_diffusion(integer_t n, scalar_t c, bool scale_rows=false) {
+    integer_t N = n * n, nnz = 5 * N - 4 * n;
+    CSRMatrix<scalar_t,integer_t> A(N, nnz);
+    auto ptr = A.ptr();
+    auto ind = A.ind();
+    auto val = A.val();
+    nnz = 0;
+    ptr[0] = 0;
+    for (integer_t row=0; row<n; row++) {
+      for (integer_t col=0; col<n; col++) {
+        integer_t i = col+n*row;
+        scalar_t s(scale_rows ? 1 + (i % 7) : 1);
+        if (row > 0)   { val[nnz] = s*(scalar_t(-1.)-c); ind[nnz++] = i-n; }
+        if (col > 0)   { val[nnz] = s*(scalar_t(-1.)-c); ind[nnz++] = i-1; }
+        val[nnz] = s*scalar_t(4.); ind[nnz++] = i;
+        if (col < n-1) { val[nnz] = s*(scalar_t(-1.)+c); ind[nnz++] = i+1; }
+        if (row < n-1) { val[nnz] = s*(scalar_t(-1.)+c); ind[nnz++] = i+n; }
+        ptr[i+1] = nnz;
+      }
+    }
+    return A;
+  }
+
+  /**
+   * 2D 5-point Laplacian on an n x n grid.
+   */
+  template<typename scalar_t,typename integer_t>
+  CSRMatrix<scalar_t,integer_t> laplacian2d(integer_t n) {
+    return convection_diffusion<scalar_t,integer_t>(n, scalar_t(0.));
+  }
+
+  /**
+   * Solve with a random right-hand side, and return 1 if the
+   * relative residual is too large.
+   */
+  template<typename scalar_t,typename integer_t> int
+  check_solve(StrumpackSparseSolver<scalar_t,integer_t>& spss,
+              const CSRMatrix<scalar_t,integer_t>& A, int seed, int nrhs) {
+    using real_t = typename RealType<scalar_t>::value_type;
+    std::minstd_rand gen(seed);
+    std::uniform_real_distribution<real_t> dis(-1., 1.);
+    DenseMatrix<scalar_t> b(A.size(), nrhs), x(A.size(), nrhs),
+      r(A.size(), nrhs);
+    for (std::size_t j=0; j<b.cols(); j++)
+      for (std::size_t i=0; i<b.rows(); i++)
+        b(i, j) = dis(gen);
+    if (spss.solve(b, x) != ReturnCode::SUCCESS)
+      return 1;
+    A.spmv(x, r);
+    r.scaled_add(scalar_t(-1.), b);
+    auto res = r.normF() / b.normF();
+    if (res > std::sqrt(blas::lamch<real_t>('E'))) {
+      std::cout << "ERROR: seed " << seed << ", relative residual "
+                << res << std::endl;
+      return 1;
+    }
+    return 0;
+  }
+
+  /**
+   * If amalgamation is enabled in the options of spss, which should
+   * be reordered already, check that fronts were amalgamated and that
+   * there are fewer fronts than without amalgamation, for the same
+   * matrix and options. Returns 1 on failure.
+   */
+  template<typename scalar_t,typename integer_t> int
+  check_amalgamation(const StrumpackSparseSolver<scalar_t,integer_t>& spss,
+                     const CSRMatrix<scalar_t,integer_t>& A,
+                     integer_t nx, integer_t ny) {
+    if (!spss.options().amalgamation()) return 0;
+    auto nr_fronts = [](const FrontCounter& fc) {
+      return fc.dense + fc.HSS + fc.BLR + fc.HODLR + fc.lossy;
+    };
+    StrumpackSparseSolver<scalar_t,integer_t> ref(false);
+    ref.options() = spss.options();
+    ref.options().set_amalgamation_ratio(0.);
+    ref.options().set_amalgamation_size(0);
+    ref.set_matrix(A);
+    if (ref.reorder(nx, ny) != ReturnCode::SUCCESS) {
+      std::cout << "ERROR: reordering failed" << std::endl;
+      return 1;
+    }
+    auto fc = spss.front_counter(), fc_ref = ref.front_counter();
+    std::cout << "# fronts = " << nr_fronts(fc) << ", amalgamated = "
+              << fc.amalgamated << ", without amalgamation = "
+              << nr_fronts(fc_ref) << std::endl;
+    if (fc.amalgamated <= 0 || nr_fronts(fc) >= nr_fronts(fc_ref)) {
+      std::cout << "ERROR: no fronts were amalgamated" << std::endl;
+      return 1;
+    }
+    return 0;
+  }
+
+} // end namespace strumpack
+
+#endif // STRUMPACK_SPARSE_TEST_UTIL_HPP
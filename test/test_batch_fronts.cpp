@@ -0,0 +1,283 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <random>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cmath>
+using namespace std;
+
+#include "StrumpackSparseSolver.hpp"
+#include "sparse/CSRMatrix.hpp"
+#include "sparse/FactorFile.hpp"
+#include "sparse/fronts/FrontalMatrixDense.hpp"
+#include "sparse/fronts/FrontalMatrixBatchKernels.hpp"
+
+using namespace strumpack;
+
+/**
+ * Complete binary tree of fronts, with separator size sizes[l] at
+ * level l (the root is level 0). Every separator is coupled to all
+ * its ancestors, so the update set of a front is the union of the
+ * separators of its ancestors. The unknowns are numbered in
+ * postorder.
+ */
+struct BinaryTree {
+  std::vector<int> begin, end, level, lchild, rchild, parent;
+
+  BinaryTree(const std::vector<int>& sizes) {
+    build(sizes, 0, -1);
+  }
+  int size() const { return begin.size(); }
+  int unknowns() const { return end.back(); }
+  std::vector<int> upd(int v) const {
+    std::vector<int> u;
+    for (int p=parent[v]; p!=-1; p=parent[p])
+      for (int i=begin[p]; i<end[p]; i++) u.push_back(i);
+    std::sort(u.begin(), u.end());
+    return u;
+  }
+
+private:
+  int build(const std::vector<int>& sizes, int l, int pa) {
+    int lc = -1, rc = -1;
+    std::vector<int> ch;
+    if (l+1 < int(sizes.size())) {
+      lc = build(sizes, l+1, -2);
+      rc = build(sizes, l+1, -2);
+    }
+    int v = size(), b = v ? end.back() : 0;
+    begin.push_back(b);
+    end.push_back(b + sizes[l]);
+    level.push_back(l);
+    lchild.push_back(lc);
+    rchild.push_back(rc);
+    parent.push_back(pa);
+    if (lc != -1) parent[lc] = parent[rc] = v;
+    return v;
+  }
+};
+
+/**
+ * Matrix with the sparsity of the tree: the diagonal blocks, and the
+ * couplings between a separator and its ancestors, random, not
+ * symmetric, and not diagonally dominant within a separator, so
+ * that the LU factorization of the fronts needs pivoting.
+ */
+template<typename scalar_t> CSRMatrix<scalar_t,int>
+tree_matrix(const BinaryTree& t) {
+  using real_t = typename RealType<scalar_t>::value_type;
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<real_t> dis(-1., 1.);
+  auto rnd = [&]() { return scalar_t(dis(gen)); };
+  const int N = t.unknowns();
+  std::vector<std::vector<int>> cols(N);
+  for (int v=0; v<t.size(); v++) {
+    auto u = t.upd(v);
+    for (int i=t.begin[v]; i<t.end[v]; i++) {
+      for (int j=t.begin[v]; j<t.end[v]; j++) cols[i].push_back(j);
+      for (auto j : u) {
+        cols[i].push_back(j);
+        cols[j].push_back(i);
+      }
+    }
+  }
+  int nnz = 0;
+  for (auto& c : cols) {
+    std::sort(c.begin(), c.end());
+    nnz += c.size();
+  }
+  CSRMatrix<scalar_t,int> A(N, nnz);
+  nnz = 0;
+  A.ptr()[0] = 0;
+  for (int i=0; i<N; i++) {
+    for (auto j : cols[i]) {
+      A.ind()[nnz] = j;
+      A.val()[nnz++] = (i == j) ? real_t(.5) + rnd() : rnd() / real_t(16.);
+    }
+    A.ptr()[i+1] = nnz;
+  }
+  return A;
+}
+
+template<typename scalar_t> std::unique_ptr<FrontalMatrix<scalar_t,int>>
+tree_fronts(const BinaryTree& t,
+            std::vector<FrontalMatrixDense<scalar_t,int>*>& fs) {
+  using FD_t = FrontalMatrixDense<scalar_t,int>;
+  std::vector<std::unique_ptr<FD_t>> f(t.size());
+  fs.resize(t.size());
+  for (int v=0; v<t.size(); v++) {
+    auto u = t.upd(v);
+    f[v].reset(new FD_t(v, t.begin[v], t.end[v], u));
+    fs[v] = f[v].get();
+    if (t.lchild[v] != -1) {
+      f[v]->set_lchild(std::move(f[t.lchild[v]]));
+      f[v]->set_rchild(std::move(f[t.rchild[v]]));
+    }
+  }
+  return std::move(f.back());
+}
+
+std::string read_file(const std::string& fname) {
+  std::ifstream f(fname);
+  std::stringstream ss;
+  ss << f.rdbuf();
+  return ss.str();
+}
+
+int count(const std::string& s, const std::string& w) {
+  int n = 0;
+  for (auto p=s.find(w); p!=std::string::npos; p=s.find(w, p+1)) n++;
+  return n;
+}
+
+/**
+ * Factor the tree of small fronts with and without the batched
+ * kernels. The pivots should be the same, and the factors and the
+ * solution should agree up to rounding.
+ */
+template<typename scalar_t> int test_batch(const std::vector<int>& sizes) {
+  using real_t = typename RealType<scalar_t>::value_type;
+  BinaryTree t(sizes);
+  auto A = tree_matrix<scalar_t>(t);
+  const int N = A.size();
+  DenseMatrix<scalar_t> b(N, 2), x[2], r(N, 2);
+  b.random();
+  const std::string tname = "test_batch_fronts.json";
+  const std::string fname[2] = {"test_batch_fronts_0.bin",
+                                "test_batch_fronts_1.bin"};
+  for (int batch : {0, 1}) {
+    std::vector<FrontalMatrixDense<scalar_t,int>*> fs;
+    auto root = tree_fronts<scalar_t>(t, fs);
+    SPOptions<scalar_t> opts;
+    if (batch) opts.enable_small_front_batching();
+    else opts.disable_small_front_batching();
+    Tracer::clear();
+    Tracer::start();
+    auto ierr = root->multifrontal_factorization(A, opts);
+    Tracer::stop();
+    if (ierr != ReturnCode::SUCCESS) {
+      cout << "ERROR: factorization failed" << endl;
+      return 1;
+    }
+    Tracer::write(tname);
+    auto s = read_file(tname);
+    std::remove(tname.c_str());
+    Tracer::clear();
+    int nbatch = count(s, "\"name\":\"factor_batch\"");
+    if (nbatch != (batch ? t.size() : 0)) {
+      cout << "ERROR: " << nbatch << " of " << t.size()
+           << " fronts factored with the batched kernels" << endl;
+      return 1;
+    }
+    {
+      FactorFileWriter f(fname[batch]);
+      for (auto fr : fs) fr->save_factors(f);
+      if (!f.good()) {
+        cout << "ERROR: could not write the factors" << endl;
+        return 1;
+      }
+    }
+    x[batch] = b;
+    root->multifrontal_solve(Trans::N, x[batch]);
+    A.spmv(x[batch], r);
+    r.scaled_add(scalar_t(-1.), b);
+    auto res = r.normF() / b.normF();
+    cout << "# " << (batch ? "batched" : "LAPACK") << " fronts, N= " << N
+         << " ||Ax-b||/||b|| = " << res << endl;
+    if (res > 1e3 * blas::lamch<real_t>('E') * N) {
+      cout << "ERROR: residual too large" << endl;
+      return 1;
+    }
+  }
+  int ierr = 0;
+  const auto tol = 1e4 * blas::lamch<real_t>('E');
+  {
+    FactorFileReader f0(fname[0]), f1(fname[1]);
+    real_t ferr(0.);
+    for (int v=0; v<t.size() && !ierr; v++) {
+      MatrixSymmetry s0, s1;
+      std::vector<int> piv0, piv1;
+      f0.read(s0); f1.read(s1);
+      f0.read(piv0); f1.read(piv1);
+      if (piv0 != piv1) {
+        cout << "ERROR: different pivots in front " << v << endl;
+        ierr = 1;
+      }
+      for (int m=0; m<3; m++) {
+        auto F0 = f0.template read_matrix<scalar_t>();
+        auto F1 = f1.template read_matrix<scalar_t>();
+        if (F0.rows() != F1.rows() || F0.cols() != F1.cols()) {
+          cout << "ERROR: different factor sizes in front " << v << endl;
+          ierr = 1;
+          break;
+        }
+        DenseMatrix<scalar_t> D(F0);
+        D.scaled_add(scalar_t(-1.), F1);
+        if (F0.rows() && F0.cols())
+          ferr = std::max(ferr, D.normF() / F0.normF());
+      }
+    }
+    if (!f0.good() || !f1.good()) {
+      cout << "ERROR: could not read the factors" << endl;
+      ierr = 1;
+    }
+    cout << "# max relative difference of the factors = " << ferr << endl;
+    if (ferr > tol) {
+      cout << "ERROR: factors differ" << endl;
+      ierr = 1;
+    }
+  }
+  std::remove(fname[0].c_str());
+  std::remove(fname[1].c_str());
+  x[1].scaled_add(scalar_t(-1.), x[0]);
+  auto xerr = x[1].normF() / x[0].normF();
+  cout << "# relative difference of the solutions = " << xerr << endl;
+  if (xerr > tol * N) {
+    cout << "ERROR: solutions differ" << endl;
+    ierr = 1;
+  }
+  return ierr;
+}
+
+int main(int argc, char* argv[]) {
+  // separator sizes per level, from the root down, covering all size
+  // buckets of the batched kernels, with 255 fronts, and update sets
+  // up to 57 <= batch::max_update_size
+  std::vector<int> sizes = {20, 12, 8, 6, 5, 4, 2, 1};
+  int ierr = 0;
+  ierr |= test_batch<double>(sizes);
+  ierr |= test_batch<float>(sizes);
+  ierr |= test_batch<std::complex<double>>(sizes);
+  return ierr;
+}
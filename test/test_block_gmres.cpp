@@ -0,0 +1,103 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#include <iostream>
+#include <random>
+#include <cmath>
+#include <algorithm>
+using namespace std;
+
+#include "iterative/IterativeSolvers.hpp"
+
+using namespace strumpack;
+
+/**
+ * Block GMRes with a diagonal matrix. If rhs_0 is a unit vector, the
+ * first right-hand side lies in an invariant subspace of A and its
+ * Krylov space breaks down after one step, while the other
+ * right-hand side still needs more iterations.
+ */
+template<typename scalar_t> int
+test_block_gmres(GramSchmidtType gs, bool invariant) {
+  using real_t = typename RealType<scalar_t>::value_type;
+  const std::size_t n = 100, nrhs = 2;
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<real_t> dis(-1., 1.);
+  DenseMatrix<scalar_t> b(n, nrhs), x(n, nrhs), r(n, nrhs);
+  for (std::size_t j=0; j<nrhs; j++)
+    for (std::size_t i=0; i<n; i++)
+      b(i, j) = dis(gen);
+  if (invariant) {
+    for (std::size_t i=0; i<n; i++)
+      b(i, 0) = scalar_t(0.);
+    b(0, 0) = scalar_t(1.);
+  }
+  auto spmv = [&](const DenseMatrix<scalar_t>& v, DenseMatrix<scalar_t>& w) {
+    for (std::size_t j=0; j<v.cols(); j++)
+      for (std::size_t i=0; i<n; i++)
+        w(i, j) = real_t(i+1) * v(i, j);
+  };
+  auto prec = [](DenseMatrix<scalar_t>&) {};
+  int its = 0;
+  const real_t rtol =
+    std::max(real_t(1e-10), 100 * blas::lamch<real_t>('E'));
+  iterative::BlockGMRes<scalar_t>
+    (spmv, prec, x, b, rtol, real_t(1e-20), its, 200, 30, gs, false, false);
+  spmv(x, r);
+  for (std::size_t j=0; j<nrhs; j++) {
+    real_t rn(0.), bn(0.);
+    for (std::size_t i=0; i<n; i++) {
+      if (!std::isfinite(std::abs(x(i, j)))) {
+        cout << "ERROR: solution not finite" << endl;
+        return 1;
+      }
+      rn += std::norm(r(i, j) - b(i, j));
+      bn += std::norm(b(i, j));
+    }
+    auto res = std::sqrt(rn / bn);
+    cout << "# " << (invariant ? "invariant" : "generic") << " rhs, "
+         << (gs == GramSchmidtType::CLASSICAL ? "classical" : "modified")
+         << " GS, column " << j << ", its = " << its
+         << ", relative residual = " << res << endl;
+    if (!(res <= 10 * rtol)) {
+      cout << "ERROR: residual too large" << endl;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  int ierr = 0;
+  for (auto gs : {GramSchmidtType::CLASSICAL, GramSchmidtType::MODIFIED})
+    for (bool invariant : {false, true}) {
+      ierr |= test_block_gmres<double>(gs, invariant);
+      ierr |= test_block_gmres<std::complex<float>>(gs, invariant);
+    }
+  return ierr;
+}
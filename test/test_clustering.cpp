@@ -0,0 +1,179 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#include <iostream>
+#include <random>
+#include <numeric>
+using namespace std;
+
+#include "clustering/Clustering.hpp"
+#include "clustering/NeighborSearch.hpp"
+#include "kernel/Metrics.hpp"
+
+using namespace strumpack;
+
+/**
+ * Check that the tree is consistent, that perm is a permutation and
+ * that the data was permuted accordingly.
+ */
+template<typename real_t> int
+check_tree(const structured::ClusterTree& t, const DenseMatrix<real_t>& X,
+           const DenseMatrix<real_t>& Xp, const std::vector<int>& perm,
+           std::size_t leaf) {
+  std::function<bool(const structured::ClusterTree&)> ok =
+    [&](const structured::ClusterTree& t) {
+    if (t.c.empty()) return true;
+    return t.c.size() == 2 && t.size == t.c[0].size + t.c[1].size &&
+      t.size >= int(leaf) && ok(t.c[0]) && ok(t.c[1]);
+  };
+  if (t.size != int(X.cols()) || !ok(t)) {
+    cout << "ERROR: inconsistent cluster tree" << endl;
+    return 1;
+  }
+  std::vector<int> sp(perm);
+  std::sort(sp.begin(), sp.end());
+  for (std::size_t i=0; i<sp.size(); i++)
+    if (sp[i] != int(i+1)) {
+      cout << "ERROR: not a permutation" << endl;
+      return 1;
+    }
+  for (std::size_t j=0; j<X.cols(); j++)
+    for (std::size_t i=0; i<X.rows(); i++)
+      if (Xp(i, j) != X(i, perm[j]-1)) {
+        cout << "ERROR: data not permuted" << endl;
+        return 1;
+      }
+  return 0;
+}
+
+bool same_tree(const structured::ClusterTree& a,
+               const structured::ClusterTree& b) {
+  if (a.size != b.size || a.c.size() != b.c.size()) return false;
+  for (std::size_t i=0; i<a.c.size(); i++)
+    if (!same_tree(a.c[i], b.c[i])) return false;
+  return true;
+}
+
+/**
+ * The kd-tree and 2-means clustering, with one and with several
+ * threads, should give the same tree and permutation.
+ */
+template<typename real_t> int
+test_clustering(ClusteringAlgorithm algo, std::size_t n, std::size_t d) {
+  std::mt19937 gen(1);
+  std::normal_distribution<real_t> dis(0., 1.);
+  DenseMatrix<real_t> X(d, n);
+  for (std::size_t j=0; j<n; j++)
+    for (std::size_t i=0; i<d; i++)
+      X(i, j) = dis(gen) + ((j % 3) ? real_t(0.) : real_t(4.));
+  const std::size_t leaf = 16;
+  structured::ClusterTree t[2];
+  std::vector<int> perm[2];
+  DenseMatrix<real_t> Xp[2];
+  for (int nt : {1, 4}) {
+    int k = (nt == 1) ? 0 : 1;
+    Xp[k] = X;
+#if defined(_OPENMP)
+    omp_set_num_threads(nt);
+#endif
+    t[k] = binary_tree_clustering(algo, Xp[k], perm[k], leaf);
+    if (check_tree(t[k], X, Xp[k], perm[k], leaf)) return 1;
+  }
+  if (!same_tree(t[0], t[1]) || perm[0] != perm[1]) {
+    cout << "ERROR: " << get_name(algo)
+         << " clustering depends on the number of threads" << endl;
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * Compare the approximate neighbors to the exact neighbors of some
+ * points. The scores should be the squared distances to the
+ * neighbors, in the precision of the data, also when the search is
+ * done in single precision.
+ */
+template<typename real_t> int
+test_ann(std::size_t n, std::size_t d, std::size_t k, bool single) {
+  std::mt19937 gen(2);
+  std::uniform_real_distribution<real_t> dis(0., 1.);
+  DenseMatrix<real_t> X(d, n);
+  for (std::size_t j=0; j<n; j++)
+    for (std::size_t i=0; i<d; i++)
+      X(i, j) = dis(gen);
+  DenseMatrix<std::uint32_t> ann;
+  DenseMatrix<real_t> scores;
+#if defined(_OPENMP)
+  omp_set_num_threads(4);
+#endif
+  find_approximate_neighbors(X, 10, k, ann, scores, single);
+  if (ann.rows() != k || ann.cols() != n) {
+    cout << "ERROR: wrong number of neighbors" << endl;
+    return 1;
+  }
+  real_t found = 0;
+  const std::size_t samples = 50;
+  for (std::size_t s=0; s<samples; s++) {
+    auto p = s * (n / samples);
+    std::vector<real_t> dist(n);
+    for (std::size_t j=0; j<n; j++)
+      dist[j] = Euclidean_distance_squared(d, &X(0, p), &X(0, j));
+    for (std::size_t i=0; i<k; i++)
+      if (std::abs(scores(i, p) - dist[ann(i, p)]) >
+          10 * blas::lamch<real_t>('E') * dist[ann(i, p)]) {
+        cout << "ERROR: wrong approximate neighbor score" << endl;
+        return 1;
+      }
+    auto sd = dist;
+    std::nth_element(sd.begin(), sd.begin()+k-1, sd.end());
+    for (std::size_t i=0; i<k; i++)
+      if (dist[ann(i, p)] <= sd[k-1]) found++;
+  }
+  auto quality = found / (samples * k);
+  if (quality < 0.9) {
+    cout << "ERROR: approximate neighbor quality " << quality << endl;
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  int ierr = 0;
+  for (auto algo : {ClusteringAlgorithm::KD_TREE,
+        ClusteringAlgorithm::TWO_MEANS}) {
+    ierr |= test_clustering<double>(algo, 5000, 3);
+    ierr |= test_clustering<float>(algo, 5000, 7);
+  }
+  // large enough for the parallel partitioning of the kd-tree
+  ierr |= test_clustering<double>(ClusteringAlgorithm::KD_TREE, 100000, 3);
+  ierr |= test_ann<double>(4000, 3, 8, false);
+  ierr |= test_ann<double>(4000, 3, 8, true);
+  ierr |= test_ann<float>(4000, 5, 8, false);
+  if (!ierr) cout << "# all clustering tests passed" << endl;
+  return ierr;
+}
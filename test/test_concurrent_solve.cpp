@@ -0,0 +1,119 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#include <iostream>
+#include <thread>
+#include <random>
+using namespace std;
+
+#include "StrumpackSparseSolver.hpp"
+#include "sparse/CSRMatrix.hpp"
+#include "sparse_test_util.hpp"
+
+using namespace strumpack;
+
+/**
+ * Many concurrent solves, from std::threads and from an OpenMP
+ * parallel loop, all using a single factorization.
+ */
+template<typename scalar_t,typename integer_t> int
+test_concurrent_solves(int argc, const char* const argv[], integer_t n) {
+  auto A = laplacian2d<scalar_t,integer_t>(n);
+  StrumpackSparseSolver<scalar_t,integer_t> spss(false);
+  spss.options().set_from_command_line(argc, argv);
+  spss.options().set_reordering_method(ReorderingStrategy::GEOMETRIC);
+  spss.set_matrix(A);
+  if (spss.reorder(n, n) != ReturnCode::SUCCESS ||
+      spss.factor() != ReturnCode::SUCCESS)
+    return 1;
+  const int nthreads = 8, nsolves = 20;
+  std::vector<int> err(nthreads, 0);
+  std::vector<std::thread> threads;
+  for (int t=0; t<nthreads; t++)
+    threads.emplace_back([&,t]() {
+      for (int s=0; s<nsolves; s++)
+        err[t] |= check_solve(spss, A, t*nsolves+s, 1+(s%3));
+    });
+  for (auto& t : threads) t.join();
+  int ierr = 0;
+  for (auto e : err) ierr |= e;
+#pragma omp parallel for reduction(|:ierr) schedule(dynamic)
+  for (int s=0; s<nthreads*nsolves; s++)
+    ierr |= check_solve(spss, A, 1000+s, 2);
+  auto r = spss.performance_report();
+  if (r[SolverPhase::SOLVE].calls != 2*nthreads*nsolves ||
+      r[SolverPhase::NUMERICAL_FACTORIZATION].calls != 1) {
+    cout << "ERROR: wrong number of solve calls "
+         << r[SolverPhase::SOLVE].calls << endl;
+    return 1;
+  }
+  return ierr;
+}
+
+/**
+ * Two solvers, each with its own thread budget, factoring and
+ * solving concurrently.
+ */
+template<typename scalar_t,typename integer_t> int
+test_concurrent_solvers(int argc, const char* const argv[], integer_t n) {
+  auto A1 = laplacian2d<scalar_t,integer_t>(n);
+  auto A2 = laplacian2d<scalar_t,integer_t>(n/2);
+  StrumpackSparseSolver<scalar_t,integer_t> s1(false), s2(false);
+  s1.options().set_from_command_line(argc, argv);
+  s2.options().set_from_command_line(argc, argv);
+  s1.options().set_num_threads(1);
+  s2.options().set_num_threads(2);
+  s1.set_matrix(A1);
+  s2.set_matrix(A2);
+  int e1 = 0, e2 = 0;
+  // the first solve does the reordering and factorization
+  std::thread t2([&]() {
+    for (int s=0; s<10; s++) e2 |= check_solve(s2, A2, s, 1);
+  });
+  for (int s=0; s<10; s++) e1 |= check_solve(s1, A1, s, 1);
+  t2.join();
+  return e1 | e2;
+}
+
+int main(int argc, char* argv[]) {
+  int n = 30;
+  if (argc > 1) n = std::max(4, atoi(argv[1]));
+  cout << "# Running with:\n# ";
+#if defined(_OPENMP)
+  cout << "OMP_NUM_THREADS=" << omp_get_max_threads() << " ";
+#endif
+  for (int i=0; i<argc; i++)
+    cout << argv[i] << " ";
+  cout << endl;
+
+  int ierr = test_concurrent_solves<double,int>(argc, argv, n);
+  ierr |= test_concurrent_solves<std::complex<float>,long long int>
+    (argc, argv, n);
+  ierr |= test_concurrent_solvers<double,int>(argc, argv, n);
+  return ierr;
+}
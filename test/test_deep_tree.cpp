@@ -0,0 +1,280 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+#include "StrumpackSparseSolver.hpp"
+#include "sparse/CSRMatrix.hpp"
+#include "sparse/fronts/FrontalMatrixDense.hpp"
+#include "sparse/fronts/FrontScheduler.hpp"
+
+using namespace strumpack;
+
+/**
+ * Block matrix with a caterpillar shaped elimination tree: a chain of
+ * nb separators S_0, .., S_{nb-1}, each with a leaf L_k attached, and
+ * all blocks of size bs. The unknowns are numbered L_0, S_0, L_1,
+ * S_1, .., which is a postorder of the tree. L_k is only coupled to
+ * S_k, and S_k to S_{k-1} and S_{k+1}. The matrix is diagonally
+ * dominant, and symmetric positive definite if sym.
+ */
+template<typename scalar_t,typename integer_t> CSRMatrix<scalar_t,integer_t>
+caterpillar(integer_t nb, integer_t bs, bool sym) {
+  integer_t N = 2 * nb * bs, nnz = 0;
+  std::vector<std::vector<integer_t>> nbrs(2 * nb);
+  for (integer_t k=0; k<nb; k++) {
+    nbrs[2*k].push_back(2*k+1);
+    nbrs[2*k+1].push_back(2*k);
+    if (k > 0) nbrs[2*k+1].push_back(2*k-1);
+    if (k < nb-1) nbrs[2*k+1].push_back(2*k+3);
+  }
+  for (auto& v : nbrs) nnz += (v.size() + 1) * bs * bs;
+  CSRMatrix<scalar_t,integer_t> A(N, nnz);
+  auto ptr = A.ptr();
+  auto ind = A.ind();
+  auto val = A.val();
+  nnz = 0;
+  ptr[0] = 0;
+  for (integer_t b=0; b<2*nb; b++) {
+    auto blks = nbrs[b];
+    blks.push_back(b);
+    std::sort(blks.begin(), blks.end());
+    for (integer_t r=b*bs; r<(b+1)*bs; r++) {
+      for (auto c : blks)
+        for (integer_t j=c*bs; j<(c+1)*bs; j++) {
+          ind[nnz] = j;
+          if (j == r) val[nnz] = 10.;
+          else val[nnz] = (sym || j < r ? -1. : -.5) / bs;
+          nnz++;
+        }
+      ptr[r+1] = nnz;
+    }
+  }
+  return A;
+}
+
+/**
+ * Build the fronts for the caterpillar matrix directly, returns the
+ * root, all fronts are stored (non-owning) in fs.
+ */
+template<typename scalar_t,typename integer_t>
+std::unique_ptr<FrontalMatrix<scalar_t,integer_t>>
+caterpillar_fronts(integer_t nb, integer_t bs,
+                   std::vector<FrontalMatrix<scalar_t,integer_t>*>& fs,
+                   bool leaf_first=false) {
+  using FD_t = FrontalMatrixDense<scalar_t,integer_t>;
+  std::unique_ptr<FrontalMatrix<scalar_t,integer_t>> chain;
+  for (integer_t k=0; k<nb; k++) {
+    std::vector<integer_t> Supd, Lupd;
+    for (integer_t i=(2*k+1)*bs; i<(2*k+2)*bs; i++) Lupd.push_back(i);
+    if (k < nb-1)
+      for (integer_t i=(2*k+3)*bs; i<(2*k+4)*bs; i++) Supd.push_back(i);
+    std::unique_ptr<FD_t> L
+      (new FD_t(2*k, 2*k*bs, (2*k+1)*bs, Lupd));
+    std::unique_ptr<FD_t> S
+      (new FD_t(2*k+1, (2*k+1)*bs, (2*k+2)*bs, Supd));
+    fs.push_back(S.get());
+    if (leaf_first) {
+      S->set_lchild(std::move(L));
+      S->set_rchild(std::move(chain));
+    } else {
+      S->set_lchild(std::move(chain));
+      S->set_rchild(std::move(L));
+    }
+    chain = std::move(S);
+  }
+  return chain;
+}
+
+template<typename scalar_t,typename integer_t> int
+test_caterpillar(integer_t nb, integer_t bs, MatrixSymmetry sym,
+                 bool leaf_first=false,
+                 ProportionalMapping pmap=ProportionalMapping::FLOPS,
+                 bool static_map=false) {
+  using real_t = typename RealType<scalar_t>::value_type;
+  bool symm = sym != MatrixSymmetry::UNSYMMETRIC;
+  auto A = caterpillar<scalar_t,integer_t>(nb, bs, symm);
+  std::vector<FrontalMatrix<scalar_t,integer_t>*> fs;
+  auto root = caterpillar_fronts<scalar_t,integer_t>(nb, bs, fs, leaf_first);
+  SPOptions<scalar_t> opts;
+  opts.set_matrix_symmetry(sym);
+  opts.set_proportional_mapping(pmap);
+  if (static_map) opts.enable_static_tree_mapping();
+  int ierr = 0;
+  if (root->multifrontal_factorization(A, opts) != ReturnCode::SUCCESS) {
+    cout << "ERROR: factorization failed" << endl;
+    ierr = 1;
+  }
+  std::vector<Trans> ops = {Trans::N};
+  if (!symm) ops.push_back(Trans::T);
+  for (auto op : ops) {
+    DenseMatrix<scalar_t> b(A.size(), 2), x(A.size(), 2), r(A.size(), 2);
+    b.random();
+    x.copy(b);
+    root->multifrontal_solve(op, x);
+    if (op == Trans::N) A.spmv(x, r);
+    else {
+      // r = A^T x, with A^T from the transposed sparsity/values
+      r.zero();
+      for (integer_t i=0; i<A.size(); i++)
+        for (integer_t t=A.ptr(i); t<A.ptr(i+1); t++)
+          for (std::size_t c=0; c<x.cols(); c++)
+            r(A.ind(t), c) += A.val(t) * x(i, c);
+    }
+    r.scaled_add(scalar_t(-1.), b);
+    auto res = r.normF() / b.normF();
+    cout << "# caterpillar nb= " << nb << " bs= " << bs
+         << " depth= " << nb+1 << " sym= " << int(sym)
+         << " leaf_first= " << leaf_first << " static= " << static_map
+         << " op= " << char(op) << " ||Ax-b||/||b|| = " << res << endl;
+    if (res > 1e3 * blas::lamch<real_t>('E')) {
+      cout << "ERROR: residual too large" << endl;
+      ierr = 1;
+    }
+  }
+  return ierr;
+}
+
+/**
+ * With the leaves as left children, the plain postorder keeps the
+ * contribution blocks of all leaves alive until the bottom of the
+ * chain is reached. The memory minimizing order visits the chain
+ * first, so that at most 3 contribution blocks are alive.
+ */
+int test_liu_order(int nb, int bs) {
+  using F_t = FrontalMatrix<double,int>;
+  std::vector<F_t*> fs;
+  auto root = caterpillar_fronts<double,int>(nb, bs, fs, true);
+  FrontScheduler<F_t> sched
+    (root.get(), [](F_t*) { return true; },
+     [](const F_t* f) { return double(f->dim_sep()); });
+  double cb = double(bs) * bs, peak = sched.peak_memory();
+  cout << "# caterpillar nb= " << nb << " bs= " << bs
+       << " peak contribution block memory = " << peak / cb
+       << " blocks" << endl;
+  int ierr = 0;
+  if (peak > 3 * cb) {
+    cout << "ERROR: peak memory too large" << endl;
+    ierr = 1;
+  }
+  // the chain should be the first child, except at the bottom
+  for (std::size_t i=0; i<sched.size(); i++) {
+    int c0 = -1, nc = 0;
+    sched.for_each_child(i, [&](int c) { if (!nc++) c0 = c; });
+    auto f0 = nc == 2 ? sched.node(c0) : nullptr;
+    if (f0 && !f0->lchild() && !f0->rchild()) {
+      cout << "ERROR: leaf visited before the chain" << endl;
+      ierr = 1;
+      break;
+    }
+  }
+  return ierr;
+}
+
+/**
+ * Same caterpillar matrix, through the full SparseSolver interface.
+ * With the natural ordering, the separator tree is built from the
+ * elimination tree, and has the same shape as the caterpillar, so
+ * the reordering, the construction of the fronts, the factorization,
+ * the solve and the destruction of the tree all see a very deep
+ * tree.
+ */
+template<typename scalar_t,typename integer_t> int
+test_solver(integer_t nb, integer_t bs, bool sym) {
+  using real_t = typename RealType<scalar_t>::value_type;
+  auto A = caterpillar<scalar_t,integer_t>(nb, bs, sym);
+  int ierr = 0;
+  {
+    SparseSolver<scalar_t,integer_t> sp(false);
+    sp.options().set_reordering_method(ReorderingStrategy::NATURAL);
+    sp.options().set_matching(MatchingJob::NONE);
+    if (sym) sp.options().set_matrix_symmetry(MatrixSymmetry::SYMMETRIC);
+    sp.set_matrix(A);
+    if (sp.reorder() != ReturnCode::SUCCESS) {
+      cout << "ERROR: reordering failed" << endl;
+      return 1;
+    }
+    if (sp.factor() != ReturnCode::SUCCESS) {
+      cout << "ERROR: factorization failed" << endl;
+      return 1;
+    }
+    DenseMatrix<scalar_t> b(A.size(), 1), x(A.size(), 1), r(A.size(), 1);
+    b.random();
+    if (sp.solve(b, x) != ReturnCode::SUCCESS) {
+      cout << "ERROR: solve failed" << endl;
+      return 1;
+    }
+    A.spmv(x, r);
+    r.scaled_add(scalar_t(-1.), b);
+    auto res = r.normF() / b.normF();
+    cout << "# solver caterpillar nb= " << nb << " bs= " << bs
+         << " sym= " << sym << " ||Ax-b||/||b|| = " << res << endl;
+    if (res > 1e3 * blas::lamch<real_t>('E')) {
+      cout << "ERROR: residual too large" << endl;
+      ierr = 1;
+    }
+  }
+  return ierr;
+}
+
+int main(int argc, char* argv[]) {
+  int ierr = 0;
+  // very deep trees, with small fronts, symmetric fronts are not
+  // handled by the small batched kernels
+  ierr |= test_caterpillar<double,int>
+    (100000, 1, MatrixSymmetry::POSITIVE_DEFINITE);
+  ierr |= test_caterpillar<double,int>(100000, 1, MatrixSymmetry::UNSYMMETRIC);
+  // deep tree with larger (LU) fronts
+  ierr |= test_caterpillar<double,int>(2000, 40, MatrixSymmetry::UNSYMMETRIC);
+  ierr |= test_caterpillar<std::complex<double>,long long>
+    (500, 40, MatrixSymmetry::SYMMETRIC);
+  // memory minimizing order, and static mapping of the subtrees to
+  // the threads, with the different cost models
+  ierr |= test_liu_order(10000, 4);
+  ierr |= test_caterpillar<double,int>
+    (2000, 10, MatrixSymmetry::UNSYMMETRIC, true);
+  for (auto pmap : {ProportionalMapping::FLOPS,
+                    ProportionalMapping::FACTOR_MEMORY,
+                    ProportionalMapping::PEAK_MEMORY})
+    ierr |= test_caterpillar<double,int>
+      (2000, 10, MatrixSymmetry::UNSYMMETRIC, true, pmap, true);
+  ierr |= test_caterpillar<double,int>
+    (100000, 1, MatrixSymmetry::POSITIVE_DEFINITE, false,
+     ProportionalMapping::PEAK_MEMORY, true);
+  // the same through SparseSolver::reorder/factor/solve
+  ierr |= test_solver<double,int>(100000, 1, false);
+  ierr |= test_solver<double,int>(100000, 1, true);
+  ierr |= test_solver<std::complex<double>,long long>(2000, 10, false);
+  if (!ierr) cout << "# all deep tree tests passed" << endl;
+  return ierr;
+}
@@ -0,0 +1,175 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#include <iostream>
+#include <random>
+using namespace std;
+
+#include "kernel/KernelRegression.hpp"
+
+using namespace strumpack;
+using namespace strumpack::kernel;
+
+/**
+ * Kernel without block evaluation, uses the per element path.
+ */
+template<typename scalar_t> class PlainGaussKernel
+  : public GaussKernel<scalar_t> {
+  using real_t = typename RealType<scalar_t>::value_type;
+public:
+  PlainGaussKernel(DenseMatrix<scalar_t>& data, scalar_t h, scalar_t lambda)
+    : GaussKernel<scalar_t>(data, h, lambda) {}
+protected:
+  bool eval_block(const std::vector<std::size_t>& I,
+                  const std::vector<std::size_t>& J,
+                  DenseMatrix<real_t>& B) const override {
+    return false;
+  }
+};
+
+/**
+ * Compare the block evaluation K(I,J) with the evaluation of every
+ * element, for random (overlapping) index sets.
+ */
+template<typename scalar_t> int
+test_block_eval(KernelType type, std::size_t n, std::size_t d, int p=1) {
+  using real_t = typename RealType<scalar_t>::value_type;
+  std::mt19937 gen(1);
+  std::normal_distribution<real_t> dis(0., 1.);
+  DenseMatrix<scalar_t> data(d, n);
+  for (std::size_t j=0; j<n; j++)
+    for (std::size_t i=0; i<d; i++)
+      data(i, j) = dis(gen) + real_t(5.);
+  const scalar_t h = 1.5, lambda = 2.;
+  auto K = create_kernel<scalar_t>(type, data, h, lambda, p);
+  std::uniform_int_distribution<std::size_t> idx(0, n-1);
+  for (std::size_t m : {1, 7, 64}) {
+    std::vector<std::size_t> I(m), J(m+3);
+    for (auto& i : I) i = idx(gen);
+    for (auto& j : J) j = idx(gen);
+    J[0] = I[0];
+    DenseMatrix<real_t> B(I.size(), J.size());
+    (*K)(I, J, B);
+    real_t err(0.), nrm(0.);
+    for (std::size_t j=0; j<J.size(); j++)
+      for (std::size_t i=0; i<I.size(); i++) {
+        auto e = K->eval(I[i], J[j]);
+        err = std::max(err, std::abs(B(i, j) - e));
+        nrm = std::max(nrm, std::abs(e));
+      }
+    if (err > 100 * blas::lamch<real_t>('E') * nrm ||
+        std::abs(B(0, 0) - K->eval(I[0], I[0])) >
+        10 * blas::lamch<real_t>('E') * nrm) {
+      cout << "ERROR: " << get_name(type) << " kernel, d= " << d
+           << ", block evaluation error " << err << endl;
+      return 1;
+    }
+  }
+  // the cached norms should be updated after modifying the data
+  if (type == KernelType::GAUSS) {
+    std::vector<std::size_t> I = {0, 1, n-1}, J = {1, 2};
+    DenseMatrix<real_t> B(I.size(), J.size()), Bp(I.size(), J.size());
+    (*K)(I, J, B);
+    for (std::size_t j=0; j<n; j++)
+      K->data()(0, j) += real_t(j);
+    PlainGaussKernel<scalar_t> P(data, h, lambda);
+    (*K)(I, J, B);
+    P(I, J, Bp);
+    Bp.scaled_add(real_t(-1.), B);
+    if (Bp.normF() > 100 * blas::lamch<real_t>('E') * B.normF()) {
+      cout << "ERROR: block evaluation after modifying the data" << endl;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Compare predict, with and without skipping far away clusters, to
+ * a direct evaluation of the kernel sums.
+ */
+template<typename scalar_t> int
+test_predict(KernelType type, std::size_t n, std::size_t m,
+             std::size_t d, int p=1) {
+  using real_t = typename RealType<scalar_t>::value_type;
+  std::mt19937 gen(2);
+  std::uniform_real_distribution<real_t> dis(0., 20.);
+  DenseMatrix<scalar_t> train(d, n), test(d, m);
+  for (std::size_t j=0; j<n; j++)
+    for (std::size_t i=0; i<d; i++) train(i, j) = dis(gen);
+  for (std::size_t j=0; j<m; j++)
+    for (std::size_t i=0; i<d; i++) test(i, j) = dis(gen);
+  const scalar_t h = 1., lambda = 2.;
+  auto K = create_kernel<scalar_t>(type, train, h, lambda, p);
+  std::vector<int> perm;
+  K->set_cluster_tree
+    (binary_tree_clustering(ClusteringAlgorithm::KD_TREE, train, perm, 16));
+  DenseMatrix<scalar_t> w(n, 1);
+  real_t w1(0.);
+  for (std::size_t r=0; r<n; r++) {
+    w(r, 0) = dis(gen) - real_t(10.);
+    w1 += std::abs(w(r, 0));
+  }
+  // reference, using a kernel with both training and test points
+  DenseMatrix<scalar_t> all(d, n+m);
+  DenseMatrixWrapper<scalar_t>(d, n, all, 0, 0).copy(train);
+  DenseMatrixWrapper<scalar_t>(d, m, all, 0, n).copy(test);
+  auto Kall = create_kernel<scalar_t>(type, all, h, lambda, p);
+  std::vector<scalar_t> ref(m);
+  for (std::size_t c=0; c<m; c++)
+    for (std::size_t r=0; r<n; r++)
+      ref[c] += w(r, 0) * Kall->eval(r, n+c);
+  for (real_t tol : {real_t(0.), real_t(1e-4)}) {
+    auto pred = K->predict(test, w, tol);
+    real_t err(0.);
+    for (std::size_t c=0; c<m; c++)
+      err = std::max(err, std::abs(pred[c] - ref[c]));
+    if (err > (tol + 1e3 * blas::lamch<real_t>('E')) * w1) {
+      cout << "ERROR: " << get_name(type) << " kernel, predict with tol= "
+           << tol << ", error " << err << endl;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  int ierr = 0;
+  for (auto t : {KernelType::GAUSS, KernelType::LAPLACE, KernelType::ANOVA})
+    for (std::size_t d : {1, 3, 17}) {
+      int p = (t == KernelType::ANOVA) ? std::min(3, int(d)) : 1;
+      ierr |= test_block_eval<double>(t, 200, d, p);
+      ierr |= test_block_eval<float>(t, 200, d, p);
+    }
+  for (auto t : {KernelType::GAUSS, KernelType::LAPLACE, KernelType::ANOVA}) {
+    ierr |= test_predict<double>(t, 1000, 300, 3, 2);
+    ierr |= test_predict<float>(t, 1000, 300, 3, 2);
+  }
+  if (!ierr) cout << "# all kernel tests passed" << endl;
+  return ierr;
+}
@@ -28,6 +28,8 @@
  */
 #include <iostream>
 #include <random>
+#include <fstream>
+#include <cstdio>
 using namespace std;
 
 #include "dense/DenseMatrix.hpp"
@@ -176,6 +178,33 @@ int run(int argc, char* argv[]) {
     std::cout << "||H-H2||_F = " << H2dense.norm() << std::endl;
   }
 
+  {
+    // a file in the layout of older versions, the version followed
+    // by the raw bytes of the DenseMatrix object, should be rejected
+    {
+      std::ofstream f("A_old.bin", std::ios::binary);
+      int v[3];
+      get_version(v, v+1, v+2);
+      f.write((const char*)v, sizeof(v));
+      f.write((const char*)&A, sizeof(A));
+      f.write((const char*)A.data(), sizeof(double)*A.rows()*A.cols());
+    }
+    auto B = DenseMatrix<double>::read("A_old.bin");
+    auto H2 = HSSMatrix<double>::read("A_old.bin");
+    std::remove("A_old.bin");
+    if (B.rows() || B.cols() || H2.rows() || H2.cols()) {
+      cout << "ERROR: file in the old layout was not rejected" << endl;
+      return 1;
+    }
+    // a different scalar type should be rejected
+    auto C = DenseMatrix<float>::read("A_hss.bin");
+    if (C.rows() || C.cols()) {
+      cout << "ERROR: file with another scalar type was not rejected"
+           << endl;
+      return 1;
+    }
+  }
+
   cout << "# exiting" << endl;
   return 0;
 }
@@ -0,0 +1,170 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#include <iostream>
+#include <fstream>
+#include <random>
+#include <algorithm>
+#include <cstdio>
+using namespace std;
+
+#include "StrumpackSparseSolver.hpp"
+#include "sparse/CSRMatrix.hpp"
+#include "sparse_test_util.hpp"
+
+using namespace strumpack;
+
+template<typename scalar_t,typename integer_t> bool
+equal(const CSRMatrix<scalar_t,integer_t>& A,
+      const CSRMatrix<scalar_t,integer_t>& B) {
+  if (A.size() != B.size() || A.nnz() != B.nnz()) return false;
+  for (integer_t i=0; i<=A.size(); i++)
+    if (A.ptr(i) != B.ptr(i)) return false;
+  for (integer_t j=0; j<A.nnz(); j++)
+    if (A.ind(j) != B.ind(j) || A.val(j) != B.val(j)) return false;
+  return true;
+}
+
+template<typename scalar_t> void
+write_value(std::ostream& os, scalar_t v) { os << v; }
+template<typename real_t> void
+write_value(std::ostream& os, std::complex<real_t> v) {
+  os << std::real(v) << " " << std::imag(v);
+}
+
+/**
+ * Write the entries of A in random order, with the given index base,
+ * only the lower triangular part if symm is true.
+ */
+template<typename scalar_t,typename integer_t> void
+write_shuffled(const CSRMatrix<scalar_t,integer_t>& A,
+               const std::string& fname, int base, bool symm) {
+  std::vector<std::pair<integer_t,integer_t>> e;
+  for (integer_t r=0; r<A.size(); r++)
+    for (integer_t j=A.ptr(r); j<A.ptr(r+1); j++)
+      if (!symm || A.ind(j) <= r) e.emplace_back(r, j);
+  std::mt19937 gen(1);
+  std::shuffle(e.begin(), e.end(), gen);
+  std::ofstream fs(fname);
+  fs << "%%MatrixMarket matrix coordinate "
+     << (is_complex<scalar_t>() ? "complex " : "real ")
+     << (symm ? "symmetric" : "general") << "\n"
+     << "% some comment\n%\n"
+     << A.size() << " " << A.size() << " " << e.size() << "\n";
+  fs.precision(17);
+  for (auto& rj : e) {
+    fs << rj.first+base << " " << A.ind(rj.second)+base << " ";
+    write_value(fs, A.val(rj.second));
+    fs << "\n";
+  }
+}
+
+template<typename scalar_t,typename integer_t> int
+test(integer_t n) {
+  std::string fname = "test_matrix_market.mtx";
+  for (auto c : {scalar_t(.3), scalar_t(0.)}) {
+    auto A = convection_diffusion<scalar_t,integer_t>(n, c);
+    bool symm = c == scalar_t(0.);
+    for (int base : {0, 1}) {
+      write_shuffled(A, fname, base, symm);
+      CSRMatrix<scalar_t,integer_t> B;
+      if (B.read_matrix_market(fname) || !equal(A, B)) {
+        std::cout << "ERROR: Matrix Market round trip failed, base = "
+                  << base << ", symmetric = " << symm << std::endl;
+        return 1;
+      }
+      if (B.symm_sparse() != symm) {
+        std::cout << "ERROR: wrong symmetry" << std::endl;
+        return 1;
+      }
+    }
+    A.print_matrix_market(fname);
+    CSRMatrix<scalar_t,integer_t> B;
+    if (B.read_matrix_market(fname) || !equal(A, B)) {
+      std::cout << "ERROR: print/read_matrix_market failed" << std::endl;
+      return 1;
+    }
+    A.print_binary(fname);
+    CSRMatrix<scalar_t,integer_t> C;
+    if (C.read_binary(fname) || !equal(A, C)) {
+      std::cout << "ERROR: print/read_binary failed" << std::endl;
+      return 1;
+    }
+  }
+  std::remove(fname.c_str());
+  return 0;
+}
+
+/**
+ * Malformed files should be rejected, not read out of bounds.
+ */
+int test_malformed() {
+  std::string fname = "test_matrix_market_bad.mtx";
+  const char* bad[] = {
+    // row index out of range
+    "3 3 3\n1 1 1.\n2 2 1.\n4 3 1.\n",
+    // column index out of range
+    "3 3 3\n1 1 1.\n2 7 1.\n3 3 1.\n",
+    // zero based, but also using index 3
+    "3 3 3\n0 0 1.\n1 1 1.\n3 2 1.\n",
+    // negative index
+    "3 3 3\n1 1 1.\n-2 2 1.\n3 3 1.\n",
+    // fewer entries than the header says
+    "3 3 4\n1 1 1.\n2 2 1.\n3 3 1.\n",
+    // more entries than the header says
+    "3 3 2\n1 1 1.\n2 2 1.\n3 3 1.\n",
+    // missing value
+    "3 3 3\n1 1 1.\n2 2\n3 3 1.\n"};
+  int ierr = 0;
+  for (auto b : bad) {
+    {
+      std::ofstream fs(fname);
+      fs << "%%MatrixMarket matrix coordinate real general\n" << b;
+    }
+    CSRMatrix<double,int> A;
+    if (!A.read_matrix_market(fname)) {
+      std::cout << "ERROR: malformed file was accepted:\n"
+                << b << std::endl;
+      ierr = 1;
+    }
+  }
+  std::remove(fname.c_str());
+  return ierr;
+}
+
+int main(int argc, char* argv[]) {
+  int n = 50;
+  if (argc > 1) n = atoi(argv[1]);
+  int ierr = 0;
+  ierr |= test<double,int>(n);
+  ierr |= test<float,long long int>(n);
+  ierr |= test<std::complex<double>,int>(n);
+  ierr |= test_malformed();
+  if (!ierr) std::cout << "Matrix Market and binary I/O OK" << std::endl;
+  return ierr;
+}
@@ -0,0 +1,308 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#include <iostream>
+#include <random>
+#include <numeric>
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+#include "sparse/ordering/NDReordering.hpp"
+#include "StrumpackSparseSolver.hpp"
+#include "StrumpackConfig.hpp"
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+using namespace strumpack;
+
+/**
+ * Symmetric graph, stored with diagonal, as it would be for a matrix.
+ */
+class TestGraph {
+public:
+  int n = 0;
+  std::vector<int> ptr, ind;
+  TestGraph(int n, const std::vector<std::pair<int,int>>& edges) : n(n) {
+    std::vector<std::vector<int>> adj(n);
+    for (int i=0; i<n; i++) adj[i].push_back(i);
+    for (auto& e : edges) {
+      adj[e.first].push_back(e.second);
+      adj[e.second].push_back(e.first);
+    }
+    ptr.push_back(0);
+    for (auto& a : adj) {
+      std::sort(a.begin(), a.end());
+      a.erase(std::unique(a.begin(), a.end()), a.end());
+      ind.insert(ind.end(), a.begin(), a.end());
+      ptr.push_back(ind.size());
+    }
+  }
+};
+
+TestGraph grid(int nx, int ny, int nz) {
+  std::vector<std::pair<int,int>> e;
+  auto id = [&](int x, int y, int z) { return x + nx*(y + ny*z); };
+  for (int z=0; z<nz; z++)
+    for (int y=0; y<ny; y++)
+      for (int x=0; x<nx; x++) {
+        if (x+1 < nx) e.emplace_back(id(x, y, z), id(x+1, y, z));
+        if (y+1 < ny) e.emplace_back(id(x, y, z), id(x, y+1, z));
+        if (z+1 < nz) e.emplace_back(id(x, y, z), id(x, y, z+1));
+      }
+  return TestGraph(nx*ny*nz, e);
+}
+
+/**
+ * nx x ny x nz grid, with the vertices numbered in random order, and
+ * slightly perturbed and rotated coordinates X (3 x n), as for an
+ * unstructured mesh.
+ */
+TestGraph shuffled_grid(int nx, int ny, int nz, std::vector<double>& X) {
+  auto g = grid(nx, ny, nz);
+  std::mt19937 gen(5);
+  std::vector<int> p(g.n);
+  std::iota(p.begin(), p.end(), 0);
+  std::shuffle(p.begin(), p.end(), gen);
+  std::uniform_real_distribution<double> eps(-.2, .2);
+  X.resize(3*g.n);
+  const double c = std::cos(.3), s = std::sin(.3);
+  for (int z=0; z<nz; z++)
+    for (int y=0; y<ny; y++)
+      for (int x=0; x<nx; x++) {
+        auto v = p[x + nx*(y + ny*z)];
+        double xe = x + eps(gen), ye = y + eps(gen);
+        X[3*v] = c*xe - s*ye;
+        X[3*v+1] = s*xe + c*ye;
+        X[3*v+2] = z + eps(gen);
+      }
+  std::vector<std::pair<int,int>> e;
+  for (int i=0; i<g.n; i++)
+    for (int t=g.ptr[i]; t<g.ptr[i+1]; t++)
+      if (g.ind[t] > i) e.emplace_back(p[i], p[g.ind[t]]);
+  return TestGraph(g.n, e);
+}
+
+TestGraph random_graph(int n, int m) {
+  std::mt19937 gen(3);
+  std::uniform_int_distribution<int> v(0, n-1);
+  std::vector<std::pair<int,int>> e;
+  for (int i=0; i<m; i++) e.emplace_back(v(gen), v(gen));
+  return TestGraph(n, e);
+}
+
+/**
+ * Check that perm is a permutation, consistent with iperm and the
+ * separator tree, and that the vertices of an edge are always in the
+ * same node, or in nodes where one is an ancestor of the other, ie,
+ * no fill between sibling subtrees.
+ */
+int check_ordering(const std::string& name, const TestGraph& G,
+                   const std::vector<int>& perm,
+                   const std::vector<int>& iperm,
+                   const SeparatorTree<int>& tree) {
+  int n = G.n;
+  for (int i=0; i<n; i++)
+    if (perm[i] < 0 || perm[i] >= n || iperm[perm[i]] != i) {
+      cout << "ERROR: " << name << ", invalid permutation" << endl;
+      return 1;
+    }
+  if (tree.sizes[tree.separators()] != n) {
+    cout << "ERROR: " << name << ", separator tree does not match" << endl;
+    return 1;
+  }
+  std::vector<int> node(n);
+  for (int s=0; s<tree.separators(); s++)
+    for (int i=tree.sizes[s]; i<tree.sizes[s+1]; i++)
+      node[i] = s;
+  for (int i=0; i<n; i++)
+    for (int t=G.ptr[i]; t<G.ptr[i+1]; t++) {
+      // in postorder, ancestors have a larger index
+      int a = node[perm[i]], b = node[perm[G.ind[t]]];
+      if (a > b) std::swap(a, b);
+      while (a != -1 && a < b) a = tree.parent[a];
+      if (a != b) {
+        cout << "ERROR: " << name << ", edge " << i << " - "
+             << G.ind[t] << " connects sibling subtrees" << endl;
+        return 1;
+      }
+    }
+  return 0;
+}
+
+int test_nd(const std::string& name, const TestGraph& G,
+            int max_root_sep=-1) {
+  std::vector<int> perm(G.n), iperm(G.n);
+  auto tree = ordering::nd_reordering
+    (G.n, G.ptr.data(), G.ind.data(), perm, iperm, 8);
+  if (check_ordering(name, G, perm, iperm, tree)) return 1;
+  auto r = tree.root();
+  auto root_sep = tree.sizes[r+1] - tree.sizes[r];
+  if (max_root_sep >= 0 && root_sep > max_root_sep) {
+    cout << "ERROR: " << name << ", top separator too large, "
+         << root_sep << " > " << max_root_sep << endl;
+    return 1;
+  }
+  cout << "# " << name << ": n= " << G.n << ", separators= "
+       << tree.separators() << ", levels= " << tree.levels()
+       << ", top separator= " << root_sep << endl;
+#if defined(_OPENMP)
+  // the ordering should not depend on the number of threads
+  auto nt = omp_get_max_threads();
+  for (int t : {1, 4}) {
+    omp_set_num_threads(t);
+    std::vector<int> perm_t(G.n), iperm_t(G.n);
+    ordering::nd_reordering
+      (G.n, G.ptr.data(), G.ind.data(), perm_t, iperm_t, 8);
+    if (perm_t != perm) {
+      cout << "ERROR: " << name << ", ordering with " << t
+           << " threads differs" << endl;
+      return 1;
+    }
+  }
+  omp_set_num_threads(nt);
+#endif
+  return 0;
+}
+
+int test_coordinate_nd(const std::string& name, const TestGraph& G,
+                       const std::vector<double>& X, int max_root_sep) {
+  std::vector<int> perm(G.n), iperm(G.n);
+  auto tree = ordering::coordinate_nd_reordering
+    (G.n, G.ptr.data(), G.ind.data(), 3, X.data(), 3, perm, iperm, 8);
+  if (check_ordering(name, G, perm, iperm, tree)) return 1;
+  auto r = tree.root();
+  auto root_sep = tree.sizes[r+1] - tree.sizes[r];
+  if (root_sep > max_root_sep) {
+    cout << "ERROR: " << name << ", top separator too large, "
+         << root_sep << " > " << max_root_sep << endl;
+    return 1;
+  }
+  cout << "# " << name << ": n= " << G.n << ", separators= "
+       << tree.separators() << ", levels= " << tree.levels()
+       << ", top separator= " << root_sep << endl;
+  return 0;
+}
+
+/**
+ * Edge bisection, as used for the separator reordering without
+ * Metis: both parts should be balanced, with a small edge cut.
+ */
+int test_bisection(const std::string& name, const TestGraph& G,
+                   int max_cut) {
+  std::vector<int> part;
+  ordering::graph_bisection(G.n, G.ptr.data(), G.ind.data(), part);
+  int w[2] = {0, 0}, cut = 0;
+  for (int i=0; i<G.n; i++) {
+    w[part[i]]++;
+    for (int t=G.ptr[i]; t<G.ptr[i+1]; t++)
+      if (part[G.ind[t]] != part[i]) cut++;
+  }
+  cut /= 2;
+  cout << "# " << name << " bisection: parts= " << w[0] << " " << w[1]
+       << ", cut= " << cut << endl;
+  if (std::max(w[0], w[1]) > 0.55 * G.n || cut > max_cut) {
+    cout << "ERROR: " << name << ", bad bisection" << endl;
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * Solve a Laplacian on the shuffled grid, using the coordinates for
+ * the ordering in SparseSolver::reorder.
+ */
+int test_solver_coordinates(const TestGraph& G,
+                            const std::vector<double>& X) {
+  int n = G.n;
+  std::vector<double> val(G.ind.size());
+  for (int i=0; i<n; i++)
+    for (int t=G.ptr[i]; t<G.ptr[i+1]; t++)
+      val[t] = (G.ind[t] == i) ? G.ptr[i+1] - G.ptr[i] : -1.;
+  DenseMatrixWrapper<double> coords(3, n, const_cast<double*>(X.data()), 3);
+  SparseSolver<double,int> sp(false);
+  sp.set_csr_matrix(n, G.ptr.data(), G.ind.data(), val.data(), true);
+  if (sp.reorder(coords) != ReturnCode::SUCCESS) {
+    cout << "ERROR: coordinate reordering failed" << endl;
+    return 1;
+  }
+  std::vector<double> b(n, 1.), x(n);
+  sp.solve(b.data(), x.data());
+  double rnorm = 0., bnorm = std::sqrt(double(n));
+  for (int i=0; i<n; i++) {
+    double r = b[i];
+    for (int t=G.ptr[i]; t<G.ptr[i+1]; t++)
+      r -= val[t] * x[G.ind[t]];
+    rnorm += r * r;
+  }
+  rnorm = std::sqrt(rnorm) / bnorm;
+  cout << "# solve with coordinate ordering, ||b-Ax||/||b|| = "
+       << rnorm << endl;
+  if (rnorm > 1e-10) {
+    cout << "ERROR: residual too large" << endl;
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  int ierr = 0;
+  ierr |= test_nd("2D grid", grid(60, 60, 1), 2*60);
+  // large enough for the parallel matching
+  ierr |= test_nd("large 2D grid", grid(150, 150, 1), 2*150);
+  ierr |= test_nd("3D grid", grid(16, 16, 16), 2*16*16);
+  ierr |= test_nd("path", grid(1000, 1, 1), 1);
+  ierr |= test_nd("random", random_graph(2000, 5000));
+  {
+    // two disconnected grids and some isolated vertices
+    auto g = grid(20, 20, 1);
+    std::vector<std::pair<int,int>> e;
+    for (int i=0; i<g.n; i++)
+      for (int t=g.ptr[i]; t<g.ptr[i+1]; t++)
+        if (g.ind[t] > i) {
+          e.emplace_back(i, g.ind[t]);
+          e.emplace_back(g.n + i, g.n + g.ind[t]);
+        }
+    ierr |= test_nd("disconnected", TestGraph(2*g.n + 50, e));
+  }
+  ierr |= test_nd("diagonal", TestGraph(100, {}));
+  ierr |= test_nd("dense", random_graph(30, 1000));
+  ierr |= test_bisection("2D grid", grid(60, 60, 1), 2*60);
+  ierr |= test_bisection("3D grid", grid(16, 16, 16), 2*16*16);
+  {
+    std::vector<double> X;
+    auto g2 = shuffled_grid(60, 60, 1, X);
+    ierr |= test_coordinate_nd("coordinates 2D", g2, X, 2*60);
+    ierr |= test_solver_coordinates(g2, X);
+    auto g3 = shuffled_grid(16, 16, 16, X);
+    ierr |= test_coordinate_nd("coordinates 3D", g3, X, 2*16*16);
+  }
+  if (!ierr) cout << "# all nested dissection tests passed" << endl;
+  return ierr;
+}
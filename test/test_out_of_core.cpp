@@ -0,0 +1,239 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "StrumpackSparseSolver.hpp"
+#include "sparse/CSRMatrix.hpp"
+#include "sparse/OutOfCoreStorage.hpp"
+#include "sparse_test_util.hpp"
+
+using namespace strumpack;
+
+/**
+ * Find the (already unlinked) out-of-core file among the open file
+ * descriptors of this process, -1 if there is none.
+ */
+int out_of_core_fd() {
+#if defined(__linux__)
+  auto d = opendir("/proc/self/fd");
+  if (!d) return -1;
+  int fd = -1;
+  while (auto e = readdir(d)) {
+    std::string p = std::string("/proc/self/fd/") + e->d_name;
+    char target[4096];
+    auto n = readlink(p.c_str(), target, sizeof(target)-1);
+    if (n <= 0) continue;
+    target[n] = '\0';
+    if (std::string(target).find("strumpack_factors_") !=
+        std::string::npos) {
+      fd = atoi(e->d_name);
+      break;
+    }
+  }
+  closedir(d);
+  return fd;
+#else
+  return -1;
+#endif
+}
+
+std::size_t out_of_core_file_size() {
+  struct stat st;
+  auto fd = out_of_core_fd();
+  if (fd < 0 || fstat(fd, &st)) return 0;
+  return st.st_size;
+}
+
+/**
+ * Blocks written from a solver (a counter set other than the process
+ * wide one) are released from that set when they are on disk, and
+ * can be read back in any order.
+ */
+int test_storage(const std::string& dir) {
+  const int nb = 8;
+  std::size_t total = 0;
+  auto C = std::make_shared<PerfCounterSet>();
+#if defined(STRUMPACK_COUNT_FLOPS)
+  long long p0 = params::memory;
+#endif
+  OutOfCoreStorage<double> ooc(dir);
+  if (!ooc.on_disk()) {
+    cout << "ERROR: could not create out-of-core file in " << dir << endl;
+    return 1;
+  }
+  std::vector<std::size_t> ids(nb), n(nb);
+  {
+    PerfCounterScope scope(C);
+    for (int i=0; i<nb; i++) {
+      n[i] = (1 << 16) + 1000 * i;
+      std::unique_ptr<double[]> b(new double[n[i]]);
+      for (std::size_t j=0; j<n[i]; j++) b[j] = i + j;
+      ids[i] = ooc.write(std::move(b), n[i]);
+      total += n[i] * sizeof(double);
+    }
+    ooc.flush();
+  }
+  if (ooc.file_size() != total || ooc.bytes_written() != total) {
+    cout << "ERROR: out-of-core file size " << ooc.file_size()
+         << ", written " << ooc.bytes_written()
+         << ", expected " << total << endl;
+    return 1;
+  }
+#if defined(STRUMPACK_COUNT_FLOPS)
+  if (C->count(PerfCounterType::MEMORY) != 0 ||
+      C->count(PerfCounterType::PEAK_MEMORY) < (1 << 16) * 8 ||
+      params::memory != p0) {
+    cout << "ERROR: resident memory after flush "
+         << C->count(PerfCounterType::MEMORY) << ", process "
+         << params::memory - p0 << endl;
+    return 1;
+  }
+#endif
+  auto check = [&](int i) {
+    auto b = ooc.read(ids[i]);
+    if (!b) return false;
+    for (std::size_t j=0; j<n[i]; j++)
+      if (b[j] != double(i + j)) return false;
+    return true;
+  };
+  ooc.start_read_ahead(true);
+  for (int i=0; i<nb; i++)
+    if (!check(i)) {
+      cout << "ERROR: forward read of block " << i << " failed" << endl;
+      return 1;
+    }
+  ooc.start_read_ahead(false);
+  for (int i=nb-1; i>=0; i--)
+    if (!check(i)) {
+      cout << "ERROR: backward read of block " << i << " failed" << endl;
+      return 1;
+    }
+  ooc.stop_read_ahead();
+  if (!check(nb/2) || ooc.bytes_read() != 2 * total + n[nb/2] * 8 ||
+      ooc.read_errors()) {
+    cout << "ERROR: read " << ooc.bytes_read() << " bytes, "
+         << ooc.read_errors() << " errors" << endl;
+    return 1;
+  }
+  auto fd = out_of_core_fd();
+  if (fd >= 0) {
+    // a failing read is reported, not fatal
+    if (ftruncate(fd, 0) || ooc.read(ids[0]) || ooc.read_errors() != 1) {
+      cout << "ERROR: read from truncated file not reported" << endl;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Factor with the factors evicted to disk, check the file size, that
+ * the factors are not counted as resident memory, and the residual
+ * of a solve which reads them back. A solve which cannot read the
+ * factors should return FILE_ERROR.
+ */
+template<typename scalar_t,typename integer_t> int
+test_solver(int argc, const char* const argv[], integer_t n) {
+  using real_t = typename RealType<scalar_t>::value_type;
+  auto A = laplacian2d<scalar_t,integer_t>(n);
+  StrumpackSparseSolver<scalar_t,integer_t> spss(false);
+  spss.options().set_from_command_line(argc, argv);
+  if (!spss.options().out_of_core())
+    spss.options().set_out_of_core_path(".");
+  spss.options().set_reordering_method(ReorderingStrategy::GEOMETRIC);
+  spss.set_matrix(A);
+  if (spss.reorder(n, n) != ReturnCode::SUCCESS ||
+      spss.factor() != ReturnCode::SUCCESS) {
+    cout << "ERROR: out-of-core factorization failed" << endl;
+    return 1;
+  }
+  std::size_t fbytes = spss.factor_nonzeros() * sizeof(scalar_t);
+  auto fsize = out_of_core_file_size();
+  if (out_of_core_fd() >= 0 && fsize != fbytes) {
+    cout << "ERROR: out-of-core file size " << fsize
+         << ", factors " << fbytes << endl;
+    return 1;
+  }
+#if defined(STRUMPACK_COUNT_FLOPS)
+  auto mem = spss.performance_report()
+    [SolverPhase::NUMERICAL_FACTORIZATION][PerfCounterType::MEMORY];
+  if (mem >= (long long)(fbytes / 2)) {
+    cout << "ERROR: factors still resident, memory " << mem
+         << ", factors " << fbytes << endl;
+    return 1;
+  }
+#endif
+  DenseMatrix<scalar_t> xe(A.size(), 1), b(A.size(), 1), x(A.size(), 1);
+  xe.fill(scalar_t(1.));
+  A.spmv(xe, b);
+  if (spss.solve(b, x) != ReturnCode::SUCCESS) {
+    cout << "ERROR: out-of-core solve failed" << endl;
+    return 1;
+  }
+  auto res = A.max_scaled_residual(x, b);
+  if (res > 100 * std::numeric_limits<real_t>::epsilon()) {
+    cout << "ERROR: out-of-core solve residual " << res << endl;
+    return 1;
+  }
+  auto fd = out_of_core_fd();
+  if (fd >= 0) {
+    if (ftruncate(fd, 0) ||
+        spss.solve(b, x) != ReturnCode::FILE_ERROR) {
+      cout << "ERROR: failed out-of-core read not reported" << endl;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  int n = 40;
+  if (argc > 1) n = std::max(4, atoi(argv[1]));
+  cout << "# Running with:\n# ";
+#if defined(_OPENMP)
+  cout << "OMP_NUM_THREADS=" << omp_get_max_threads() << " ";
+#endif
+  for (int i=0; i<argc; i++)
+    cout << argv[i] << " ";
+  cout << endl;
+
+  SPOptions<double> opts;
+  opts.set_from_command_line(argc, argv);
+  int ierr = test_storage(opts.out_of_core() ? opts.out_of_core_path() : ".");
+  ierr |= test_solver<double,int>(argc, argv, n);
+  ierr |= test_solver<std::complex<float>,long long int>(argc, argv, n);
+  return ierr;
+}
@@ -0,0 +1,154 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#include <iostream>
+#include <thread>
+using namespace std;
+
+#include "StrumpackSparseSolver.hpp"
+#include "sparse/CSRMatrix.hpp"
+#include "sparse_test_util.hpp"
+
+using namespace strumpack;
+
+/**
+ * Counters incremented from all threads in a parallel region should
+ * add up in the active counter set only.
+ */
+int test_counter_sets() {
+  auto A = std::make_shared<PerfCounterSet>(),
+    B = std::make_shared<PerfCounterSet>();
+  long long p0 = params::flops, n = 10000;
+  {
+    PerfCounterScope scope(A);
+#pragma omp parallel for
+    for (long long i=0; i<n; i++)
+      params::flops += 1;
+    {
+      PerfCounterScope scope(B);
+      params::flops += 3;
+    }
+#pragma omp parallel for
+    for (int i=0; i<4; i++) {
+      params::memory += PerfCounterSet::memory_flush_threshold;
+      params::memory -= PerfCounterSet::memory_flush_threshold;
+      params::memory += 10;
+    }
+  }
+  if (A->count(PerfCounterType::FLOPS) != n ||
+      B->count(PerfCounterType::FLOPS) != 3 ||
+      params::flops != p0) {
+    cout << "ERROR: wrong flop counts: " << A->count(PerfCounterType::FLOPS)
+         << " " << B->count(PerfCounterType::FLOPS) << endl;
+    return 1;
+  }
+  auto c = A->counts();
+  if (c[int(PerfCounterType::MEMORY)] != 40 ||
+      c[int(PerfCounterType::PEAK_MEMORY)] <
+      PerfCounterSet::memory_flush_threshold) {
+    cout << "ERROR: wrong memory counts: " << c[int(PerfCounterType::MEMORY)]
+         << " " << c[int(PerfCounterType::PEAK_MEMORY)] << endl;
+    return 1;
+  }
+  return 0;
+}
+
+template<typename scalar_t,typename integer_t> int
+factor_solve(StrumpackSparseSolver<scalar_t,integer_t>& spss,
+             const CSRMatrix<scalar_t,integer_t>& A, integer_t n) {
+  DenseMatrix<scalar_t> b(A.size(), 1), x(A.size(), 1);
+  b.fill(scalar_t(1.));
+  spss.options().set_reordering_method(ReorderingStrategy::GEOMETRIC);
+  spss.set_matrix(A);
+  if (spss.reorder(n, n) != ReturnCode::SUCCESS ||
+      spss.factor() != ReturnCode::SUCCESS ||
+      spss.solve(b, x) != ReturnCode::SUCCESS)
+    return 1;
+  return 0;
+}
+
+/**
+ * The performance report of a solver should not depend on other
+ * solvers running at the same time.
+ */
+template<typename scalar_t,typename integer_t> int
+test_solver_reports(int argc, const char* const argv[], integer_t n) {
+  auto A1 = laplacian2d<scalar_t,integer_t>(n);
+  auto A2 = laplacian2d<scalar_t,integer_t>(n/2);
+  StrumpackSparseSolver<scalar_t,integer_t> s1(false), s2(false);
+  s1.options().set_from_command_line(argc, argv);
+  s2.options().set_from_command_line(argc, argv);
+  if (factor_solve(s1, A1, n)) return 1;
+  auto r1 = s1.performance_report();
+  s1.reset_performance_report();
+  s1.delete_factors();
+  for (int p=0; p<SOLVER_PHASES; p++)
+    if (r1[SolverPhase(p)].calls < 1 || r1[SolverPhase(p)].time < 0.) {
+      cout << "ERROR: phase " << get_name(SolverPhase(p))
+           << " was not recorded" << endl;
+      return 1;
+    }
+  r1.print(cout);
+  int e1 = 0, e2 = 0;
+  std::thread t2([&]() { e2 = factor_solve(s2, A2, n/2); });
+  e1 = factor_solve(s1, A1, n);
+  t2.join();
+  if (e1 || e2) return 1;
+  auto fact = SolverPhase::NUMERICAL_FACTORIZATION;
+  auto f1 = r1[fact][PerfCounterType::FLOPS];
+  auto f1c = s1.performance_report()[fact][PerfCounterType::FLOPS];
+  auto f2c = s2.performance_report()[fact][PerfCounterType::FLOPS];
+#if defined(STRUMPACK_COUNT_FLOPS)
+  if (f1 <= 0 || f1 != f1c || f2c >= f1) {
+#else
+  if (f1 != 0 || f1c != 0 || f2c != 0) {
+#endif
+    cout << "ERROR: wrong factorization flops " << f1 << " "
+         << f1c << " " << f2c << endl;
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  int n = 30;
+  if (argc > 1) n = std::max(4, atoi(argv[1]));
+  cout << "# Running with:\n# ";
+#if defined(_OPENMP)
+  cout << "OMP_NUM_THREADS=" << omp_get_max_threads() << " ";
+#endif
+  for (int i=0; i<argc; i++)
+    cout << argv[i] << " ";
+  cout << endl;
+
+  int ierr = test_counter_sets();
+  ierr |= test_solver_reports<double,int>(argc, argv, n);
+  ierr |= test_solver_reports<std::complex<float>,long long int>
+    (argc, argv, n);
+  return ierr;
+}
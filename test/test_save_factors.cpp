@@ -0,0 +1,171 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#include <iostream>
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+using namespace std;
+
+#include "StrumpackSparseSolver.hpp"
+#include "sparse/CSRMatrix.hpp"
+#include "sparse/FactorFile.hpp"
+#include "sparse_test_util.hpp"
+
+using namespace strumpack;
+
+#define ERROR_TOLERANCE 1e2
+
+template<typename scalar_t,typename integer_t> int
+check_solve(StrumpackSparseSolver<scalar_t,integer_t>& spss,
+            const CSRMatrix<scalar_t,integer_t>& A,
+            const DenseMatrix<scalar_t>& b, DenseMatrix<scalar_t>& x,
+            const std::string& name) {
+  using real_t = typename RealType<scalar_t>::value_type;
+  if (spss.solve(b, x) != ReturnCode::SUCCESS) {
+    cout << "problem during solve." << endl;
+    return 1;
+  }
+  auto res = A.max_scaled_residual(x, b);
+  cout << "# " << name << ", COMPONENTWISE SCALED RESIDUAL = "
+       << res << endl;
+  if (res > ERROR_TOLERANCE * blas::lamch<real_t>('E') * A.size()) {
+    cout << "RESIDUAL TOO LARGE!" << endl;
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * Factor and solve, save the factors to file, then load them in a
+ * new solver, for the same matrix, and solve again without
+ * refactoring. The solutions should be the same.
+ */
+template<typename scalar_t,typename integer_t> int
+test_save_factors(int argc, const char* const argv[], integer_t n,
+                  scalar_t c) {
+  auto A = convection_diffusion<scalar_t,integer_t>(n, c);
+  integer_t N = A.size();
+  std::string fname = "strumpack_factors_" + std::to_string(getpid());
+  int nrhs = 2;
+  DenseMatrix<scalar_t> b(N, nrhs), x(N, nrhs), x_exact(N, nrhs),
+    x_loaded(N, nrhs);
+  x_exact.random();
+  A.spmv(x_exact, b);
+  {
+    StrumpackSparseSolver<scalar_t,integer_t> spss(false);
+    spss.options().set_from_command_line(argc, argv);
+    spss.options().set_reordering_method(ReorderingStrategy::GEOMETRIC);
+    spss.set_matrix(A);
+    if (spss.reorder(n, n) != ReturnCode::SUCCESS) {
+      cout << "problem with reordering of the matrix." << endl;
+      return 1;
+    }
+    if (spss.factor() != ReturnCode::SUCCESS) {
+      cout << "problem during factorization of the matrix." << endl;
+      return 1;
+    }
+    if (check_solve(spss, A, b, x, "factored")) return 1;
+    if (spss.save_factors(fname) != ReturnCode::SUCCESS) {
+      cout << "problem saving the factors." << endl;
+      return 1;
+    }
+  }
+  {
+    StrumpackSparseSolver<scalar_t,integer_t> spss(false);
+    spss.options().set_from_command_line(argc, argv);
+    spss.set_matrix(A);
+    auto err = spss.load_factors(fname);
+    std::remove(fname.c_str());
+    if (err != ReturnCode::SUCCESS) {
+      cout << "problem loading the factors." << endl;
+      return 1;
+    }
+    if (check_solve(spss, A, b, x_loaded, "loaded")) return 1;
+  }
+  using real_t = typename RealType<scalar_t>::value_type;
+  x_loaded.scaled_add(scalar_t(-1.), x);
+  if (x_loaded.normF() >
+      ERROR_TOLERANCE * blas::lamch<real_t>('E') * x.normF()) {
+    cout << "SOLUTION DIFFERS FROM THE SAVED FACTORIZATION!" << endl;
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * An array length in a corrupt file, for which the size in bytes
+ * overflows to a value that fits in the file, should be rejected.
+ */
+int test_corrupt_length() {
+  std::string fname = "strumpack_corrupt_" + std::to_string(getpid());
+  {
+    FactorFileWriter f(fname);
+    f.write_header<double,int>();
+    f.write(std::size_t(-1) / sizeof(double) + 2);
+    std::vector<char> pad(2*FactorFileWriter::alignment, 0);
+    f.stream().write(pad.data(), pad.size());
+  }
+  std::vector<double> v;
+  bool ok;
+  {
+    FactorFileReader f(fname);
+    ok = f.read_header<double,int>();
+    if (ok) {
+      f.read(v);
+      ok = f.good();
+    }
+  }
+  std::remove(fname.c_str());
+  if (ok || !v.empty()) {
+    cout << "ERROR: corrupt array length was accepted" << endl;
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  int n = 30;
+  if (argc > 1) n = std::max(2, atoi(argv[1]));
+  cout << "# Running with:\n# ";
+#if defined(_OPENMP)
+  cout << "OMP_NUM_THREADS=" << omp_get_max_threads() << " ";
+#endif
+  for (int i=0; i<argc; i++)
+    cout << argv[i] << " ";
+  cout << endl;
+
+  int ierr = test_corrupt_length();
+  ierr |= test_save_factors<double,int>(argc, argv, n, .4);
+  ierr |= test_save_factors<float,int>(argc, argv, n, .4f);
+  ierr |= test_save_factors<std::complex<double>,int>
+    (argc, argv, n, {.4, .3});
+  ierr |= test_save_factors<std::complex<float>,long long int>
+    (argc, argv, n, {.4f, .3f});
+  return ierr;
+}
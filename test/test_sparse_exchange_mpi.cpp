@@ -0,0 +1,128 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li,.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+using namespace std;
+
+#include "misc/MPIWrapper.hpp"
+
+using namespace strumpack;
+
+/**
+ * Fill the send buffers for a sparse exchange: every rank sends to
+ * itself and to a few neighbors, the message to rank p has size
+ * (len * (1 + (r + p) % 3)) and entries that identify sender,
+ * receiver and position.
+ */
+void fill(const MPIComm& c, const std::vector<int>& nbrs, int len,
+          std::vector<std::vector<double>>& sbuf) {
+  int r = c.rank();
+  sbuf.assign(c.size(), std::vector<double>());
+  for (auto p : nbrs)
+    for (int i=0; i<len*(1+(r+p)%3); i++)
+      sbuf[p].push_back(1e6*r + 1e3*p + i);
+}
+
+int check(const MPIComm& c, const std::vector<int>& from, int len,
+          const std::vector<double*>& pbuf, const std::string& name) {
+  int r = c.rank(), P = c.size(), err = 0;
+  std::vector<bool> src(P, false);
+  for (auto p : from) src[p] = true;
+  for (int p=0; p<P; p++) {
+    auto n = src[p] ? len*(1+(r+p)%3) : 0;
+    for (int i=0; i<n && !err; i++)
+      if (pbuf[p][i] != 1e6*p + 1e3*r + i) err = 1;
+  }
+  c.all_reduce(&err, 1, MPI_MAX);
+  if (err && c.is_root())
+    cout << "ERROR: " << name << ", wrong data received" << endl;
+  return err;
+}
+
+int main(int argc, char* argv[]) {
+  MPI_Init(&argc, &argv);
+  int ierr = 0;
+  {
+    MPIComm c;
+    int r = c.rank(), P = c.size();
+    // send to the next two ranks, receive from the previous two
+    std::vector<int> to, from;
+    for (int d : {0, 1, 2}) {
+      if (d >= P) break;
+      to.push_back((r + d) % P);
+      from.push_back((r - d + P) % P);
+    }
+    std::sort(to.begin(), to.end());
+    to.erase(std::unique(to.begin(), to.end()), to.end());
+    std::sort(from.begin(), from.end());
+    from.erase(std::unique(from.begin(), from.end()), from.end());
+    std::vector<std::vector<double>> sbuf;
+    std::vector<double> rbuf;
+    std::vector<double*> pbuf;
+    // reference, dense all_to_all_v
+    fill(c, to, 10, sbuf);
+    c.all_to_all_v(sbuf, rbuf, pbuf);
+    ierr |= check(c, from, 10, pbuf, "all_to_all_v");
+    // the pattern is set up by the first exchange, and reused by the
+    // later ones, with different message sizes
+    ExchangePattern pattern;
+    for (int len : {10, 3, 0, 25}) {
+      fill(c, to, len, sbuf);
+      c.sparse_all_to_all_v(sbuf, rbuf, pbuf, pattern);
+      ierr |= check(c, from, len, pbuf, "sparse_all_to_all_v");
+    }
+    if (int(pattern.destinations().size()) != int(to.size())-1 ||
+        int(pattern.sources().size()) != int(from.size())-1) {
+      cout << "ERROR: rank " << r << ", wrong communication pattern" << endl;
+      ierr = 1;
+    }
+    // without a stored pattern
+    fill(c, to, 7, sbuf);
+    c.sparse_all_to_all_v(sbuf, rbuf, pbuf);
+    ierr |= check(c, from, 7, pbuf, "sparse_all_to_all_v, no pattern");
+    // only local data, no messages
+    ExchangePattern local;
+    for (int len : {5, 8}) {
+      fill(c, {r}, len, sbuf);
+      c.sparse_all_to_all_v(sbuf, rbuf, pbuf, local);
+      ierr |= check(c, {r}, len, pbuf, "sparse_all_to_all_v, local");
+    }
+    if (!local.local()) {
+      cout << "ERROR: rank " << r << ", local exchange not detected" << endl;
+      ierr = 1;
+    }
+    c.all_reduce(&ierr, 1, MPI_MAX);
+    if (!ierr && c.is_root())
+      cout << "# all sparse exchange tests passed" << endl;
+  }
+  MPI_Finalize();
+  return ierr;
+}
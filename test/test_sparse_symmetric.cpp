@@ -0,0 +1,205 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#include <iostream>
+#include <cstring>
+#include <cmath>
+using namespace std;
+
+#include "StrumpackSparseSolver.hpp"
+#include "sparse/CSRMatrix.hpp"
+#include "sparse_test_util.hpp"
+
+using namespace strumpack;
+
+#define ERROR_TOLERANCE 1e2
+
+/**
+ * 2D 5-point Laplacian on an n x n grid, with the diagonal shifted
+ * by -shift. For shift = 0 this is symmetric positive definite, for
+ * large enough shift it is symmetric indefinite.
+ */
+template<typename scalar_t,typename integer_t> CSRMatrix<scalar_t,integer_t>
+shifted_laplacian(integer_t n, scalar_t shift) {
+  integer_t N = n * n, nnz = 5 * N - 4 * n;
+  CSRMatrix<scalar_t,integer_t> A(N, nnz);
+  auto ptr = A.ptr();
+  auto ind = A.ind();
+  auto val = A.val();
+  nnz = 0;
+  ptr[0] = 0;
+  for (integer_t row=0; row<n; row++) {
+    for (integer_t col=0; col<n; col++) {
+      integer_t i = col+n*row;
+      if (row > 0)   { val[nnz] = -1.0; ind[nnz++] = i-n; }
+      if (col > 0)   { val[nnz] = -1.0; ind[nnz++] = i-1; }
+      val[nnz] = scalar_t(4.0) - shift; ind[nnz++] = i;
+      if (col < n-1) { val[nnz] = -1.0; ind[nnz++] = i+1; }
+      if (row < n-1) { val[nnz] = -1.0; ind[nnz++] = i+n; }
+      ptr[i+1] = nnz;
+    }
+  }
+  A.set_symm_sparse();
+  return A;
+}
+
+template<typename scalar_t,typename integer_t> int
+test_symmetric(int argc, const char* const argv[], integer_t n,
+               MatrixSymmetry sym, scalar_t shift) {
+  using real_t = typename RealType<scalar_t>::value_type;
+  auto A = shifted_laplacian<scalar_t,integer_t>(n, shift);
+  integer_t N = A.size();
+  DenseMatrix<scalar_t> b(N, 1), x(N, 1), x_exact(N, 1);
+  x_exact.random();
+  A.spmv(x_exact, b);
+
+  long long nnz[2];
+  for (int s=0; s<2; s++) {
+    StrumpackSparseSolver<scalar_t,integer_t> spss(false);
+    spss.options().set_from_command_line(argc, argv);
+    spss.options().set_reordering_method(ReorderingStrategy::GEOMETRIC);
+    spss.options().set_Krylov_solver(KrylovSolver::DIRECT);
+    spss.options().set_matrix_symmetry
+      (s ? sym : MatrixSymmetry::UNSYMMETRIC);
+    spss.set_matrix(A);
+    if (spss.reorder(n, n) != ReturnCode::SUCCESS) {
+      cout << "problem with reordering of the matrix." << endl;
+      return 1;
+    }
+    if (check_amalgamation(spss, A, n, n)) return 1;
+    if (spss.factor() != ReturnCode::SUCCESS) {
+      cout << "problem during factorization of the matrix." << endl;
+      return 1;
+    }
+    spss.solve(b, x);
+    auto res = A.max_scaled_residual(x, b);
+    cout << "# " << get_name(s ? sym : MatrixSymmetry::UNSYMMETRIC)
+         << ", COMPONENTWISE SCALED RESIDUAL = " << res << endl;
+    if (res > ERROR_TOLERANCE * blas::lamch<real_t>('E') * N) {
+      cout << "RESIDUAL TOO LARGE!" << endl;
+      return 1;
+    }
+    nnz[s] = spss.factor_nonzeros();
+  }
+  cout << "# factor nonzeros, unsymmetric = " << nnz[0]
+       << ", " << get_name(sym) << " = " << nnz[1] << endl;
+  if (nnz[1] >= nnz[0]) {
+    cout << "SYMMETRIC FACTORS NOT SMALLER!" << endl;
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * Check that replace_tiny_pivots is honoured by the symmetric
+ * factorizations. One vertex is decoupled from the rest of the grid
+ * and gets a zero diagonal, giving an exact zero pivot. With b zero
+ * in that vertex the system is consistent, and the solve should
+ * only be accurate if the zero pivot was replaced.
+ */
+template<typename scalar_t,typename integer_t> int
+test_tiny_pivots(int argc, const char* const argv[], integer_t n,
+                 MatrixSymmetry sym, scalar_t shift) {
+  using real_t = typename RealType<scalar_t>::value_type;
+  auto A = shifted_laplacian<scalar_t,integer_t>(n, shift);
+  integer_t N = A.size(), k = n / 2 + n * (n / 2);
+  auto ptr = A.ptr();
+  auto ind = A.ind();
+  auto val = A.val();
+  for (integer_t i=0; i<N; i++)
+    for (integer_t j=ptr[i]; j<ptr[i+1]; j++)
+      if (i == k || ind[j] == k) val[j] = scalar_t(0.);
+  DenseMatrix<scalar_t> b(N, 1), x(N, 1), x_exact(N, 1);
+  x_exact.random();
+  x_exact(k, 0) = scalar_t(0.);
+  A.spmv(x_exact, b);
+
+  StrumpackSparseSolver<scalar_t,integer_t> spss(false);
+  spss.options().set_from_command_line(argc, argv);
+  spss.options().set_reordering_method(ReorderingStrategy::GEOMETRIC);
+  spss.options().set_Krylov_solver(KrylovSolver::DIRECT);
+  spss.options().set_matrix_symmetry(sym);
+  // only the dense symmetric fronts are tested here
+  spss.options().set_compression(CompressionType::NONE);
+  spss.options().enable_replace_tiny_pivots();
+  spss.set_matrix(A);
+  if (spss.reorder(n, n) != ReturnCode::SUCCESS) {
+    cout << "problem with reordering of the matrix." << endl;
+    return 1;
+  }
+  auto ierr = spss.factor();
+  if (ierr != ReturnCode::SUCCESS && ierr != ReturnCode::ZERO_PIVOT) {
+    cout << "problem during factorization of the matrix." << endl;
+    return 1;
+  }
+  spss.solve(b, x);
+  for (integer_t i=0; i<N; i++)
+    if (!std::isfinite(std::abs(x(i, 0)))) {
+      cout << "SOLUTION NOT FINITE, TINY PIVOT NOT REPLACED?" << endl;
+      return 1;
+    }
+  auto res = A.max_scaled_residual(x, b);
+  cout << "# " << get_name(sym) << " with a zero pivot replaced"
+       << ", COMPONENTWISE SCALED RESIDUAL = " << res << endl;
+  if (res > ERROR_TOLERANCE * blas::lamch<real_t>('E') * N) {
+    cout << "RESIDUAL TOO LARGE!" << endl;
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  int n = 30;
+  if (argc > 1) n = std::max(2, atoi(argv[1]));
+  cout << "# Running with:\n# ";
+#if defined(_OPENMP)
+  cout << "OMP_NUM_THREADS=" << omp_get_max_threads() << " ";
+#endif
+  for (int i=0; i<argc; i++)
+    cout << argv[i] << " ";
+  cout << endl;
+
+  int ierr = 0;
+  ierr |= test_symmetric<double,int>
+    (argc, argv, n, MatrixSymmetry::POSITIVE_DEFINITE, 0.);
+  ierr |= test_symmetric<double,int>
+    (argc, argv, n, MatrixSymmetry::SYMMETRIC, 1.3);
+  ierr |= test_symmetric<std::complex<double>,int>
+    (argc, argv, n, MatrixSymmetry::POSITIVE_DEFINITE, 0.);
+  ierr |= test_symmetric<std::complex<double>,long long int>
+    (argc, argv, n, MatrixSymmetry::SYMMETRIC, {1.3, 0.1});
+  ierr |= test_symmetric<float,int>
+    (argc, argv, n, MatrixSymmetry::SYMMETRIC, 1.3f);
+  ierr |= test_tiny_pivots<double,int>
+    (argc, argv, n, MatrixSymmetry::POSITIVE_DEFINITE, 0.);
+  ierr |= test_tiny_pivots<double,int>
+    (argc, argv, n, MatrixSymmetry::SYMMETRIC, 1.3);
+  ierr |= test_tiny_pivots<std::complex<double>,int>
+    (argc, argv, n, MatrixSymmetry::POSITIVE_DEFINITE, 0.);
+  return ierr;
+}
@@ -0,0 +1,106 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#include <iostream>
+#include <cstring>
+using namespace std;
+
+#include "StrumpackSparseSolver.hpp"
+#include "sparse/CSRMatrix.hpp"
+#include "sparse_test_util.hpp"
+
+using namespace strumpack;
+
+#define ERROR_TOLERANCE 1e2
+
+template<typename scalar_t,typename integer_t> int
+test_transpose(int argc, const char* const argv[], integer_t n,
+               scalar_t c, MatchingJob job) {
+  using real_t = typename RealType<scalar_t>::value_type;
+  auto A = convection_diffusion<scalar_t,integer_t>(n, c, true);
+  integer_t N = A.size();
+
+  StrumpackSparseSolver<scalar_t,integer_t> spss(false);
+  spss.options().set_from_command_line(argc, argv);
+  spss.options().set_reordering_method(ReorderingStrategy::GEOMETRIC);
+  spss.options().set_matching(job);
+  spss.set_matrix(A);
+  if (spss.reorder(n, n) != ReturnCode::SUCCESS) {
+    cout << "problem with reordering of the matrix." << endl;
+    return 1;
+  }
+  if (check_amalgamation(spss, A, n, n)) return 1;
+  if (spss.factor() != ReturnCode::SUCCESS) {
+    cout << "problem during factorization of the matrix." << endl;
+    return 1;
+  }
+  int nrhs = 3;
+  for (auto op : {Trans::N, Trans::T, Trans::C}) {
+    DenseMatrix<scalar_t> b(N, nrhs), x(N, nrhs), x_exact(N, nrhs);
+    x_exact.random();
+    A.spmv(op, x_exact, b);
+    auto ierr = spss.solve(op, b, x);
+    if (ierr != ReturnCode::SUCCESS) {
+      cout << "solve with op = " << char(op) << " failed: "
+           << ierr << endl;
+      return 1;
+    }
+    auto res = A.max_scaled_residual(op, x, b);
+    cout << "# op = " << char(op) << ", matching = " << int(job)
+         << ", COMPONENTWISE SCALED RESIDUAL = " << res << endl;
+    if (res > ERROR_TOLERANCE * blas::lamch<real_t>('E') * N) {
+      cout << "RESIDUAL TOO LARGE!" << endl;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  int n = 30;
+  if (argc > 1) n = std::max(2, atoi(argv[1]));
+  cout << "# Running with:\n# ";
+#if defined(_OPENMP)
+  cout << "OMP_NUM_THREADS=" << omp_get_max_threads() << " ";
+#endif
+  for (int i=0; i<argc; i++)
+    cout << argv[i] << " ";
+  cout << endl;
+
+  int ierr = 0;
+  for (auto job : {MatchingJob::NONE,
+                   MatchingJob::MAX_DIAGONAL_PRODUCT_SCALING}) {
+    ierr |= test_transpose<double,int>(argc, argv, n, .4, job);
+    ierr |= test_transpose<float,int>(argc, argv, n, .4f, job);
+    ierr |= test_transpose<std::complex<double>,int>
+      (argc, argv, n, {.4, .3}, job);
+    ierr |= test_transpose<std::complex<float>,long long int>
+      (argc, argv, n, {.4f, .3f}, job);
+  }
+  return ierr;
+}
@@ -0,0 +1,275 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <memory>
+#include <thread>
+using namespace std;
+
+#include "StrumpackSparseSolver.hpp"
+#include "sparse/CSRMatrix.hpp"
+#include "misc/TaskTimer.hpp"
+#include "sparse_test_util.hpp"
+
+using namespace strumpack;
+
+std::string read_file(const std::string& fname) {
+  std::ifstream f(fname);
+  std::stringstream ss;
+  ss << f.rdbuf();
+  return ss.str();
+}
+
+int count(const std::string& s, const std::string& sub) {
+  int n = 0;
+  for (auto p = s.find(sub); p != std::string::npos; p = s.find(sub, p+1))
+    n++;
+  return n;
+}
+
+/**
+ * Events recorded from all threads in a parallel region should show
+ * up in the trace, nothing should be recorded when disabled.
+ */
+int test_tracer() {
+  const std::string fname = "test_tracer.json";
+  Tracer::clear();
+  {
+    TraceScope t("disabled");
+  }
+  Tracer::start();
+  const int n = 100;
+#pragma omp parallel for
+  for (int i=0; i<n; i++) {
+    TraceArgs a;
+    a.level = i;
+    TraceScope t("event \"quoted\"", a);
+  }
+  {
+    TaskTimer t("named timer");
+    t.start();
+  }
+  Tracer::stop();
+  if (!Tracer::write(fname)) {
+    cout << "ERROR: could not write " << fname << endl;
+    return 1;
+  }
+  auto s = read_file(fname);
+  std::remove(fname.c_str());
+  if (s.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[") != 0 ||
+      count(s, "\"name\":\"event \\\"quoted\\\"\"") != n ||
+      count(s, "\"level\":") != n ||
+      count(s, "\"name\":\"named timer\"") != 1 ||
+      count(s, "\"disabled\"") != 0 ||
+      count(s, "\"thread_name\"") < 1) {
+    cout << "ERROR: wrong trace:\n" << s << endl;
+    return 1;
+  }
+  Tracer::clear();
+  return 0;
+}
+
+/**
+ * A solver with a trace file writes the trace when it is destroyed,
+ * with an event for every front in the factorization and solve.
+ */
+template<typename scalar_t,typename integer_t> int
+test_solver_trace(int argc, const char* const argv[], integer_t n) {
+  const std::string fname = "test_solver_trace.json";
+  auto A = laplacian2d<scalar_t,integer_t>(n);
+  {
+    StrumpackSparseSolver<scalar_t,integer_t> spss(false);
+    spss.options().set_from_command_line(argc, argv);
+    spss.options().set_reordering_method(ReorderingStrategy::GEOMETRIC);
+    spss.options().set_trace_file(fname);
+    spss.set_matrix(A);
+    DenseMatrix<scalar_t> b(A.size(), 1), x(A.size(), 1);
+    b.fill(scalar_t(1.));
+    if (spss.reorder(n, n) != ReturnCode::SUCCESS ||
+        spss.factor() != ReturnCode::SUCCESS ||
+        spss.solve(b, x) != ReturnCode::SUCCESS)
+      return 1;
+  }
+  if (Tracer::enabled()) {
+    cout << "ERROR: tracing still enabled after the solver" << endl;
+    return 1;
+  }
+  auto s = read_file(fname);
+  std::remove(fname.c_str());
+  Tracer::clear();
+  int factor = count(s, "\"name\":\"factor\"") +
+    count(s, "\"name\":\"compress_factor\"") +
+    count(s, "\"name\":\"factor_batch\"");
+  int fwd = count(s, "\"name\":\"fwd_solve\"");
+  int bwd = count(s, "\"name\":\"bwd_solve\"");
+  if (s.empty() || factor < 1 || fwd < 1 || fwd != bwd ||
+      count(s, "\"dim_sep\":") < factor + fwd + bwd ||
+      count(s, "\"name\":\"solve\"") != 1) {
+    cout << "ERROR: wrong solver trace, " << factor
+         << " factor events, " << fwd << " forward and " << bwd
+         << " backward solve events" << endl;
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * Two solvers traced at the same time, but used one after the
+ * other: each trace file should only contain the events of its own
+ * solver, even when the solvers are destroyed in reverse order.
+ */
+template<typename scalar_t,typename integer_t> int
+test_two_solvers_trace(int argc, const char* const argv[], integer_t n) {
+  const std::string fname[2] =
+    {"test_solver_trace_0.json", "test_solver_trace_1.json"};
+  auto A = laplacian2d<scalar_t,integer_t>(n);
+  {
+    std::unique_ptr<StrumpackSparseSolver<scalar_t,integer_t>> spss[2];
+    for (int i=0; i<2; i++) {
+      spss[i].reset(new StrumpackSparseSolver<scalar_t,integer_t>(false));
+      spss[i]->options().set_from_command_line(argc, argv);
+      spss[i]->options().set_reordering_method
+        (ReorderingStrategy::GEOMETRIC);
+      spss[i]->options().set_trace_file(fname[i]);
+      spss[i]->set_matrix(A);
+    }
+    DenseMatrix<scalar_t> b(A.size(), 1), x(A.size(), 1);
+    b.fill(scalar_t(1.));
+    for (int i=0; i<2; i++)
+      for (int r=0; r<=i; r++)
+        if (spss[i]->reorder(n, n) != ReturnCode::SUCCESS ||
+            spss[i]->solve(b, x) != ReturnCode::SUCCESS)
+          return 1;
+    spss[1].reset();
+    spss[0].reset();
+  }
+  Tracer::clear();
+  for (int i=0; i<2; i++) {
+    auto s = read_file(fname[i]);
+    std::remove(fname[i].c_str());
+    if (count(s, "\"name\":\"solve\"") != i+1) {
+      cout << "ERROR: trace of solver " << i << " has "
+           << count(s, "\"name\":\"solve\"") << " solve events, "
+           << "expected " << i+1 << endl;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Two solvers traced while running at the same time, in different
+ * threads: the trace of each solver should only contain its own
+ * solves.
+ */
+template<typename scalar_t,typename integer_t> int
+test_concurrent_solvers_trace(int argc, const char* const argv[],
+                              integer_t n) {
+  const std::string fname[2] =
+    {"test_concurrent_trace_0.json", "test_concurrent_trace_1.json"};
+  const int nsolves[2] = {5, 10};
+  CSRMatrix<scalar_t,integer_t> A[2] =
+    {laplacian2d<scalar_t,integer_t>(n),
+     laplacian2d<scalar_t,integer_t>(n/2)};
+  {
+    StrumpackSparseSolver<scalar_t,integer_t> spss[2] = {false, false};
+    int err[2] = {0, 0};
+    auto run = [&](int i) {
+      spss[i].options().set_from_command_line(argc, argv);
+      spss[i].options().set_trace_file(fname[i]);
+      spss[i].set_matrix(A[i]);
+      for (int s=0; s<nsolves[i]; s++)
+        err[i] |= check_solve(spss[i], A[i], s, 1);
+    };
+    std::thread t1(run, 1);
+    run(0);
+    t1.join();
+    if (err[0] || err[1]) return 1;
+  }
+  for (int i=0; i<2; i++) {
+    auto s = read_file(fname[i]);
+    std::remove(fname[i].c_str());
+    if (count(s, "\"name\":\"solve\"") != nsolves[i] ||
+        count(s, "\"name\":\"fwd_solve\"") < nsolves[i]) {
+      cout << "ERROR: trace of concurrent solver " << i << " has "
+           << count(s, "\"name\":\"solve\"") << " solve events, "
+           << "expected " << nsolves[i] << endl;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Only max_events() events are kept per thread, the others are
+ * counted as dropped.
+ */
+int test_max_events() {
+  const std::string fname = "test_max_events.json";
+  Tracer::clear();
+  auto max_events = Tracer::max_events();
+  Tracer::set_max_events(10);
+  Tracer::start();
+  for (int i=0; i<100; i++)
+    TraceScope t("capped");
+  Tracer::stop();
+  Tracer::set_max_events(max_events);
+  bool ok = Tracer::write(fname);
+  auto s = read_file(fname);
+  std::remove(fname.c_str());
+  if (!ok || count(s, "\"name\":\"capped\"") != 10 ||
+      count(s, "\"count\":90") != 1) {
+    cout << "ERROR: wrong trace with a full buffer:\n" << s << endl;
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  int n = 30;
+  if (argc > 1) n = std::max(4, atoi(argv[1]));
+  cout << "# Running with:\n# ";
+#if defined(_OPENMP)
+  cout << "OMP_NUM_THREADS=" << omp_get_max_threads() << " ";
+#endif
+  for (int i=0; i<argc; i++)
+    cout << argv[i] << " ";
+  cout << endl;
+
+  int ierr = test_tracer();
+  ierr |= test_solver_trace<double,int>(argc, argv, n);
+  ierr |= test_solver_trace<std::complex<float>,long long int>
+    (argc, argv, n);
+  ierr |= test_two_solvers_trace<double,int>(argc, argv, n);
+  ierr |= test_concurrent_solvers_trace<double,int>(argc, argv, n);
+  ierr |= test_max_events();
+  return ierr;
+}
@@ -0,0 +1,145 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#include <iostream>
+#include <random>
+#include <chrono>
+#include <cmath>
+using namespace std;
+
+#include "misc/Tools.hpp"
+
+using namespace strumpack;
+
+/**
+ * The work vector pool as it was before the size-class bins, with a
+ * best-fit linear scan in a global critical section. Only used here
+ * as a reference.
+ */
+template<typename scalar_t> class ReferenceVectorPool {
+public:
+  std::vector<scalar_t,NoInit<scalar_t>> get(std::size_t s=0) {
+    std::vector<scalar_t,NoInit<scalar_t>> v;
+#pragma omp critical
+    {
+      if (!data_.empty()) {
+        std::size_t pos = 0, vsize = data_[0].capacity();
+        for (std::size_t i=0; i<data_.size(); i++) {
+          auto c = data_[i].capacity();
+          if (c >= s && c < vsize) {
+            pos = i;
+            vsize = c;
+          }
+        }
+        v = std::move(data_[pos]);
+        v.resize(s);
+        data_.erase(data_.begin()+pos);
+      } else v.resize(s);
+    }
+    return v;
+  }
+  void restore(std::vector<scalar_t,NoInit<scalar_t>>& v) {
+    if (v.empty()) return;
+#pragma omp critical
+    data_.push_back(std::move(v));
+  }
+private:
+  std::vector<std::vector<scalar_t,NoInit<scalar_t>>> data_;
+};
+
+/**
+ * Mimic the use of the pool in the multifrontal factorization: each
+ * task gets a few vectors of random size (log-uniform), touches
+ * them, and returns them, possibly from another task.
+ */
+template<typename pool_t> int
+run(pool_t& pool, int ntasks, std::size_t maxsize, double& time) {
+  int err = 0;
+  auto t0 = std::chrono::steady_clock::now();
+#pragma omp parallel
+#pragma omp single
+  for (int t=0; t<ntasks; t++) {
+#pragma omp task firstprivate(t) shared(pool, err)
+    {
+      std::mt19937 gen(t);
+      std::uniform_real_distribution<double> lg
+        (0., std::log2(double(maxsize)));
+      std::size_t s1 = std::size_t(std::exp2(lg(gen))),
+        s2 = std::size_t(std::exp2(lg(gen)));
+      auto v1 = pool.get(s1);
+      auto v2 = pool.get(s2);
+      if (v1.size() != s1 || v2.size() != s2) {
+#pragma omp atomic write
+        err = 1;
+      }
+      if (s1) { v1.front() = 1.; v1.back() = 1.; }
+      if (s2) { v2.front() = 1.; v2.back() = 1.; }
+      pool.restore(v2);
+      pool.restore(v1);
+    }
+  }
+  time = std::chrono::duration<double>
+    (std::chrono::steady_clock::now() - t0).count();
+  return err;
+}
+
+int main(int argc, char* argv[]) {
+  int ntasks = 100000;
+  std::size_t maxsize = 1 << 12;
+  if (argc > 1) ntasks = std::max(1, atoi(argv[1]));
+  if (argc > 2) maxsize = std::max(1, atoi(argv[2]));
+  cout << "# Running with:\n# ";
+#if defined(_OPENMP)
+  cout << "OMP_NUM_THREADS=" << omp_get_max_threads() << " ";
+#endif
+  for (int i=0; i<argc; i++)
+    cout << argv[i] << " ";
+  cout << endl;
+
+  // the first pass fills the pool, time the second pass
+  int ierr = 0;
+  double t_ref = 0., t_new = 0.;
+  {
+    ReferenceVectorPool<double> pool;
+    ierr |= run(pool, ntasks, maxsize, t_ref);
+    ierr |= run(pool, ntasks, maxsize, t_ref);
+  }
+  {
+    VectorPool<double> pool;
+    ierr |= run(pool, ntasks, maxsize, t_new);
+    ierr |= run(pool, ntasks, maxsize, t_new);
+    auto v = pool.get(maxsize);
+    if (v.size() != maxsize) ierr = 1;
+    pool.restore(v);
+    if (!v.empty()) ierr = 1;
+  }
+  cout << "# reference pool (critical section): " << t_ref << " sec" << endl
+       << "# binned pool: " << t_new << " sec" << endl;
+  if (ierr) cout << "ERROR: wrong vector size from pool" << endl;
+  return ierr;
+}